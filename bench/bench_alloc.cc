@@ -0,0 +1,86 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 21:10:39
+ * @LastEditTime: 2026-10-18 21:10:39
+ * @FilePath: /miniKV/bench/bench_alloc.cc
+ * @Description:  内存分配基准：多线程下短生命周期对象的分配/释放
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memory/pool_alloc.h"
+#include "../src/memtable/random.h"
+
+namespace minikvdb::bench
+{
+    // 单线程分配后立即释放，测量分配器本身的固定开销
+    template <typename Alloc>
+    static void BM_AllocFree(benchmark::State &state)
+    {
+        Alloc alloc;
+        const int32_t size = static_cast<int32_t>(state.range(0));
+        for (auto _ : state)
+        {
+            void *p = alloc.Allocate(size);
+            benchmark::DoNotOptimize(p);
+            alloc.Deallocate(p, size);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_AllocFree, DefaultAlloc)->RangeMultiplier(4)->Range(16, 16 << 10);
+    BENCHMARK_TEMPLATE(BM_AllocFree, PoolAlloc)->RangeMultiplier(4)->Range(16, 16 << 10);
+
+    static void BM_DefaultAllocReallocate(benchmark::State &state)
+    {
+        DefaultAlloc alloc;
+        const int32_t size = static_cast<int32_t>(state.range(0));
+        for (auto _ : state)
+        {
+            void *p = alloc.Allocate(size);
+            p = alloc.Reallocate(p, size, 2 * size);
+            benchmark::DoNotOptimize(p);
+            alloc.Deallocate(p, 2 * size);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_DefaultAllocReallocate)->RangeMultiplier(4)->Range(16, 16 << 10);
+
+    // 每个线程维护一个固定大小的环，每次释放最老的块再分配一个随机大小的新块
+    template <typename Alloc>
+    static void BM_AllocChurn(benchmark::State &state)
+    {
+        const int kRing = 1024;
+        const int32_t max_size = static_cast<int32_t>(state.range(0));
+        Alloc alloc;
+        Random rnd(301 + state.thread_index());
+        std::vector<std::pair<void *, int32_t>> ring(kRing, {nullptr, 0});
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            auto &slot = ring[i++ % kRing];
+            if (slot.first != nullptr)
+            {
+                alloc.Deallocate(slot.first, slot.second);
+            }
+            slot.second = 16 + rnd.Uniform(max_size - 16);
+            slot.first = alloc.Allocate(slot.second);
+            benchmark::DoNotOptimize(slot.first);
+        }
+        for (auto &slot : ring)
+        {
+            if (slot.first != nullptr)
+            {
+                alloc.Deallocate(slot.first, slot.second);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_AllocChurn, DefaultAlloc)->Arg(256)->Arg(4096)->ThreadRange(1, 16)->UseRealTime();
+    BENCHMARK_TEMPLATE(BM_AllocChurn, PoolAlloc)->Arg(256)->Arg(4096)->ThreadRange(1, 16)->UseRealTime();
+}
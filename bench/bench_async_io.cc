@@ -0,0 +1,113 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 16:30:09
+ * @LastEditTime: 2026-10-20 16:30:09
+ * @FilePath: /miniKV/bench/bench_async_io.cc
+ * @Description:  批量随机读基准：逐个pread vs io_uring vs 线程池pread
+ *
+ * ********************************
+ *  参数：backend为0(同步pread)、1(io_uring)或2(线程池)，batch为一批读的块数，
+ *  cold为1时每批读之前用posix_fadvise(DONTNEED)丢弃页缓存，模拟冷读
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+
+#include "../src/memtable/random.h"
+#include "../src/utils/async_io.h"
+
+namespace minikvdb::bench
+{
+    static constexpr size_t kBlockSize = 4096;
+    static constexpr size_t kNumBlocks = 16384; // 64MB
+
+    // 进程内共享的数据文件，退出时删除
+    static int DataFile()
+    {
+        static int fd = -1;
+        static std::string path;
+        if (fd < 0)
+        {
+            const char *dir = std::getenv("TMPDIR");
+            path = std::string(dir != nullptr ? dir : "/tmp") + "/minikvdb_bench_async_io_XXXXXX";
+            fd = ::mkstemp(&path[0]);
+            std::vector<char> block(kBlockSize, 'x');
+            for (size_t i = 0; i < kNumBlocks; ++i)
+            {
+                if (::write(fd, block.data(), kBlockSize) != static_cast<ssize_t>(kBlockSize))
+                {
+                    std::abort();
+                }
+            }
+            ::fsync(fd);
+            std::atexit([]()
+                        { ::close(fd);
+                          ::unlink(path.c_str()); });
+        }
+        return fd;
+    }
+
+    static void BM_MultiRead(benchmark::State &state)
+    {
+        const int backend = static_cast<int>(state.range(0));
+        const size_t batch = static_cast<size_t>(state.range(1));
+        const bool cold = state.range(2) != 0;
+        int fd = DataFile();
+
+        std::unique_ptr<AsyncReader> reader;
+        if (backend != 0)
+        {
+            reader = NewAsyncReader(backend == 1, static_cast<int>(batch));
+            if (backend == 1 && std::string(reader->Name()) != "io_uring")
+            {
+                state.SkipWithError("io_uring unavailable");
+                return;
+            }
+        }
+
+        std::vector<char> buf(batch * kBlockSize);
+        std::vector<ReadRequest> reqs(batch);
+        FastRandom rnd(301);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            if (cold)
+            {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            }
+            for (size_t i = 0; i < batch; ++i)
+            {
+                reqs[i].fd = fd;
+                reqs[i].offset = rnd.Uniform(kNumBlocks) * kBlockSize;
+                reqs[i].len = kBlockSize;
+                reqs[i].scratch = buf.data() + i * kBlockSize;
+            }
+            state.ResumeTiming();
+
+            if (reader == nullptr)
+            {
+                SyncMultiRead(reqs.data(), batch);
+            }
+            else
+            {
+                reader->MultiRead(reqs.data(), batch);
+            }
+            benchmark::DoNotOptimize(reqs.data());
+        }
+        state.SetItemsProcessed(state.iterations() * batch);
+        state.SetBytesProcessed(state.iterations() * batch * kBlockSize);
+    }
+
+    BENCHMARK(BM_MultiRead)
+        ->ArgsProduct({{0, 1, 2}, {1, 100}, {0, 1}})
+        ->ArgNames({"backend", "batch", "cold"})
+        ->UseRealTime();
+}
@@ -0,0 +1,220 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 10:12:40
+ * @LastEditTime: 2026-10-22 10:12:40
+ * @FilePath: /miniKV/bench/bench_bplus_tree.cc
+ * @Description:  有序内存表结构对比：跳表 vs B+树
+ *
+ * ********************************
+ *  两种结构使用相同的key、value与比较函数，分别测Insert(顺序/均匀)、点查、
+ *  范围扫描(Seek后Next 100次)与全表迭代，key类型分为int64_t和string两组
+ *  B+树的叶子连续存放kv指针，扫描时按缓存行顺序访问，跳表每个Next都是一次指针追逐
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/bplus_tree.h"
+#include "../src/memtable/skiplist.h"
+#include "key_generator.h"
+
+namespace minikvdb::bench
+{
+    struct OrderedIntComparator
+    {
+        int operator()(const int64_t &a, const int64_t &b) const
+        {
+            return a < b ? -1 : (a > b ? 1 : 0);
+        }
+    };
+
+    struct OrderedStringComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    template <typename Key>
+    struct OrderedComparatorOf;
+
+    template <>
+    struct OrderedComparatorOf<int64_t>
+    {
+        using type = OrderedIntComparator;
+    };
+
+    template <>
+    struct OrderedComparatorOf<std::string>
+    {
+        using type = OrderedStringComparator;
+    };
+
+    // 被测结构
+    struct SkipListTable
+    {
+        template <typename Key>
+        using Type = SkipList<Key, std::string, typename OrderedComparatorOf<Key>::type>;
+    };
+
+    struct BPlusTreeTable
+    {
+        template <typename Key>
+        using Type = BPlusTree<Key, std::string, typename OrderedComparatorOf<Key>::type>;
+    };
+
+    static const std::string kOrderedValue(16, 'v');
+    static constexpr int kScanLength = 100;
+
+    template <class Table, typename Key>
+    static std::unique_ptr<typename Table::template Type<Key>> NewOrderedTable()
+    {
+        using Cmp = typename OrderedComparatorOf<Key>::type;
+        return std::make_unique<typename Table::template Type<Key>>(Cmp(), std::make_shared<DefaultAlloc>());
+    }
+
+    // [0, n)的一个排列：顺序分布为恒等排列，其余为随机打乱
+    template <typename Key>
+    static std::vector<Key> OrderedUniqueKeys(int64_t n, KeyDistribution dist)
+    {
+        std::vector<Key> keys;
+        keys.reserve(n);
+        for (int64_t i = 0; i < n; ++i)
+        {
+            keys.push_back(MakeKey<Key>(i));
+        }
+        if (dist != KeyDistribution::kSequential)
+        {
+            Random rnd(301);
+            for (int64_t i = n - 1; i > 0; --i)
+            {
+                std::swap(keys[i], keys[rnd.Uniform(static_cast<int>(i + 1))]);
+            }
+        }
+        return keys;
+    }
+
+    // 查询类基准共享同一张表，相同entries的多次运行只构建一次
+    template <class Table, typename Key>
+    static typename Table::template Type<Key> *SharedOrderedTable(int64_t n)
+    {
+        static std::unique_ptr<typename Table::template Type<Key>> table;
+        static int64_t size = -1;
+        if (size != n)
+        {
+            table.reset(); // 先释放旧表，避免同时持有两张大表
+            table = NewOrderedTable<Table, Key>();
+            for (const Key &key : OrderedUniqueKeys<Key>(n, KeyDistribution::kUniform))
+            {
+                table->Insert(key, kOrderedValue);
+            }
+            size = n;
+        }
+        return table.get();
+    }
+
+    template <class Table, typename Key>
+    static void BM_OrderedInsert(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto dist = static_cast<KeyDistribution>(state.range(1));
+        auto keys = OrderedUniqueKeys<Key>(n, dist);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto table = NewOrderedTable<Table, Key>();
+            state.ResumeTiming();
+            for (const Key &key : keys)
+            {
+                table->Insert(key, kOrderedValue);
+            }
+            state.PauseTiming();
+            table.reset();
+            EpochManager::get_instance()->TryReclaim();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+        state.SetLabel(DistributionName(dist));
+    }
+
+    template <class Table, typename Key>
+    static void BM_OrderedGet(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto *table = SharedOrderedTable<Table, Key>(n);
+        KeyGenerator gen(KeyDistribution::kUniform, n);
+        for (auto _ : state)
+        {
+            Key key = MakeKey<Key>(gen.Next());
+            benchmark::DoNotOptimize(table->Contains(key));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // 随机Seek后顺序读kScanLength个kv，吞吐按读到的kv数计算
+    template <class Table, typename Key>
+    static void BM_OrderedScan(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto *table = SharedOrderedTable<Table, Key>(n);
+        KeyGenerator gen(KeyDistribution::kUniform, n);
+        int64_t items = 0;
+        for (auto _ : state)
+        {
+            typename Table::template Type<Key>::Iterator iter(table);
+            iter.Seek(MakeKey<Key>(gen.Next()));
+            for (int i = 0; i < kScanLength && iter.Valid(); ++i, iter.Next())
+            {
+                benchmark::DoNotOptimize(iter.value());
+                ++items;
+            }
+        }
+        state.SetItemsProcessed(items);
+    }
+
+    template <class Table, typename Key>
+    static void BM_OrderedIterate(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto *table = SharedOrderedTable<Table, Key>(n);
+        for (auto _ : state)
+        {
+            typename Table::template Type<Key>::Iterator iter(table);
+            for (iter.MoveToFirst(); iter.Valid(); iter.Next())
+            {
+                benchmark::DoNotOptimize(iter.value());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    static const std::vector<int64_t> kOrderedEntries = {100000, 1000000, 10000000};
+    static const std::vector<int64_t> kOrderedInsertDists = {
+        static_cast<int64_t>(KeyDistribution::kSequential),
+        static_cast<int64_t>(KeyDistribution::kUniform)};
+
+    BENCHMARK_TEMPLATE(BM_OrderedInsert, SkipListTable, int64_t)->ArgsProduct({kOrderedEntries, kOrderedInsertDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedInsert, BPlusTreeTable, int64_t)->ArgsProduct({kOrderedEntries, kOrderedInsertDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedInsert, SkipListTable, std::string)->ArgsProduct({kOrderedEntries, kOrderedInsertDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedInsert, BPlusTreeTable, std::string)->ArgsProduct({kOrderedEntries, kOrderedInsertDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedGet, SkipListTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedGet, BPlusTreeTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedGet, SkipListTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedGet, BPlusTreeTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedScan, SkipListTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedScan, BPlusTreeTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedScan, SkipListTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedScan, BPlusTreeTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"});
+    BENCHMARK_TEMPLATE(BM_OrderedIterate, SkipListTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedIterate, BPlusTreeTable, int64_t)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedIterate, SkipListTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_OrderedIterate, BPlusTreeTable, std::string)->ArgsProduct({kOrderedEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+}
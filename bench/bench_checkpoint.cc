@@ -0,0 +1,125 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:40:05
+ * @LastEditTime: 2026-10-21 10:40:05
+ * @FilePath: /miniKV/bench/bench_checkpoint.cc
+ * @Description:  checkpoint重启基准：重启后第一次读请求的等待时间
+ *
+ * ********************************
+ *  每轮先丢弃checkpoint文件的页缓存(冷启动)，计时从打开文件到第一次Get返回：
+ *    mmap为0   先完整重建memtable再服务读请求(与重放日志一样，需要读完所有数据)
+ *    mmap为1   映射文件后立即在映射内存上查找，memtable在后台线程中重建
+ *  计数器rebuild_ms为memtable完整重建所需时间(mmap为1时不计入首次读取)
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/checkpoint.h"
+#include "../src/memtable/comparator.h"
+#include "../src/memtable/memtable.h"
+#include "../src/utils/page_cache.h"
+#include "../src/utils/thread_pool.h"
+
+namespace minikvdb::bench
+{
+    using CheckpointTable = MemTable<std::string, std::string, BytewiseComparator, BytewiseHash>;
+    using Restored = RestoredMemTable<std::string, std::string, BytewiseComparator, BytewiseHash>;
+
+    static constexpr size_t kValueSize = 100;
+
+    static std::string CheckpointKey(int64_t i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "key_%012lld", static_cast<long long>(i));
+        return buf;
+    }
+
+    // 每种规模只写一次checkpoint文件
+    static const std::string &CheckpointFile(int64_t entries)
+    {
+        static std::map<int64_t, std::string> files;
+        auto it = files.find(entries);
+        if (it != files.end())
+        {
+            return it->second;
+        }
+        const char *dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr ? dir : "/tmp") + "/minikvdb_bench_ckpt_" + std::to_string(entries);
+        {
+            CheckpointTable table(BytewiseComparator(), std::make_shared<DefaultAlloc>());
+            for (int64_t i = 0; i < entries; ++i)
+            {
+                table.Insert(CheckpointKey(i), std::string(kValueSize, 'v'));
+            }
+            WriteCheckpoint(table, path, {{"entries", std::to_string(entries)}});
+        }
+        if (files.empty())
+        {
+            std::atexit([]()
+                        { for (auto &[n, p] : files)
+                          {
+                              unlink(p.c_str());
+                          } });
+        }
+        return files.emplace(entries, path).first->second;
+    }
+
+    static std::unique_ptr<CheckpointTable> NewCheckpointTable()
+    {
+        return std::make_unique<CheckpointTable>(BytewiseComparator(), std::make_shared<DefaultAlloc>());
+    }
+
+    static void BM_RestartFirstRead(benchmark::State &state)
+    {
+        const bool mmap = state.range(0) != 0;
+        const int64_t entries = state.range(1);
+        const std::string &path = CheckpointFile(entries);
+        const std::string key = CheckpointKey(entries / 2);
+        ThreadPool pool(1, 0);
+        double rebuild_ms = 0;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            DropPageCache(path);
+            auto restored = std::make_unique<Restored>(NewCheckpointTable());
+            state.ResumeTiming();
+
+            auto start = std::chrono::steady_clock::now();
+            if (!restored->Open(path, mmap ? &pool : nullptr))
+            {
+                state.SkipWithError("open checkpoint failed");
+                break;
+            }
+            if (!mmap)
+            {
+                restored->WaitForRebuild();
+            }
+            benchmark::DoNotOptimize(restored->Get(key));
+
+            state.PauseTiming();
+            restored->WaitForRebuild();
+            rebuild_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            restored.reset();
+            state.ResumeTiming();
+        }
+        state.counters["rebuild_ms"] = rebuild_ms / state.iterations();
+    }
+
+    BENCHMARK(BM_RestartFirstRead)
+        ->ArgsProduct({{0, 1}, {100000, 1000000}})
+        ->ArgNames({"mmap", "entries"})
+        ->Iterations(3)
+        ->UseRealTime()
+        ->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,140 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 12:10:44
+ * @LastEditTime: 2026-10-23 14:05:12
+ * @FilePath: /miniKV/bench/bench_compaction.cc
+ * @Description:  compaction吞吐(MB/s)随subcompaction线程数的变化，以及不同compaction策略的写放大
+ *
+ * ********************************
+ *  BM_Compaction：8个相互重叠的输入有序段，每段256K条(key 19字节 + value 100字节)，
+ *  参数subcompactions为切分的段数，第0段在调用线程上执行，其余段在ThreadPool的低优先级线程上执行
+ *  BM_CompactionWriteAmp：追加为主的写入(90%新key递增，10%覆盖旧key)，共200次flush，
+ *  tiered为0时每次flush后都合并为一个有序段(相当于只有一层的leveled)，为1时使用tiered策略
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../src/compaction/compaction_job.h"
+#include "../src/compaction/tiered_compaction.h"
+#include "../src/memtable/random.h"
+#include "../src/utils/thread_pool.h"
+#include "key_generator.h"
+
+namespace minikvdb::bench
+{
+    struct RunComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using StringRun = SortedRun<std::string, std::string>;
+
+    static const std::vector<StringRun> &CompactionInputs()
+    {
+        static std::vector<StringRun> runs;
+        if (runs.empty())
+        {
+            const int kRuns = 8;
+            const uint64_t kPerRun = 256 * 1024;
+            const std::string value(100, 'v');
+            runs.resize(kRuns);
+            for (int r = 0; r < kRuns; ++r)
+            {
+                // 第r段取编号为r (mod kRuns)附近的key，各段key范围完全重叠
+                for (uint64_t i = 0; i < kPerRun; ++i)
+                {
+                    runs[r].Append(MakeKey<std::string>(i * kRuns + r / 2), value);
+                }
+                runs[r].id = kRuns - r;
+            }
+        }
+        return runs;
+    }
+
+    static void BM_Compaction(benchmark::State &state)
+    {
+        const std::vector<StringRun> &runs = CompactionInputs();
+        std::vector<const StringRun *> inputs;
+        for (const StringRun &run : runs)
+        {
+            inputs.push_back(&run);
+        }
+        // 线程数只增不减，调用线程执行第0段，低优先级线程数取subcompactions - 1即可
+        static ThreadPool pool(1, 1);
+        const int subcompactions = static_cast<int>(state.range(0));
+        pool.SetBackgroundThreads(subcompactions - 1, Priority::kLow);
+        uint64_t bytes = 0;
+        for (auto _ : state)
+        {
+            CompactionJob<std::string, std::string, RunComparator> job(inputs, RunComparator(), subcompactions,
+                                                                        nullptr, false, &pool);
+            std::vector<StringRun> outputs = job.Execute();
+            bytes += job.GetStats().bytes_read;
+            state.PauseTiming();
+            outputs.clear(); // 释放输出不计入耗时
+            state.ResumeTiming();
+        }
+        state.SetBytesProcessed(bytes);
+    }
+
+    BENCHMARK(BM_Compaction)
+        ->RangeMultiplier(2)
+        ->Range(1, 32)
+        ->ArgName("subcompactions")
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+    static void BM_CompactionWriteAmp(benchmark::State &state)
+    {
+        const bool tiered = state.range(0) != 0;
+        const int kFlushes = 200;
+        const uint64_t kPerFlush = 4096;
+        const std::string value(100, 'v');
+        TieredCompactionOptions opts;
+        if (!tiered)
+        {
+            opts.run_count_trigger = 2;
+            opts.max_size_amplification_percent = 0;
+        }
+        TieredCompactionStats stats;
+        for (auto _ : state)
+        {
+            TieredCompaction<std::string, std::string, RunComparator> compaction(RunComparator(), opts);
+            Random rnd(301);
+            uint64_t next_key = 0;
+            for (int f = 0; f < kFlushes; ++f)
+            {
+                std::map<std::string, std::string> memtable;
+                for (uint64_t i = 0; i < kPerFlush; ++i)
+                {
+                    uint64_t k = (next_key > 0 && rnd.OneIn(10)) ? rnd.Uniform(static_cast<int>(next_key)) : next_key++;
+                    memtable[MakeKey<std::string>(k)] = value;
+                }
+                StringRun run;
+                run.id = f;
+                for (auto &[k, v] : memtable)
+                {
+                    run.Append(k, v);
+                }
+                compaction.AddRun(std::move(run));
+                compaction.CompactUntilStable();
+            }
+            stats = compaction.GetStats();
+        }
+        state.counters["write_amp"] = stats.WriteAmplification();
+        state.counters["space_amp"] = stats.SpaceAmplification();
+        state.counters["runs"] = static_cast<double>(stats.num_runs);
+        state.counters["compactions"] = static_cast<double>(stats.num_compactions);
+    }
+
+    BENCHMARK(BM_CompactionWriteAmp)->Arg(0)->Arg(1)->ArgName("tiered")->Iterations(1)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,44 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 14:02:55
+ * @LastEditTime: 2026-10-18 14:02:55
+ * @FilePath: /miniKV/bench/bench_crc32c.cc
+ * @Description:  CRC32C吞吐基准，bytes_per_second即GB/s
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <string>
+#include <benchmark/benchmark.h>
+
+#include "../src/utils/crc32c.h"
+
+namespace minikvdb::bench
+{
+    static void BM_Crc32c(benchmark::State &state)
+    {
+        std::string data(state.range(0), 'x');
+        uint32_t crc = 0;
+        for (auto _ : state)
+        {
+            crc = crc32c::Extend(crc, data.data(), data.size());
+            benchmark::DoNotOptimize(crc);
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+        state.SetLabel(crc32c::IsHardwareAccelerated() ? "sse4.2" : "slicing-by-8");
+    }
+    BENCHMARK(BM_Crc32c)->RangeMultiplier(8)->Range(64, 4 << 20);
+
+    static void BM_Crc32cPortable(benchmark::State &state)
+    {
+        std::string data(state.range(0), 'x');
+        uint32_t crc = 0;
+        for (auto _ : state)
+        {
+            crc = crc32c::ExtendPortable(crc, data.data(), data.size());
+            benchmark::DoNotOptimize(crc);
+        }
+        state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+    }
+    BENCHMARK(BM_Crc32cPortable)->RangeMultiplier(8)->Range(64, 4 << 20);
+}
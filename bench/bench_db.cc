@@ -0,0 +1,151 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-23 18:25:33
+ * @FilePath: /miniKV/bench/bench_db.cc
+ * @Description:  DB随机写入吞吐(fillrandom)：列族数量与批次大小，大value的kv分离
+ *
+ * ********************************
+ *  每轮新建一个DB与空WAL，随机写入kEntries条(key 19字节 + value 100字节)，
+ *  写入轮流落在各列族上，batch条写入组成一个WriteBatch(一条WAL记录)。
+ *  WAL不sync，只测试编码、日志与memtable/flush/compaction的开销。
+ *  大value场景每轮写入kLargeValueBytes，key空间为条数的一半，约一半写入是覆盖；
+ *  write_amp = (WAL + flush + compaction写出 + blob文件写入) / 用户写入字节数。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+
+#include "../src/db/db.h"
+#include "key_generator.h"
+
+namespace minikvdb::bench
+{
+    static constexpr uint64_t kEntries = 100000;
+    static constexpr size_t kDBValueSize = 100;
+    static constexpr uint64_t kLargeValueBytes = 64 << 20;
+
+    static std::string BenchWalPath()
+    {
+        const char *dir = std::getenv("TMPDIR");
+        return std::string(dir != nullptr ? dir : "/tmp") + "/minikvdb_bench_wal";
+    }
+
+    static void BM_DBFillRandom(benchmark::State &state)
+    {
+        const int num_cfs = static_cast<int>(state.range(0));
+        const int batch_size = static_cast<int>(state.range(1));
+        const std::string wal = BenchWalPath();
+        const std::string value(kDBValueSize, 'v');
+        uint64_t bytes = 0;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            unlink(wal.c_str());
+            DBOptions options;
+            options.wal_path = wal;
+            auto db = std::make_unique<DB>(options);
+            std::vector<ColumnFamily *> cfs{db->DefaultColumnFamily()};
+            for (int i = 1; i < num_cfs; ++i)
+            {
+                cfs.push_back(db->CreateColumnFamily("cf" + std::to_string(i)));
+            }
+            db->Open();
+            KeyGenerator gen(KeyDistribution::kUniform, kEntries * 10);
+            state.ResumeTiming();
+
+            WriteBatch batch;
+            for (uint64_t i = 0; i < kEntries; ++i)
+            {
+                std::string key = MakeKey<std::string>(gen.Next());
+                batch.Put(cfs[i % cfs.size()]->GetID(), key, value);
+                bytes += key.size() + value.size();
+                if (batch.Count() == static_cast<uint32_t>(batch_size))
+                {
+                    db->Write(&batch);
+                    batch.Clear();
+                }
+            }
+            db->Write(&batch);
+            db->WaitForBackgroundWork(); // 后台flush与compaction计入耗时
+
+            state.PauseTiming();
+            db.reset();
+            state.ResumeTiming();
+        }
+        unlink(wal.c_str());
+        state.SetBytesProcessed(bytes);
+        state.SetItemsProcessed(state.iterations() * kEntries);
+    }
+
+    BENCHMARK(BM_DBFillRandom)
+        ->ArgsProduct({{1, 4}, {1, 16}})
+        ->ArgNames({"cfs", "batch"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+    static void BM_DBFillRandomLargeValue(benchmark::State &state)
+    {
+        const size_t value_size = static_cast<size_t>(state.range(0));
+        const bool blob = state.range(1) != 0;
+        const uint64_t entries = kLargeValueBytes / value_size;
+        const std::string wal = BenchWalPath();
+        const std::string blob_dir = wal + "_blobs";
+        const std::string value(value_size, 'v');
+        uint64_t bytes = 0;
+        uint64_t written = 0;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            unlink(wal.c_str());
+            std::filesystem::remove_all(blob_dir);
+            std::filesystem::create_directories(blob_dir);
+            auto stats = std::make_shared<Statistics>();
+            DBOptions options;
+            options.wal_path = wal;
+            options.stats = stats;
+            auto db = std::make_unique<DB>(options);
+            ColumnFamilyOptions cf_options;
+            cf_options.enable_blob_files = blob;
+            cf_options.blob_dir = blob_dir;
+            cf_options.blob_file_size = 16 << 20;
+            ColumnFamily *cf = db->CreateColumnFamily("large", cf_options);
+            db->Open();
+            KeyGenerator gen(KeyDistribution::kUniform, entries / 2);
+            state.ResumeTiming();
+
+            for (uint64_t i = 0; i < entries; ++i)
+            {
+                std::string key = MakeKey<std::string>(gen.Next());
+                db->Put(cf, key, value);
+                bytes += key.size() + value.size();
+            }
+            db->WaitForBackgroundWork();
+
+            state.PauseTiming();
+            written += stats->GetTickerCount(Ticker::kWalBytes) + stats->GetTickerCount(Ticker::kFlushBytesWritten) +
+                       stats->GetTickerCount(Ticker::kCompactionBytesWritten) +
+                       stats->GetTickerCount(Ticker::kBlobBytesWritten);
+            db.reset();
+            state.ResumeTiming();
+        }
+        unlink(wal.c_str());
+        std::filesystem::remove_all(blob_dir);
+        state.SetBytesProcessed(bytes);
+        state.counters["write_amp"] = bytes == 0 ? 0.0 : static_cast<double>(written) / bytes;
+    }
+
+    BENCHMARK(BM_DBFillRandomLargeValue)
+        ->ArgsProduct({{16 << 10, 64 << 10}, {0, 1}})
+        ->ArgNames({"value", "blob"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+}
@@ -0,0 +1,125 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/bench/bench_direct_io.cc
+ * @Description:  direct I/O基准：模拟compaction顺序读入、顺序写出时对页缓存的污染
+ *
+ * ********************************
+ *  每轮把input文件(冷)顺序读出并写入output文件，direct为1时读写都使用O_DIRECT，
+ *  为0时使用普通缓冲I/O。计数器：
+ *    input_cached_mb/output_cached_mb   compaction结束后两个文件驻留页缓存的大小
+ *    hot_hit_rate                       前台读的热文件仍驻留在页缓存中的比例
+ *  热文件在内存充足时不会被挤出，此时应主要关注compaction文件占用的页缓存大小
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+
+#include "../src/utils/page_cache.h"
+#include "../src/utils/sequential_file.h"
+#include "../src/utils/writable_file.h"
+
+namespace minikvdb::bench
+{
+    static constexpr size_t kHotFileSize = 64 << 20;
+    static constexpr size_t kInputFileSize = 256 << 20;
+
+    struct DirectIOFiles
+    {
+        std::string hot;
+        std::string input;
+        std::string output;
+    };
+
+    static std::string WriteFile(const std::string &dir, const char *name, size_t size)
+    {
+        std::string path = dir + "/minikvdb_bench_" + name;
+        WritableFile file(nullptr, Priority::kLow, 1 << 20);
+        file.Open(path);
+        std::string block(1 << 20, 'x');
+        for (size_t i = 0; i < size; i += block.size())
+        {
+            file.Append(block);
+        }
+        file.Sync();
+        return path;
+    }
+
+    static void ReadFile(const std::string &path)
+    {
+        SequentialFile file;
+        file.Open(path);
+        std::vector<char> buf(1 << 20);
+        while (file.Read(buf.data(), buf.size()) > 0)
+        {
+        }
+    }
+
+    static const DirectIOFiles &Files()
+    {
+        static DirectIOFiles files;
+        if (files.hot.empty())
+        {
+            const char *dir = std::getenv("TMPDIR");
+            std::string d = dir != nullptr ? dir : "/tmp";
+            files.hot = WriteFile(d, "hot", kHotFileSize);
+            files.input = WriteFile(d, "input", kInputFileSize);
+            files.output = d + "/minikvdb_bench_output";
+            std::atexit([]()
+                        { unlink(files.hot.c_str());
+                          unlink(files.input.c_str());
+                          unlink(files.output.c_str()); });
+        }
+        return files;
+    }
+
+    static double CachedMB(const std::string &path)
+    {
+        PageCacheResidency res;
+        GetPageCacheResidency(path, &res);
+        return static_cast<double>(res.resident_pages * PageSize()) / (1 << 20);
+    }
+
+    static void BM_CompactionIO(benchmark::State &state)
+    {
+        const bool direct = state.range(0) != 0;
+        const DirectIOFiles &files = Files();
+        std::vector<char> buf(256 << 10);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            ReadFile(files.hot); // 前台读把热文件读入页缓存
+            DropPageCache(files.input);
+            unlink(files.output.c_str());
+            state.ResumeTiming();
+
+            SequentialFile in(direct);
+            WritableFile out(nullptr, Priority::kLow, 1 << 20, direct);
+            in.Open(files.input);
+            out.Open(files.output);
+            ssize_t n;
+            while ((n = in.Read(buf.data(), buf.size())) > 0)
+            {
+                out.Append(buf.data(), static_cast<size_t>(n));
+            }
+            out.Sync();
+            out.Close();
+        }
+
+        PageCacheResidency hot;
+        GetPageCacheResidency(files.hot, &hot);
+        state.counters["hot_hit_rate"] = hot.HitRate();
+        state.counters["input_cached_mb"] = CachedMB(files.input);
+        state.counters["output_cached_mb"] = CachedMB(files.output);
+        state.SetBytesProcessed(state.iterations() * kInputFileSize * 2);
+    }
+
+    BENCHMARK(BM_CompactionIO)->Arg(0)->Arg(1)->ArgName("direct")->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,71 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 17:05:33
+ * @LastEditTime: 2026-10-18 17:05:33
+ * @FilePath: /miniKV/bench/bench_lock.cc
+ * @Description:  锁竞争基准，1~64线程争抢同一把锁
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdint>
+#include <thread>
+#include <benchmark/benchmark.h>
+
+#include "../src/utils/lock.h"
+
+namespace minikvdb::bench
+{
+    // 临界区很短(修改一条共享缓存行)，主要测量锁本身的获取/释放代价与缓存行迁移开销
+    template <typename T>
+    static void BM_LockContention(benchmark::State &state)
+    {
+        static T lock;
+        static int64_t shared_counter = 0;
+        for (auto _ : state)
+        {
+            ScopedLock<T> guard(lock);
+            ++shared_counter;
+            benchmark::DoNotOptimize(shared_counter);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_LockContention, MutexLock)->ThreadRange(1, 64)->UseRealTime();
+    BENCHMARK_TEMPLATE(BM_LockContention, SpinLock)->ThreadRange(1, 64)->UseRealTime();
+    // 票据锁严格FIFO，线程数超过CPU核数时每次交接都要等排在下一位的线程被调度，
+    // 吞吐会断崖式下降(这是公平锁的固有代价)，因此只测到CPU核数
+    static void TicketLockThreads(benchmark::internal::Benchmark *b)
+    {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        for (int t = 1; t <= 64 && (t == 1 || t <= cores); t *= 2)
+        {
+            b->Threads(t);
+        }
+    }
+    BENCHMARK_TEMPLATE(BM_LockContention, TicketLock)->Apply(TicketLockThreads)->UseRealTime();
+
+    // 读多写少：每64次操作中1次写
+    template <typename T>
+    static void BM_ReadMostly(benchmark::State &state)
+    {
+        static T lock;
+        static int64_t shared_value = 0;
+        uint32_t i = 0;
+        for (auto _ : state)
+        {
+            if ((++i & 63) == 0)
+            {
+                ScopedLock<T> guard(lock);
+                ++shared_value;
+            }
+            else
+            {
+                ScopedSharedLock<T> guard(lock);
+                benchmark::DoNotOptimize(shared_value);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_ReadMostly, SharedMutexLock)->ThreadRange(1, 64)->UseRealTime();
+    BENCHMARK_TEMPLATE(BM_ReadMostly, RWLock)->ThreadRange(1, 64)->UseRealTime();
+}
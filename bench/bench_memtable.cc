@@ -0,0 +1,163 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 20:20:31
+ * @LastEditTime: 2026-10-22 21:03:15
+ * @FilePath: /miniKV/bench/bench_memtable.cc
+ * @Description:  MemTable基准：布隆过滤器对点查的影响、memtable创建开销
+ *
+ * ********************************
+ *  参数：entries为表中kv数量，bloom为0(不启用)或1(约10bit/key)，
+ *  miss为查询中不存在key的百分比
+ *  Create模拟memtable轮转：反复创建并销毁一张空表，rep为MemTableRepType，
+ *  heap_bytes_per_create为每次创建后未归还的堆内存(glibc下统计)
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/memtable.h"
+#include "key_generator.h"
+
+namespace minikvdb::bench
+{
+    struct MemTableStringComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using StringTable = MemTable<std::string, std::string, MemTableStringComparator>;
+
+    static StringTable *SharedTable(int64_t n, bool bloom)
+    {
+        static std::unique_ptr<StringTable> table;
+        static int64_t size = -1;
+        static bool built_bloom = false;
+        if (size != n || built_bloom != bloom)
+        {
+            table.reset();
+            table = std::make_unique<StringTable>(MemTableStringComparator(), std::make_shared<DefaultAlloc>());
+            if (bloom)
+            {
+                table->EnableBloomFilter(n * 10 / 8);
+            }
+            // 只插入偶数编号，奇数编号的key一定不存在
+            for (int64_t i = 0; i < n; ++i)
+            {
+                table->Insert(MakeKey<std::string>(2 * i), "value");
+            }
+            size = n;
+            built_bloom = bloom;
+        }
+        return table.get();
+    }
+
+    static void BM_MemTableGet(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        const int64_t miss_percent = state.range(2);
+        StringTable *table = SharedTable(n, state.range(1) != 0);
+        Random rnd(301);
+        int64_t found = 0;
+        for (auto _ : state)
+        {
+            uint64_t k = 2 * rnd.Uniform(static_cast<int>(n));
+            if (static_cast<int64_t>(rnd.Uniform(100)) < miss_percent)
+            {
+                ++k;
+            }
+            auto v = table->Get(MakeKey<std::string>(k));
+            found += v.has_value();
+            benchmark::DoNotOptimize(v);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["hit_rate"] = state.iterations() ? double(found) / state.iterations() : 0;
+        state.counters["bloom_bytes"] = static_cast<double>(table->GetBloomMemUsage());
+    }
+
+    BENCHMARK(BM_MemTableGet)
+        ->ArgsProduct({{100000, 1000000}, {0, 1}, {0, 50, 100}})
+        ->ArgNames({"entries", "bloom", "miss"});
+
+    // 一批batch个均匀分布的key：multi为0时逐个Get，为1时一次MultiGet
+    static void BM_MemTableMultiGet(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        const size_t batch = static_cast<size_t>(state.range(1));
+        const bool multi = state.range(2) != 0;
+        StringTable *table = SharedTable(n, false);
+        Random rnd(301);
+        std::vector<std::string> keys(batch);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            for (auto &key : keys)
+            {
+                key = MakeKey<std::string>(2 * rnd.Uniform(static_cast<int>(n)));
+            }
+            state.ResumeTiming();
+
+            if (multi)
+            {
+                auto values = table->MultiGet(keys);
+                benchmark::DoNotOptimize(values);
+            }
+            else
+            {
+                for (const auto &key : keys)
+                {
+                    auto v = table->Get(key);
+                    benchmark::DoNotOptimize(v);
+                }
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * batch);
+    }
+
+    BENCHMARK(BM_MemTableMultiGet)
+        ->ArgsProduct({{1000000}, {16, 100, 1000}, {0, 1}})
+        ->ArgNames({"entries", "batch", "multi"});
+
+    // 当前已分配的堆内存字节数，非glibc平台返回0
+    static size_t HeapInUse()
+    {
+#if defined(__GLIBC__)
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    static void BM_MemTableCreate(benchmark::State &state)
+    {
+        const auto type = static_cast<MemTableRepType>(state.range(0));
+        auto alloc = std::make_shared<DefaultAlloc>();
+        const size_t heap_before = HeapInUse();
+        for (auto _ : state)
+        {
+            StringTable table(MemTableStringComparator(), alloc, type);
+            benchmark::DoNotOptimize(table.GetSize());
+        }
+        const size_t heap_after = HeapInUse();
+        state.SetItemsProcessed(state.iterations());
+        state.counters["heap_bytes_per_create"] =
+            heap_after > heap_before ? double(heap_after - heap_before) / state.iterations() : 0;
+    }
+
+    BENCHMARK(BM_MemTableCreate)
+        ->ArgsProduct({{static_cast<int64_t>(MemTableRepType::kSkipList),
+                        static_cast<int64_t>(MemTableRepType::kHashSkipList),
+                        static_cast<int64_t>(MemTableRepType::kBPlusTree)}})
+        ->ArgNames({"rep"});
+}
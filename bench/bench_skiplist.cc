@@ -0,0 +1,317 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 09:40:02
+ * @LastEditTime: 2026-10-19 09:40:02
+ * @FilePath: /miniKV/bench/bench_skiplist.cc
+ * @Description:  跳表热点路径基准：Insert/Get/Contains/Delete/迭代
+ *
+ * ********************************
+ *  参数：entries为表中kv数量(10K~10M)，dist为key分布(0顺序 1均匀 2Zipfian)
+ *  key类型分为int64_t和16字节以上的string两组
+ *  Insert/Delete要求key不重复，因此只测顺序与均匀(随机排列)两种分布
+ *  GetLarge测1M~100M条数据下的点查，对比固定最大高度与按数据量计算的最大高度
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/skiplist.h"
+#include "../src/utils/perf_context.h"
+#include "key_generator.h"
+
+namespace minikvdb::bench
+{
+    struct IntComparator
+    {
+        int operator()(const int64_t &a, const int64_t &b) const
+        {
+            return a < b ? -1 : (a > b ? 1 : 0);
+        }
+    };
+
+    struct StringComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    template <typename Key>
+    struct ComparatorOf;
+
+    template <>
+    struct ComparatorOf<int64_t>
+    {
+        using type = IntComparator;
+    };
+
+    template <>
+    struct ComparatorOf<std::string>
+    {
+        using type = StringComparator;
+    };
+
+    template <typename Key>
+    using List = SkipList<Key, std::string, typename ComparatorOf<Key>::type>;
+
+    static const std::string kValue(16, 'v');
+
+    template <typename Key>
+    static std::unique_ptr<List<Key>> NewList()
+    {
+        using Cmp = typename ComparatorOf<Key>::type;
+        return std::make_unique<List<Key>>(Cmp(), std::make_shared<DefaultAlloc>());
+    }
+
+    // [0, n)的一个排列：顺序分布为恒等排列，其余为随机打乱
+    template <typename Key>
+    static std::vector<Key> UniqueKeys(int64_t n, KeyDistribution dist)
+    {
+        std::vector<Key> keys;
+        keys.reserve(n);
+        for (int64_t i = 0; i < n; ++i)
+        {
+            keys.push_back(MakeKey<Key>(i));
+        }
+        if (dist != KeyDistribution::kSequential)
+        {
+            Random rnd(301);
+            for (int64_t i = n - 1; i > 0; --i)
+            {
+                std::swap(keys[i], keys[rnd.Uniform(static_cast<int>(i + 1))]);
+            }
+        }
+        return keys;
+    }
+
+    // 查询类基准共享同一张表，相同entries的多次运行只构建一次
+    template <typename Key>
+    static List<Key> *SharedList(int64_t n)
+    {
+        static std::unique_ptr<List<Key>> list;
+        static int64_t size = -1;
+        if (size != n)
+        {
+            list.reset(); // 先释放旧表，避免同时持有两张大表
+            list = NewList<Key>();
+            for (const Key &key : UniqueKeys<Key>(n, KeyDistribution::kUniform))
+            {
+                list->Insert(key, kValue);
+            }
+            size = n;
+        }
+        return list.get();
+    }
+
+    template <typename Key>
+    static void BM_SkipListInsert(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto keys = UniqueKeys<Key>(n, static_cast<KeyDistribution>(state.range(1)));
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto list = NewList<Key>();
+            state.ResumeTiming();
+            for (const Key &key : keys)
+            {
+                list->Insert(key, kValue);
+            }
+            state.PauseTiming();
+            list.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+        state.SetLabel(DistributionName(static_cast<KeyDistribution>(state.range(1))));
+    }
+
+    template <typename Key>
+    static void BM_SkipListDelete(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto dist = static_cast<KeyDistribution>(state.range(1));
+        auto keys = UniqueKeys<Key>(n, dist);
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            auto list = NewList<Key>();
+            for (const Key &key : keys)
+            {
+                list->Insert(key, kValue);
+            }
+            state.ResumeTiming();
+            for (const Key &key : keys)
+            {
+                list->Delete(key);
+            }
+            state.PauseTiming();
+            list.reset();
+            EpochManager::get_instance()->TryReclaim();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+        state.SetLabel(DistributionName(dist));
+    }
+
+    template <typename Key>
+    static void BM_SkipListGet(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto dist = static_cast<KeyDistribution>(state.range(1));
+        List<Key> *list = SharedList<Key>(n);
+        KeyGenerator gen(dist, n);
+        int64_t found = 0;
+        for (auto _ : state)
+        {
+            Key key = MakeKey<Key>(gen.Next());
+            auto v = list->Get(key);
+            found += v.has_value();
+            benchmark::DoNotOptimize(v);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["hit_rate"] = state.iterations() ? double(found) / state.iterations() : 0;
+        state.SetLabel(DistributionName(dist));
+    }
+
+    // 查询key范围是表中key的两倍，约一半未命中
+    template <typename Key>
+    static void BM_SkipListContains(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        auto dist = static_cast<KeyDistribution>(state.range(1));
+        List<Key> *list = SharedList<Key>(n);
+        KeyGenerator gen(dist, 2 * n);
+        int64_t found = 0;
+        for (auto _ : state)
+        {
+            Key key = MakeKey<Key>(gen.Next());
+            found += list->Contains(key);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["hit_rate"] = state.iterations() ? double(found) / state.iterations() : 0;
+        state.SetLabel(DistributionName(dist));
+    }
+
+    template <typename Key>
+    static void BM_SkipListIterate(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        List<Key> *list = SharedList<Key>(n);
+        for (auto _ : state)
+        {
+            typename List<Key>::SkipListIterator iter(list);
+            int64_t count = 0;
+            for (iter.MoveToFirst(); iter.Valid(); iter.Next())
+            {
+                benchmark::DoNotOptimize(iter.key());
+                ++count;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    static const std::vector<int64_t> kEntries = {10000, 100000, 1000000, 10000000};
+    static const std::vector<int64_t> kUniqueDists = {
+        static_cast<int64_t>(KeyDistribution::kSequential),
+        static_cast<int64_t>(KeyDistribution::kUniform)};
+    static const std::vector<int64_t> kAllDists = {
+        static_cast<int64_t>(KeyDistribution::kSequential),
+        static_cast<int64_t>(KeyDistribution::kUniform),
+        static_cast<int64_t>(KeyDistribution::kZipfian)};
+
+    // 旧实现：Lehmer生成器上最多kMaxHeight次OneIn(4)
+    static void BM_RandomLevelLoop(benchmark::State &state)
+    {
+        Random rnd(0xdeadbeef);
+        for (auto _ : state)
+        {
+            int level = 1;
+            while (level < 12 && rnd.OneIn(4))
+            {
+                ++level;
+            }
+            benchmark::DoNotOptimize(level);
+        }
+    }
+
+    // 新实现：一次xorshift64*，由尾部0位数直接得到层高
+    static void BM_RandomLevelCtz(benchmark::State &state)
+    {
+        FastRandom *rnd = FastRandom::GetTLSInstance();
+        for (auto _ : state)
+        {
+            uint64_t r = rnd->Next64() | (1ULL << 63);
+            int level = 1 + __builtin_ctzll(r) / 2;
+            level = level < 12 ? level : 12;
+            benchmark::DoNotOptimize(level);
+        }
+    }
+
+    // 大表点查：最大高度固定为默认值(height=0)与按数据量计算(height=1)对比，
+    // 每次Get的key比较次数应随log(entries)增长。value用int64_t以压低内存，100M条约需8GB
+    using LargeList = SkipList<int64_t, int64_t, IntComparator, 24>;
+
+    static LargeList *SharedLargeList(int64_t n, bool auto_height)
+    {
+        static std::unique_ptr<LargeList> list;
+        static int64_t size = -1;
+        static bool built_auto = false;
+        if (size != n || built_auto != auto_height)
+        {
+            list.reset();
+            int height = auto_height ? LargeList::HeightForEntries(n) : MINIKVDB_SKIPLIST_MAX_HEIGHT;
+            list = std::make_unique<LargeList>(IntComparator(), std::make_shared<DefaultAlloc>(), height);
+            for (int64_t key : UniqueKeys<int64_t>(n, KeyDistribution::kUniform))
+            {
+                list->Insert(key, key);
+            }
+            size = n;
+            built_auto = auto_height;
+        }
+        return list.get();
+    }
+
+    static void BM_SkipListGetLarge(benchmark::State &state)
+    {
+        const int64_t n = state.range(0);
+        LargeList *list = SharedLargeList(n, state.range(1) != 0);
+        KeyGenerator gen(KeyDistribution::kUniform, n);
+        PerfLevel saved = GetPerfLevel();
+        SetPerfLevel(PerfLevel::kEnableCount);
+        GetPerfContext()->Reset();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(list->Get(static_cast<int64_t>(gen.Next())));
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["max_height"] = list->GetMaxHeight();
+        state.counters["cmp_per_get"] =
+            state.iterations() ? double(GetPerfContext()->user_key_comparison_count) / state.iterations() : 0;
+        SetPerfLevel(saved);
+    }
+
+    BENCHMARK(BM_RandomLevelLoop);
+    BENCHMARK(BM_RandomLevelCtz)->ThreadRange(1, 8);
+    BENCHMARK_TEMPLATE(BM_SkipListInsert, int64_t)->ArgsProduct({kEntries, kUniqueDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_SkipListInsert, std::string)->ArgsProduct({kEntries, kUniqueDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_SkipListDelete, int64_t)->ArgsProduct({kEntries, kUniqueDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_SkipListDelete, std::string)->ArgsProduct({kEntries, kUniqueDists})->ArgNames({"entries", "dist"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_SkipListGet, int64_t)->ArgsProduct({kEntries, kAllDists})->ArgNames({"entries", "dist"});
+    BENCHMARK_TEMPLATE(BM_SkipListGet, std::string)->ArgsProduct({kEntries, kAllDists})->ArgNames({"entries", "dist"});
+    BENCHMARK_TEMPLATE(BM_SkipListContains, int64_t)->ArgsProduct({kEntries, kAllDists})->ArgNames({"entries", "dist"});
+    BENCHMARK_TEMPLATE(BM_SkipListContains, std::string)->ArgsProduct({kEntries, kAllDists})->ArgNames({"entries", "dist"});
+    BENCHMARK_TEMPLATE(BM_SkipListIterate, int64_t)->ArgsProduct({kEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_SkipListIterate, std::string)->ArgsProduct({kEntries})->ArgNames({"entries"})->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_SkipListGetLarge)
+        ->ArgsProduct({{1 << 20, 1 << 22, 1 << 24, 1 << 26, 100000000}, {0, 1}})
+        ->ArgNames({"entries", "height"});
+}
@@ -0,0 +1,295 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:12:40
+ * @LastEditTime: 2026-10-23 15:20:47
+ * @FilePath: /miniKV/bench/bench_zero_copy.cc
+ * @Description:  跳表读写路径的拷贝与分配：Get三种取值方式、Insert三种写入方式
+ *
+ * ********************************
+ *  本文件替换了全局operator new/delete的全部形式(数组、nothrow、对齐)，按线程统计分配次数与字节数，
+ *  计数器alloc_bytes_per_op/allocs_per_op即每次操作的堆分配量；
+ *  copied_bytes_per_op为每次操作拷贝的key/value字节数。
+ *  Get参数mode：0返回optional<string>(拷贝value)，1写入调用方缓冲区(复用容量)，
+ *              2 GetPinned(不拷贝)
+ *  Insert参数mode：0 const&拷贝string，1右值移动string，2 Slice内联进结点
+ *  GetHetero参数mode：0由(指针, 长度)构造临时string再查找，1透明比较器下直接用string_view查找
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/skiplist.h"
+#include "../src/memtable/comparator.h"
+#include "../src/utils/slice.h"
+
+namespace minikvdb::bench
+{
+    thread_local uint64_t tls_alloc_count = 0;
+    thread_local uint64_t tls_alloc_bytes = 0;
+}
+
+namespace
+{
+    // 所有形式的operator new/delete都经过这两个函数，保证分配与释放成对且都被计数。
+    // 标记为noinline：内联后gcc会把new表达式与free直接配对，误报-Wmismatched-new-delete
+    __attribute__((noinline)) void *CountedAlloc(size_t n, size_t alignment) noexcept
+    {
+        ++minikvdb::bench::tls_alloc_count;
+        minikvdb::bench::tls_alloc_bytes += n;
+        if (n == 0)
+        {
+            n = 1;
+        }
+        if (alignment <= alignof(std::max_align_t))
+        {
+            return std::malloc(n);
+        }
+        void *p = nullptr;
+        return posix_memalign(&p, alignment, n) == 0 ? p : nullptr;
+    }
+
+    __attribute__((noinline)) void CountedFree(void *p) noexcept { std::free(p); }
+
+    void *CountedAllocOrThrow(size_t n, size_t alignment)
+    {
+        void *p = CountedAlloc(n, alignment);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+void *operator new(size_t n) { return CountedAllocOrThrow(n, 0); }
+
+void *operator new[](size_t n) { return CountedAllocOrThrow(n, 0); }
+
+void *operator new(size_t n, const std::nothrow_t &) noexcept { return CountedAlloc(n, 0); }
+
+void *operator new[](size_t n, const std::nothrow_t &) noexcept { return CountedAlloc(n, 0); }
+
+void *operator new(size_t n, std::align_val_t al) { return CountedAllocOrThrow(n, static_cast<size_t>(al)); }
+
+void *operator new[](size_t n, std::align_val_t al) { return CountedAllocOrThrow(n, static_cast<size_t>(al)); }
+
+void *operator new(size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(n, static_cast<size_t>(al));
+}
+
+void *operator new[](size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(n, static_cast<size_t>(al));
+}
+
+void operator delete(void *p) noexcept { CountedFree(p); }
+
+void operator delete[](void *p) noexcept { CountedFree(p); }
+
+void operator delete(void *p, size_t) noexcept { CountedFree(p); }
+
+void operator delete[](void *p, size_t) noexcept { CountedFree(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept { CountedFree(p); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept { CountedFree(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { CountedFree(p); }
+
+void operator delete[](void *p, std::align_val_t) noexcept { CountedFree(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept { CountedFree(p); }
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { CountedFree(p); }
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { CountedFree(p); }
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { CountedFree(p); }
+
+namespace minikvdb::bench
+{
+    struct ZeroCopyStringComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const { return a.compare(b); }
+    };
+
+    using StringList = SkipList<std::string, std::string, ZeroCopyStringComparator>;
+    using SliceList = SkipList<Slice, Slice, SliceComparator>;
+
+    static constexpr int kKeySize = 64;
+    static constexpr int kNumKeys = 100000;
+
+    static std::string ZeroCopyKey(int i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%016d", i);
+        return std::string(buf) + std::string(kKeySize - 16, 'k');
+    }
+
+    // 分配计数清零，返回当前值用于计算差值
+    struct AllocSnapshot
+    {
+        uint64_t count = tls_alloc_count;
+        uint64_t bytes = tls_alloc_bytes;
+    };
+
+    static void ReportAllocs(benchmark::State &state, const AllocSnapshot &start, double copied_per_op)
+    {
+        double ops = static_cast<double>(state.iterations());
+        state.counters["allocs_per_op"] = (tls_alloc_count - start.count) / ops;
+        state.counters["alloc_bytes_per_op"] = (tls_alloc_bytes - start.bytes) / ops;
+        state.counters["copied_bytes_per_op"] = copied_per_op;
+    }
+
+    static StringList *SharedList(int value_size)
+    {
+        static std::unique_ptr<StringList> list;
+        static int built = -1;
+        if (built != value_size)
+        {
+            list = std::make_unique<StringList>(ZeroCopyStringComparator(), std::make_shared<DefaultAlloc>());
+            for (int i = 0; i < kNumKeys; ++i)
+            {
+                list->Insert(ZeroCopyKey(i), std::string(value_size, 'v'));
+            }
+            built = value_size;
+        }
+        return list.get();
+    }
+
+    static void BM_SkipListGetValue(benchmark::State &state)
+    {
+        const int value_size = static_cast<int>(state.range(0));
+        const int mode = static_cast<int>(state.range(1));
+        StringList *list = SharedList(value_size);
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1024; ++i)
+        {
+            keys.push_back(ZeroCopyKey((i * 7919) % kNumKeys));
+        }
+
+        std::string buf;
+        StringList::PinnedValue pinned;
+        size_t i = 0;
+        AllocSnapshot start;
+        for (auto _ : state)
+        {
+            const std::string &key = keys[i++ & 1023];
+            if (mode == 0)
+            {
+                auto v = list->Get(key);
+                benchmark::DoNotOptimize(v);
+            }
+            else if (mode == 1)
+            {
+                list->Get(key, &buf);
+                benchmark::DoNotOptimize(buf);
+            }
+            else
+            {
+                list->GetPinned(key, &pinned);
+                benchmark::DoNotOptimize(pinned.value().data());
+            }
+        }
+        pinned.Reset();
+        ReportAllocs(state, start, mode == 2 ? 0 : value_size);
+    }
+
+    BENCHMARK(BM_SkipListGetValue)
+        ->ArgsProduct({{16, 100, 1000}, {0, 1, 2}})
+        ->ArgNames({"value_size", "mode"});
+
+    static void BM_SkipListInsertCopy(benchmark::State &state)
+    {
+        const int value_size = static_cast<int>(state.range(0));
+        const int mode = static_cast<int>(state.range(1));
+        const size_t n = static_cast<size_t>(state.max_iterations);
+        std::vector<std::string> keys(n);
+        std::vector<std::string> values(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            keys[i] = ZeroCopyKey(static_cast<int>(i));
+            values[i].assign(value_size, 'v');
+        }
+        StringList strings(ZeroCopyStringComparator(), std::make_shared<DefaultAlloc>());
+        SliceList slices(SliceComparator(), std::make_shared<DefaultAlloc>());
+
+        size_t i = 0;
+        AllocSnapshot start;
+        for (auto _ : state)
+        {
+            if (mode == 0)
+            {
+                strings.Insert(keys[i], values[i]);
+            }
+            else if (mode == 1)
+            {
+                strings.Insert(std::move(keys[i]), std::move(values[i]));
+            }
+            else
+            {
+                slices.Insert(Slice(keys[i]), Slice(values[i]));
+            }
+            ++i;
+        }
+        ReportAllocs(state, start, mode == 1 ? 0 : kKeySize + value_size);
+    }
+
+    BENCHMARK(BM_SkipListInsertCopy)
+        ->ArgsProduct({{100, 1000}, {0, 1, 2}})
+        ->ArgNames({"value_size", "mode"})
+        ->Iterations(100000);
+
+    static void BM_SkipListGetHetero(benchmark::State &state)
+    {
+        const int mode = static_cast<int>(state.range(0));
+        using TransparentList = SkipList<std::string, std::string, BytewiseComparator>;
+        static std::unique_ptr<TransparentList> list;
+        if (list == nullptr)
+        {
+            list = std::make_unique<TransparentList>(BytewiseComparator(), std::make_shared<DefaultAlloc>());
+            for (int i = 0; i < kNumKeys; ++i)
+            {
+                list->Insert(ZeroCopyKey(i), "value");
+            }
+        }
+        // 调用方手里只有(指针, 长度)形式的key，例如从网络缓冲区解析出来的请求
+        std::string arena;
+        for (int i = 0; i < 1024; ++i)
+        {
+            arena += ZeroCopyKey((i * 7919) % kNumKeys);
+        }
+
+        std::string buf;
+        size_t i = 0;
+        AllocSnapshot start;
+        for (auto _ : state)
+        {
+            const char *key = arena.data() + (i++ & 1023) * kKeySize;
+            bool found;
+            if (mode == 0)
+            {
+                found = list->Get(std::string(key, kKeySize), &buf);
+            }
+            else
+            {
+                found = list->Get(std::string_view(key, kKeySize), &buf);
+            }
+            benchmark::DoNotOptimize(found);
+        }
+        ReportAllocs(state, start, mode == 0 ? kKeySize : 0);
+    }
+
+    BENCHMARK(BM_SkipListGetHetero)->Arg(0)->Arg(1)->ArgName("mode");
+}
@@ -0,0 +1,166 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 09:12:30
+ * @LastEditTime: 2026-10-19 09:12:30
+ * @FilePath: /miniKV/bench/key_generator.h
+ * @Description:  基准测试用的key分布生成器(顺序、均匀、Zipfian)
+ *
+ * ********************************
+ *  Zipfian算法参考YCSB的ZipfianGenerator(Gray et al., "Quickly Generating
+ *  Billion-Record Synthetic Databases")，并按YCSB的做法对结果做哈希打散
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_BENCH_KEY_GENERATOR_H
+#define MINIKVDB_BENCH_KEY_GENERATOR_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "../src/memtable/random.h"
+
+namespace minikvdb::bench
+{
+    enum class KeyDistribution
+    {
+        kSequential, // 0, 1, 2, ...
+        kUniform,    // [0, n)均匀分布
+        kZipfian,    // [0, n)Zipfian分布，热点key被哈希打散
+    };
+
+    inline const char *DistributionName(KeyDistribution d)
+    {
+        switch (d)
+        {
+        case KeyDistribution::kSequential:
+            return "sequential";
+        case KeyDistribution::kUniform:
+            return "uniform";
+        default:
+            return "zipfian";
+        }
+    }
+
+    // [0, 1)均匀分布的double
+    inline double NextDouble(Random &rnd)
+    {
+        return (rnd.Next() - 1) / 2147483646.0;
+    }
+
+    // [0, n)上的Zipfian分布，theta越大越倾斜
+    class ZipfianGenerator
+    {
+    public:
+        explicit ZipfianGenerator(uint64_t n, double theta = 0.99) : n_(n), theta_(theta)
+        {
+            zeta2_ = Zeta(2, theta_);
+            zetan_ = Zeta(n_, theta_);
+            alpha_ = 1.0 / (1.0 - theta_);
+            eta_ = (1 - std::pow(2.0 / n_, 1 - theta_)) / (1 - zeta2_ / zetan_);
+        }
+
+        // 返回值越小出现概率越高
+        uint64_t Next(Random &rnd) const
+        {
+            double u = NextDouble(rnd);
+            double uz = u * zetan_;
+            if (uz < 1.0)
+            {
+                return 0;
+            }
+            if (uz < 1.0 + std::pow(0.5, theta_))
+            {
+                return 1;
+            }
+            uint64_t r = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+            return r >= n_ ? n_ - 1 : r;
+        }
+
+        uint64_t GetItemCount() const { return n_; }
+
+    private:
+        static double Zeta(uint64_t n, double theta)
+        {
+            double sum = 0;
+            for (uint64_t i = 1; i <= n; ++i)
+            {
+                sum += 1.0 / std::pow(static_cast<double>(i), theta);
+            }
+            return sum;
+        }
+
+        uint64_t n_;
+        double theta_;
+        double zeta2_;
+        double zetan_;
+        double alpha_;
+        double eta_;
+    };
+
+    // 64位FNV-1a，用于打散Zipfian的热点
+    inline uint64_t FnvHash64(uint64_t v)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < 8; ++i)
+        {
+            h ^= v & 0xff;
+            h *= 0x100000001b3ULL;
+            v >>= 8;
+        }
+        return h;
+    }
+
+    // 生成[0, n)上指定分布的key编号
+    class KeyGenerator
+    {
+    public:
+        KeyGenerator(KeyDistribution dist, uint64_t n, uint32_t seed = 301)
+            : dist_(dist), n_(n), rnd_(seed), zipf_(dist == KeyDistribution::kZipfian ? n : 2)
+        {
+        }
+
+        uint64_t Next()
+        {
+            switch (dist_)
+            {
+            case KeyDistribution::kSequential:
+                return seq_++ % n_;
+            case KeyDistribution::kUniform:
+                return rnd_.Uniform(static_cast<int>(n_));
+            default:
+                return FnvHash64(zipf_.Next(rnd_)) % n_;
+            }
+        }
+
+    private:
+        KeyDistribution dist_;
+        uint64_t n_;
+        uint64_t seq_ = 0;
+        Random rnd_;
+        ZipfianGenerator zipf_;
+    };
+
+    // key编号转成实际key：整数直接使用，字符串补零到定长，保证字典序与数值序一致
+    template <typename Key>
+    inline Key MakeKey(uint64_t k);
+
+    template <>
+    inline int64_t MakeKey<int64_t>(uint64_t k)
+    {
+        return static_cast<int64_t>(k);
+    }
+
+    template <>
+    inline std::string MakeKey<std::string>(uint64_t k)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "key%016llu", static_cast<unsigned long long>(k));
+        return buf;
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 16:05:27
+ * @LastEditTime: 2026-10-23 15:14:03
+ * @FilePath: /miniKV/src/compaction/compaction_filter.h
+ * @Description: compaction filter：flush/compaction过程中由用户决定丢弃或改写每个kv
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的CompactionFilter。flush与compaction对每个key的最新版本调用一次Filter，
+ *  返回kRemove时该key被丢弃(更旧的版本在同一次合并中本就会被丢弃)，
+ *  返回kChangeValue时以new_value代替原value写出。
+ *  注意：还没有删除标记(tombstone)，若合并的输入不包含最旧的有序段(bottommost为false)，
+ *  丢弃一个key可能使更旧段中的旧版本重新可见，Filter应参考Context决定能否丢弃。
+ *  subcompaction会在多个线程中并发调用Filter，实现必须是线程安全的。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_COMPACTION_FILTER_H
+#define MINIKVDB_COMPACTION_FILTER_H
+
+#include "../memtable/ttl.h"
+
+namespace minikvdb
+{
+    template <typename Key, typename Value>
+    class CompactionFilter
+    {
+    public:
+        enum class Decision
+        {
+            kKeep,        // 原样保留
+            kRemove,      // 丢弃
+            kChangeValue, // 以new_value代替原value
+        };
+
+        struct Context
+        {
+            bool is_flush = false;      // flush(否则为compaction)
+            bool is_bottommost = false; // 输入包含最旧的数据，丢弃不会使旧版本重新可见
+        };
+
+        virtual ~CompactionFilter() = default;
+
+        /**
+         * @description:                    对一个kv做决定
+         * @param {Context} &ctx            调用场景
+         * @param {Key} &key                key
+         * @param {Value} &value            当前value
+         * @param {Value} *new_value        返回kChangeValue时写入新的value
+         * @return {*}
+         */
+        virtual Decision Filter(const Context &ctx, const Key &key, const Value &value, Value *new_value) const = 0;
+
+        virtual const char *Name() const = 0;
+    };
+
+    /*
+     * 清理过期数据的compaction filter：
+     * bottommost时直接丢弃过期的kv；否则把过期kv的value改写为空、保留过期时间，
+     * 它在读取时被视为不存在，相当于一个删除标记，遮住更旧段中的旧版本，直到合并到最旧的段时才被丢弃。
+     */
+    template <typename Key, typename Value>
+    class TtlCompactionFilter : public CompactionFilter<Key, TtlValue<Value>>
+    {
+    public:
+        using Base = CompactionFilter<Key, TtlValue<Value>>;
+
+        explicit TtlCompactionFilter(TtlClock clock = &WallClockMicros) : clock_(clock) {}
+
+        typename Base::Decision Filter(const typename Base::Context &ctx, const Key & /*key*/,
+                                       const TtlValue<Value> &value, TtlValue<Value> *new_value) const override
+        {
+            if (!value.Expired(clock_()))
+            {
+                return Base::Decision::kKeep;
+            }
+            if (ctx.is_bottommost)
+            {
+                return Base::Decision::kRemove;
+            }
+            new_value->value = Value();
+            new_value->expire_micros = value.expire_micros;
+            return Base::Decision::kChangeValue;
+        }
+
+        const char *Name() const override { return "TtlCompactionFilter"; }
+
+    private:
+        TtlClock clock_;
+    };
+}
+
+#endif
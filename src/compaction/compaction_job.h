@@ -0,0 +1,304 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 10:31:54
+ * @LastEditTime: 2026-10-23 14:05:12
+ * @FilePath: /miniKV/src/compaction/compaction_job.h
+ * @Description: compaction任务：把多个有序段合并为新的有序段
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的subcompaction：按输入中采样得到的key边界把整个key范围
+ *  切成若干段，每段独立做多路归并并产生自己的输出有序段。
+ *  第0段在调用线程上执行，其余段提交到ThreadPool的低优先级队列；
+ *  调用线程做完第0段后还会接手尚未被工作线程取走的段，最后等待latch归零。
+ *  因此即使Execute本身运行在唯一的低优先级线程上也不会死锁，没有线程池时所有段依次在调用线程上执行。
+ *  相同key只保留最新(输入中靠前)的版本，设置了compaction filter时对最新版本调用一次。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_COMPACTION_JOB_H
+#define MINIKVDB_COMPACTION_JOB_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+#include "sorted_run.h"
+
+namespace minikvdb
+{
+    struct CompactionStats
+    {
+        uint64_t bytes_read = 0;
+        uint64_t bytes_written = 0;
+        uint64_t entries_read = 0;
+        uint64_t entries_written = 0;
+        uint64_t entries_filtered = 0; // 被compaction filter丢弃的kv数
+        uint64_t micros = 0;
+        int num_subcompactions = 0;
+    };
+
+    template <typename Key, typename Value, class Comparator>
+    class CompactionJob
+    {
+    public:
+        using Run = SortedRun<Key, Value>;
+
+        /**
+         * @description:                        构造compaction任务
+         * @param {vector<const Run *>} inputs  输入有序段，按从新到旧排列
+         * @param {Comparator} cmp              key比较函数
+         * @param {int} max_subcompactions      最多切分的段数
+         * @param {CompactionFilter} *filter    compaction filter，为空时不过滤，必须是线程安全的
+         * @param {bool} bottommost             输入是否包含最旧的数据
+         * @param {ThreadPool} *pool            执行subcompaction的线程池(低优先级)，为空时在调用线程上依次执行
+         * @return {*}
+         */
+        CompactionJob(std::vector<const Run *> inputs, Comparator cmp, int max_subcompactions = 1,
+                      const CompactionFilter<Key, Value> *filter = nullptr, bool bottommost = false,
+                      ThreadPool *pool = nullptr)
+            : inputs_(std::move(inputs)), compare_(cmp),
+              max_subcompactions_(max_subcompactions < 1 ? 1 : max_subcompactions),
+              filter_(filter), bottommost_(bottommost), pool_(pool)
+        {
+        }
+
+        /**
+         * @description:    执行compaction
+         * @return {*}      输出有序段，按key范围递增排列，彼此不重叠
+         */
+        std::vector<Run> Execute();
+
+        inline const CompactionStats &GetStats() const { return stats_; }
+
+    private:
+        // 单个subcompaction负责的key范围[begin, end)，空指针表示不设边界
+        struct SubcompactionState
+        {
+            const Key *begin = nullptr;
+            const Key *end = nullptr;
+            Run output;
+            uint64_t entries_filtered = 0;
+        };
+
+        // 按各输入的大小比例采样key，再取等分位点作为切分边界
+        std::vector<Key> GenSubcompactionBoundaries();
+
+        void ProcessKeyRange(SubcompactionState *sub);
+
+        // 把subs[1..]提交到线程池，与工作线程一起处理完所有段后返回
+        void RunSubcompactions(std::vector<SubcompactionState> *subs);
+
+        std::vector<const Run *> inputs_;
+        Comparator const compare_;
+        int const max_subcompactions_;
+        const CompactionFilter<Key, Value> *const filter_;
+        bool const bottommost_;
+        ThreadPool *const pool_;
+        CompactionStats stats_;
+    };
+
+    template <typename Key, typename Value, class Comparator>
+    std::vector<SortedRun<Key, Value>> CompactionJob<Key, Value, Comparator>::Execute()
+    {
+        auto start = std::chrono::steady_clock::now();
+        stats_ = CompactionStats();
+        for (const Run *input : inputs_)
+        {
+            stats_.bytes_read += input->bytes;
+            stats_.entries_read += input->entries.size();
+        }
+
+        std::vector<Key> boundaries = GenSubcompactionBoundaries();
+        std::vector<SubcompactionState> subs(boundaries.size() + 1);
+        for (size_t i = 0; i < subs.size(); ++i)
+        {
+            subs[i].begin = i == 0 ? nullptr : &boundaries[i - 1];
+            subs[i].end = i == boundaries.size() ? nullptr : &boundaries[i];
+        }
+
+        if (pool_ == nullptr || subs.size() == 1)
+        {
+            for (SubcompactionState &sub : subs)
+            {
+                ProcessKeyRange(&sub);
+            }
+        }
+        else
+        {
+            RunSubcompactions(&subs);
+        }
+
+        std::vector<Run> outputs;
+        for (SubcompactionState &sub : subs)
+        {
+            if (!sub.output.Empty())
+            {
+                stats_.bytes_written += sub.output.bytes;
+                stats_.entries_written += sub.output.entries.size();
+                outputs.push_back(std::move(sub.output));
+            }
+            stats_.entries_filtered += sub.entries_filtered;
+        }
+        stats_.num_subcompactions = static_cast<int>(subs.size());
+        stats_.micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+        return outputs;
+    }
+
+    template <typename Key, typename Value, class Comparator>
+    void CompactionJob<Key, Value, Comparator>::RunSubcompactions(std::vector<SubcompactionState> *subs)
+    {
+        // 每个段由先认领到的一方(工作线程或调用线程)处理，latch记录处理完的段数。
+        // Execute返回后才被取出的任务认领必然失败，只会访问由shared_ptr保活的认领状态
+        struct Claims
+        {
+            explicit Claims(size_t n) : claimed(new std::atomic<bool>[n]()), done(static_cast<int>(n)) {}
+
+            std::unique_ptr<std::atomic<bool>[]> claimed;
+            CountDownLatch done;
+        };
+        auto claims = std::make_shared<Claims>(subs->size());
+        SubcompactionState *states = subs->data();
+        auto process = [this, claims, states](size_t i)
+        {
+            if (!claims->claimed[i].exchange(true))
+            {
+                ProcessKeyRange(&states[i]);
+                claims->done.CountDown();
+            }
+        };
+
+        for (size_t i = 1; i < subs->size(); ++i)
+        {
+            pool_->Schedule([process, i]()
+                            { process(i); },
+                            Priority::kLow);
+        }
+        for (size_t i = 0; i < subs->size(); ++i)
+        {
+            process(i);
+        }
+        claims->done.Wait();
+    }
+
+    template <typename Key, typename Value, class Comparator>
+    std::vector<Key> CompactionJob<Key, Value, Comparator>::GenSubcompactionBoundaries()
+    {
+        std::vector<Key> boundaries;
+        if (max_subcompactions_ <= 1)
+        {
+            return boundaries;
+        }
+
+        static const uint64_t kSamples = 128; // 每个subcompaction平均分到的样本数
+        uint64_t total = 0;
+        for (const Run *input : inputs_)
+        {
+            total += input->entries.size();
+        }
+        if (total == 0)
+        {
+            return boundaries;
+        }
+
+        std::vector<Key> samples;
+        for (const Run *input : inputs_)
+        {
+            size_t n = input->entries.size();
+            size_t want = std::max<size_t>(1, kSamples * max_subcompactions_ * n / total);
+            want = std::min(want, n);
+            for (size_t i = 0; i < want; ++i)
+            {
+                samples.push_back(input->entries[i * n / want].first);
+            }
+        }
+        std::sort(samples.begin(), samples.end(), [this](const Key &a, const Key &b)
+                  { return compare_(a, b) < 0; });
+        samples.erase(std::unique(samples.begin(), samples.end(), [this](const Key &a, const Key &b)
+                                  { return compare_(a, b) == 0; }),
+                      samples.end());
+
+        // 样本太少时减少切分数，保证每段至少有一个样本
+        int num = std::min<int>(max_subcompactions_, static_cast<int>(samples.size()));
+        for (int i = 1; i < num; ++i)
+        {
+            boundaries.push_back(samples[samples.size() * i / num]);
+        }
+        return boundaries;
+    }
+
+    template <typename Key, typename Value, class Comparator>
+    void CompactionJob<Key, Value, Comparator>::ProcessKeyRange(SubcompactionState *sub)
+    {
+        using Entry = std::pair<Key, Value>;
+        auto less = [this](const Entry &e, const Key &k)
+        { return compare_(e.first, k) < 0; };
+
+        // 每个输入在[begin, end)内的游标
+        struct Cursor
+        {
+            const Entry *pos;
+            const Entry *limit;
+            size_t input; // 输入序号，越小越新
+        };
+        std::vector<Cursor> cursors;
+        for (size_t i = 0; i < inputs_.size(); ++i)
+        {
+            const std::vector<Entry> &entries = inputs_[i]->entries;
+            const Entry *first = entries.data();
+            const Entry *last = entries.data() + entries.size();
+            if (sub->begin != nullptr)
+            {
+                first = std::lower_bound(first, last, *sub->begin, less);
+            }
+            if (sub->end != nullptr)
+            {
+                last = std::lower_bound(first, last, *sub->end, less);
+            }
+            if (first != last)
+            {
+                cursors.push_back({first, last, i});
+            }
+        }
+
+        // 小顶堆：key小的在前，key相同时新的在前
+        auto greater = [this](const Cursor &a, const Cursor &b)
+        {
+            int c = compare_(a.pos->first, b.pos->first);
+            return c != 0 ? c > 0 : a.input > b.input;
+        };
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater, std::move(cursors));
+
+        typename CompactionFilter<Key, Value>::Context ctx;
+        ctx.is_bottommost = bottommost_;
+        const Key *last_key = nullptr;
+        while (!heap.empty())
+        {
+            Cursor cur = heap.top();
+            heap.pop();
+            if (last_key == nullptr || compare_(*last_key, cur.pos->first) != 0)
+            {
+                if (FilterAndAppend(filter_, ctx, cur.pos->first, cur.pos->second, &sub->output))
+                {
+                    ++sub->entries_filtered;
+                }
+                last_key = &cur.pos->first;
+            }
+            // 否则是同一个key更旧的版本，丢弃
+            if (++cur.pos != cur.limit)
+            {
+                heap.push(cur);
+            }
+        }
+    }
+}
+
+#endif
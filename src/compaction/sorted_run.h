@@ -0,0 +1,119 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 10:02:18
+ * @LastEditTime: 2026-10-20 10:02:18
+ * @FilePath: /miniKV/src/compaction/sorted_run.h
+ * @Description: 有序段(sorted run)：memtable flush与compaction的输入输出单位
+ *
+ * ********************************
+ *  在SSTable落盘之前以内存中的有序数组代替一个SST文件：
+ *  key严格递增、不重复，bytes为所有kv的KVSizeOf之和。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_SORTED_RUN_H
+#define MINIKVDB_SORTED_RUN_H
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../memtable/kv_size.h"
+#include "../memtable/memtable.h"
+#include "compaction_filter.h"
+
+namespace minikvdb
+{
+    template <typename Key, typename Value>
+    struct SortedRun
+    {
+        uint64_t id = 0;                             // 编号，越大越新
+        std::vector<std::pair<Key, Value>> entries; // 按key有序
+        uint64_t bytes = 0;                          // kv总大小
+
+        inline bool Empty() const { return entries.empty(); }
+
+        inline const Key &Smallest() const
+        {
+            assert(!Empty());
+            return entries.front().first;
+        }
+
+        inline const Key &Largest() const
+        {
+            assert(!Empty());
+            return entries.back().first;
+        }
+
+        inline void Append(const Key &key, const Value &value)
+        {
+            entries.emplace_back(key, value);
+            bytes += KVSizeOf(key) + KVSizeOf(value);
+        }
+    };
+
+    /**
+     * @description:                        把compaction filter应用到一个kv上，需要保留时追加到run
+     * @param {CompactionFilter} *filter    为空时直接追加
+     * @param {Context} &ctx                调用场景
+     * @param {Key} &key                    key
+     * @param {Value} &value                value
+     * @param {SortedRun} *run              输出有序段
+     * @return {*}                          是否被丢弃
+     */
+    template <typename Key, typename Value>
+    bool FilterAndAppend(const CompactionFilter<Key, Value> *filter,
+                         const typename CompactionFilter<Key, Value>::Context &ctx,
+                         const Key &key, const Value &value, SortedRun<Key, Value> *run)
+    {
+        using Decision = typename CompactionFilter<Key, Value>::Decision;
+        if (filter == nullptr)
+        {
+            run->Append(key, value);
+            return false;
+        }
+        Value new_value{};
+        switch (filter->Filter(ctx, key, value, &new_value))
+        {
+        case Decision::kRemove:
+            return true;
+        case Decision::kChangeValue:
+            run->Append(key, new_value);
+            return false;
+        default:
+            run->Append(key, value);
+            return false;
+        }
+    }
+
+    /**
+     * @description:                        将memtable按key顺序导出为一个有序段，flush期间不能修改表
+     * @param {MemTable} &table             memtable
+     * @param {uint64_t} id                 有序段编号
+     * @param {CompactionFilter} *filter    compaction filter，为空时不过滤
+     * @param {bool} bottommost             没有更旧的数据(第一次flush)，filter可以放心丢弃
+     * @return {*}
+     */
+    template <typename Key, typename Value, class Comparator, class Hash>
+    SortedRun<Key, Value> FlushMemTable(const MemTable<Key, Value, Comparator, Hash> &table, uint64_t id,
+                                        const CompactionFilter<Key, Value> *filter = nullptr,
+                                        bool bottommost = false)
+    {
+        SortedRun<Key, Value> run;
+        run.id = id;
+        typename CompactionFilter<Key, Value>::Context ctx;
+        ctx.is_flush = true;
+        ctx.is_bottommost = bottommost;
+        typename MemTable<Key, Value, Comparator, Hash>::MemTableIterator iter(&table);
+        for (iter.MoveToFirst(); iter.Valid(); iter.Next())
+        {
+            FilterAndAppend(filter, ctx, iter.key(), iter.value(), &run);
+        }
+        return run;
+    }
+}
+
+#endif
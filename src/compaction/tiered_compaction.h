@@ -0,0 +1,356 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 14:20:36
+ * @LastEditTime: 2026-10-24 11:02:19
+ * @FilePath: /miniKV/src/compaction/tiered_compaction.h
+ * @Description: tiered(universal)compaction：把大小相近的有序段合并在一起
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的universal compaction。所有有序段按从新到旧排列，
+ *  每次只合并相邻的一段有序段，合并结果留在原位置，因此新旧顺序始终保持。
+ *  有序段数达到run_count_trigger后按以下顺序挑选：
+ *    1. 空间放大：除最旧段外的总大小超过最旧段的max_size_amplification_percent%时全部合并
+ *    2. 大小比例：从较新的段开始累加，下一个段不超过已选总大小的(100 + size_ratio)%就一起合并
+ *    3. 段数：以上都不满足时合并最新的若干个段，使段数回到run_count_trigger - 1
+ *  与leveled相比每个字节被重写的次数少得多(写放大低)，代价是同一个key可能存在多个版本(空间放大高)。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_TIERED_COMPACTION_H
+#define MINIKVDB_TIERED_COMPACTION_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "../utils/lock.h"
+#include "../utils/statistics.h"
+#include "compaction_job.h"
+#include "sorted_run.h"
+
+namespace minikvdb
+{
+    struct TieredCompactionOptions
+    {
+        // 百分比：下一个有序段不超过已选总大小的(100 + size_ratio)%时一起合并
+        unsigned size_ratio = 1;
+        int min_merge_width = 2;
+        int max_merge_width = INT_MAX;
+        // 有序段数达到该值才开始compaction
+        int run_count_trigger = 4;
+        // 估计的空间放大(除最旧段外的总大小 / 最旧段，百分比)超过该值时做一次全量合并
+        unsigned max_size_amplification_percent = 200;
+        // 单个compaction的最大subcompaction数，见CompactionJob
+        int max_subcompactions = 1;
+    };
+
+    enum class CompactionReason
+    {
+        kNone,
+        kSizeAmplification,
+        kSizeRatio,
+        kRunCount,
+    };
+
+    // 选中的有序段为[start, start + count)，下标按从新到旧排列
+    struct TieredCompactionPick
+    {
+        size_t start = 0;
+        size_t count = 0;
+        CompactionReason reason = CompactionReason::kNone;
+
+        inline bool Empty() const { return count == 0; }
+    };
+
+    /**
+     * @description:                            按tiered策略挑选需要合并的有序段
+     * @param {vector<uint64_t>} &run_bytes     各有序段大小，按从新到旧排列
+     * @param {TieredCompactionOptions} &opts   配置
+     * @return {*}                              不需要compaction时返回空的pick
+     */
+    inline TieredCompactionPick PickTieredCompaction(const std::vector<uint64_t> &run_bytes,
+                                                     const TieredCompactionOptions &opts)
+    {
+        TieredCompactionPick pick;
+        const size_t n = run_bytes.size();
+        const size_t min_width = static_cast<size_t>(std::max(2, opts.min_merge_width));
+        const size_t max_width = static_cast<size_t>(std::max(opts.max_merge_width, opts.min_merge_width));
+        if (n < 2 || n < static_cast<size_t>(opts.run_count_trigger))
+        {
+            return pick;
+        }
+
+        uint64_t newer_bytes = 0;
+        for (size_t i = 0; i + 1 < n; ++i)
+        {
+            newer_bytes += run_bytes[i];
+        }
+        if (newer_bytes * 100 > static_cast<uint64_t>(opts.max_size_amplification_percent) * run_bytes[n - 1])
+        {
+            pick.start = 0;
+            pick.count = n;
+            pick.reason = CompactionReason::kSizeAmplification;
+            return pick;
+        }
+
+        for (size_t start = 0; start + min_width <= n; ++start)
+        {
+            uint64_t candidate = run_bytes[start];
+            size_t end = start + 1;
+            while (end < n && end - start < max_width &&
+                   run_bytes[end] * 100 <= candidate * (100 + opts.size_ratio))
+            {
+                candidate += run_bytes[end];
+                ++end;
+            }
+            if (end - start >= min_width)
+            {
+                pick.start = start;
+                pick.count = end - start;
+                pick.reason = CompactionReason::kSizeRatio;
+                return pick;
+            }
+        }
+
+        // 合并最新的若干个段，合并后段数为run_count_trigger - 1
+        size_t count = n - static_cast<size_t>(std::max(opts.run_count_trigger, 1)) + 1;
+        pick.start = 0;
+        pick.count = std::min(n, std::max(min_width, count));
+        pick.reason = CompactionReason::kRunCount;
+        return pick;
+    }
+
+    struct TieredCompactionStats
+    {
+        uint64_t bytes_flushed = 0;             // 写入(flush)的字节数
+        uint64_t bytes_compaction_read = 0;     // compaction读入的字节数
+        uint64_t bytes_compaction_written = 0;  // compaction写出的字节数
+        uint64_t num_compactions = 0;
+        uint64_t num_runs = 0;
+        uint64_t total_bytes = 0;               // 当前所有有序段的总大小
+        uint64_t oldest_run_bytes = 0;
+
+        // 每写入一个字节总共写出的字节数
+        inline double WriteAmplification() const
+        {
+            return bytes_flushed == 0 ? 0.0 : static_cast<double>(bytes_flushed + bytes_compaction_written) / bytes_flushed;
+        }
+
+        // 以最旧(最大)段近似有效数据量，估计的空间放大 = 总大小 / 最旧段
+        inline double SpaceAmplification() const
+        {
+            return oldest_run_bytes == 0 ? 0.0 : static_cast<double>(total_bytes) / oldest_run_bytes;
+        }
+    };
+
+    /*
+     * 一组按tiered策略维护的有序段：flush产生的新段加入最前面，MaybeCompact挑选并执行一次合并。
+     * 未设置有序段锁时非线程安全；设置线程池后subcompaction在其低优先级队列中并行执行。
+     * 设置有序段锁后，挑选持有其读锁，AddRun与compaction结果的安装持有其写锁，合并本身不持有锁，
+     * 因此持有读锁的Get/GetRuns/GetStats与AddRun都可以与后台compaction并发(MaybeCompact之间仍需串行)。
+     * 有序段存放在deque中，AddRun在最前面插入不会使合并中的输入段失效；安装时按编号找回输入段的位置。
+     */
+    template <typename Key, typename Value, class Comparator>
+    class TieredCompaction
+    {
+    public:
+        using Run = SortedRun<Key, Value>;
+
+        /**
+         * @description:                            构造
+         * @param {Comparator} cmp                  key比较函数
+         * @param {TieredCompactionOptions} opts    配置
+         * @param {shared_ptr<Statistics>} stats    统计信息，为空时不记录
+         * @return {*}
+         */
+        explicit TieredCompaction(Comparator cmp, TieredCompactionOptions opts = TieredCompactionOptions(),
+                                  std::shared_ptr<Statistics> stats = nullptr)
+            : compare_(cmp), opts_(opts), stats_(std::move(stats))
+        {
+        }
+
+        // 加入flush得到的有序段，它比已有的段都新
+        void AddRun(Run run)
+        {
+            if (run.Empty())
+            {
+                return;
+            }
+            if (stats_ != nullptr)
+            {
+                stats_->RecordTick(Ticker::kFlushBytesWritten, run.bytes);
+            }
+            std::unique_lock<SharedMutexLock> lock = LockRuns();
+            stats_bytes_flushed_ += run.bytes;
+            runs_.push_front(std::move(run));
+        }
+
+        // 设置compaction filter，之后的compaction都会调用
+        void SetCompactionFilter(std::shared_ptr<const CompactionFilter<Key, Value>> filter)
+        {
+            filter_ = std::move(filter);
+        }
+
+        // 设置执行subcompaction的线程池，为空时在调用线程上执行，线程池需比本对象活得久
+        void SetThreadPool(ThreadPool *pool) { pool_ = pool; }
+
+        // 设置保护有序段集合的读写锁，为空时不加锁
+        void SetRunsMutex(SharedMutexLock *mu) { runs_mu_ = mu; }
+
+        // 按当前有序段大小挑选，不执行
+        TieredCompactionPick PickCompaction() const
+        {
+            std::vector<uint64_t> run_bytes;
+            run_bytes.reserve(runs_.size());
+            for (const Run &run : runs_)
+            {
+                run_bytes.push_back(run.bytes);
+            }
+            return PickTieredCompaction(run_bytes, opts_);
+        }
+
+        /**
+         * @description:    挑选并执行一次compaction
+         * @return {*}      执行的compaction的原因，没有需要合并的段时返回kNone
+         */
+        CompactionReason MaybeCompact()
+        {
+            TieredCompactionPick pick;
+            std::vector<const Run *> inputs;
+            bool bottommost;
+            {
+                std::shared_lock<SharedMutexLock> lock = LockRunsShared();
+                pick = PickCompaction();
+                if (pick.Empty())
+                {
+                    return CompactionReason::kNone;
+                }
+                for (size_t i = pick.start; i < pick.start + pick.count; ++i)
+                {
+                    inputs.push_back(&runs_[i]);
+                }
+                // 包含最旧的段时filter可以放心丢弃kv；之后只会在最前面加入更新的段，结论不变
+                bottommost = pick.start + pick.count == runs_.size();
+            }
+            CompactionJob<Key, Value, Comparator> job(inputs, compare_, opts_.max_subcompactions,
+                                                      filter_.get(), bottommost, pool_);
+            std::vector<Run> outputs = job.Execute();
+
+            // subcompaction的输出按key范围递增且不重叠，拼接后仍是一个有序段；编号取输入中最新的
+            Run merged;
+            merged.id = inputs.front()->id;
+            for (Run &out : outputs)
+            {
+                merged.bytes += out.bytes;
+                std::move(out.entries.begin(), out.entries.end(), std::back_inserter(merged.entries));
+            }
+            const CompactionStats &job_stats = job.GetStats();
+            {
+                std::unique_lock<SharedMutexLock> lock = LockRuns();
+                // 合并期间可能有新段加入最前面，输入段整体后移但仍然相邻
+                auto first = std::find_if(runs_.begin(), runs_.end(), [&inputs](const Run &run)
+                                          { return run.id == inputs.front()->id; });
+                auto pos = runs_.erase(first, first + pick.count);
+                if (!merged.Empty())
+                {
+                    runs_.insert(pos, std::move(merged));
+                }
+                stats_bytes_compaction_read_ += job_stats.bytes_read;
+                stats_bytes_compaction_written_ += job_stats.bytes_written;
+                ++stats_num_compactions_;
+            }
+            if (stats_ != nullptr)
+            {
+                stats_->RecordTick(Ticker::kCompactionBytesRead, job_stats.bytes_read);
+                stats_->RecordTick(Ticker::kCompactionBytesWritten, job_stats.bytes_written);
+                stats_->RecordTick(Ticker::kCompactions);
+            }
+            return pick.reason;
+        }
+
+        // 反复compaction直到不再需要
+        void CompactUntilStable()
+        {
+            while (MaybeCompact() != CompactionReason::kNone)
+            {
+            }
+        }
+
+        // 从新到旧依次查找
+        std::optional<Value> Get(const Key &key) const
+        {
+            for (const Run &run : runs_)
+            {
+                auto it = std::lower_bound(run.entries.begin(), run.entries.end(), key,
+                                           [this](const std::pair<Key, Value> &e, const Key &k)
+                                           { return compare_(e.first, k) < 0; });
+                if (it != run.entries.end() && compare_(it->first, key) == 0)
+                {
+                    return it->second;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // 按从新到旧排列的有序段
+        inline const std::deque<Run> &GetRuns() const { return runs_; }
+
+        // 只能原地改写value(如kv分离的GC搬迁blob)，不能改变key及其顺序，也不能增删有序段
+        inline std::deque<Run> &GetMutableRuns() { return runs_; }
+
+        inline const TieredCompactionOptions &GetOptions() const { return opts_; }
+
+        TieredCompactionStats GetStats() const
+        {
+            TieredCompactionStats s;
+            s.bytes_flushed = stats_bytes_flushed_;
+            s.bytes_compaction_read = stats_bytes_compaction_read_;
+            s.bytes_compaction_written = stats_bytes_compaction_written_;
+            s.num_compactions = stats_num_compactions_;
+            s.num_runs = runs_.size();
+            for (const Run &run : runs_)
+            {
+                s.total_bytes += run.bytes;
+            }
+            s.oldest_run_bytes = runs_.empty() ? 0 : runs_.back().bytes;
+            return s;
+        }
+
+    private:
+        // 持有有序段锁的写锁，未设置时返回不持有锁的unique_lock
+        std::unique_lock<SharedMutexLock> LockRuns()
+        {
+            return runs_mu_ == nullptr ? std::unique_lock<SharedMutexLock>() : std::unique_lock<SharedMutexLock>(*runs_mu_);
+        }
+
+        std::shared_lock<SharedMutexLock> LockRunsShared()
+        {
+            return runs_mu_ == nullptr ? std::shared_lock<SharedMutexLock>() : std::shared_lock<SharedMutexLock>(*runs_mu_);
+        }
+
+        Comparator const compare_;
+        TieredCompactionOptions const opts_;
+        std::shared_ptr<Statistics> stats_;
+        std::shared_ptr<const CompactionFilter<Key, Value>> filter_;
+        ThreadPool *pool_ = nullptr;
+        SharedMutexLock *runs_mu_ = nullptr;
+        std::deque<Run> runs_; // 从新到旧
+
+        uint64_t stats_bytes_flushed_ = 0;
+        uint64_t stats_bytes_compaction_read_ = 0;
+        uint64_t stats_bytes_compaction_written_ = 0;
+        uint64_t stats_num_compactions_ = 0;
+    };
+}
+
+#endif
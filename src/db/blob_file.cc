@@ -0,0 +1,228 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 14:12:45
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/src/db/blob_file.cc
+ * @Description: kv分离blob文件实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "blob_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "../utils/crc32c.h"
+
+namespace minikvdb
+{
+    void BlobIndex::EncodeTo(std::string *dst) const
+    {
+        dst->append(reinterpret_cast<const char *>(&file_number), sizeof(file_number));
+        dst->append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        dst->append(reinterpret_cast<const char *>(&size), sizeof(size));
+        dst->append(reinterpret_cast<const char *>(&crc), sizeof(crc));
+    }
+
+    bool BlobIndex::DecodeFrom(const Slice &input)
+    {
+        if (input.size() != kEncodedSize)
+        {
+            return false;
+        }
+        memcpy(&file_number, input.data(), sizeof(file_number));
+        memcpy(&offset, input.data() + 8, sizeof(offset));
+        memcpy(&size, input.data() + 16, sizeof(size));
+        memcpy(&crc, input.data() + 20, sizeof(crc));
+        return true;
+    }
+
+    BlobStorage::BlobStorage(std::string dir, std::string prefix, uint64_t target_file_size,
+                             std::shared_ptr<Statistics> stats, RateLimiter *limiter)
+        : dir_(std::move(dir)), prefix_(std::move(prefix)), target_file_size_(target_file_size),
+          stats_(std::move(stats)), limiter_(limiter)
+    {
+    }
+
+    BlobStorage::~BlobStorage()
+    {
+        if (writer_ != nullptr)
+        {
+            writer_->Close();
+        }
+        for (auto &[number, file] : files_)
+        {
+            ::close(file.fd);
+        }
+    }
+
+    std::string BlobStorage::FileName(uint64_t number) const
+    {
+        return dir_ + "/" + prefix_ + "_" + std::to_string(number) + ".blob";
+    }
+
+    bool BlobStorage::OpenNewFile(Priority pri)
+    {
+        if (writer_ != nullptr && !writer_->Close())
+        {
+            return false;
+        }
+        uint64_t number = next_number_++;
+        std::string path = FileName(number);
+        writer_ = std::make_unique<WritableFile>(limiter_, pri, 1 << 20);
+        if (!writer_->Open(path))
+        {
+            writer_.reset();
+            return false;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            writer_.reset();
+            return false;
+        }
+        ScopedLock<SharedMutexLock> lock(mu_);
+        files_[number].fd = fd;
+        current_ = number;
+        return true;
+    }
+
+    bool BlobStorage::Add(const Slice &value, BlobIndex *index, Priority pri)
+    {
+        std::lock_guard<std::mutex> write_lock(write_mu_);
+        if (writer_ == nullptr || writer_->GetFileSize() >= target_file_size_)
+        {
+            if (!OpenNewFile(pri))
+            {
+                return false;
+            }
+        }
+        else if (!writer_->SetPriority(pri))
+        {
+            return false;
+        }
+        index->file_number = current_;
+        index->offset = writer_->GetFileSize();
+        index->size = static_cast<uint32_t>(value.size());
+        index->crc = crc32c::Mask(crc32c::Value(value.data(), value.size()));
+        if (!writer_->Append(value.data(), value.size()))
+        {
+            return false;
+        }
+        {
+            ScopedLock<SharedMutexLock> lock(mu_);
+            files_[current_].total_bytes += value.size();
+            // 新写入的value在被重新统计之前都视为存活
+            files_[current_].live_bytes += value.size();
+        }
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kBlobBytesWritten, value.size());
+        }
+        return true;
+    }
+
+    bool BlobStorage::Flush(Priority pri)
+    {
+        std::lock_guard<std::mutex> write_lock(write_mu_);
+        return writer_ == nullptr || (writer_->SetPriority(pri) && writer_->Flush());
+    }
+
+    bool BlobStorage::Get(const BlobIndex &index, std::string *value) const
+    {
+        // 读完之前持有读锁，避免文件被GC关闭
+        ScopedSharedLock<SharedMutexLock> lock(mu_);
+        auto it = files_.find(index.file_number);
+        if (it == files_.end())
+        {
+            return false;
+        }
+        value->resize(index.size);
+        size_t done = 0;
+        while (done < index.size)
+        {
+            ssize_t n = ::pread(it->second.fd, &(*value)[done], index.size - done, index.offset + done);
+            if (n <= 0)
+            {
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kBlobBytesRead, index.size);
+        }
+        return crc32c::Unmask(index.crc) == crc32c::Value(value->data(), value->size());
+    }
+
+    void BlobStorage::ResetLive()
+    {
+        ScopedLock<SharedMutexLock> lock(mu_);
+        for (auto &[number, file] : files_)
+        {
+            file.live_bytes = 0;
+        }
+    }
+
+    void BlobStorage::AddLive(const BlobIndex &index)
+    {
+        ScopedLock<SharedMutexLock> lock(mu_);
+        auto it = files_.find(index.file_number);
+        if (it != files_.end())
+        {
+            it->second.live_bytes += index.size;
+        }
+    }
+
+    std::vector<uint64_t> BlobStorage::FilesToCollect(double ratio) const
+    {
+        std::vector<uint64_t> numbers;
+        ScopedSharedLock<SharedMutexLock> lock(mu_);
+        for (auto &[number, file] : files_)
+        {
+            if (number != current_ && file.total_bytes > 0 &&
+                static_cast<double>(file.total_bytes - file.live_bytes) >= ratio * file.total_bytes)
+            {
+                numbers.push_back(number);
+            }
+        }
+        return numbers;
+    }
+
+    void BlobStorage::DeleteFile(uint64_t number, uint64_t relocated_bytes)
+    {
+        ScopedLock<SharedMutexLock> lock(mu_);
+        auto it = files_.find(number);
+        if (it == files_.end() || number == current_)
+        {
+            return;
+        }
+        ::close(it->second.fd);
+        ::unlink(FileName(number).c_str());
+        files_.erase(it);
+        ++gc_files_;
+        gc_relocated_ += relocated_bytes;
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kBlobGCBytesRelocated, relocated_bytes);
+        }
+    }
+
+    BlobStorageStats BlobStorage::GetStats() const
+    {
+        BlobStorageStats s;
+        ScopedSharedLock<SharedMutexLock> lock(mu_);
+        s.num_files = files_.size();
+        for (auto &[number, file] : files_)
+        {
+            s.total_bytes += file.total_bytes;
+            s.live_bytes += file.live_bytes;
+        }
+        s.gc_files = gc_files_;
+        s.gc_relocated = gc_relocated_;
+        return s;
+    }
+}
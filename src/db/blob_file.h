@@ -0,0 +1,144 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 14:12:45
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/src/db/blob_file.h
+ * @Description: kv分离：大value写入只追加的blob文件，有序段中只保留引用
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的integrated BlobDB与WiscKey。flush时超过阈值的value写入blob文件，
+ *  有序段中只存放BlobIndex(文件号、偏移、长度、crc)，compaction只搬动这24字节的引用。
+ *  每个blob文件记录写入的总字节数；compaction后重新统计仍被引用的字节数，
+ *  垃圾比例超过阈值的文件把存活的value搬到当前文件后删除(GC)。
+ *  写入与滚动文件由内部的写入锁串行执行，flush与GC搬迁可以并发写入；存活字节统计与GC由调用方串行执行。
+ *  文件表由内部读写锁保护，Get(pread)与GetStats持有读锁，可以与后台写入、删除文件并发。
+ *  设置了限速器时按调用方给出的优先级申请令牌：flush时写入用kHigh，GC搬迁用kLow。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_BLOB_FILE_H
+#define MINIKVDB_BLOB_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../utils/lock.h"
+#include "../utils/rate_limiter.h"
+#include "../utils/slice.h"
+#include "../utils/statistics.h"
+#include "../utils/writable_file.h"
+
+namespace minikvdb
+{
+    struct BlobIndex
+    {
+        static const size_t kEncodedSize = 24;
+
+        uint64_t file_number = 0;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+        uint32_t crc = 0; // 掩码后的crc32c
+
+        void EncodeTo(std::string *dst) const;
+
+        bool DecodeFrom(const Slice &input);
+    };
+
+    struct BlobStorageStats
+    {
+        uint64_t num_files = 0;
+        uint64_t total_bytes = 0;   // 所有blob文件的大小
+        uint64_t live_bytes = 0;    // 上次统计时仍被引用的字节数
+        uint64_t gc_files = 0;      // GC删除的文件数
+        uint64_t gc_relocated = 0;  // GC搬迁的存活字节数
+
+        inline uint64_t GarbageBytes() const { return total_bytes - live_bytes; }
+    };
+
+    class BlobStorage
+    {
+    public:
+        /**
+         * @description:                            构造
+         * @param {string} dir                      blob文件所在目录
+         * @param {string} prefix                   文件名前缀，文件名为<dir>/<prefix>_<number>.blob
+         * @param {uint64_t} target_file_size       当前文件超过该大小后换新文件
+         * @param {shared_ptr<Statistics>} stats    统计信息，为空时不记录
+         * @param {RateLimiter} *limiter            限速器，为空时不限速
+         * @return {*}
+         */
+        BlobStorage(std::string dir, std::string prefix, uint64_t target_file_size,
+                    std::shared_ptr<Statistics> stats = nullptr, RateLimiter *limiter = nullptr);
+
+        ~BlobStorage();
+
+        BlobStorage(const BlobStorage &) = delete;
+        BlobStorage &operator=(const BlobStorage &) = delete;
+
+        /**
+         * @description:                把value追加到当前blob文件
+         * @param {Slice} &value        value
+         * @param {BlobIndex} *index    输出引用
+         * @param {Priority} pri        向限速器申请令牌的优先级
+         * @return {*}
+         */
+        bool Add(const Slice &value, BlobIndex *index, Priority pri);
+
+        // 把当前文件的缓冲写入内核，之后新写入的value才能被Get读到。
+        // 有序段只在内存中，重启时以WAL为准，因此不需要fdatasync
+        bool Flush(Priority pri);
+
+        // 按引用读取value并校验crc
+        bool Get(const BlobIndex &index, std::string *value) const;
+
+        // 重新统计存活字节数：先Reset，再对每个仍被引用的BlobIndex调用AddLive
+        void ResetLive();
+
+        void AddLive(const BlobIndex &index);
+
+        // 垃圾比例不低于ratio的文件(不含当前文件)
+        std::vector<uint64_t> FilesToCollect(double ratio) const;
+
+        // 删除已不再被引用的文件
+        void DeleteFile(uint64_t number, uint64_t relocated_bytes);
+
+        BlobStorageStats GetStats() const;
+
+        std::string FileName(uint64_t number) const;
+
+    private:
+        struct BlobFile
+        {
+            int fd = -1; // 只读，供pread
+            uint64_t total_bytes = 0;
+            uint64_t live_bytes = 0;
+        };
+
+        // 持有write_mu_调用
+        bool OpenNewFile(Priority pri);
+
+        std::string const dir_;
+        std::string const prefix_;
+        uint64_t const target_file_size_;
+        std::shared_ptr<Statistics> stats_;
+        RateLimiter *const limiter_;
+
+        mutable SharedMutexLock mu_; // 保护files_、current_及GC计数
+        std::map<uint64_t, BlobFile> files_;
+        std::mutex write_mu_;        // 串行化写入方，保护writer_与next_number_
+        std::unique_ptr<WritableFile> writer_;
+        uint64_t current_ = 0; // 当前写入的文件号，0表示还没有文件
+        uint64_t next_number_ = 1;
+        uint64_t gc_files_ = 0;
+        uint64_t gc_relocated_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,496 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/src/db/column_family.h
+ * @Description: 列族(column family)：逻辑上独立的keyspace
+ *
+ * ********************************
+ *  每个列族有自己的memtable、Comparator、有序段集合与compaction配置，
+ *  Comparator是模板参数，通过ColumnFamily接口做类型擦除，DB只通过接口访问列族。
+ *  memtable与有序段中存放的value带一个类型字节(kTypeValue/kTypeDeletion)：
+ *  有序段中可能还有旧版本，Delete需要写入删除标记，合并到最旧的段时才真正丢弃。
+ *  开启kv分离后，flush时不小于min_blob_size的value写入blob文件(blob_file.h)，
+ *  有序段中只存放类型为kTypeBlobIndex的引用；每次flush/compaction后重新统计各blob文件的存活字节，
+ *  垃圾比例达到blob_gc_garbage_ratio的文件把存活value搬到当前文件后删除。
+ *  flush分两步：DB持有写锁时把写满的memtable换成只读的immutable memtable(SwitchMemTable)，
+ *  之后在后台线程中导出为有序段(FlushImmutable)并合并(CompactRuns)，导出完成前immutable memtable仍然可读。
+ *  memtable由DB的锁保护；immutable memtable、有序段集合的变更持有列族的读写锁，读取持有其读锁。
+ *  compaction与blob GC由compaction_mu_串行执行；flush不获取它，只在加入有序段时短暂持有写锁，
+ *  因此flush不会等待正在进行的compaction。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_COLUMN_FAMILY_H
+#define MINIKVDB_COLUMN_FAMILY_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../compaction/compaction_filter.h"
+#include "../compaction/sorted_run.h"
+#include "../compaction/tiered_compaction.h"
+#include "../memory/default_alloc.h"
+#include "../memtable/memtable.h"
+#include "../utils/lock.h"
+#include "../utils/rate_limiter.h"
+#include "../utils/slice.h"
+#include "../utils/statistics.h"
+#include "../utils/thread_pool.h"
+#include "blob_file.h"
+#include "write_batch.h"
+
+namespace minikvdb
+{
+    struct ColumnFamilyOptions
+    {
+        MemTableRepType memtable_rep = MemTableRepType::kSkipList;
+        // memtable内存占用超过该值时flush为有序段
+        int64_t write_buffer_size = 4 << 20;
+        TieredCompactionOptions compaction;
+        // 用户的compaction filter，看到的是不带类型字节的value，不会看到删除标记
+        std::shared_ptr<const CompactionFilter<std::string, std::string>> compaction_filter;
+
+        // kv分离：flush时不小于min_blob_size的value写入blob文件，有序段中只保留引用
+        bool enable_blob_files = false;
+        size_t min_blob_size = 4096;
+        uint64_t blob_file_size = 256 << 20;
+        std::string blob_dir = "."; // blob文件名为<blob_dir>/<列族名>_<编号>.blob
+        // 垃圾字节占文件大小的比例达到该值时回收该文件
+        double blob_gc_garbage_ratio = 0.5;
+        // blob文件写入的限速器，flush时以高优先级、GC搬迁以低优先级申请令牌；为空时DB使用DBOptions::rate_limiter
+        std::shared_ptr<RateLimiter> rate_limiter;
+    };
+
+    class ColumnFamily
+    {
+    public:
+        ColumnFamily(uint32_t id, std::string name, ColumnFamilyOptions options)
+            : id_(id), name_(std::move(name)), options_(std::move(options))
+        {
+        }
+
+        virtual ~ColumnFamily() = default;
+
+        ColumnFamily(const ColumnFamily &) = delete;
+        ColumnFamily &operator=(const ColumnFamily &) = delete;
+
+        inline uint32_t GetID() const { return id_; }
+
+        inline const std::string &GetName() const { return name_; }
+
+        inline const ColumnFamilyOptions &GetOptions() const { return options_; }
+
+        // 写入memtable，已存在的key被覆盖
+        virtual void Put(const Slice &key, const Slice &value) = 0;
+
+        virtual void Delete(const Slice &key) = 0;
+
+        // 依次查找memtable、immutable memtable与从新到旧的有序段，遇到删除标记即返回false
+        virtual bool Get(const Slice &key, std::string *value) = 0;
+
+        virtual int64_t GetMemTableUsage() = 0;
+
+        inline bool NeedsFlush() { return GetMemTableUsage() >= options_.write_buffer_size; }
+
+        /**
+         * @description:    持有DB写锁调用：memtable转为immutable memtable并换上新的memtable
+         * @return {*}      memtable为空时返回false；调用前上一个immutable memtable必须已经flush完成
+         */
+        virtual bool SwitchMemTable() = 0;
+
+        // 上一次SwitchMemTable得到的immutable memtable是否还未flush完成
+        virtual bool HasImmutable() = 0;
+
+        // 后台调用：immutable memtable导出为编号为run_id的有序段，加入有序段集合后移除immutable memtable
+        virtual void FlushImmutable(uint64_t run_id) = 0;
+
+        /**
+         * @description:    后台调用：按compaction配置合并有序段直到不再需要，随后回收blob文件
+         * @return {*}      执行的compaction次数
+         */
+        virtual uint64_t CompactRuns() = 0;
+
+        virtual size_t GetNumRuns() const = 0;
+
+        virtual TieredCompactionStats GetCompactionStats() const = 0;
+
+        // 未开启kv分离时全部为0
+        virtual BlobStorageStats GetBlobStats() const = 0;
+
+    private:
+        uint32_t const id_;
+        std::string const name_;
+        ColumnFamilyOptions const options_;
+    };
+
+    /*
+     * 处理删除标记并转调用户filter：删除标记在bottommost时丢弃，其余时候保留；
+     * 用户filter在非bottommost时返回kRemove会改写为删除标记，避免旧版本重新可见。
+     * blob引用在有用户filter时读出value再交给用户filter，kChangeValue的结果以内联value写出
+     */
+    class InternalCompactionFilter final : public CompactionFilter<std::string, std::string>
+    {
+    public:
+        InternalCompactionFilter(std::shared_ptr<const CompactionFilter<std::string, std::string>> user,
+                                 const BlobStorage *blobs)
+            : user_(std::move(user)), blobs_(blobs)
+        {
+        }
+
+        Decision Filter(const Context &ctx, const std::string &key, const std::string &value,
+                        std::string *new_value) const override
+        {
+            if (value.empty() || static_cast<uint8_t>(value[0]) == kTypeDeletion)
+            {
+                return ctx.is_bottommost ? Decision::kRemove : Decision::kKeep;
+            }
+            if (user_ == nullptr)
+            {
+                return Decision::kKeep;
+            }
+            std::string stored_value;
+            if (static_cast<uint8_t>(value[0]) == kTypeBlobIndex)
+            {
+                BlobIndex index;
+                if (blobs_ == nullptr || !index.DecodeFrom(Slice(value.data() + 1, value.size() - 1)) ||
+                    !blobs_->Get(index, &stored_value))
+                {
+                    // 读不到blob时保留引用，不让用户filter看到错误的value
+                    return Decision::kKeep;
+                }
+            }
+            else
+            {
+                stored_value = value.substr(1);
+            }
+            std::string user_value;
+            switch (user_->Filter(ctx, key, stored_value, &user_value))
+            {
+            case Decision::kRemove:
+                if (ctx.is_bottommost)
+                {
+                    return Decision::kRemove;
+                }
+                new_value->assign(1, static_cast<char>(kTypeDeletion));
+                return Decision::kChangeValue;
+            case Decision::kChangeValue:
+                new_value->assign(1, static_cast<char>(kTypeValue));
+                new_value->append(user_value);
+                return Decision::kChangeValue;
+            default:
+                return Decision::kKeep;
+            }
+        }
+
+        const char *Name() const override { return "InternalCompactionFilter"; }
+
+    private:
+        std::shared_ptr<const CompactionFilter<std::string, std::string>> user_;
+        const BlobStorage *blobs_;
+    };
+
+    template <class Comparator>
+    class ColumnFamilyImpl final : public ColumnFamily
+    {
+    public:
+        using Table = MemTable<std::string, std::string, Comparator>;
+
+        ColumnFamilyImpl(uint32_t id, std::string name, ColumnFamilyOptions options, Comparator cmp,
+                         std::shared_ptr<Statistics> stats, ThreadPool *pool = nullptr)
+            : ColumnFamily(id, std::move(name), std::move(options)), cmp_(cmp), stats_(std::move(stats)),
+              blobs_(GetOptions().enable_blob_files
+                         ? std::make_unique<BlobStorage>(GetOptions().blob_dir, GetName(),
+                                                         GetOptions().blob_file_size, stats_,
+                                                         GetOptions().rate_limiter.get())
+                         : nullptr),
+              filter_(std::make_shared<InternalCompactionFilter>(GetOptions().compaction_filter, blobs_.get())),
+              compaction_(cmp, GetOptions().compaction, stats_)
+        {
+            compaction_.SetCompactionFilter(filter_);
+            compaction_.SetThreadPool(pool);
+            compaction_.SetRunsMutex(&mu_);
+            table_ = NewTable();
+        }
+
+        void Put(const Slice &key, const Slice &value) override
+        {
+            std::string internal_value;
+            internal_value.reserve(value.size() + 1);
+            internal_value.push_back(static_cast<char>(kTypeValue));
+            internal_value.append(value.data(), value.size());
+            Replace(key.ToString(), std::move(internal_value));
+        }
+
+        void Delete(const Slice &key) override
+        {
+            std::string k = key.ToString();
+            bool has_older;
+            {
+                ScopedSharedLock<SharedMutexLock> lock(mu_);
+                has_older = imm_ != nullptr || !compaction_.GetRuns().empty();
+            }
+            if (!has_older)
+            {
+                // 没有更旧的数据，直接删除即可；只有SwitchMemTable(同样持有DB写锁)会产生更旧的数据
+                table_->Delete(k);
+                return;
+            }
+            Replace(std::move(k), std::string(1, static_cast<char>(kTypeDeletion)));
+        }
+
+        bool Get(const Slice &key, std::string *value) override
+        {
+            std::string k = key.ToString();
+            std::optional<std::string> found = table_->Get(k);
+            // 读完blob之前持有读锁，GC改写引用与删除文件都在写锁之后
+            ScopedSharedLock<SharedMutexLock> lock(mu_);
+            if (!found.has_value() && imm_ != nullptr)
+            {
+                found = imm_->Get(k);
+            }
+            if (!found.has_value())
+            {
+                found = compaction_.Get(k);
+            }
+            if (!found.has_value() || found->empty() || static_cast<uint8_t>((*found)[0]) == kTypeDeletion)
+            {
+                return false;
+            }
+            BlobIndex index;
+            if (DecodeBlobIndex(*found, &index))
+            {
+                return blobs_ != nullptr && blobs_->Get(index, value);
+            }
+            value->assign(found->data() + 1, found->size() - 1);
+            return true;
+        }
+
+        int64_t GetMemTableUsage() override { return table_->GetMemUsage(); }
+
+        bool SwitchMemTable() override
+        {
+            if (table_->GetSize() == 0)
+            {
+                return false;
+            }
+            ScopedLock<SharedMutexLock> lock(mu_);
+            imm_ = std::move(table_);
+            table_ = NewTable();
+            return true;
+        }
+
+        bool HasImmutable() override
+        {
+            ScopedSharedLock<SharedMutexLock> lock(mu_);
+            return imm_ != nullptr;
+        }
+
+        void FlushImmutable(uint64_t run_id) override
+        {
+            // 同一列族同时最多一个flush，只有本函数会移除imm_，导出与写blob不需要持有mu_
+            bool bottommost;
+            {
+                // 只有flush会加入有序段，此时为空则直到本次AddRun之前一直为空
+                ScopedSharedLock<SharedMutexLock> lock(mu_);
+                bottommost = compaction_.GetRuns().empty();
+            }
+            auto run = FlushMemTable(*imm_, run_id, filter_.get(), bottommost);
+            {
+                // 写blob到加入有序段之间不能插入GC的存活统计，否则刚写入的blob会被当作垃圾
+                std::unique_lock<std::mutex> blob_lock(blob_mu_, std::defer_lock);
+                if (blobs_ != nullptr)
+                {
+                    blob_lock.lock();
+                    ExtractBlobs(&run);
+                }
+                // 先加入有序段再移除immutable memtable，读者在任何时刻都能看到这批数据
+                compaction_.AddRun(std::move(run));
+            }
+            std::unique_ptr<Table> imm;
+            {
+                ScopedLock<SharedMutexLock> lock(mu_);
+                imm = std::move(imm_);
+            }
+        }
+
+        uint64_t CompactRuns() override
+        {
+            std::lock_guard<std::mutex> compaction_lock(compaction_mu_);
+            const uint64_t before = GetCompactionStats().num_compactions;
+            compaction_.CompactUntilStable();
+            if (blobs_ != nullptr)
+            {
+                MaybeCollectGarbage();
+            }
+            return GetCompactionStats().num_compactions - before;
+        }
+
+        size_t GetNumRuns() const override
+        {
+            ScopedSharedLock<SharedMutexLock> lock(mu_);
+            return compaction_.GetRuns().size();
+        }
+
+        TieredCompactionStats GetCompactionStats() const override
+        {
+            ScopedSharedLock<SharedMutexLock> lock(mu_);
+            return compaction_.GetStats();
+        }
+
+        BlobStorageStats GetBlobStats() const override
+        {
+            return blobs_ == nullptr ? BlobStorageStats() : blobs_->GetStats();
+        }
+
+    private:
+        std::unique_ptr<Table> NewTable()
+        {
+            auto table = std::make_unique<Table>(cmp_, std::make_shared<DefaultAlloc>(), GetOptions().memtable_rep);
+            table->SetStatistics(stats_);
+            return table;
+        }
+
+        // memtable的Insert会忽略已存在的key，覆盖时先删除旧值
+        void Replace(std::string key, std::string internal_value)
+        {
+            if (table_->Contains(key))
+            {
+                table_->Delete(key);
+            }
+            table_->Insert(std::move(key), std::move(internal_value));
+        }
+
+        // 大value写入blob文件并替换为引用，写入失败的value保持内联。
+        // 写停顿的写入在等待flush，按高优先级(与WAL相同)申请令牌
+        void ExtractBlobs(SortedRun<std::string, std::string> *run)
+        {
+            const size_t min_size = GetOptions().min_blob_size;
+            std::string blob_value;
+            for (auto &[key, value] : run->entries)
+            {
+                if (value.empty() || static_cast<uint8_t>(value[0]) != kTypeValue || value.size() - 1 < min_size)
+                {
+                    continue;
+                }
+                BlobIndex index;
+                if (!blobs_->Add(Slice(value.data() + 1, value.size() - 1), &index, Priority::kHigh))
+                {
+                    continue;
+                }
+                run->bytes -= KVSizeOf(value);
+                blob_value.assign(1, static_cast<char>(kTypeBlobIndex));
+                index.EncodeTo(&blob_value);
+                value.swap(blob_value);
+                run->bytes += KVSizeOf(value);
+            }
+            // 有序段中的引用可能立即被读取，先让blob数据对pread可见
+            blobs_->Flush(Priority::kHigh);
+        }
+
+        // 持有compaction_mu_调用：统计仍被有序段引用的blob字节，搬迁垃圾比例过高的文件中存活的value后删除文件。
+        // 统计与挑选持有blob_mu_与读锁；搬迁(读写blob)不持有锁，可以与flush并发，
+        // 新的引用最后在写锁下一次性改写，之后才删除旧文件
+        void MaybeCollectGarbage()
+        {
+            std::map<uint64_t, uint64_t> relocated;               // 文件号 -> 搬迁字节数
+            std::vector<std::pair<std::string *, BlobIndex>> moves; // 需要搬迁的引用及其当前位置
+            {
+                std::lock_guard<std::mutex> blob_lock(blob_mu_);
+                ScopedSharedLock<SharedMutexLock> lock(mu_);
+                auto &runs = compaction_.GetMutableRuns();
+                BlobIndex index;
+                blobs_->ResetLive();
+                for (auto &run : runs)
+                {
+                    for (auto &[key, value] : run.entries)
+                    {
+                        if (DecodeBlobIndex(value, &index))
+                        {
+                            blobs_->AddLive(index);
+                        }
+                    }
+                }
+                // 当前文件不会被选中，之后的flush只写当前文件或更新的文件
+                std::vector<uint64_t> victims = blobs_->FilesToCollect(GetOptions().blob_gc_garbage_ratio);
+                if (victims.empty())
+                {
+                    return;
+                }
+                for (uint64_t number : victims)
+                {
+                    relocated[number] = 0;
+                }
+                for (auto &run : runs)
+                {
+                    for (auto &[key, value] : run.entries)
+                    {
+                        if (DecodeBlobIndex(value, &index) && relocated.count(index.file_number) != 0)
+                        {
+                            moves.emplace_back(&value, index);
+                        }
+                    }
+                }
+            }
+
+            // 有序段只在compaction_mu_下被合并，flush只在最前面加入新段，这些value的地址不会失效
+            std::string blob;
+            std::vector<std::pair<std::string *, BlobIndex>> rewrites;
+            for (auto &[value, index] : moves)
+            {
+                BlobIndex new_index;
+                if (!blobs_->Get(index, &blob) || !blobs_->Add(blob, &new_index, Priority::kLow))
+                {
+                    // 搬迁失败时旧文件仍被引用，本轮不删除任何文件
+                    return;
+                }
+                rewrites.emplace_back(value, new_index);
+                relocated[index.file_number] += index.size;
+            }
+            if (!blobs_->Flush(Priority::kLow))
+            {
+                return;
+            }
+            {
+                ScopedLock<SharedMutexLock> lock(mu_);
+                for (auto &[value, new_index] : rewrites)
+                {
+                    // 引用长度固定，改写后有序段大小不变
+                    value->resize(1);
+                    new_index.EncodeTo(value);
+                }
+            }
+            for (auto &[number, bytes] : relocated)
+            {
+                blobs_->DeleteFile(number, bytes);
+            }
+        }
+
+        static bool DecodeBlobIndex(const std::string &value, BlobIndex *index)
+        {
+            return !value.empty() && static_cast<uint8_t>(value[0]) == kTypeBlobIndex &&
+                   index->DecodeFrom(Slice(value.data() + 1, value.size() - 1));
+        }
+
+        Comparator const cmp_;
+        std::shared_ptr<Statistics> stats_;
+        std::unique_ptr<BlobStorage> blobs_;
+        std::shared_ptr<InternalCompactionFilter> filter_;
+        TieredCompaction<std::string, std::string, Comparator> compaction_;
+        std::unique_ptr<Table> table_;
+
+        mutable SharedMutexLock mu_;     // 保护imm_与有序段集合
+        std::unique_ptr<Table> imm_;     // 等待后台flush的immutable memtable
+        std::mutex compaction_mu_;       // 串行执行本列族的compaction与blob GC，flush不获取
+        std::mutex blob_mu_;             // flush写blob到加入有序段之间持有，排斥GC的存活统计
+    };
+}
+
+#endif
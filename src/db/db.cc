@@ -0,0 +1,361 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-24 11:02:19
+ * @FilePath: /miniKV/src/db/db.cc
+ * @Description: DB实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "db.h"
+
+#include <unistd.h>
+
+namespace minikvdb
+{
+    class DB::MemTableInserter final : public WriteBatch::Handler
+    {
+    public:
+        // apply为false时只检查列族是否存在
+        MemTableInserter(DB *db, bool apply) : db_(db), apply_(apply) {}
+
+        void Put(uint32_t cf_id, const Slice &key, const Slice &value) override
+        {
+            if (Check(cf_id) && apply_)
+            {
+                db_->column_families_[cf_id]->Put(key, value);
+            }
+        }
+
+        void Delete(uint32_t cf_id, const Slice &key) override
+        {
+            if (Check(cf_id) && apply_)
+            {
+                db_->column_families_[cf_id]->Delete(key);
+            }
+        }
+
+        inline bool Ok() const { return ok_; }
+
+    private:
+        bool Check(uint32_t cf_id)
+        {
+            ok_ = ok_ && cf_id < db_->column_families_.size();
+            return ok_;
+        }
+
+        DB *db_;
+        bool apply_;
+        bool ok_ = true;
+    };
+
+    DB::DB(DBOptions options)
+        : options_(std::move(options)),
+          pool_(options_.thread_pool != nullptr ? options_.thread_pool : std::make_shared<ThreadPool>())
+    {
+        CreateColumnFamily(kDefaultColumnFamilyName);
+    }
+
+    DB::~DB()
+    {
+        // 后台任务引用列族，线程池也可能在多个DB间共享，析构前必须等它们结束
+        WaitForBackgroundWork();
+        if (wal_ != nullptr)
+        {
+            wal_->Close();
+        }
+    }
+
+    bool DB::Open()
+    {
+        ScopedLock<SharedMutexLock> lock(mu_);
+        if (opened_)
+        {
+            return false;
+        }
+        uint64_t wal_records = 0;
+        bool wal_truncated = false;
+        if (!options_.wal_path.empty())
+        {
+            if (::access(options_.wal_path.c_str(), F_OK) == 0)
+            {
+                WalReader reader;
+                if (!reader.Open(options_.wal_path))
+                {
+                    LOG_EVENT(options_.info_log.get(), kLogError, "db.open.failed", {"wal", options_.wal_path},
+                              {"reason", "open wal for recovery"});
+                    return false;
+                }
+                std::string record;
+                WriteBatch batch;
+                while (reader.ReadRecord(&record))
+                {
+                    if (!batch.SetData(record) || !ApplyBatch(batch))
+                    {
+                        LOG_EVENT(options_.info_log.get(), kLogError, "db.open.failed", {"wal", options_.wal_path},
+                                  {"reason", "corrupted batch"}, {"record", wal_records});
+                        return false;
+                    }
+                    ++wal_records;
+                    last_sequence_ = batch.Sequence() + batch.Count() - 1;
+                    // 重放时还没有读者，持有mu_等待上一次flush即可
+                    MaybeFlush(true);
+                }
+                // 损坏处之后可能还有已确认的写入，默认不能静默丢弃
+                if (reader.IsCorrupted() && !options_.wal_tolerate_corruption)
+                {
+                    LOG_EVENT(options_.info_log.get(), kLogError, "db.open.failed", {"wal", options_.wal_path},
+                              {"reason", "corrupted wal record"}, {"record", wal_records},
+                              {"offset", reader.GetValidSize()});
+                    return false;
+                }
+                if (reader.IsCorrupted())
+                {
+                    LOG_EVENT(options_.info_log.get(), kLogWarn, "wal.corruption.dropped", {"wal", options_.wal_path},
+                              {"record", wal_records}, {"offset", reader.GetValidSize()});
+                }
+                // 丢弃崩溃时未写完的尾部(或容忍的损坏处之后的内容)，否则之后追加的记录会跟在损坏的数据后面
+                wal_truncated = reader.IsTruncated() || reader.IsCorrupted();
+                if (wal_truncated && ::truncate(options_.wal_path.c_str(), reader.GetValidSize()) != 0)
+                {
+                    LOG_EVENT(options_.info_log.get(), kLogError, "db.open.failed", {"wal", options_.wal_path},
+                              {"reason", "truncate wal tail"});
+                    return false;
+                }
+            }
+            wal_ = std::make_unique<WalWriter>(options_.wal_use_direct_io, options_.stats, options_.rate_limiter.get());
+            if (!wal_->Open(options_.wal_path))
+            {
+                wal_.reset();
+                LOG_EVENT(options_.info_log.get(), kLogError, "db.open.failed", {"wal", options_.wal_path},
+                          {"reason", "open wal for append"});
+                return false;
+            }
+        }
+        opened_ = true;
+        LOG_EVENT(options_.info_log.get(), kLogInfo, "db.open", {"wal", options_.wal_path},
+                  {"column_families", column_families_.size()}, {"wal_records", wal_records},
+                  {"wal_truncated", wal_truncated}, {"last_sequence", last_sequence_});
+        return true;
+    }
+
+    ColumnFamily *DB::GetColumnFamily(const std::string &name)
+    {
+        for (auto &cf : column_families_)
+        {
+            if (cf->GetName() == name)
+            {
+                return cf.get();
+            }
+        }
+        return nullptr;
+    }
+
+    bool DB::Put(ColumnFamily *cf, const Slice &key, const Slice &value)
+    {
+        WriteBatch batch;
+        batch.Put(cf->GetID(), key, value);
+        return Write(&batch);
+    }
+
+    bool DB::Delete(ColumnFamily *cf, const Slice &key)
+    {
+        WriteBatch batch;
+        batch.Delete(cf->GetID(), key);
+        return Write(&batch);
+    }
+
+    bool DB::Write(WriteBatch *batch)
+    {
+        if (batch->Count() == 0)
+        {
+            return true;
+        }
+        WaitForWriteStall();
+        ScopedLock<SharedMutexLock> lock(mu_);
+        if (!opened_)
+        {
+            return false;
+        }
+        // 先检查再写WAL，保证写入日志的批次一定能被重放
+        MemTableInserter checker(this, false);
+        if (!batch->Iterate(&checker) || !checker.Ok())
+        {
+            return false;
+        }
+        batch->SetSequence(last_sequence_ + 1);
+        if (wal_ != nullptr && !wal_->AddRecord(batch->Data(), options_.sync_wal))
+        {
+            LOG_EVENT(options_.info_log.get(), kLogError, "wal.write.failed", {"wal", options_.wal_path},
+                      {"sequence", last_sequence_ + 1}, {"bytes", batch->Data().size()});
+            return false;
+        }
+        ApplyBatch(*batch);
+        last_sequence_ += batch->Count();
+        MaybeFlush(false);
+        return true;
+    }
+
+    bool DB::Get(ColumnFamily *cf, const Slice &key, std::string *value)
+    {
+        ScopedSharedLock<SharedMutexLock> lock(mu_);
+        return cf->Get(key, value);
+    }
+
+    bool DB::Flush(ColumnFamily *cf)
+    {
+        for (;;)
+        {
+            // 在mu_之外等待上一次flush，不阻塞读
+            {
+                std::unique_lock<std::mutex> lock(bg_mu_);
+                bg_cv_.wait(lock, [cf]
+                            { return !cf->HasImmutable(); });
+            }
+            ScopedLock<SharedMutexLock> lock(mu_);
+            // immutable memtable只在mu_下产生，等待之后可能又有写入换下了memtable
+            if (!cf->HasImmutable())
+            {
+                ScheduleFlush(cf, "manual");
+                break;
+            }
+        }
+        WaitForBackgroundWork();
+        return true;
+    }
+
+    void DB::WaitForWriteStall()
+    {
+        std::unique_lock<std::mutex> lock(bg_mu_);
+        bg_cv_.wait(lock, [this]
+                    { return !write_stalled_; });
+    }
+
+    void DB::WaitForBackgroundWork()
+    {
+        std::unique_lock<std::mutex> lock(bg_mu_);
+        bg_cv_.wait(lock, [this]
+                    { return bg_jobs_ == 0; });
+    }
+
+    uint64_t DB::GetLatestSequence()
+    {
+        ScopedSharedLock<SharedMutexLock> lock(mu_);
+        return last_sequence_;
+    }
+
+    bool DB::ApplyBatch(const WriteBatch &batch)
+    {
+        MemTableInserter inserter(this, true);
+        return batch.Iterate(&inserter) && inserter.Ok();
+    }
+
+    void DB::MaybeFlush(bool wait)
+    {
+        for (auto &cf : column_families_)
+        {
+            if (!cf->NeedsFlush())
+            {
+                continue;
+            }
+            // 最多一个immutable memtable。检查与设置写停顿都持有bg_mu_，flush完成后才会解除，不会错过
+            {
+                std::unique_lock<std::mutex> lock(bg_mu_);
+                if (wait)
+                {
+                    // 后台flush不获取mu_，不会死锁
+                    bg_cv_.wait(lock, [&cf]
+                                { return !cf->HasImmutable(); });
+                }
+                else if (cf->HasImmutable())
+                {
+                    write_stalled_ = true;
+                    continue;
+                }
+            }
+            ScheduleFlush(cf.get(), "write_buffer_full");
+        }
+    }
+
+    void DB::ScheduleFlush(ColumnFamily *cf, const char *reason)
+    {
+        const int64_t memtable_bytes = cf->GetMemTableUsage();
+        if (!cf->SwitchMemTable())
+        {
+            return;
+        }
+        const uint64_t run_id = next_run_id_++;
+        {
+            std::lock_guard<std::mutex> lock(bg_mu_);
+            ++bg_jobs_;
+        }
+        pool_->Schedule([this, cf, run_id, memtable_bytes, reason]
+                        { BackgroundFlush(cf, run_id, memtable_bytes, reason); },
+                        Priority::kHigh);
+    }
+
+    void DB::BackgroundFlush(ColumnFamily *cf, uint64_t run_id, int64_t memtable_bytes, const char *reason)
+    {
+        cf->FlushImmutable(run_id);
+        if (options_.info_log != nullptr)
+        {
+            TieredCompactionStats stats = cf->GetCompactionStats();
+            LOG_EVENT(options_.info_log.get(), kLogInfo, "flush", {"cf", cf->GetName()}, {"reason", reason},
+                      {"run_id", run_id}, {"memtable_bytes", memtable_bytes}, {"runs", stats.num_runs},
+                      {"total_bytes", stats.total_bytes}, {"write_amp", stats.WriteAmplification()});
+        }
+        UpdateCompactionDebt();
+        // 先登记compaction再结束本任务，WaitForBackgroundWork不会在两者之间返回；
+        // immutable memtable已移除，解除写停顿，FinishBackgroundJob唤醒等待者
+        {
+            std::lock_guard<std::mutex> lock(bg_mu_);
+            ++bg_jobs_;
+            write_stalled_ = false;
+        }
+        pool_->Schedule([this, cf]
+                        { BackgroundCompaction(cf); },
+                        Priority::kLow);
+        FinishBackgroundJob();
+    }
+
+    void DB::BackgroundCompaction(ColumnFamily *cf)
+    {
+        const uint64_t compactions = cf->CompactRuns();
+        if (compactions > 0 && options_.info_log != nullptr)
+        {
+            TieredCompactionStats stats = cf->GetCompactionStats();
+            LOG_EVENT(options_.info_log.get(), kLogInfo, "compaction", {"cf", cf->GetName()},
+                      {"compactions", compactions}, {"runs", stats.num_runs}, {"total_bytes", stats.total_bytes},
+                      {"write_amp", stats.WriteAmplification()}, {"space_amp", stats.SpaceAmplification()});
+        }
+        UpdateCompactionDebt();
+        FinishBackgroundJob();
+    }
+
+    void DB::UpdateCompactionDebt()
+    {
+        if (options_.rate_limiter == nullptr)
+        {
+            return;
+        }
+        // Open之后不再创建列族，后台线程可以直接遍历
+        uint64_t debt = 0;
+        uint64_t limit = 0;
+        for (auto &cf : column_families_)
+        {
+            TieredCompactionStats stats = cf->GetCompactionStats();
+            debt += stats.total_bytes - stats.oldest_run_bytes;
+            limit += static_cast<uint64_t>(cf->GetOptions().write_buffer_size) *
+                     static_cast<uint64_t>(cf->GetOptions().compaction.run_count_trigger);
+        }
+        options_.rate_limiter->SetPendingDebt(debt, limit);
+    }
+
+    void DB::FinishBackgroundJob()
+    {
+        std::lock_guard<std::mutex> lock(bg_mu_);
+        --bg_jobs_;
+        bg_cv_.notify_all();
+    }
+}
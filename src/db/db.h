@@ -0,0 +1,173 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-24 11:02:19
+ * @FilePath: /miniKV/src/db/db.h
+ * @Description: DB：多个列族共享一个WAL与一个序列号空间
+ *
+ * ********************************
+ *  所有列族的写入都编码为WriteBatch，分配连续的序列号后作为一条记录写入同一个WAL，
+ *  再应用到各列族的memtable，因此跨列族的批次是原子的：重启时要么整批重放，要么整批丢弃。
+ *  写入持有写锁串行执行，Get持有读锁，可以并发。
+ *  memtable写满时写入线程只把它换成immutable memtable，flush在线程池的高优先级队列、compaction在低优先级队列中执行，
+ *  后台任务不需要DB的锁，flush也不等待同一列族正在进行的compaction；
+ *  上一个immutable memtable还未flush完成时，之后的写入在获取锁之前等待它完成(写停顿)，读不受影响。
+ *  每次flush与compaction后把各列族的compaction欠账(最旧段以外的有序段大小)报告给限速器。
+ *  列族需要在Open之前按与上次相同的顺序创建(Comparator是代码，无法从日志恢复)，
+ *  WAL中只记录列族编号。有序段目前只在内存中，WAL不会被截断。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_DB_H
+#define MINIKVDB_DB_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../log/log.h"
+#include "../memtable/comparator.h"
+#include "../utils/lock.h"
+#include "../utils/rate_limiter.h"
+#include "../utils/slice.h"
+#include "../utils/statistics.h"
+#include "../utils/thread_pool.h"
+#include "column_family.h"
+#include "wal.h"
+#include "write_batch.h"
+
+namespace minikvdb
+{
+    struct DBOptions
+    {
+        std::string wal_path;           // WAL文件路径，为空时不写WAL
+        bool sync_wal = false;          // 每次写入后是否fdatasync
+        bool wal_use_direct_io = false; // 以O_DIRECT写WAL
+        // WAL中间出现校验失败的记录时：false(默认)打开失败；true丢弃损坏处及之后的内容后继续打开
+        bool wal_tolerate_corruption = false;
+        std::shared_ptr<Statistics> stats;
+        // 后台任务线程池，flush在高优先级队列、compaction与subcompaction在低优先级队列中执行；
+        // 为空时DB自己创建一个(各1个线程)
+        std::shared_ptr<ThreadPool> thread_pool;
+        // WAL(高优先级)与后台写入共享的限速器，为空时不限速；auto_tuned时速率随compaction欠账调整
+        std::shared_ptr<RateLimiter> rate_limiter;
+        // 本DB的日志实例(需已init)，打开、flush等事件以key=value形式写入，为空时不输出
+        std::shared_ptr<Log> info_log;
+    };
+
+    class DB
+    {
+    public:
+        static constexpr const char *kDefaultColumnFamilyName = "default";
+
+        // 构造时创建使用BytewiseComparator的default列族(编号0)
+        explicit DB(DBOptions options);
+
+        ~DB();
+
+        DB(const DB &) = delete;
+        DB &operator=(const DB &) = delete;
+
+        /**
+         * @description:                        创建列族，必须在Open之前调用
+         * @param {string} &name                列族名
+         * @param {ColumnFamilyOptions} options 列族配置
+         * @param {Comparator} cmp              key比较函数
+         * @return {*}                          已Open或名字重复时返回nullptr
+         */
+        template <class Comparator = BytewiseComparator>
+        ColumnFamily *CreateColumnFamily(const std::string &name, ColumnFamilyOptions options = ColumnFamilyOptions(),
+                                         Comparator cmp = Comparator())
+        {
+            if (opened_ || GetColumnFamily(name) != nullptr)
+            {
+                return nullptr;
+            }
+            if (options.rate_limiter == nullptr)
+            {
+                options.rate_limiter = options_.rate_limiter;
+            }
+            uint32_t id = static_cast<uint32_t>(column_families_.size());
+            column_families_.push_back(std::make_unique<ColumnFamilyImpl<Comparator>>(
+                id, name, std::move(options), cmp, options_.stats, pool_.get()));
+            return column_families_.back().get();
+        }
+
+        // 重放WAL恢复各列族的memtable，然后打开WAL追加写入
+        bool Open();
+
+        inline ColumnFamily *DefaultColumnFamily() { return column_families_[0].get(); }
+
+        ColumnFamily *GetColumnFamily(const std::string &name);
+
+        bool Put(ColumnFamily *cf, const Slice &key, const Slice &value);
+
+        bool Delete(ColumnFamily *cf, const Slice &key);
+
+        /**
+         * @description:                原子地写入一个批次，可以跨列族
+         * @param {WriteBatch} *batch   批次，返回后其序列号被设置
+         * @return {*}                  引用了不存在的列族或写WAL失败时返回false，此时没有任何修改
+         */
+        bool Write(WriteBatch *batch);
+
+        bool Get(ColumnFamily *cf, const Slice &key, std::string *value);
+
+        // 把列族的memtable导出为有序段，等待后台flush与compaction完成后返回
+        bool Flush(ColumnFamily *cf);
+
+        // 阻塞直到本DB已提交的后台flush与compaction全部完成
+        void WaitForBackgroundWork();
+
+        // 最后一次写入使用的序列号
+        uint64_t GetLatestSequence();
+
+    private:
+        class MemTableInserter;
+
+        // 把批次应用到各列族的memtable，列族不存在时返回false
+        bool ApplyBatch(const WriteBatch &batch);
+
+        // 持有写锁调用：换下写满的memtable。上一次flush还未完成时，wait为true则等待它完成(Open重放时)，
+        // 否则设置写停顿，由之后的写入在获取mu_之前等待
+        void MaybeFlush(bool wait);
+
+        // 不持有mu_调用：等待写停顿解除
+        void WaitForWriteStall();
+
+        // 持有写锁调用：换下列族的memtable并提交后台flush，列族不能有未完成flush的immutable memtable
+        void ScheduleFlush(ColumnFamily *cf, const char *reason);
+
+        void BackgroundFlush(ColumnFamily *cf, uint64_t run_id, int64_t memtable_bytes, const char *reason);
+
+        void BackgroundCompaction(ColumnFamily *cf);
+
+        // 欠账为各列族最旧段以外的有序段大小，达到write_buffer_size * run_count_trigger时限速器使用最大速率
+        void UpdateCompactionDebt();
+
+        // 后台任务结束时调用，唤醒等待者
+        void FinishBackgroundJob();
+
+        DBOptions const options_;
+        std::shared_ptr<ThreadPool> pool_; // 先于列族构造、后于列族析构
+        std::vector<std::unique_ptr<ColumnFamily>> column_families_;
+        std::unique_ptr<WalWriter> wal_;
+        bool opened_ = false;
+
+        SharedMutexLock mu_;
+        uint64_t last_sequence_ = 0;
+        uint64_t next_run_id_ = 1;
+
+        std::mutex bg_mu_;
+        std::condition_variable bg_cv_; // 后台任务结束时通知
+        int bg_jobs_ = 0;               // 已提交未结束的后台任务数
+        bool write_stalled_ = false;    // 写停顿，flush完成时解除
+    };
+}
+
+#endif
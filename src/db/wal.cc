@@ -0,0 +1,122 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-23 21:40:16
+ * @FilePath: /miniKV/src/db/wal.cc
+ * @Description: 预写日志(WAL)实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "wal.h"
+
+#include <cstring>
+
+#include "../utils/crc32c.h"
+
+namespace minikvdb
+{
+    WalWriter::WalWriter(bool use_direct_io, std::shared_ptr<Statistics> stats, RateLimiter *limiter)
+        : file_(limiter, Priority::kHigh, 64 << 10, use_direct_io), stats_(std::move(stats))
+    {
+    }
+
+    bool WalWriter::Open(const std::string &path)
+    {
+        return file_.Open(path, true);
+    }
+
+    bool WalWriter::AddRecord(const Slice &record, bool sync)
+    {
+        uint32_t length = static_cast<uint32_t>(record.size());
+        uint32_t crc = crc32c::Extend(crc32c::Value(reinterpret_cast<const char *>(&length), sizeof(length)),
+                                      record.data(), record.size());
+        uint32_t masked = crc32c::Mask(crc);
+        header_.assign(reinterpret_cast<const char *>(&masked), sizeof(masked));
+        header_.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        if (!file_.Append(header_) || !file_.Append(record.data(), record.size()))
+        {
+            return false;
+        }
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kWalBytes, kHeaderSize + record.size());
+        }
+        // 不要求落盘时也写入内核，进程崩溃不会丢失已确认的写入
+        return sync ? Sync() : file_.Flush();
+    }
+
+    bool WalWriter::Sync()
+    {
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kWalSyncs);
+        }
+        return file_.Sync();
+    }
+
+    bool WalWriter::Close()
+    {
+        return file_.Close();
+    }
+
+    bool WalReader::Open(const std::string &path)
+    {
+        truncated_ = false;
+        corrupted_ = false;
+        valid_size_ = 0;
+        return file_.Open(path);
+    }
+
+    size_t WalReader::ReadFully(char *scratch, size_t n)
+    {
+        size_t done = 0;
+        while (done < n)
+        {
+            ssize_t r = file_.Read(scratch + done, n - done);
+            if (r <= 0)
+            {
+                break;
+            }
+            done += static_cast<size_t>(r);
+        }
+        return done;
+    }
+
+    bool WalReader::ReadRecord(std::string *record)
+    {
+        char header[WalWriter::kHeaderSize];
+        size_t n = ReadFully(header, sizeof(header));
+        if (n == 0)
+        {
+            return false;
+        }
+        if (n < sizeof(header))
+        {
+            truncated_ = true;
+            return false;
+        }
+        uint32_t masked, length;
+        memcpy(&masked, header, sizeof(masked));
+        memcpy(&length, header + 4, sizeof(length));
+        // 写入时长度不会超过上限，超过说明header本身已损坏
+        if (length > kMaxRecordSize)
+        {
+            corrupted_ = true;
+            return false;
+        }
+        record->resize(length);
+        if (ReadFully(&(*record)[0], length) < length)
+        {
+            truncated_ = true;
+            return false;
+        }
+        if (crc32c::Unmask(masked) != crc32c::Extend(crc32c::Value(header + 4, sizeof(length)), record->data(), length))
+        {
+            corrupted_ = true;
+            return false;
+        }
+        valid_size_ += WalWriter::kHeaderSize + length;
+        return true;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-23 21:40:16
+ * @FilePath: /miniKV/src/db/wal.h
+ * @Description: 预写日志(WAL)的写入与读取
+ *
+ * ********************************
+ *  每条记录为 [fixed32 masked_crc][fixed32 length][payload]，crc为crc32c(length || payload)。
+ *  写入经过WritableFile(可选O_DIRECT、可限速)，sync时fdatasync，并记录kWalBytes、kWalSyncs计数器。
+ *  读取到文件末尾不完整的记录时停止：崩溃时末尾未写完的记录本就没有被确认，丢弃是安全的。
+ *  完整读出但校验失败(或长度非法)的记录是文件损坏，不是崩溃造成的，之后的记录可能是已确认的写入，
+ *  由调用方决定打开失败还是丢弃损坏处之后的内容。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_WAL_H
+#define MINIKVDB_WAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../utils/sequential_file.h"
+#include "../utils/slice.h"
+#include "../utils/statistics.h"
+#include "../utils/writable_file.h"
+
+namespace minikvdb
+{
+    class WalWriter
+    {
+    public:
+        static const size_t kHeaderSize = 8;
+
+        /**
+         * @description:                            构造
+         * @param {bool} use_direct_io              是否以O_DIRECT写日志
+         * @param {shared_ptr<Statistics>} stats    统计信息，为空时不记录
+         * @param {RateLimiter} *limiter            限速器，为空时不限速；WAL写入以高优先级申请令牌
+         * @return {*}
+         */
+        explicit WalWriter(bool use_direct_io = false, std::shared_ptr<Statistics> stats = nullptr,
+                           RateLimiter *limiter = nullptr);
+
+        WalWriter(const WalWriter &) = delete;
+        WalWriter &operator=(const WalWriter &) = delete;
+
+        // 以追加方式打开，文件不存在时创建
+        bool Open(const std::string &path);
+
+        /**
+         * @description:            追加一条记录
+         * @param {Slice} &record   记录内容
+         * @param {bool} sync       是否在返回前落盘
+         * @return {*}
+         */
+        bool AddRecord(const Slice &record, bool sync);
+
+        bool Sync();
+
+        bool Close();
+
+        inline uint64_t GetFileSize() const { return file_.GetFileSize(); }
+
+    private:
+        WritableFile file_;
+        std::shared_ptr<Statistics> stats_;
+        std::string header_;
+    };
+
+    class WalReader
+    {
+    public:
+        // 长度超过该值的记录视为损坏
+        static const uint32_t kMaxRecordSize = 1u << 30;
+
+        WalReader() = default;
+
+        WalReader(const WalReader &) = delete;
+        WalReader &operator=(const WalReader &) = delete;
+
+        bool Open(const std::string &path);
+
+        /**
+         * @description:            读取下一条记录
+         * @param {string} *record  输出
+         * @return {*}              到达末尾、末尾记录不完整或遇到损坏的记录时返回false
+         */
+        bool ReadRecord(std::string *record);
+
+        // 因文件末尾的记录不完整而停止(崩溃时未写完的记录)
+        inline bool IsTruncated() const { return truncated_; }
+
+        // 因记录校验失败或长度非法而停止
+        inline bool IsCorrupted() const { return corrupted_; }
+
+        // 最后一条完整记录之后的偏移
+        inline uint64_t GetValidSize() const { return valid_size_; }
+
+    private:
+        // 读满n字节，返回实际读到的字节数
+        size_t ReadFully(char *scratch, size_t n);
+
+        SequentialFile file_;
+        bool truncated_ = false;
+        bool corrupted_ = false;
+        uint64_t valid_size_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-22 09:30:18
+ * @FilePath: /miniKV/src/db/write_batch.cc
+ * @Description: 写批次WriteBatch实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "write_batch.h"
+
+#include <cstring>
+
+namespace minikvdb
+{
+    namespace
+    {
+        void PutFixed32(std::string *dst, uint32_t v)
+        {
+            dst->append(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        uint32_t DecodeFixed32(const char *p)
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // 读取[fixed32 len][bytes]
+        bool GetLengthPrefixed(Slice *input, Slice *result)
+        {
+            if (input->size() < 4)
+            {
+                return false;
+            }
+            uint32_t len = DecodeFixed32(input->data());
+            if (input->size() - 4 < len)
+            {
+                return false;
+            }
+            *result = Slice(input->data() + 4, len);
+            input->remove_prefix(4 + len);
+            return true;
+        }
+    }
+
+    WriteBatch::WriteBatch()
+    {
+        Clear();
+    }
+
+    void WriteBatch::Clear()
+    {
+        rep_.assign(kHeaderSize, '\0');
+    }
+
+    uint32_t WriteBatch::Count() const
+    {
+        return DecodeFixed32(rep_.data() + 8);
+    }
+
+    void WriteBatch::SetCount(uint32_t n)
+    {
+        memcpy(&rep_[8], &n, sizeof(n));
+    }
+
+    uint64_t WriteBatch::Sequence() const
+    {
+        uint64_t seq;
+        memcpy(&seq, rep_.data(), sizeof(seq));
+        return seq;
+    }
+
+    void WriteBatch::SetSequence(uint64_t seq)
+    {
+        memcpy(&rep_[0], &seq, sizeof(seq));
+    }
+
+    void WriteBatch::Put(uint32_t cf_id, const Slice &key, const Slice &value)
+    {
+        SetCount(Count() + 1);
+        rep_.push_back(static_cast<char>(kTypeValue));
+        PutFixed32(&rep_, cf_id);
+        PutFixed32(&rep_, static_cast<uint32_t>(key.size()));
+        rep_.append(key.data(), key.size());
+        PutFixed32(&rep_, static_cast<uint32_t>(value.size()));
+        rep_.append(value.data(), value.size());
+    }
+
+    void WriteBatch::Delete(uint32_t cf_id, const Slice &key)
+    {
+        SetCount(Count() + 1);
+        rep_.push_back(static_cast<char>(kTypeDeletion));
+        PutFixed32(&rep_, cf_id);
+        PutFixed32(&rep_, static_cast<uint32_t>(key.size()));
+        rep_.append(key.data(), key.size());
+    }
+
+    bool WriteBatch::SetData(const Slice &data)
+    {
+        if (data.size() < kHeaderSize)
+        {
+            return false;
+        }
+        rep_.assign(data.data(), data.size());
+        return true;
+    }
+
+    bool WriteBatch::Iterate(Handler *handler) const
+    {
+        Slice input(rep_);
+        input.remove_prefix(kHeaderSize);
+        uint32_t found = 0;
+        while (!input.empty())
+        {
+            if (input.size() < 5)
+            {
+                return false;
+            }
+            uint8_t type = static_cast<uint8_t>(input[0]);
+            uint32_t cf_id = DecodeFixed32(input.data() + 1);
+            input.remove_prefix(5);
+            Slice key, value;
+            switch (type)
+            {
+            case kTypeValue:
+                if (!GetLengthPrefixed(&input, &key) || !GetLengthPrefixed(&input, &value))
+                {
+                    return false;
+                }
+                handler->Put(cf_id, key, value);
+                break;
+            case kTypeDeletion:
+                if (!GetLengthPrefixed(&input, &key))
+                {
+                    return false;
+                }
+                handler->Delete(cf_id, key);
+                break;
+            default:
+                return false;
+            }
+            ++found;
+        }
+        return found == Count();
+    }
+}
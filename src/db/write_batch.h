@@ -0,0 +1,89 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-22 09:30:18
+ * @FilePath: /miniKV/src/db/write_batch.h
+ * @Description: 写批次WriteBatch：跨列族原子写入的单位，也是WAL中一条记录的内容
+ *
+ * ********************************
+ *  编码格式(小端)：
+ *    header : [fixed64 sequence][fixed32 count]
+ *    record : [uint8 type][fixed32 cf_id][fixed32 key_len][key]，type为kTypeValue时再跟[fixed32 value_len][value]
+ *  一个批次中的所有操作占用连续的序列号[sequence, sequence + count)。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_WRITE_BATCH_H
+#define MINIKVDB_WRITE_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../utils/slice.h"
+
+namespace minikvdb
+{
+    enum ValueType : uint8_t
+    {
+        kTypeDeletion = 0,
+        kTypeValue = 1,
+        kTypeBlobIndex = 2, // 只出现在有序段中，value为编码后的BlobIndex，不会写入WriteBatch
+    };
+
+    class WriteBatch
+    {
+    public:
+        static const size_t kHeaderSize = 12;
+
+        WriteBatch();
+
+        void Put(uint32_t cf_id, const Slice &key, const Slice &value);
+
+        void Delete(uint32_t cf_id, const Slice &key);
+
+        void Clear();
+
+        // 操作个数
+        uint32_t Count() const;
+
+        uint64_t Sequence() const;
+
+        void SetSequence(uint64_t seq);
+
+        // 编码后的内容，即写入WAL的记录
+        inline const std::string &Data() const { return rep_; }
+
+        inline size_t ApproximateSize() const { return rep_.size(); }
+
+        /**
+         * @description:            用WAL中读出的记录替换批次内容
+         * @param {Slice} &data     编码后的批次
+         * @return {*}              长度不足header时返回false
+         */
+        bool SetData(const Slice &data);
+
+        /*
+         * 按写入顺序回放批次中的操作
+         */
+        class Handler
+        {
+        public:
+            virtual ~Handler() = default;
+            virtual void Put(uint32_t cf_id, const Slice &key, const Slice &value) = 0;
+            virtual void Delete(uint32_t cf_id, const Slice &key) = 0;
+        };
+
+        // 内容损坏(越界、类型错误、个数不符)时返回false，此前的操作已经回放
+        bool Iterate(Handler *handler) const;
+
+    private:
+        void SetCount(uint32_t n);
+
+        std::string rep_;
+    };
+}
+
+#endif
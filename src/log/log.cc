@@ -1,7 +1,7 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-27 21:25:01
- * @LastEditTime: 2023-05-27 23:38:30
+ * @LastEditTime: 2026-10-23 15:31:09
  * @FilePath: /miniKV/src/log/log.cc
  * @Description: 日志模块实现
  *
@@ -18,12 +18,53 @@ using namespace std;
 
 namespace minikvdb
 {
-    Log::Log()
+    namespace
     {
-        m_count = 0;
-        m_is_async = false;
+        // value为空或含空白、引号、'='时加双引号，并转义其中的引号、反斜杠与换行
+        void AppendLogValue(std::string *out, const std::string &value)
+        {
+            bool quote = value.empty();
+            for (char c : value)
+            {
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"' || c == '=' || c == '\\')
+                {
+                    quote = true;
+                    break;
+                }
+            }
+            if (!quote)
+            {
+                out->append(value);
+                return;
+            }
+            out->push_back('"');
+            for (char c : value)
+            {
+                switch (c)
+                {
+                case '"':
+                    out->append("\\\"");
+                    break;
+                case '\\':
+                    out->append("\\\\");
+                    break;
+                case '\n':
+                    out->append("\\n");
+                    break;
+                case '\r':
+                    out->append("\\r");
+                    break;
+                default:
+                    out->push_back(c);
+                    break;
+                }
+            }
+            out->push_back('"');
+        }
     }
 
+    Log::Log() = default;
+
     Log::~Log()
     {
         if (m_fp != NULL)
@@ -35,128 +76,196 @@ namespace minikvdb
     // Log初始化函数
     bool Log::init(const char *file_name, int close_log, int log_buf_size, int split_lines)
     {
-        // 参数初始化
-        m_close_log = close_log;
-        m_log_buf_size = log_buf_size;
-        m_buf = new char[m_log_buf_size];
-        memset(m_buf, '\0', m_log_buf_size);
-        m_split_lines = split_lines;
+        std::call_once(m_init_flag, [&]
+                       { m_init_ok = open(file_name, close_log, log_buf_size, split_lines); });
+        return m_init_ok;
+    }
+
+    bool Log::open(const char *file_name, int close_log, int log_buf_size, int split_lines)
+    {
+        ScopedLock<MutexLock> lock(m_mutex);
+        // 参数初始化，缓冲区至少要放下时间与级别前缀
+        m_log_buf_size = log_buf_size < 128 ? 128 : log_buf_size;
+        m_buf.reset(new char[m_log_buf_size]);
+        memset(m_buf.get(), '\0', m_log_buf_size);
+        m_split_lines = split_lines < 1 ? 1 : split_lines;
 
         time_t t = time(NULL);
-        struct tm *sys_tm = localtime(&t);
-        struct tm my_tm = *sys_tm;
+        struct tm my_tm;
+        localtime_r(&t, &my_tm);
 
+        // 路径或文件名过长时初始化失败，而不是截断后写到别的文件里
         const char *p = strrchr(file_name, '/');
-        char log_full_name[256] = {0};
-
-        if (p == NULL)
+        const char *name = p == NULL ? file_name : p + 1;
+        int dir_len = p == NULL ? 0 : static_cast<int>(p - file_name + 1);
+        if (strlen(name) >= sizeof(log_name) || dir_len >= static_cast<int>(sizeof(dir_name)))
         {
-            snprintf(log_full_name, 255, "%d_%02d_%02d_%s", my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday, file_name);
+            return false;
         }
-        else
+        snprintf(log_name, sizeof(log_name), "%s", name);
+        snprintf(dir_name, sizeof(dir_name), "%.*s", dir_len, file_name);
+        if (!make_file_name(my_tm, 0, full_name, sizeof(full_name)))
         {
-            strcpy(log_name, p + 1);
-            strncpy(dir_name, file_name, p - file_name + 1);
-            snprintf(log_full_name, 255, "%s%d_%02d_%02d_%s", dir_name, my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday, log_name);
+            return false;
         }
 
         m_today = my_tm.tm_mday;
 
-        m_fp = fopen(log_full_name, "a");
+        m_fp = fopen(full_name, "a");
         if (m_fp == NULL)
         {
             return false;
         }
-
+        // 文件打开后才允许写入，在此之前的并发写日志都是空操作
+        m_close_log.store(close_log, std::memory_order_release);
         return true;
     }
 
-    void Log::write_log(int level, const char *format, ...)
+    bool Log::make_file_name(const struct tm &my_tm, long long part, char *out, size_t size) const
+    {
+        int n;
+        if (part == 0)
+        {
+            n = snprintf(out, size, "%s%d_%02d_%02d_%s", dir_name, my_tm.tm_year + 1900, my_tm.tm_mon + 1,
+                         my_tm.tm_mday, log_name);
+        }
+        else
+        {
+            n = snprintf(out, size, "%s%d_%02d_%02d_%s.%lld", dir_name, my_tm.tm_year + 1900, my_tm.tm_mon + 1,
+                         my_tm.tm_mday, log_name, part);
+        }
+        return n >= 0 && static_cast<size_t>(n) < size;
+    }
+
+    int Log::begin_line(int level)
     {
         struct timeval now = {0, 0};
         gettimeofday(&now, NULL);
         time_t t = now.tv_sec;
-        struct tm *sys_tm = localtime(&t);
-        struct tm my_tm = *sys_tm;
-        char s[16] = {0};
+        struct tm my_tm;
+        localtime_r(&t, &my_tm);
 
         // 根据不同log等级写log文件
+        const char *s;
         switch (level)
         {
-        case 0:
-            strcpy(s, "[debug]:");
+        case kLogDebug:
+            s = "[debug]:";
+            break;
+        case kLogWarn:
+            s = "[warn]:";
+            break;
+        case kLogError:
+            s = "[error]:";
             break;
-        case 1:
-            strcpy(s, "[info]:");
-        case 2:
-            strcpy(s, "[warn]:");
-        case 3:
-            strcpy(s, "[error]:");
         default:
-            strcpy(s, "[info]:");
+            s = "[info]:";
             break;
         }
 
         // 写入一个log，对m_count++, m_split_lines最大行数
-        m_mutex.lock();
         m_count++;
 
         // 不是一天 或者 日志行数达到上限，开启新的日志文件进行写入
         if (m_today != my_tm.tm_mday || m_count % m_split_lines == 0)
         {
-            char new_log[256] = {0};
-            fflush(m_fp);
-            fclose(m_fp);
-            char tail[16] = {0};
-
-            snprintf(tail, 16, "%d_%02d_%02d_", my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday);
-
-            if (m_today != my_tm.tm_mday)
+            const bool new_day = m_today != my_tm.tm_mday;
+            char new_name[sizeof(full_name)];
+            // 新文件名放不下时继续写当前文件
+            if (make_file_name(my_tm, new_day ? 0 : m_count / m_split_lines, new_name, sizeof(new_name)))
             {
-                snprintf(new_log, 255, "%s%s%s", dir_name, tail, log_name);
-                m_today = my_tm.tm_mday;
-                m_count = 0;
+                fflush(m_fp);
+                fclose(m_fp);
+                memcpy(full_name, new_name, sizeof(full_name));
+                m_fp = fopen(full_name, "a");
             }
-            else
+            if (new_day)
             {
-                snprintf(new_log, 255, "%s%s%s.%lld", dir_name, tail, log_name, m_count / m_split_lines);
+                m_today = my_tm.tm_mday;
+                m_count = 0;
             }
-            m_fp = fopen(new_log, "a");
         }
 
-        // 进行写入
-        m_mutex.unlock();
-
-        va_list valst;
-        va_start(valst, format);
-
-        string log_str;
-        m_mutex.lock();
-
         // 写入的具体时间内容格式
-        int n = snprintf(m_buf, 48, "%d-%02d-%02d %02d:%02d:%02d.%06ld %s ",
+        int n = snprintf(m_buf.get(), m_log_buf_size, "%d-%02d-%02d %02d:%02d:%02d.%06ld %s ",
                          my_tm.tm_year + 1900, my_tm.tm_mon + 1, my_tm.tm_mday,
                          my_tm.tm_hour, my_tm.tm_min, my_tm.tm_sec, now.tv_usec, s);
+        return n < m_log_buf_size ? n : m_log_buf_size - 1;
+    }
 
-        int m = vsnprintf(m_buf + n, m_log_buf_size - 1, format, valst);
+    void Log::write_log(int level, const char *format, ...)
+    {
+        ScopedLock<MutexLock> lock(m_mutex);
+        if (m_fp == NULL)
+        {
+            return;
+        }
+        int n = begin_line(level);
+        if (m_fp == NULL)
+        {
+            return;
+        }
+
+        va_list valst;
+        va_start(valst, format);
+        // 预留换行符与'\0'的位置，过长的内容被截断
+        int m = vsnprintf(m_buf.get() + n, m_log_buf_size - n - 1, format, valst);
+        va_end(valst);
+        if (m < 0)
+        {
+            m = 0;
+        }
+        else if (m > m_log_buf_size - n - 2)
+        {
+            m = m_log_buf_size - n - 2;
+        }
         m_buf[n + m] = '\n';
         m_buf[n + m + 1] = '\0';
-        log_str = m_buf;
 
-        m_mutex.unlock();
+        fputs(m_buf.get(), m_fp);
+    }
 
-        m_mutex.lock();
-        fputs(log_str.c_str(), m_fp);
-        m_mutex.unlock();
+    void Log::write_kv(int level, const char *event, std::initializer_list<LogField> fields)
+    {
+        // 在锁外拼接字段
+        std::string line("event=");
+        AppendLogValue(&line, event);
+        for (const LogField &field : fields)
+        {
+            line.push_back(' ');
+            line.append(field.key);
+            line.push_back('=');
+            AppendLogValue(&line, field.value);
+        }
+        line.push_back('\n');
 
-        va_end(valst);
+        ScopedLock<MutexLock> lock(m_mutex);
+        if (m_fp == NULL)
+        {
+            return;
+        }
+        begin_line(level);
+        if (m_fp == NULL)
+        {
+            return;
+        }
+        fputs(m_buf.get(), m_fp);
+        fputs(line.c_str(), m_fp);
     }
 
     void Log::flush(void)
     {
-        m_mutex.lock();
+        ScopedLock<MutexLock> lock(m_mutex);
         // 强制刷新写入流缓冲区
-        fflush(m_fp);
-        m_mutex.unlock();
+        if (m_fp != NULL)
+        {
+            fflush(m_fp);
+        }
+    }
+
+    std::string Log::get_file_name()
+    {
+        ScopedLock<MutexLock> lock(m_mutex);
+        return m_fp == NULL ? std::string() : std::string(full_name);
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,17 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-27 21:08:34
- * @LastEditTime: 2023-05-27 23:57:54
+ * @LastEditTime: 2026-10-23 15:31:09
  * @FilePath: /miniKV/src/log/log.h
  * @Description: 日志模块定义
  *
+ * ********************************
+ *  Log既可以作为全局单例(get_instance，LOG_DEBUG等宏使用)，也可以为每个DB单独创建一个实例。
+ *  init对每个实例只生效一次，重复调用直接返回第一次的结果，不会重新分配缓冲区或重新打开文件；
+ *  未init的实例处于关闭状态，写日志是空操作，因此数据结构中的LOG_*宏在应用没有初始化日志时几乎没有开销。
+ *  除printf风格的write_log外，write_kv以key=value的形式输出一个事件，便于grep与脚本解析。
+ * ********************************
+ *
  * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
  */
 
@@ -13,7 +20,12 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 #include <stdarg.h>
 #include <pthread.h>
 #include "../utils/lock.h"
@@ -22,24 +34,59 @@ using namespace std;
 
 namespace minikvdb
 {
-    // 单例模式创建日志
+    // 日志级别，与write_log的level参数一致
+    enum LogLevel
+    {
+        kLogDebug = 0,
+        kLogInfo = 1,
+        kLogWarn = 2,
+        kLogError = 3,
+    };
+
+    // 结构化日志中的一个字段，value在构造时格式化为字符串
+    struct LogField
+    {
+        LogField(const char *k, const std::string &v) : key(k), value(v) {}
+
+        LogField(const char *k, const char *v) : key(k), value(v == nullptr ? "" : v) {}
+
+        LogField(const char *k, bool v) : key(k), value(v ? "true" : "false") {}
+
+        template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+        LogField(const char *k, T v) : key(k), value(std::to_string(v))
+        {
+        }
+
+        const char *key;
+        std::string value;
+    };
+
     class Log
     {
     public:
-        // C++11以后,使用局部变量懒汉不用加锁
+        // 全局单例，C++11以后局部静态变量的初始化是线程安全的
         static Log *get_instance()
         {
             static Log instance;
             return &instance;
         }
 
+        // 独立的日志实例(例如每个DB一个)，init之前处于关闭状态
+        Log();
+
+        virtual ~Log();
+
+        Log(const Log &) = delete;
+
+        Log &operator=(const Log &) = delete;
+
         /**
-         * @description:                日志初始化函数
+         * @description:                日志初始化函数，每个实例只生效一次，可在多个线程中并发调用
          * @param {char} *file_name     日志输出文件名
          * @param {int} close_log       日志关闭标志
          * @param {int} log_buf_size    日志缓冲区大小
          * @param {int} split_lines     最大行数
-         * @return {*}
+         * @return {*}                  第一次初始化是否成功
          */
         bool init(const char *file_name, int close_log, int log_buf_size = 8192, int split_lines = 5000000);
 
@@ -51,57 +98,82 @@ namespace minikvdb
          */
         void write_log(int level, const char *format, ...);
 
+        /**
+         * @description:                        以key=value的形式书写一个事件，例如 event=flush cf=default bytes=1024
+         * @param {int} level                   日志级别
+         * @param {char} *event                 事件名
+         * @param {initializer_list} fields     字段，value含空白、引号或'='时加双引号
+         * @return {*}
+         */
+        void write_kv(int level, const char *event, std::initializer_list<LogField> fields);
+
         /**
          * @description:        日志实时刷新函数
          * @return {*}
          */
         void flush(void);
 
-        int get_close_log() { return m_close_log; }
+        int get_close_log() const { return m_close_log.load(std::memory_order_acquire); }
+
+        // 当前写入的日志文件名，未初始化时为空
+        std::string get_file_name();
 
     private:
-        Log();
-        virtual ~Log();
+        // 需持有m_mutex：必要时切换日志文件，并把时间与级别前缀写入m_buf，返回前缀长度
+        int begin_line(int level);
+
+        bool open(const char *file_name, int close_log, int log_buf_size, int split_lines);
+
+        // 按dir_name + 日期前缀 + log_name(+ .分卷号)拼出文件名，放不下时返回false
+        bool make_file_name(const struct tm &my_tm, long long part, char *out, size_t size) const;
 
     private:
-        char dir_name[128]; // 路径名
-        char log_name[128]; // log文件名
-        int m_split_lines;  // 日志最大行数
-        int m_log_buf_size; // 日志缓冲区大小
-        long long m_count;  // 日志行数记录
-        int m_today;        // 因为按天分类,记录当前时间是那一天
-        FILE *m_fp;         // 打开log的文件指针
-        char *m_buf;
-        bool m_is_async;   // 是否同步标志位
-        MutexLock m_mutex; // 互斥锁
-        int m_close_log;   // 关闭日志
+        char dir_name[128] = {0}; // 路径名
+        char log_name[128] = {0}; // log文件名
+        // 当前log文件的完整路径：路径名 + "yyyy_mm_dd_" + log文件名 + ".分卷号"
+        char full_name[sizeof(dir_name) + sizeof(log_name) + 64] = {0};
+        int m_split_lines = 0;     // 日志最大行数
+        int m_log_buf_size = 0;    // 日志缓冲区大小
+        long long m_count = 0;     // 日志行数记录
+        int m_today = 0;           // 因为按天分类,记录当前时间是那一天
+        FILE *m_fp = nullptr;      // 打开log的文件指针
+        std::unique_ptr<char[]> m_buf;
+        bool m_is_async = false;           // 是否同步标志位
+        MutexLock m_mutex;                 // 互斥锁
+        std::atomic<int> m_close_log{1};   // 关闭日志，init之前为关闭
+        std::once_flag m_init_flag;        // 保证init只执行一次
+        bool m_init_ok = false;            // 第一次init的结果
     };
 
 }
 
-#define LOG_DEBUG(format, ...)                                              \
-    if (0 == minikvdb::Log::get_instance()->get_close_log())                                 \
-    {                                                                       \
-        minikvdb::Log::get_instance()->write_log(0, format, ##__VA_ARGS__); \
-        minikvdb::Log::get_instance()->flush();                             \
-    }
-#define LOG_INFO(format, ...)                                               \
-    if (0 == minikvdb::Log::get_instance()->get_close_log())                \
-    {                                                                       \
-        minikvdb::Log::get_instance()->write_log(1, format, ##__VA_ARGS__); \
-        minikvdb::Log::get_instance()->flush();                             \
-    }
-#define LOG_WARN(format, ...)                                               \
-    if (0 == minikvdb::Log::get_instance()->get_close_log())                \
-    {                                                                       \
-        minikvdb::Log::get_instance()->write_log(2, format, ##__VA_ARGS__); \
-        minikvdb::Log::get_instance()->flush();                             \
-    }
-#define LOG_ERROR(format, ...)                                              \
-    if (0 == minikvdb::Log::get_instance()->get_close_log())                \
-    {                                                                       \
-        minikvdb::Log::get_instance()->write_log(3, format, ##__VA_ARGS__); \
-        minikvdb::Log::get_instance()->flush();                             \
-    }
-
-#endif
\ No newline at end of file
+#define LOG_BASE(level, format, ...)                                 \
+    do                                                               \
+    {                                                                \
+        minikvdb::Log *log_ = minikvdb::Log::get_instance();         \
+        if (0 == log_->get_close_log())                              \
+        {                                                            \
+            log_->write_log(level, format, ##__VA_ARGS__);           \
+            log_->flush();                                           \
+        }                                                            \
+    } while (0)
+
+#define LOG_DEBUG(format, ...) LOG_BASE(minikvdb::kLogDebug, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_BASE(minikvdb::kLogInfo, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_BASE(minikvdb::kLogWarn, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_BASE(minikvdb::kLogError, format, ##__VA_ARGS__)
+
+// 向指定的Log实例输出结构化事件，logger为空时不输出：
+// LOG_EVENT(logger, minikvdb::kLogInfo, "flush", {"cf", name}, {"bytes", bytes});
+#define LOG_EVENT(logger, level, event, ...)                         \
+    do                                                               \
+    {                                                                \
+        minikvdb::Log *log_ = (logger);                              \
+        if (log_ != nullptr && 0 == log_->get_close_log())           \
+        {                                                            \
+            log_->write_kv(level, event, {__VA_ARGS__});             \
+            log_->flush();                                           \
+        }                                                            \
+    } while (0)
+
+#endif
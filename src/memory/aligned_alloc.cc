@@ -0,0 +1,111 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-23 15:10:26
+ * @FilePath: /miniKV/src/memory/aligned_alloc.cc
+ * @Description: 对齐内存分配与缓冲区池实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "aligned_alloc.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace minikvdb
+{
+    AlignedAlloc::AlignedAlloc(size_t alignment) : alignment_(alignment)
+    {
+        assert(alignment_ >= sizeof(void *) && (alignment_ & (alignment_ - 1)) == 0);
+    }
+
+    void *AlignedAlloc::Allocate(int32_t n)
+    {
+        void *p = nullptr;
+        if (posix_memalign(&p, alignment_, AlignUp(static_cast<size_t>(n), alignment_)) != 0)
+        {
+            return nullptr;
+        }
+        return p;
+    }
+
+    void AlignedAlloc::Deallocate(void *p, int32_t /*n*/)
+    {
+        free(p);
+    }
+
+    void *AlignedAlloc::Reallocate(void *p, int32_t old_size, int32_t new_size)
+    {
+        if (p != nullptr && AlignUp(old_size, alignment_) >= AlignUp(new_size, alignment_))
+        {
+            return p; // 按对齐取整后的容量已经足够
+        }
+        void *q = Allocate(new_size);
+        if (q != nullptr && p != nullptr)
+        {
+            memcpy(q, p, std::min(old_size, new_size));
+            Deallocate(p, old_size);
+        }
+        return q;
+    }
+
+    AlignedBufferPool::AlignedBufferPool(size_t buffer_size, size_t alignment, size_t max_cached)
+        : alloc_(alignment), buffer_size_(AlignUp(buffer_size, alignment)), max_cached_(max_cached)
+    {
+    }
+
+    AlignedBufferPool::~AlignedBufferPool()
+    {
+        for (char *buf : free_)
+        {
+            alloc_.Deallocate(buf, static_cast<int32_t>(buffer_size_));
+        }
+    }
+
+    char *AlignedBufferPool::Acquire()
+    {
+        {
+            ScopedLock<SpinLock> guard(lock_);
+            if (!free_.empty())
+            {
+                char *buf = free_.back();
+                free_.pop_back();
+                return buf;
+            }
+            ++allocated_;
+        }
+        return static_cast<char *>(alloc_.Allocate(static_cast<int32_t>(buffer_size_)));
+    }
+
+    void AlignedBufferPool::Release(char *buf)
+    {
+        if (buf == nullptr)
+        {
+            return;
+        }
+        {
+            ScopedLock<SpinLock> guard(lock_);
+            if (free_.size() < max_cached_)
+            {
+                free_.push_back(buf);
+                return;
+            }
+        }
+        alloc_.Deallocate(buf, static_cast<int32_t>(buffer_size_));
+    }
+
+    size_t AlignedBufferPool::GetCachedCount()
+    {
+        ScopedLock<SpinLock> guard(lock_);
+        return free_.size();
+    }
+
+    size_t AlignedBufferPool::GetAllocatedCount()
+    {
+        ScopedLock<SpinLock> guard(lock_);
+        return allocated_;
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/src/memory/aligned_alloc.h
+ * @Description: 按页对齐的内存分配与缓冲区池，供O_DIRECT读写使用
+ *
+ * ********************************
+ *  O_DIRECT要求用户缓冲区地址、文件偏移和读写长度都按逻辑块大小对齐，
+ *  统一按4KB对齐即可覆盖常见设备(512B/4KB)。
+ *  AlignedAlloc与DefaultAlloc的接口一致，只是返回的地址满足对齐要求；
+ *  AlignedBufferPool缓存固定大小的对齐缓冲区，避免每打开一个文件都重新分配。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_ALIGNED_ALLOC_H
+#define MINIKVDB_ALIGNED_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils/lock.h"
+
+namespace minikvdb
+{
+    constexpr size_t kDefaultIOAlignment = 4096;
+
+    // x向上取整到alignment的整数倍，alignment须为2的幂
+    inline size_t AlignUp(size_t x, size_t alignment) { return (x + alignment - 1) & ~(alignment - 1); }
+
+    inline size_t AlignDown(size_t x, size_t alignment) { return x & ~(alignment - 1); }
+
+    class AlignedAlloc
+    {
+    public:
+        explicit AlignedAlloc(size_t alignment = kDefaultIOAlignment);
+
+        ~AlignedAlloc() = default;
+
+        /**
+         * @description:        内存分配函数，返回地址按alignment对齐
+         * @param {int32_t} n   分配内存size
+         * @return {*}          已分配内存，失败返回nullptr
+         */
+        void *Allocate(int32_t n);
+
+        /**
+         * @description:        内存释放函数
+         * @param {void} *p     已分配地址
+         * @param {int32_t} n   已分配内存size
+         * @return {*}
+         */
+        void Deallocate(void *p, int32_t n);
+
+        /**
+         * @description:                内存扩容函数，realloc不保证对齐，因此重新分配并拷贝
+         * @param {void} *p             已分配地址
+         * @param {int32_t} old_size    已分配内存size
+         * @param {int32_t} new_size    扩容内存size
+         * @return {*}
+         */
+        void *Reallocate(void *p, int32_t old_size, int32_t new_size);
+
+        inline size_t GetAlignment() const { return alignment_; }
+
+    private:
+        size_t const alignment_;
+    };
+
+    class AlignedBufferPool
+    {
+    public:
+        /**
+         * @description:                    构造缓冲区池
+         * @param {size_t} buffer_size      每个缓冲区的大小，向上取整到alignment
+         * @param {size_t} alignment        对齐要求，须为2的幂
+         * @param {size_t} max_cached       最多缓存的空闲缓冲区个数，超出的直接释放
+         * @return {*}
+         */
+        explicit AlignedBufferPool(size_t buffer_size = 64 * 1024, size_t alignment = kDefaultIOAlignment,
+                                   size_t max_cached = 64);
+
+        ~AlignedBufferPool();
+
+        AlignedBufferPool(const AlignedBufferPool &) = delete;
+        AlignedBufferPool &operator=(const AlignedBufferPool &) = delete;
+
+        // 进程共享的64KB缓冲区池，WritableFile/SequentialFile默认从这里取缓冲区
+        static AlignedBufferPool *get_instance()
+        {
+            static AlignedBufferPool instance;
+            return &instance;
+        }
+
+        // 取一个缓冲区，内容未初始化
+        char *Acquire();
+
+        // 归还Acquire得到的缓冲区
+        void Release(char *buf);
+
+        inline size_t GetBufferSize() const { return buffer_size_; }
+
+        inline size_t GetAlignment() const { return alloc_.GetAlignment(); }
+
+        // 当前空闲缓存的缓冲区个数
+        size_t GetCachedCount();
+
+        // 累计向系统申请的缓冲区个数
+        size_t GetAllocatedCount();
+
+    private:
+        AlignedAlloc alloc_;
+        size_t const buffer_size_;
+        size_t const max_cached_;
+        SpinLock lock_;
+        std::vector<char *> free_;
+        size_t allocated_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 18:02:44
+ * @LastEditTime: 2026-10-18 18:02:44
+ * @FilePath: /miniKV/src/memory/epoch.cc
+ * @Description: 基于epoch的内存回收实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "epoch.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+namespace minikvdb
+{
+    EpochManager::~EpochManager()
+    {
+        // 进程退出时不会再有读者，全部释放
+        for (auto &r : retired_)
+        {
+            r.deleter(r.ptr);
+        }
+        retired_.clear();
+    }
+
+    EpochManager::ThreadHandle::~ThreadHandle()
+    {
+        if (slot >= 0)
+        {
+            EpochManager *mgr = EpochManager::get_instance();
+            mgr->records_[slot].state.store(0, std::memory_order_release);
+            mgr->records_[slot].in_use.store(false, std::memory_order_release);
+        }
+    }
+
+    EpochManager::ThreadHandle &EpochManager::LocalHandle()
+    {
+        thread_local ThreadHandle handle;
+        return handle;
+    }
+
+    int EpochManager::AcquireSlot()
+    {
+        for (int i = 0; i < kMaxThreads; ++i)
+        {
+            bool expected = false;
+            if (!records_[i].in_use.load(std::memory_order_relaxed) &&
+                records_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                int hw = slot_high_water_.load(std::memory_order_relaxed);
+                while (hw < i + 1 && !slot_high_water_.compare_exchange_weak(hw, i + 1, std::memory_order_acq_rel))
+                {
+                }
+                return i;
+            }
+        }
+        fprintf(stderr, "EpochManager: too many threads (max %d)\n", kMaxThreads);
+        abort();
+    }
+
+    void EpochManager::Enter()
+    {
+        ThreadHandle &h = LocalHandle();
+        if (h.depth++ > 0)
+        {
+            return;
+        }
+        if (h.slot < 0)
+        {
+            h.slot = AcquireSlot();
+        }
+        std::atomic<uint64_t> &state = records_[h.slot].state;
+        // 登记后再确认一次全局epoch没有变化：否则可能在登记前epoch已被推进，
+        // 需要以新的epoch重新登记
+        uint64_t e;
+        do
+        {
+            e = global_epoch_.load(std::memory_order_seq_cst);
+            state.store((e << 1) | 1, std::memory_order_seq_cst);
+        } while (global_epoch_.load(std::memory_order_seq_cst) != e);
+    }
+
+    void EpochManager::Exit()
+    {
+        ThreadHandle &h = LocalHandle();
+        assert(h.depth > 0);
+        if (--h.depth == 0)
+        {
+            records_[h.slot].state.store(0, std::memory_order_release);
+        }
+    }
+
+    void EpochManager::Retire(void *p, void (*deleter)(void *))
+    {
+        bool need_reclaim = false;
+        {
+            ScopedLock<MutexLock> guard(mutex_);
+            retired_.push_back({p, deleter, global_epoch_.load(std::memory_order_seq_cst)});
+            need_reclaim = ++retired_since_reclaim_ >= kReclaimInterval;
+        }
+        if (need_reclaim)
+        {
+            TryReclaim();
+        }
+    }
+
+    size_t EpochManager::TryReclaim()
+    {
+        std::vector<Retired> ready;
+        {
+            ScopedLock<MutexLock> guard(mutex_);
+            retired_since_reclaim_ = 0;
+
+            uint64_t epoch = global_epoch_.load(std::memory_order_seq_cst);
+            bool can_advance = true;
+            int hw = slot_high_water_.load(std::memory_order_acquire);
+            for (int i = 0; i < hw; ++i)
+            {
+                uint64_t s = records_[i].state.load(std::memory_order_seq_cst);
+                if ((s & 1) && (s >> 1) != epoch)
+                {
+                    can_advance = false; // 还有读者停留在旧epoch
+                    break;
+                }
+            }
+            if (can_advance)
+            {
+                global_epoch_.store(++epoch, std::memory_order_seq_cst);
+            }
+
+            // retire时epoch为e的对象，在全局epoch >= e + 2时一定没有读者持有
+            size_t keep = 0;
+            for (size_t i = 0; i < retired_.size(); ++i)
+            {
+                if (retired_[i].epoch + 2 <= epoch)
+                {
+                    ready.push_back(retired_[i]);
+                }
+                else
+                {
+                    retired_[keep++] = retired_[i];
+                }
+            }
+            retired_.resize(keep);
+        }
+
+        // 在锁外调用释放函数，避免deleter再次retire时死锁
+        for (auto &r : ready)
+        {
+            r.deleter(r.ptr);
+        }
+        return ready.size();
+    }
+
+    size_t EpochManager::PendingCount()
+    {
+        ScopedLock<MutexLock> guard(mutex_);
+        return retired_.size();
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 18:02:44
+ * @LastEditTime: 2026-10-18 18:02:44
+ * @FilePath: /miniKV/src/memory/epoch.h
+ * @Description: 基于epoch的内存回收(EBR)
+ *
+ * ********************************
+ *  无锁读场景下，写者摘除的结点可能仍被并发读者持有，不能立刻释放。
+ *  读者在访问共享结构前进入临界区(EpochGuard)并登记当前全局epoch；
+ *  写者摘除结点后调用Retire延迟释放。只有当所有处于临界区的读者都已
+ *  观察到当前epoch时全局epoch才能前进，在epoch e时retire的对象在全局
+ *  epoch到达e + 2后才会真正释放，此时不可能再有读者持有它。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_EPOCH_H
+#define MINIKVDB_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "../utils/lock.h"
+
+namespace minikvdb
+{
+    // 单例模式创建epoch管理器
+    class EpochManager
+    {
+    public:
+        static EpochManager *get_instance()
+        {
+            static EpochManager instance;
+            return &instance;
+        }
+
+        /**
+         * @description:    当前线程进入读临界区，可嵌套
+         * @return {*}
+         */
+        void Enter();
+
+        /**
+         * @description:    当前线程退出读临界区，与Enter成对调用
+         * @return {*}
+         */
+        void Exit();
+
+        /**
+         * @description:                    延迟释放一个已从共享结构上摘除的对象
+         * @param {void} *p                 待释放对象
+         * @param {void (*)(void *)} deleter 释放函数
+         * @return {*}
+         */
+        void Retire(void *p, void (*deleter)(void *));
+
+        /**
+         * @description:    尝试推进全局epoch，并释放所有已经安全的对象
+         * @return {*}      本次释放的对象数量
+         */
+        size_t TryReclaim();
+
+        // 尚未释放的对象数量
+        size_t PendingCount();
+
+        inline uint64_t GetEpoch() { return global_epoch_.load(std::memory_order_acquire); }
+
+    private:
+        EpochManager() = default;
+        ~EpochManager();
+
+        EpochManager(const EpochManager &) = delete;
+        EpochManager &operator=(const EpochManager &) = delete;
+
+        // 线程槽位：state = (epoch << 1) | active
+        struct alignas(kCacheLineSize) ThreadRecord
+        {
+            std::atomic<uint64_t> state{0};
+            std::atomic<bool> in_use{false};
+        };
+
+        struct Retired
+        {
+            void *ptr;
+            void (*deleter)(void *);
+            uint64_t epoch;
+        };
+
+        // 线程私有信息，线程退出时归还槽位
+        struct ThreadHandle
+        {
+            int slot = -1;
+            int depth = 0; // 临界区嵌套深度
+            ~ThreadHandle();
+        };
+
+        int AcquireSlot();
+
+        static ThreadHandle &LocalHandle();
+
+    private:
+        enum
+        {
+            kMaxThreads = 256,      // 最多同时有多少线程使用EBR
+            kReclaimInterval = 64   // 每retire多少个对象尝试回收一次
+        };
+
+        std::atomic<uint64_t> global_epoch_{1};
+        std::atomic<int> slot_high_water_{0}; // 曾经使用过的最大槽位+1，回收时只扫描这些槽位
+        ThreadRecord records_[kMaxThreads];
+
+        MutexLock mutex_; // 保护retired_与epoch推进
+        std::vector<Retired> retired_;
+        size_t retired_since_reclaim_ = 0;
+    };
+
+    // 读临界区RAII封装
+    class EpochGuard
+    {
+    public:
+        EpochGuard() { EpochManager::get_instance()->Enter(); }
+
+        ~EpochGuard() { EpochManager::get_instance()->Exit(); }
+
+        EpochGuard(const EpochGuard &) = delete;
+        EpochGuard &operator=(const EpochGuard &) = delete;
+    };
+}
+
+#endif
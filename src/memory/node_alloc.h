@@ -0,0 +1,69 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-23 10:02:18
+ * @LastEditTime: 2026-10-23 10:02:18
+ * @FilePath: /miniKV/src/memory/node_alloc.h
+ * @Description: 内存表结点(跳表结点、哈希桶结点、B+树entry)的分配入口
+ *
+ * ********************************
+ *  每个kv对应一次小块分配，大小只取决于层高与Slice内容长度，正好落在PoolAlloc的size class内。
+ *  MINIKVDB_NODE_POOL_ALLOC为1(默认，cmake -DMINIKVDB_NODE_POOL_ALLOC=OFF关闭)时走PoolAlloc，
+ *  分配/释放通常只访问线程缓存；为0时退回::operator new/delete，便于用sanitizer或其他malloc排查问题。
+ *  释放时必须给出与分配时相同的大小。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_NODE_ALLOC_H
+#define MINIKVDB_NODE_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "pool_alloc.h"
+
+#ifndef MINIKVDB_NODE_POOL_ALLOC
+#define MINIKVDB_NODE_POOL_ALLOC 1
+#endif
+
+namespace minikvdb
+{
+    /**
+     * @description:        分配一个结点，至少16字节对齐
+     * @param {size_t} n    结点大小(含内联的key/value内容)
+     * @return {*}
+     */
+    inline void *AllocateNode(size_t n)
+    {
+#if MINIKVDB_NODE_POOL_ALLOC
+        void *p = PoolAlloc().Allocate(static_cast<int32_t>(n));
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+#else
+        return ::operator new(n);
+#endif
+    }
+
+    /**
+     * @description:        释放AllocateNode分配的结点
+     * @param {void} *p     结点地址
+     * @param {size_t} n    与分配时相同的大小
+     * @return {*}
+     */
+    inline void DeallocateNode(void *p, size_t n)
+    {
+#if MINIKVDB_NODE_POOL_ALLOC
+        PoolAlloc().Deallocate(p, static_cast<int32_t>(n));
+#else
+        (void)n;
+        ::operator delete(p);
+#endif
+    }
+}
+
+#endif
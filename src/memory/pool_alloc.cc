@@ -0,0 +1,465 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 20:05:47
+ * @LastEditTime: 2026-10-23 10:02:18
+ * @FilePath: /miniKV/src/memory/pool_alloc.cc
+ * @Description: 按大小分级的空闲链表内存池实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "pool_alloc.h"
+#include "../utils/lock.h"
+
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+namespace minikvdb
+{
+    namespace
+    {
+        const int32_t kClassSizes[] = {
+            16, 32, 48, 64, 80, 96, 112, 128,
+            160, 192, 224, 256, 320, 384, 448, 512,
+            640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+            2560, 3072, 3584, 4096};
+        const int kNumClasses = sizeof(kClassSizes) / sizeof(kClassSizes[0]);
+
+        const size_t kChunkSize = 64 * 1024; // 中心仓库每次向系统申请的大小
+
+        // 空闲对象复用自身的前8个字节作为链表指针
+        struct FreeObject
+        {
+            FreeObject *next;
+        };
+
+        // 请求大小 -> size class下标，按16字节粒度查表
+        struct ClassMap
+        {
+            uint8_t index[PoolAlloc::kMaxSmallSize / 16 + 1];
+
+            ClassMap()
+            {
+                int cls = 0;
+                for (int i = 0; i <= PoolAlloc::kMaxSmallSize / 16; ++i)
+                {
+                    while (kClassSizes[cls] < i * 16)
+                    {
+                        ++cls;
+                    }
+                    index[i] = static_cast<uint8_t>(cls);
+                }
+            }
+        };
+
+        const ClassMap &GetClassMap()
+        {
+            static const ClassMap map;
+            return map;
+        }
+
+        inline int SizeClass(int32_t n)
+        {
+            return GetClassMap().index[(n + 15) >> 4];
+        }
+
+        // 线程缓存与中心仓库一次交换的对象数量：小对象多换一些，大对象少换一些
+        inline uint32_t BatchSize(int cls)
+        {
+            int32_t n = static_cast<int32_t>(32 * 1024 / kClassSizes[cls]);
+            return static_cast<uint32_t>(n < 2 ? 2 : (n > 64 ? 64 : n));
+        }
+
+        // 仅由所属线程写入、其他线程只读的计数器，避免加锁指令
+        inline void Bump(std::atomic<uint64_t> &c, uint64_t delta = 1)
+        {
+            c.store(c.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        // 各线程计数器的累加结果
+        struct Totals
+        {
+            uint64_t alloc_count = 0;
+            uint64_t free_count = 0;
+            uint64_t large_alloc_count = 0;
+            uint64_t cache_hits = 0;
+            uint64_t depot_fetches = 0;
+            uint64_t depot_releases = 0;
+            uint64_t bytes_allocated = 0;
+            uint64_t bytes_freed = 0;
+        };
+
+        struct ThreadCache;
+
+        // 全局中心仓库
+        class Depot
+        {
+        public:
+            ~Depot()
+            {
+                for (void *chunk : chunks_)
+                {
+                    free(chunk);
+                }
+            }
+
+            /**
+             * @description:            批量取出对象
+             * @param {int} cls         size class
+             * @param {uint32_t} want   期望数量
+             * @param {uint32_t} *got   实际数量
+             * @return {*}              对象链表
+             */
+            FreeObject *Fetch(int cls, uint32_t want, uint32_t *got)
+            {
+                CentralList &list = lists_[cls];
+                ScopedLock<SpinLock> guard(list.lock);
+                if (list.count < want)
+                {
+                    Refill(cls, list);
+                }
+                FreeObject *head = list.head;
+                FreeObject *tail = head;
+                uint32_t n = 1;
+                while (n < want && tail->next != nullptr)
+                {
+                    tail = tail->next;
+                    ++n;
+                }
+                list.head = tail->next;
+                list.count -= n;
+                tail->next = nullptr;
+                *got = n;
+                return head;
+            }
+
+            // 批量归还一条以nullptr结尾的链表
+            void Release(int cls, FreeObject *head, FreeObject *tail, uint32_t n)
+            {
+                CentralList &list = lists_[cls];
+                ScopedLock<SpinLock> guard(list.lock);
+                tail->next = list.head;
+                list.head = head;
+                list.count += n;
+            }
+
+            void Register(ThreadCache *cache)
+            {
+                ScopedLock<MutexLock> guard(registry_mutex_);
+                caches_.push_back(cache);
+            }
+
+            void Unregister(ThreadCache *cache);
+
+            PoolAllocStats Collect();
+
+            std::atomic<uint64_t> bytes_reserved{0};
+
+        private:
+            struct alignas(kCacheLineSize) CentralList
+            {
+                SpinLock lock;
+                FreeObject *head = nullptr;
+                uint32_t count = 0;
+            };
+
+            // 从系统申请一个chunk切分成对象放入链表，调用者持有list.lock
+            void Refill(int cls, CentralList &list)
+            {
+                const size_t size = kClassSizes[cls];
+                char *chunk = static_cast<char *>(malloc(kChunkSize));
+                if (chunk == nullptr)
+                {
+                    fprintf(stderr, "PoolAlloc: out of memory\n");
+                    abort();
+                }
+                {
+                    ScopedLock<MutexLock> guard(chunks_mutex_);
+                    chunks_.push_back(chunk);
+                }
+                bytes_reserved.fetch_add(kChunkSize, std::memory_order_relaxed);
+                size_t objects = kChunkSize / size;
+                for (size_t i = objects; i > 0; --i)
+                {
+                    auto obj = reinterpret_cast<FreeObject *>(chunk + (i - 1) * size);
+                    obj->next = list.head;
+                    list.head = obj;
+                }
+                list.count += static_cast<uint32_t>(objects);
+            }
+
+            CentralList lists_[kNumClasses];
+
+            MutexLock chunks_mutex_;
+            std::vector<void *> chunks_;
+
+            MutexLock registry_mutex_;
+            std::vector<ThreadCache *> caches_;
+            Totals retired_; // 已退出线程的统计
+        };
+
+        // 中心仓库不析构：静态对象析构阶段(如EpochManager释放延迟回收的结点)仍可能释放对象
+        Depot &GetDepot()
+        {
+            static Depot *depot = new Depot();
+            return *depot;
+        }
+
+        // 本线程的缓存已析构(线程退出或进程退出阶段)，之后的分配/释放直接访问中心仓库
+        thread_local bool cache_destroyed = false;
+
+        // 线程私有缓存
+        struct ThreadCache
+        {
+            struct List
+            {
+                FreeObject *head = nullptr;
+                uint32_t count = 0;
+            };
+
+            List lists[kNumClasses];
+
+            std::atomic<uint64_t> alloc_count{0};
+            std::atomic<uint64_t> free_count{0};
+            std::atomic<uint64_t> large_alloc_count{0};
+            std::atomic<uint64_t> cache_hits{0};
+            std::atomic<uint64_t> depot_fetches{0};
+            std::atomic<uint64_t> depot_releases{0};
+            std::atomic<uint64_t> bytes_allocated{0};
+            std::atomic<uint64_t> bytes_freed{0};
+
+            ThreadCache() { GetDepot().Register(this); }
+
+            ~ThreadCache()
+            {
+                // 线程退出，缓存的对象全部还给中心仓库
+                for (int cls = 0; cls < kNumClasses; ++cls)
+                {
+                    List &list = lists[cls];
+                    if (list.head == nullptr)
+                    {
+                        continue;
+                    }
+                    FreeObject *tail = list.head;
+                    while (tail->next != nullptr)
+                    {
+                        tail = tail->next;
+                    }
+                    GetDepot().Release(cls, list.head, tail, list.count);
+                    list.head = nullptr;
+                    list.count = 0;
+                }
+                GetDepot().Unregister(this);
+                cache_destroyed = true;
+            }
+
+            void *Allocate(int cls)
+            {
+                List &list = lists[cls];
+                Bump(alloc_count);
+                Bump(bytes_allocated, kClassSizes[cls]);
+                if (list.head != nullptr)
+                {
+                    Bump(cache_hits);
+                }
+                else
+                {
+                    Bump(depot_fetches);
+                    list.head = GetDepot().Fetch(cls, BatchSize(cls), &list.count);
+                }
+                FreeObject *obj = list.head;
+                list.head = obj->next;
+                --list.count;
+                return obj;
+            }
+
+            void Deallocate(void *p, int cls)
+            {
+                List &list = lists[cls];
+                Bump(free_count);
+                Bump(bytes_freed, kClassSizes[cls]);
+                auto obj = static_cast<FreeObject *>(p);
+                obj->next = list.head;
+                list.head = obj;
+                ++list.count;
+
+                // 缓存过多时归还一批，避免一个线程囤积另一个线程释放的对象
+                uint32_t batch = BatchSize(cls);
+                if (list.count > 2 * batch)
+                {
+                    FreeObject *head = list.head;
+                    FreeObject *tail = head;
+                    for (uint32_t i = 1; i < batch; ++i)
+                    {
+                        tail = tail->next;
+                    }
+                    list.head = tail->next;
+                    list.count -= batch;
+                    tail->next = nullptr;
+                    Bump(depot_releases);
+                    GetDepot().Release(cls, head, tail, batch);
+                }
+            }
+
+            void AddTo(Totals &t) const
+            {
+                t.alloc_count += alloc_count.load(std::memory_order_relaxed);
+                t.free_count += free_count.load(std::memory_order_relaxed);
+                t.large_alloc_count += large_alloc_count.load(std::memory_order_relaxed);
+                t.cache_hits += cache_hits.load(std::memory_order_relaxed);
+                t.depot_fetches += depot_fetches.load(std::memory_order_relaxed);
+                t.depot_releases += depot_releases.load(std::memory_order_relaxed);
+                t.bytes_allocated += bytes_allocated.load(std::memory_order_relaxed);
+                t.bytes_freed += bytes_freed.load(std::memory_order_relaxed);
+            }
+        };
+
+        void Depot::Unregister(ThreadCache *cache)
+        {
+            ScopedLock<MutexLock> guard(registry_mutex_);
+            cache->AddTo(retired_);
+            for (size_t i = 0; i < caches_.size(); ++i)
+            {
+                if (caches_[i] == cache)
+                {
+                    caches_[i] = caches_.back();
+                    caches_.pop_back();
+                    break;
+                }
+            }
+        }
+
+        PoolAllocStats Depot::Collect()
+        {
+            Totals t;
+            {
+                ScopedLock<MutexLock> guard(registry_mutex_);
+                t = retired_;
+                for (ThreadCache *cache : caches_)
+                {
+                    cache->AddTo(t);
+                }
+            }
+            PoolAllocStats s;
+            s.alloc_count = t.alloc_count;
+            s.free_count = t.free_count;
+            s.large_alloc_count = t.large_alloc_count;
+            s.cache_hits = t.cache_hits;
+            s.depot_fetches = t.depot_fetches;
+            s.depot_releases = t.depot_releases;
+            // 对象可能在另一个线程释放，只有汇总后的差值才有意义
+            s.bytes_in_use = t.bytes_allocated > t.bytes_freed ? t.bytes_allocated - t.bytes_freed : 0;
+            s.bytes_reserved = bytes_reserved.load(std::memory_order_relaxed);
+            return s;
+        }
+
+        // 缓存已析构时返回nullptr
+        ThreadCache *LocalCache()
+        {
+            if (cache_destroyed)
+            {
+                return nullptr;
+            }
+            thread_local ThreadCache cache;
+            return &cache;
+        }
+    }
+
+    void *PoolAlloc::Allocate(int32_t n)
+    {
+        ThreadCache *cache = LocalCache();
+        if (n > kMaxSmallSize)
+        {
+            if (cache != nullptr)
+            {
+                Bump(cache->alloc_count);
+                Bump(cache->large_alloc_count);
+            }
+            return malloc(n);
+        }
+        const int cls = SizeClass(n < 1 ? 1 : n);
+        if (cache == nullptr)
+        {
+            uint32_t got = 0;
+            return GetDepot().Fetch(cls, 1, &got);
+        }
+        return cache->Allocate(cls);
+    }
+
+    void PoolAlloc::Deallocate(void *p, int32_t n)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+        ThreadCache *cache = LocalCache();
+        if (n > kMaxSmallSize)
+        {
+            if (cache != nullptr)
+            {
+                Bump(cache->free_count);
+            }
+            free(p);
+            return;
+        }
+        const int cls = SizeClass(n < 1 ? 1 : n);
+        if (cache == nullptr)
+        {
+            auto obj = static_cast<FreeObject *>(p);
+            GetDepot().Release(cls, obj, obj, 1);
+            return;
+        }
+        cache->Deallocate(p, cls);
+    }
+
+    void *PoolAlloc::Reallocate(void *p, int32_t old_size, int32_t new_size)
+    {
+        if (p == nullptr)
+        {
+            return Allocate(new_size);
+        }
+        // 新旧大小落在同一个size class时无需搬移
+        if (old_size <= kMaxSmallSize && new_size <= kMaxSmallSize &&
+            RoundUpSize(old_size) == RoundUpSize(new_size))
+        {
+            return p;
+        }
+        if (old_size > kMaxSmallSize && new_size > kMaxSmallSize)
+        {
+            return realloc(p, new_size);
+        }
+        void *q = Allocate(new_size);
+        memcpy(q, p, old_size < new_size ? old_size : new_size);
+        Deallocate(p, old_size);
+        return q;
+    }
+
+    PoolAllocStats PoolAlloc::GetStats()
+    {
+        return GetDepot().Collect();
+    }
+
+    int32_t PoolAlloc::RoundUpSize(int32_t n)
+    {
+        if (n > kMaxSmallSize)
+        {
+            return n;
+        }
+        return kClassSizes[SizeClass(n < 1 ? 1 : n)];
+    }
+
+    std::string PoolAllocStats::ToString() const
+    {
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+                 "alloc_count=%llu free_count=%llu large_alloc_count=%llu cache_hits=%llu "
+                 "depot_fetches=%llu depot_releases=%llu bytes_in_use=%llu bytes_reserved=%llu",
+                 (unsigned long long)alloc_count, (unsigned long long)free_count,
+                 (unsigned long long)large_alloc_count, (unsigned long long)cache_hits,
+                 (unsigned long long)depot_fetches, (unsigned long long)depot_releases,
+                 (unsigned long long)bytes_in_use, (unsigned long long)bytes_reserved);
+        return buf;
+    }
+}
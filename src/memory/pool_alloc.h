@@ -0,0 +1,96 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 20:05:47
+ * @LastEditTime: 2026-10-18 20:05:47
+ * @FilePath: /miniKV/src/memory/pool_alloc.h
+ * @Description: 按大小分级的空闲链表内存池(FreeListAllocate)
+ *
+ * ********************************
+ *  设计借鉴于tcmalloc：
+ *  - 不超过kMaxSmallSize的请求按大小向上取整到若干个size class，每个class一条空闲链表
+ *  - 每个线程持有自己的缓存(ThreadCache)，分配/释放通常无需加锁
+ *  - 线程缓存为空或过多时与全局中心仓库(depot)批量交换对象
+ *  - 更大的请求直接交给malloc/free
+ *  中心仓库只从系统申请大块内存切分，进程退出前不归还系统
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_POOL_ALLOC_H
+#define MINIKVDB_POOL_ALLOC_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace minikvdb
+{
+    // 内存池统计信息
+    struct PoolAllocStats
+    {
+        uint64_t alloc_count = 0;      // Allocate调用次数(含大块)
+        uint64_t free_count = 0;       // Deallocate调用次数(含大块)
+        uint64_t large_alloc_count = 0; // 超过kMaxSmallSize直接走malloc的次数
+        uint64_t cache_hits = 0;       // 直接命中线程缓存的小块分配次数
+        uint64_t depot_fetches = 0;    // 线程缓存从中心仓库批量取对象的次数
+        uint64_t depot_releases = 0;   // 线程缓存向中心仓库批量归还对象的次数
+        uint64_t bytes_in_use = 0;     // 已分配未释放的小块字节数(按size class计)
+        uint64_t bytes_reserved = 0;   // 中心仓库从系统申请的总字节数
+
+        std::string ToString() const;
+    };
+
+    // 接口与DefaultAlloc一致，所有实例共享同一个全局内存池
+    class PoolAlloc
+    {
+    public:
+        PoolAlloc() = default;
+
+        ~PoolAlloc() = default;
+
+        /**
+         * @description:        内存分配函数
+         * @param {int32_t} n   分配内存size
+         * @return {*}          已分配内存，至少16字节对齐
+         */
+        void *Allocate(int32_t n);
+
+        /**
+         * @description:        内存释放函数
+         * @param {void} *p     已分配地址
+         * @param {int32_t} n   已分配内存size，必须与分配时一致
+         * @return {*}
+         */
+        void Deallocate(void *p, int32_t n);
+
+        /**
+         * @description:                内存扩容函数
+         * @param {void} *p             已分配地址
+         * @param {int32_t} old_size    已分配内存size
+         * @param {int32_t} new_size    扩容内存size
+         * @return {*}
+         */
+        void *Reallocate(void *p, int32_t old_size, int32_t new_size);
+
+        /**
+         * @description:    汇总所有线程的统计信息
+         * @return {*}      PoolAllocStats
+         */
+        static PoolAllocStats GetStats();
+
+        /**
+         * @description:        请求大小对应的size class实际大小
+         * @param {int32_t} n   请求大小
+         * @return {*}          size class大小，大块请求返回n
+         */
+        static int32_t RoundUpSize(int32_t n);
+
+        enum
+        {
+            kMaxSmallSize = 4096 // 不超过该大小的请求走内存池
+        };
+    };
+}
+
+#endif
@@ -0,0 +1,1073 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 19:08:36
+ * @LastEditTime: 2026-10-22 19:08:36
+ * @FilePath: /miniKV/src/memtable/bplus_tree.h
+ * @Description: 缓存友好的B+树内存表结构
+ *
+ * ********************************
+ *  跳表每前进一步都要访问一个新结点，范围扫描时几乎每个key都是一次cache miss；
+ *  B+树把Capacity个相邻的kv指针连续放在同一个叶子中，查找时每层只访问一个结点，
+ *  扫描时一个叶子内的entry地址事先已知，可以预取。
+ *  线程安全与SkipList一致：写操作(Insert/Delete)需要外部同步，读操作(Get/Contains/迭代器)无需加锁。
+ *  读者使用乐观锁(思路借鉴于OLC，Optimistic Lock Coupling)：每个结点带一个版本号，
+ *  写者修改结点前把版本号改为奇数、改完后再加一；读者读结点前后比较版本号，不一致则从根重新查找，
+ *  下降时先拿到子结点的版本号再校验父结点，保证看到的父子关系是一致的。
+ *  kv存放在独立分配的entry中，发布后不再修改，Delete摘除的entry通过EpochManager延迟释放；
+ *  结点之间只会分裂、不会合并，删空的叶子保留在树中。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_BPLUS_TREE_H
+#define MINIKVDB_BPLUS_TREE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "../memory/default_alloc.h"
+#include "../memory/epoch.h"
+#include "../memory/node_alloc.h"
+#include "../utils/lock.h"
+#include "../utils/perf_context.h"
+#include "../utils/statistics.h"
+#include "comparator.h"
+#include "kv_size.h"
+
+// 每个结点最多容纳的key数，可在编译时覆盖；默认32个指针即叶子中4条cache line
+#ifndef MINIKVDB_BPLUS_TREE_NODE_CAPACITY
+#define MINIKVDB_BPLUS_TREE_NODE_CAPACITY 32
+#endif
+
+namespace minikvdb
+{
+    template <typename Key, typename Value, class Comparator, int Capacity = MINIKVDB_BPLUS_TREE_NODE_CAPACITY>
+    class BPlusTree
+    {
+        struct Entry;
+        struct NodeBase;
+        struct Leaf;
+        struct Inner;
+
+    public:
+        /**
+         * @description:                            显示调用BPlusTree构造函数
+         * @param {Comparator} cmp                  key比较函数
+         * @param {shared_ptr<DefaultAlloc>} alloc  内存分配器
+         * @return {*}
+         */
+        explicit BPlusTree(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc);
+
+        // 析构时不能再有并发读者
+        ~BPlusTree();
+
+        // 删除拷贝构造函数
+        BPlusTree(const BPlusTree &) = delete;
+        BPlusTree &operator=(const BPlusTree &) = delete;
+
+        /**
+         * @description:                key-vaue插入函数, 语义与SkipList::Insert一致，key已存在时忽略本次插入
+         * @param {Key} &key            key
+         * @param {Value} &value        value
+         * @return {*}
+         */
+        void Insert(const Key &key, const Value &value) { InsertImpl(key, value); }
+
+        // 右值版本：key/value直接移动进entry，不再拷贝
+        void Insert(Key &&key, Value &&value) { InsertImpl(std::move(key), std::move(value)); }
+
+        /**
+         * @description:                删除key对应的value，key不存在时什么也不做
+         * @param {Key} &key            key
+         * @return {*}
+         */
+        void Delete(const Key &key);
+
+        /**
+         * @description:                检查是否存在key
+         * @param {Key} &key            key
+         * @return {*}                  true/false
+         */
+        bool Contains(const Key &key) { return ContainsImpl(key); }
+
+        /**
+         * @description:                key-value查找函数
+         * @param {Key} &key            key
+         * @return {*}                  存在返回value，不存在返回nullopt
+         */
+        std::optional<Value> Get(const Key &key) { return GetImpl(key); }
+
+        /**
+         * @description:                key-value查找函数，结果写入调用方提供的缓冲区，语义与SkipList一致
+         * @param {Key} &key            key
+         * @param {Value} *value        输出，不存在时保持不变
+         * @return {*}                  是否存在
+         */
+        bool Get(const Key &key, Value *value) { return GetImpl(key, value); }
+
+        /*
+         * 固定在entry上的value视图，语义与SkipList::PinnedValue一致：
+         * 存活期间处于epoch读临界区，entry即使被并发删除也不会被释放
+         */
+        class PinnedValue
+        {
+        public:
+            PinnedValue() = default;
+
+            PinnedValue(const PinnedValue &) = delete;
+            PinnedValue &operator=(const PinnedValue &) = delete;
+
+            inline bool Valid() const { return value_ != nullptr; }
+
+            inline const Value &value() const
+            {
+                assert(Valid());
+                return *value_;
+            }
+
+            // 解除固定，之后不能再访问value()
+            inline void Reset()
+            {
+                value_ = nullptr;
+                guard_.reset();
+            }
+
+        private:
+            friend class BPlusTree;
+
+            const Value *value_ = nullptr;
+            std::optional<EpochGuard> guard_;
+        };
+
+        /**
+         * @description:                    零拷贝查找
+         * @param {Key} &key                key
+         * @param {PinnedValue} *pinned     输出，存在时固定在entry的value上，不存在时被Reset
+         * @return {*}                      是否存在
+         */
+        bool GetPinned(const Key &key, PinnedValue *pinned) { return GetPinnedImpl(key, pinned); }
+
+        // 异构查找，语义与SkipList一致
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Contains(const K &key) { return ContainsImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        std::optional<Value> Get(const K &key) { return GetImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Get(const K &key, Value *value) { return GetImpl(key, value); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool GetPinned(const K &key, PinnedValue *pinned) { return GetPinnedImpl(key, pinned); }
+
+        /**
+         * @description:                    批量查找，接口与SkipList::MultiGet一致；
+         *                                  每个key各自从根查找，树高很低，没有可复用的查找路径
+         * @param {size_t} n                key数量
+         * @param {Key} *const *keys        待查找的key
+         * @param {optional<Value>} *values 输出，与keys一一对应
+         * @return {*}
+         */
+        void MultiGet(size_t n, const Key *const *keys, std::optional<Value> *values);
+
+        inline int GetSize() { return size; }
+
+        inline int64_t GetMemUsage() { return mem_usage; }
+
+        // 树高，只有一个叶子时为1
+        inline int GetHeight() const { return height_; }
+
+        // 设置统计对象，需在并发访问开始前调用；为空时不统计
+        inline void SetStatistics(std::shared_ptr<Statistics> stats) { stats_ = std::move(stats); }
+
+        /*
+         * 有序迭代器，接口与SkipListIterator一致
+         * 每次把一个叶子的entry指针拷贝到迭代器内(校验版本号保证拷贝完整)，再在拷贝上前进；
+         * 迭代器存活期间处于epoch读临界区，拷贝中的entry即使被并发删除也不会被释放
+         */
+        class BPlusTreeIterator
+        {
+        public:
+            explicit BPlusTreeIterator(const BPlusTree *tree);
+
+            // 如果当前iter指向的位置有效，则返回true
+            bool Valid();
+
+            const Key &key();
+
+            const Value &value();
+
+            void Next();
+
+            void Prev() = delete;
+
+            // 将当前位置移到第一个kv，必须要先调用此函数或Seek才可以进行迭代
+            void MoveToFirst();
+
+            // 将当前位置移到第一个key >= target的kv
+            void Seek(const Key &target);
+
+        private:
+            // 拷贝leaf中的entry，只保留key大于(inclusive时为不小于)bound的部分
+            void LoadLeaf(Leaf *leaf, const Key *bound, bool inclusive);
+
+            // 沿叶子链表找到下一个在bound之后还有entry的叶子
+            void SkipEmptyLeaves(const Key *bound, bool inclusive);
+
+            const BPlusTree *tree_;
+            Leaf *leaf_ = nullptr;                // 当前拷贝来自的叶子，为空表示迭代结束
+            std::array<Entry *, Capacity> entries_; // 当前叶子的拷贝
+            int count_ = 0;
+            int pos_ = 0;
+            EpochGuard guard_; // 保护拷贝中的entry不被回收
+        };
+
+        using Iterator = BPlusTreeIterator;
+
+    private:
+        enum
+        {
+            kCapacity = Capacity,
+            kMaxDepth = 64 // 查找路径的最大长度，每个结点至少有两个孩子，足以容纳任何可能的数据量
+        };
+        static_assert(kCapacity >= 3, "BPlusTree node capacity must be at least 3");
+
+        // 写者记录的查找路径上的一步
+        struct PathStep
+        {
+            Inner *node;
+            int child; // 下降到的孩子下标
+        };
+        using Path = std::array<PathStep, kMaxDepth>;
+
+        /**
+         * @description:                    读者从根查找到key所在的叶子，返回前已校验父结点
+         * @param {K} &key                  Key或与Key可比较的类型
+         * @param {uint64_t} *version       输出，叶子的版本号
+         * @param {uint64_t} *cmp_count     累加key比较次数
+         * @return {*}                      期间有写者修改路径上的结点时返回nullptr，需要重试
+         */
+        template <typename K>
+        Leaf *TryFindLeaf(const K &key, uint64_t *version, uint64_t *cmp_count) const;
+
+        /**
+         * @description:                    查找key所在的entry，调用方需处于epoch读临界区
+         * @param {K} &key                  Key或与Key可比较的类型
+         * @param {uint64_t} *cmp_count     输出，key比较次数
+         * @return {*}                      不存在返回nullptr
+         */
+        template <typename K>
+        Entry *SearchEntry(const K &key, uint64_t *cmp_count) const;
+
+        // 在SearchEntry基础上记录点查的perf context与统计信息
+        template <typename K>
+        Entry *FindEntry(const K &key);
+
+        // 写者从根查找到key所在的叶子并记录路径
+        Leaf *FindLeafForWrite(const Key &key, Path &path, int *depth, uint64_t *cmp_count);
+
+        // 内部结点中key应下降到的孩子下标；读到不一致的数据时返回-1
+        template <typename K>
+        int ChildIndex(const Inner *node, const K &key, uint64_t *cmp_count) const;
+
+        // 叶子中第一个key >= key的位置，*equal表示该位置的key与key相等；读到不一致的数据时返回-1
+        template <typename K>
+        int LeafLowerBound(const Leaf *leaf, const K &key, bool *equal, uint64_t *cmp_count) const;
+
+        template <typename K>
+        bool ContainsImpl(const K &key);
+
+        template <typename K>
+        std::optional<Value> GetImpl(const K &key);
+
+        template <typename K>
+        bool GetImpl(const K &key, Value *value);
+
+        template <typename K>
+        bool GetPinnedImpl(const K &key, PinnedValue *pinned);
+
+        template <typename K, typename V>
+        void InsertImpl(K &&key, V &&value);
+
+        /**
+         * @description:                    叶子已满时分裂叶子，并把分隔key逐层插入父结点，必要时产生新的根
+         * @param {Leaf} *leaf              待插入的叶子
+         * @param {int} pos                 entry在叶子中的插入位置
+         * @param {Entry} *entry            新entry
+         * @param {Path} &path              从根到叶子的路径
+         * @param {int} depth               路径上内部结点的数量
+         * @return {*}
+         */
+        void SplitAndInsert(Leaf *leaf, int pos, Entry *entry, Path &path, int depth);
+
+        // 新建一个entry，Slice类型key/value的内容与entry在同一次分配中
+        template <typename K, typename V>
+        static Entry *NewEntry(K &&key, V &&value);
+
+        // 内部结点中的分隔key是独立的拷贝，不依赖可能被删除的entry
+        static const Key *NewSeparator(const Key &key);
+
+        static void DestroySeparator(const Key *key);
+
+        // 释放以node为根的子树(含其中的entry与分隔key)
+        static void DestroySubtree(NodeBase *node);
+
+        std::atomic<NodeBase *> root_;
+        Leaf *head_leaf_; // 最左侧的叶子，分裂只会产生右兄弟，因此它始终是第一个叶子
+        int height_ = 1;
+
+        std::shared_ptr<DefaultAlloc> alloc;
+
+        int64_t size = 0;          // 表中数据量(kv键值对数量)
+        int64_t mem_usage = 0;     // kv键值对所占用的内存大小，单位：Byte
+        Comparator const compare_; // 比较函数
+
+        std::shared_ptr<Statistics> stats_; // 统计信息，可为空
+    };
+
+    /*================================================================
+    *  B+树 entry 与结点定义
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    struct BPlusTree<Key, Value, Comparator, Capacity>::Entry
+    {
+        template <typename K, typename V>
+        Entry(K &&k, V &&v) : key(std::forward<K>(k)), value(std::forward<V>(v))
+        {
+        }
+
+        // 供EpochManager延迟释放
+        static void Destroy(void *p)
+        {
+            Entry *entry = static_cast<Entry *>(p);
+            const size_t n = sizeof(Entry) + InlineBytesOf<Key>(entry->key) + InlineBytesOf<Value>(entry->value);
+            entry->~Entry();
+            DeallocateNode(entry, n);
+        }
+
+        const Key key;
+        Value value;
+    };
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    struct alignas(kCacheLineSize) BPlusTree<Key, Value, Comparator, Capacity>::NodeBase
+    {
+        explicit NodeBase(bool leaf) : is_leaf(leaf) {}
+
+        // 读者：等待正在进行的修改结束，返回版本号
+        uint64_t StableVersion() const
+        {
+            uint64_t v = version.load(std::memory_order_acquire);
+            while (v & 1)
+            {
+                std::this_thread::yield();
+                v = version.load(std::memory_order_acquire);
+            }
+            return v;
+        }
+
+        // 读者：读取结点内容之后调用，期间没有写者修改时返回true
+        bool Validate(uint64_t v) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return version.load(std::memory_order_relaxed) == v;
+        }
+
+        // 写者：开始修改，之后的写入对读者可见时读者一定能看到奇数版本号
+        void Lock()
+        {
+            version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        // 写者：修改结束
+        void Unlock() { version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        // 读者看到的count可能来自一次不完整的修改，使用前截断到合法范围
+        int LoadCount() const
+        {
+            int n = count.load(std::memory_order_relaxed);
+            return n < 0 ? 0 : (n > kCapacity ? kCapacity : n);
+        }
+
+        std::atomic<uint64_t> version{0}; // 奇数表示写者正在修改
+        std::atomic<int> count{0};        // 叶子中的entry数，内部结点中的分隔key数
+        const bool is_leaf;
+    };
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    struct BPlusTree<Key, Value, Comparator, Capacity>::Leaf : NodeBase
+    {
+        Leaf() : NodeBase(true)
+        {
+            for (auto &slot : slots)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<Leaf *> next{nullptr};     // 右兄弟
+        std::atomic<Entry *> slots[Capacity]; // 按key有序
+    };
+
+    // children[i]中的key都小于keys[i]，children[i + 1]中的key都不小于keys[i]
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    struct BPlusTree<Key, Value, Comparator, Capacity>::Inner : NodeBase
+    {
+        Inner() : NodeBase(false)
+        {
+            for (auto &key : keys)
+            {
+                key.store(nullptr, std::memory_order_relaxed);
+            }
+            for (auto &child : children)
+            {
+                child.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<const Key *> keys[Capacity];
+        std::atomic<NodeBase *> children[Capacity + 1];
+    };
+
+    /*================================================================
+    *  B+树 迭代器功能实现
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::BPlusTreeIterator(const BPlusTree *tree)
+        : tree_(tree)
+    {
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::LoadLeaf(Leaf *leaf, const Key *bound,
+                                                                                 bool inclusive)
+    {
+        leaf_ = leaf;
+        while (true)
+        {
+            uint64_t v = leaf->StableVersion();
+            int n = leaf->LoadCount();
+            int kept = 0;
+            bool consistent = true;
+            for (int i = 0; i < n; ++i)
+            {
+                Entry *entry = leaf->slots[i].load(std::memory_order_acquire);
+                if (entry == nullptr)
+                {
+                    consistent = false;
+                    break;
+                }
+                if (bound != nullptr)
+                {
+                    int cmp = tree_->compare_(entry->key, *bound);
+                    if (cmp < 0 || (cmp == 0 && !inclusive))
+                    {
+                        continue;
+                    }
+                }
+                entries_[kept++] = entry;
+            }
+            if (consistent && leaf->Validate(v))
+            {
+                count_ = kept;
+                pos_ = 0;
+                return;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::SkipEmptyLeaves(const Key *bound,
+                                                                                        bool inclusive)
+    {
+        while (leaf_ != nullptr && pos_ >= count_)
+        {
+            Leaf *next = leaf_->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+            {
+                leaf_ = nullptr;
+                return;
+            }
+            // 下一个叶子可能由当前叶子在拷贝之后分裂而来，其中可能有已经访问过的key
+            LoadLeaf(next, bound, inclusive);
+        }
+        if (leaf_ != nullptr && pos_ + 1 < count_)
+        {
+            __builtin_prefetch(entries_[pos_ + 1]);
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::MoveToFirst()
+    {
+        LoadLeaf(tree_->head_leaf_, nullptr, true);
+        SkipEmptyLeaves(nullptr, true);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::Seek(const Key &target)
+    {
+        uint64_t version = 0;
+        uint64_t cmp_count = 0;
+        Leaf *leaf = nullptr;
+        while ((leaf = tree_->TryFindLeaf(target, &version, &cmp_count)) == nullptr)
+        {
+        }
+        // 找到叶子之后它只可能向右分裂，大于等于target的key要么仍在其中，要么在其右侧的叶子中
+        LoadLeaf(leaf, &target, true);
+        SkipEmptyLeaves(&target, true);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::Next()
+    {
+        assert(Valid());
+        ++pos_;
+        if (pos_ < count_)
+        {
+            // 下一个entry的地址已知，提前取入cache
+            if (pos_ + 1 < count_)
+            {
+                __builtin_prefetch(entries_[pos_ + 1]);
+            }
+            return;
+        }
+        const Key *last = &entries_[count_ - 1]->key;
+        SkipEmptyLeaves(last, false);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    const Key &BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::key()
+    {
+        assert(Valid());
+        return entries_[pos_]->key;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    const Value &BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::value()
+    {
+        assert(Valid());
+        return entries_[pos_]->value;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    bool BPlusTree<Key, Value, Comparator, Capacity>::BPlusTreeIterator::Valid()
+    {
+        return leaf_ != nullptr && pos_ < count_;
+    }
+
+    /*================================================================
+    *  B+树 主要功能实现
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    int BPlusTree<Key, Value, Comparator, Capacity>::ChildIndex(const Inner *node, const K &key,
+                                                                 uint64_t *cmp_count) const
+    {
+        // 第一个大于key的分隔key的下标，即为应下降到的孩子
+        int lo = 0;
+        int hi = node->LoadCount();
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            const Key *sep = node->keys[mid].load(std::memory_order_acquire);
+            if (sep == nullptr)
+            {
+                return -1;
+            }
+            ++*cmp_count;
+            if (compare_(*sep, key) <= 0)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    int BPlusTree<Key, Value, Comparator, Capacity>::LeafLowerBound(const Leaf *leaf, const K &key, bool *equal,
+                                                                     uint64_t *cmp_count) const
+    {
+        *equal = false;
+        int lo = 0;
+        int hi = leaf->LoadCount();
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            Entry *entry = leaf->slots[mid].load(std::memory_order_acquire);
+            if (entry == nullptr)
+            {
+                return -1;
+            }
+            ++*cmp_count;
+            int cmp = compare_(entry->key, key);
+            if (cmp < 0)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                *equal = cmp == 0;
+                hi = mid;
+            }
+        }
+        // 结果为hi最后一次收缩的位置，*equal记录的正是该位置的比较结果
+        return lo;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    typename BPlusTree<Key, Value, Comparator, Capacity>::Leaf *BPlusTree<Key, Value, Comparator, Capacity>::TryFindLeaf(
+        const K &key, uint64_t *version, uint64_t *cmp_count) const
+    {
+        NodeBase *node = root_.load(std::memory_order_acquire);
+        uint64_t v = node->StableVersion();
+        // 读到版本号之前根可能已经分裂，旧根只覆盖左半部分
+        if (root_.load(std::memory_order_acquire) != node)
+        {
+            return nullptr;
+        }
+        while (!node->is_leaf)
+        {
+            const Inner *inner = static_cast<const Inner *>(node);
+            int idx = ChildIndex(inner, key, cmp_count);
+            NodeBase *child = idx < 0 ? nullptr : inner->children[idx].load(std::memory_order_acquire);
+            if (child == nullptr || !inner->Validate(v))
+            {
+                return nullptr;
+            }
+            uint64_t child_version = child->StableVersion();
+            // 拿到子结点版本号后再校验父结点：父结点未变，说明此刻子结点仍覆盖key
+            if (!inner->Validate(v))
+            {
+                return nullptr;
+            }
+            node = child;
+            v = child_version;
+        }
+        *version = v;
+        return static_cast<Leaf *>(node);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    typename BPlusTree<Key, Value, Comparator, Capacity>::Entry *BPlusTree<Key, Value, Comparator, Capacity>::SearchEntry(
+        const K &key, uint64_t *cmp_count) const
+    {
+        while (true)
+        {
+            uint64_t version = 0;
+            Leaf *leaf = TryFindLeaf(key, &version, cmp_count);
+            if (leaf == nullptr)
+            {
+                continue;
+            }
+            bool equal = false;
+            int pos = LeafLowerBound(leaf, key, &equal, cmp_count);
+            Entry *found = (pos >= 0 && equal) ? leaf->slots[pos].load(std::memory_order_acquire) : nullptr;
+            if (pos >= 0 && leaf->Validate(version))
+            {
+                return found;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    typename BPlusTree<Key, Value, Comparator, Capacity>::Entry *BPlusTree<Key, Value, Comparator, Capacity>::FindEntry(
+        const K &key)
+    {
+        PERF_TIMER_GUARD(get_search_cycles);
+        uint64_t cmp_count = 0;
+        Entry *found = SearchEntry(key, &cmp_count);
+        PERF_TIMER_STOP(get_search_cycles);
+
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+            stats_->RecordInHistogram(HistogramType::kComparisonsPerGet, cmp_count);
+        }
+        return found;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    bool BPlusTree<Key, Value, Comparator, Capacity>::ContainsImpl(const K &key)
+    {
+        EpochGuard guard;
+        uint64_t cmp_count = 0;
+        return SearchEntry(key, &cmp_count) != nullptr;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    std::optional<Value> BPlusTree<Key, Value, Comparator, Capacity>::GetImpl(const K &key)
+    {
+        EpochGuard guard;
+        Entry *found = FindEntry(key);
+        if (found == nullptr)
+        {
+            return std::nullopt;
+        }
+        return found->value;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    bool BPlusTree<Key, Value, Comparator, Capacity>::GetImpl(const K &key, Value *value)
+    {
+        EpochGuard guard;
+        Entry *found = FindEntry(key);
+        if (found == nullptr)
+        {
+            return false;
+        }
+        *value = found->value;
+        return true;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K>
+    bool BPlusTree<Key, Value, Comparator, Capacity>::GetPinnedImpl(const K &key, PinnedValue *pinned)
+    {
+        pinned->Reset();
+        pinned->guard_.emplace(); // 先进入临界区再查找，保证找到的entry在pinned存活期间不被释放
+        Entry *found = FindEntry(key);
+        if (found == nullptr)
+        {
+            pinned->Reset();
+            return false;
+        }
+        pinned->value_ = &found->value;
+        return true;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::MultiGet(size_t n, const Key *const *keys,
+                                                               std::optional<Value> *values)
+    {
+        EpochGuard guard;
+        PERF_TIMER_GUARD(get_search_cycles);
+        uint64_t cmp_count = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            Entry *found = SearchEntry(*keys[i], &cmp_count);
+            values[i].reset();
+            if (found != nullptr)
+            {
+                values[i] = found->value;
+            }
+        }
+        PERF_TIMER_STOP(get_search_cycles);
+
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    typename BPlusTree<Key, Value, Comparator, Capacity>::Leaf *BPlusTree<Key, Value, Comparator, Capacity>::FindLeafForWrite(
+        const Key &key, Path &path, int *depth, uint64_t *cmp_count)
+    {
+        // 写者是唯一修改树的线程，不需要校验版本号
+        NodeBase *node = root_.load(std::memory_order_relaxed);
+        *depth = 0;
+        while (!node->is_leaf)
+        {
+            Inner *inner = static_cast<Inner *>(node);
+            int idx = ChildIndex(inner, key, cmp_count);
+            assert(*depth < kMaxDepth);
+            path[(*depth)++] = PathStep{inner, idx};
+            node = inner->children[idx].load(std::memory_order_relaxed);
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K, typename V>
+    void BPlusTree<Key, Value, Comparator, Capacity>::InsertImpl(K &&key, V &&value)
+    {
+        PERF_TIMER_GUARD(put_search_cycles);
+        Path path;
+        int depth = 0;
+        uint64_t cmp_count = 0;
+        Leaf *leaf = FindLeafForWrite(key, path, &depth, &cmp_count);
+        bool equal = false;
+        int pos = LeafLowerBound(leaf, key, &equal, &cmp_count);
+        PERF_TIMER_STOP(put_search_cycles);
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+            stats_->RecordInHistogram(HistogramType::kComparisonsPerPut, cmp_count);
+        }
+        if (equal)
+        {
+            return; // 与SkipList一致，忽略重复的key
+        }
+
+        ++size;
+        mem_usage += KVSizeOf(key);
+        mem_usage += KVSizeOf(value);
+
+        PERF_TIMER_GUARD(put_alloc_cycles);
+        Entry *entry = NewEntry(std::forward<K>(key), std::forward<V>(value));
+        PERF_TIMER_STOP(put_alloc_cycles);
+
+        PERF_TIMER_GUARD(put_link_cycles);
+        int n = leaf->count.load(std::memory_order_relaxed);
+        if (n < kCapacity)
+        {
+            leaf->Lock();
+            for (int i = n; i > pos; --i)
+            {
+                leaf->slots[i].store(leaf->slots[i - 1].load(std::memory_order_relaxed), std::memory_order_release);
+            }
+            leaf->slots[pos].store(entry, std::memory_order_release);
+            leaf->count.store(n + 1, std::memory_order_relaxed);
+            leaf->Unlock();
+            return;
+        }
+        SplitAndInsert(leaf, pos, entry, path, depth);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::SplitAndInsert(Leaf *leaf, int pos, Entry *entry, Path &path,
+                                                                    int depth)
+    {
+        // 从下往上找到第一个未满的祖先，它与其下的路径结点都会被修改；都满时根也要分裂
+        int top = depth - 1;
+        while (top >= 0 && path[top].node->count.load(std::memory_order_relaxed) == kCapacity)
+        {
+            --top;
+        }
+        // 修改前锁住所有受影响的结点，读者在其中任何一个上校验失败都会从根重试
+        for (int i = std::max(top, 0); i < depth; ++i)
+        {
+            path[i].node->Lock();
+        }
+        leaf->Lock();
+
+        // 分裂叶子：在末尾追加(顺序写入)时左叶子保持满的，否则对半分
+        std::array<Entry *, kCapacity + 1> merged;
+        for (int i = 0, j = 0; i <= kCapacity; ++i)
+        {
+            merged[i] = i == pos ? entry : leaf->slots[j++].load(std::memory_order_relaxed);
+        }
+        const int left_count = pos == kCapacity ? kCapacity : (kCapacity + 1) / 2;
+        Leaf *right = new Leaf();
+        for (int i = left_count; i <= kCapacity; ++i)
+        {
+            right->slots[i - left_count].store(merged[i], std::memory_order_relaxed);
+        }
+        right->count.store(kCapacity + 1 - left_count, std::memory_order_relaxed);
+        right->next.store(leaf->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (int i = 0; i < kCapacity; ++i)
+        {
+            leaf->slots[i].store(i < left_count ? merged[i] : nullptr, std::memory_order_release);
+        }
+        leaf->count.store(left_count, std::memory_order_relaxed);
+        // right的内容先于指向它的指针对读者可见
+        leaf->next.store(right, std::memory_order_release);
+
+        const Key *sep = NewSeparator(merged[left_count]->key);
+        NodeBase *new_child = right;
+
+        // 逐层向上插入(sep, new_child)
+        int level = depth - 1;
+        for (; level >= 0; --level)
+        {
+            Inner *node = path[level].node;
+            const int idx = path[level].child; // sep插入到keys[idx]，new_child插入到children[idx + 1]
+            const int n = node->count.load(std::memory_order_relaxed);
+            if (n < kCapacity)
+            {
+                for (int i = n; i > idx; --i)
+                {
+                    node->keys[i].store(node->keys[i - 1].load(std::memory_order_relaxed), std::memory_order_release);
+                    node->children[i + 1].store(node->children[i].load(std::memory_order_relaxed),
+                                                std::memory_order_release);
+                }
+                node->keys[idx].store(sep, std::memory_order_release);
+                node->children[idx + 1].store(new_child, std::memory_order_release);
+                node->count.store(n + 1, std::memory_order_relaxed);
+                break;
+            }
+
+            // 内部结点也已满：合并后中间的分隔key上移，右半部分放入新结点
+            std::array<const Key *, kCapacity + 1> keys;
+            std::array<NodeBase *, kCapacity + 2> children;
+            for (int i = 0, j = 0; i <= kCapacity; ++i)
+            {
+                keys[i] = i == idx ? sep : node->keys[j++].load(std::memory_order_relaxed);
+            }
+            for (int i = 0, j = 0; i <= kCapacity + 1; ++i)
+            {
+                children[i] = i == idx + 1 ? new_child : node->children[j++].load(std::memory_order_relaxed);
+            }
+            const int mid = idx == kCapacity ? kCapacity - 1 : kCapacity / 2;
+            Inner *sibling = new Inner();
+            for (int i = mid + 1; i <= kCapacity; ++i)
+            {
+                sibling->keys[i - mid - 1].store(keys[i], std::memory_order_relaxed);
+            }
+            for (int i = mid + 1; i <= kCapacity + 1; ++i)
+            {
+                sibling->children[i - mid - 1].store(children[i], std::memory_order_relaxed);
+            }
+            sibling->count.store(kCapacity - mid, std::memory_order_relaxed);
+            for (int i = 0; i < kCapacity; ++i)
+            {
+                node->keys[i].store(i < mid ? keys[i] : nullptr, std::memory_order_release);
+            }
+            for (int i = 0; i <= kCapacity; ++i)
+            {
+                node->children[i].store(i <= mid ? children[i] : nullptr, std::memory_order_release);
+            }
+            node->count.store(mid, std::memory_order_relaxed);
+
+            sep = keys[mid];
+            new_child = sibling;
+        }
+
+        if (level < 0)
+        {
+            // 根分裂：先发布新根再解锁旧根，解锁后读到旧根版本号的读者一定能看到新根
+            Inner *root = new Inner();
+            root->keys[0].store(sep, std::memory_order_relaxed);
+            root->children[0].store(root_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            root->children[1].store(new_child, std::memory_order_relaxed);
+            root->count.store(1, std::memory_order_relaxed);
+            root_.store(root, std::memory_order_release);
+            ++height_;
+        }
+
+        leaf->Unlock();
+        for (int i = depth - 1; i >= std::max(top, 0); --i)
+        {
+            path[i].node->Unlock();
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::Delete(const Key &key)
+    {
+        Path path;
+        int depth = 0;
+        uint64_t cmp_count = 0;
+        Leaf *leaf = FindLeafForWrite(key, path, &depth, &cmp_count);
+        bool equal = false;
+        int pos = LeafLowerBound(leaf, key, &equal, &cmp_count);
+        if (!equal)
+        {
+            return;
+        }
+        Entry *target = leaf->slots[pos].load(std::memory_order_relaxed);
+        --size;
+        mem_usage -= KVSizeOf(target->key);
+        mem_usage -= KVSizeOf(target->value);
+
+        const int n = leaf->count.load(std::memory_order_relaxed);
+        leaf->Lock();
+        for (int i = pos; i + 1 < n; ++i)
+        {
+            leaf->slots[i].store(leaf->slots[i + 1].load(std::memory_order_relaxed), std::memory_order_release);
+        }
+        leaf->slots[n - 1].store(nullptr, std::memory_order_release);
+        leaf->count.store(n - 1, std::memory_order_relaxed);
+        leaf->Unlock();
+
+        // 可能仍有读者或迭代器持有target，交给EpochManager在安全后释放
+        EpochManager::get_instance()->Retire(target, &Entry::Destroy);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    template <typename K, typename V>
+    typename BPlusTree<Key, Value, Comparator, Capacity>::Entry *BPlusTree<Key, Value, Comparator, Capacity>::NewEntry(
+        K &&key, V &&value)
+    {
+        char *mem = static_cast<char *>(AllocateNode(sizeof(Entry) + InlineBytesOf<Key>(key) + InlineBytesOf<Value>(value)));
+        char *inline_data = mem + sizeof(Entry);
+        return new (mem) Entry(InlineCopy<Key>(std::forward<K>(key), inline_data),
+                               InlineCopy<Value>(std::forward<V>(value), inline_data));
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    const Key *BPlusTree<Key, Value, Comparator, Capacity>::NewSeparator(const Key &key)
+    {
+        char *mem = static_cast<char *>(AllocateNode(sizeof(Key) + InlineBytesOf<Key>(key)));
+        char *inline_data = mem + sizeof(Key);
+        return new (mem) Key(InlineCopy<Key>(key, inline_data));
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::DestroySeparator(const Key *key)
+    {
+        const size_t n = sizeof(Key) + InlineBytesOf<Key>(*key);
+        key->~Key();
+        DeallocateNode(const_cast<Key *>(key), n);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    void BPlusTree<Key, Value, Comparator, Capacity>::DestroySubtree(NodeBase *node)
+    {
+        const int n = node->count.load(std::memory_order_relaxed);
+        if (node->is_leaf)
+        {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            for (int i = 0; i < n; ++i)
+            {
+                Entry::Destroy(leaf->slots[i].load(std::memory_order_relaxed));
+            }
+            delete leaf;
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (int i = 0; i < n; ++i)
+        {
+            DestroySeparator(inner->keys[i].load(std::memory_order_relaxed));
+        }
+        for (int i = 0; i <= n; ++i)
+        {
+            DestroySubtree(inner->children[i].load(std::memory_order_relaxed));
+        }
+        delete inner;
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    BPlusTree<Key, Value, Comparator, Capacity>::BPlusTree(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc)
+        : alloc(std::move(alloc)), compare_(cmp)
+    {
+        head_leaf_ = new Leaf();
+        root_.store(head_leaf_, std::memory_order_relaxed);
+    }
+
+    template <typename Key, typename Value, class Comparator, int Capacity>
+    BPlusTree<Key, Value, Comparator, Capacity>::~BPlusTree()
+    {
+        // 已删除的entry由EpochManager负责释放，这里只释放仍在树中的部分
+        DestroySubtree(root_.load(std::memory_order_relaxed));
+    }
+}
+
+#endif
@@ -0,0 +1,667 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:40:05
+ * @LastEditTime: 2026-10-23 21:05:44
+ * @FilePath: /miniKV/src/memtable/checkpoint.h
+ * @Description: memtable快照落盘(checkpoint)与基于mmap的快速启动
+ *
+ * ********************************
+ *  正常关闭时把memtable按key顺序写成一个可直接mmap的紧凑文件，重启时无需重放日志：
+ *  映射文件后立即可以在映射内存上二分查找服务读请求，完整的memtable在后台线程中重建，
+ *  重建完成后读请求切换到memtable；data校验或解码失败时清空已重建的部分，之后的读请求一律返回空，
+ *  不再访问可能损坏的映射内存，由调用方退回日志重放。
+ *
+ *  文件格式(只追加写出，小端)：
+ *    data     : 按key递增的记录，每条为 [fixed32 key_len][fixed32 value_len][key][value]
+ *    index    : num_entries个fixed64，第i条记录在文件中的偏移
+ *    manifest : [fixed32 n]，随后n组 [fixed32 len][name][fixed32 len][value]
+ *    footer   : 固定kFooterSize字节，见checkpoint::Footer
+ *  footer与index/manifest的crc在打开时校验(大小与条目数成正比，远小于数据)，
+ *  data的crc在后台重建时校验，打开文件不需要读完整个文件。
+ *  key/value支持std::string、Slice(映射内存上的视图，零拷贝)与可平凡复制的类型。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_CHECKPOINT_H
+#define MINIKVDB_CHECKPOINT_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../utils/crc32c.h"
+#include "../utils/mmap_file.h"
+#include "../utils/slice.h"
+#include "../utils/thread_pool.h"
+#include "../utils/writable_file.h"
+#include "comparator.h"
+#include "memtable.h"
+
+namespace minikvdb
+{
+    // 随checkpoint一起保存的表元信息(例如存活的有序段编号、下一个文件号)，由调用方定义内容
+    using CheckpointManifest = std::map<std::string, std::string>;
+
+    namespace checkpoint
+    {
+        static const uint64_t kMagic = 0x3154504b43564b4dull; // "MKVCKPT1"
+        static const uint32_t kVersion = 1;
+        static const size_t kFooterSize = 64;
+        static const size_t kRecordHeaderSize = 8; // key_len + value_len
+
+        /*
+         * 文件末尾的固定长度footer
+         */
+        struct Footer
+        {
+            uint64_t magic = kMagic;
+            uint32_t version = kVersion;
+            uint64_t num_entries = 0;
+            uint64_t index_offset = 0;    // data段结束位置
+            uint64_t manifest_offset = 0; // index段结束位置
+            uint64_t manifest_size = 0;
+            uint32_t data_crc = 0; // 掩码后的crc32c，覆盖[0, index_offset)
+            uint32_t meta_crc = 0; // 掩码后的crc32c，覆盖[index_offset, manifest_offset + manifest_size)
+        };
+
+        inline void PutFixed32(std::string *dst, uint32_t v)
+        {
+            dst->append(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        inline void PutFixed64(std::string *dst, uint64_t v)
+        {
+            dst->append(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        inline uint32_t DecodeFixed32(const char *p)
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint64_t DecodeFixed64(const char *p)
+        {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // footer编码为kFooterSize字节，最后8字节为footer自身的crc与填充
+        inline std::string EncodeFooter(const Footer &f)
+        {
+            std::string dst;
+            PutFixed64(&dst, f.magic);
+            PutFixed32(&dst, f.version);
+            PutFixed32(&dst, 0); // 保留
+            PutFixed64(&dst, f.num_entries);
+            PutFixed64(&dst, f.index_offset);
+            PutFixed64(&dst, f.manifest_offset);
+            PutFixed64(&dst, f.manifest_size);
+            PutFixed32(&dst, f.data_crc);
+            PutFixed32(&dst, f.meta_crc);
+            PutFixed32(&dst, crc32c::Mask(crc32c::Value(dst.data(), dst.size())));
+            dst.resize(kFooterSize, '\0');
+            return dst;
+        }
+
+        inline bool DecodeFooter(const char *p, Footer *f)
+        {
+            if (crc32c::Unmask(DecodeFixed32(p + 56)) != crc32c::Value(p, 56))
+            {
+                return false;
+            }
+            f->magic = DecodeFixed64(p);
+            f->version = DecodeFixed32(p + 8);
+            f->num_entries = DecodeFixed64(p + 16);
+            f->index_offset = DecodeFixed64(p + 24);
+            f->manifest_offset = DecodeFixed64(p + 32);
+            f->manifest_size = DecodeFixed64(p + 40);
+            f->data_crc = DecodeFixed32(p + 48);
+            f->meta_crc = DecodeFixed32(p + 52);
+            return f->magic == kMagic && f->version == kVersion;
+        }
+
+        // string按内容、可平凡复制的类型按对象表示编码
+        template <typename T>
+        inline void EncodeField(const T &t, std::string *dst)
+        {
+            if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, Slice>)
+            {
+                dst->append(t.data(), t.size());
+            }
+            else
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "checkpoint只支持string、Slice与可平凡复制的类型");
+                dst->append(reinterpret_cast<const char *>(&t), sizeof(T));
+            }
+        }
+
+        // 解码出的Slice指向映射内存，文件关闭前有效
+        template <typename T>
+        inline bool DecodeField(const char *p, size_t n, T *out)
+        {
+            if constexpr (std::is_same_v<T, std::string>)
+            {
+                out->assign(p, n);
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, Slice>)
+            {
+                *out = Slice(p, n);
+                return true;
+            }
+            else
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "checkpoint只支持string、Slice与可平凡复制的类型");
+                if (n != sizeof(T))
+                {
+                    return false;
+                }
+                memcpy(out, p, sizeof(T));
+                return true;
+            }
+        }
+
+        // 先fsync文件再rename，最后fsync所在目录，保证崩溃后要么是旧文件要么是完整的新文件
+        inline bool SyncDir(const std::string &path)
+        {
+            size_t pos = path.find_last_of('/');
+            std::string dir = pos == std::string::npos ? "." : (pos == 0 ? "/" : path.substr(0, pos));
+            int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                return false;
+            }
+            bool ok = ::fsync(fd) == 0;
+            ::close(fd);
+            return ok;
+        }
+    }
+
+    /**
+     * @description:                        把memtable写成checkpoint文件，写出期间不能修改表
+     *                                      先写到path.tmp，落盘后原子地rename为path
+     * @param {MemTable} &table             memtable
+     * @param {string} &path                checkpoint文件路径
+     * @param {CheckpointManifest} &manifest 表元信息
+     * @param {bool} use_direct_io          是否以O_DIRECT写出，避免挤掉页缓存中的热数据
+     * @param {RateLimiter} *limiter        限速器，为空时不限速；按高优先级(与flush相同)申请令牌
+     * @return {*}                          是否成功
+     */
+    template <typename Key, typename Value, class Comparator, class Hash>
+    bool WriteCheckpoint(const MemTable<Key, Value, Comparator, Hash> &table, const std::string &path,
+                         const CheckpointManifest &manifest = CheckpointManifest(), bool use_direct_io = false,
+                         RateLimiter *limiter = nullptr)
+    {
+        const std::string tmp = path + ".tmp";
+        WritableFile file(limiter, Priority::kHigh, 1 << 20, use_direct_io);
+        if (!file.Open(tmp))
+        {
+            return false;
+        }
+
+        checkpoint::Footer footer;
+        std::vector<uint64_t> offsets;
+        uint32_t data_crc = 0;
+        std::string record;
+        bool ok = true;
+        typename MemTable<Key, Value, Comparator, Hash>::MemTableIterator iter(&table);
+        for (iter.MoveToFirst(); ok && iter.Valid(); iter.Next())
+        {
+            record.clear();
+            checkpoint::PutFixed32(&record, 0);
+            checkpoint::PutFixed32(&record, 0);
+            checkpoint::EncodeField(iter.key(), &record);
+            uint32_t key_len = static_cast<uint32_t>(record.size() - checkpoint::kRecordHeaderSize);
+            checkpoint::EncodeField(iter.value(), &record);
+            uint32_t value_len = static_cast<uint32_t>(record.size() - checkpoint::kRecordHeaderSize - key_len);
+            memcpy(&record[0], &key_len, sizeof(key_len));
+            memcpy(&record[4], &value_len, sizeof(value_len));
+
+            offsets.push_back(file.GetFileSize());
+            data_crc = crc32c::Extend(data_crc, record.data(), record.size());
+            ok = file.Append(record);
+        }
+
+        std::string meta;
+        for (uint64_t offset : offsets)
+        {
+            checkpoint::PutFixed64(&meta, offset);
+        }
+        footer.num_entries = offsets.size();
+        footer.index_offset = file.GetFileSize();
+        footer.manifest_offset = footer.index_offset + meta.size();
+        checkpoint::PutFixed32(&meta, static_cast<uint32_t>(manifest.size()));
+        for (auto &[name, value] : manifest)
+        {
+            checkpoint::PutFixed32(&meta, static_cast<uint32_t>(name.size()));
+            meta.append(name);
+            checkpoint::PutFixed32(&meta, static_cast<uint32_t>(value.size()));
+            meta.append(value);
+        }
+        footer.manifest_size = footer.index_offset + meta.size() - footer.manifest_offset;
+        footer.data_crc = crc32c::Mask(data_crc);
+        footer.meta_crc = crc32c::Mask(crc32c::Value(meta.data(), meta.size()));
+
+        ok = ok && file.Append(meta) && file.Append(checkpoint::EncodeFooter(footer)) && file.Sync();
+        ok = file.Close() && ok;
+        if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return checkpoint::SyncDir(path);
+    }
+
+    /*
+     * 只读的checkpoint文件：mmap后直接在映射内存上二分查找，打开时只读取footer、index与manifest
+     */
+    template <typename Key, typename Value, class Comparator>
+    class CheckpointReader
+    {
+    public:
+        explicit CheckpointReader(Comparator cmp = Comparator()) : cmp_(cmp) {}
+
+        CheckpointReader(const CheckpointReader &) = delete;
+        CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+        /**
+         * @description:            映射并校验checkpoint文件
+         * @param {string} &path    文件路径
+         * @return {*}              文件不存在、格式错误或footer/index/manifest校验失败时返回false
+         */
+        bool Open(const std::string &path)
+        {
+            Close();
+            if (!file_.Open(path) || file_.size() < checkpoint::kFooterSize ||
+                !checkpoint::DecodeFooter(file_.data() + file_.size() - checkpoint::kFooterSize, &footer_))
+            {
+                Close();
+                return false;
+            }
+            const uint64_t meta_end = file_.size() - checkpoint::kFooterSize;
+            if (footer_.index_offset > footer_.manifest_offset ||
+                footer_.manifest_offset - footer_.index_offset != footer_.num_entries * sizeof(uint64_t) ||
+                footer_.manifest_offset + footer_.manifest_size != meta_end)
+            {
+                Close();
+                return false;
+            }
+            const char *meta = file_.data() + footer_.index_offset;
+            if (crc32c::Unmask(footer_.meta_crc) != crc32c::Value(meta, meta_end - footer_.index_offset) ||
+                !ParseManifest(file_.data() + footer_.manifest_offset, footer_.manifest_size))
+            {
+                Close();
+                return false;
+            }
+            index_ = meta;
+            // 点查只访问少量页，关闭预读避免每次缺页都读入大段无关数据
+            file_.Advise(AccessPattern::kRandom);
+            return true;
+        }
+
+        void Close()
+        {
+            file_.Close();
+            footer_ = checkpoint::Footer();
+            index_ = nullptr;
+            manifest_.clear();
+        }
+
+        inline bool IsOpen() const { return index_ != nullptr; }
+
+        inline size_t GetSize() const { return footer_.num_entries; }
+
+        inline const CheckpointManifest &GetManifest() const { return manifest_; }
+
+        // 顺序读一遍data段并校验crc，后台重建前调用
+        bool VerifyData()
+        {
+            file_.Advise(AccessPattern::kSequential);
+            bool ok = crc32c::Unmask(footer_.data_crc) == crc32c::Value(file_.data(), footer_.index_offset);
+            file_.Advise(AccessPattern::kRandom);
+            return ok;
+        }
+
+        std::optional<Value> Get(const Key &key) const
+        {
+            return GetImpl(key);
+        }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        std::optional<Value> Get(const K &key) const
+        {
+            return GetImpl(key);
+        }
+
+        bool Contains(const Key &key) const
+        {
+            size_t i = LowerBound(key);
+            return i < footer_.num_entries && Compare(i, key) == 0;
+        }
+
+        /**
+         * @description:            按key顺序读取第i条记录，供后台重建memtable
+         * @param {size_t} i        记录下标，小于GetSize()
+         * @param {Key} *key        输出key
+         * @param {Value} *value    输出value
+         * @return {*}              记录损坏时返回false
+         */
+        bool ReadEntry(size_t i, Key *key, Value *value) const
+        {
+            std::string_view k, v;
+            return RecordAt(i, &k, &v) && checkpoint::DecodeField(k.data(), k.size(), key) &&
+                   checkpoint::DecodeField(v.data(), v.size(), value);
+        }
+
+    private:
+        bool ParseManifest(const char *p, size_t n)
+        {
+            const char *limit = p + n;
+            if (n < 4)
+            {
+                return false;
+            }
+            uint32_t count = checkpoint::DecodeFixed32(p);
+            p += 4;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                std::string field[2];
+                for (auto &f : field)
+                {
+                    if (limit - p < 4 || static_cast<size_t>(limit - p - 4) < checkpoint::DecodeFixed32(p))
+                    {
+                        return false;
+                    }
+                    f.assign(p + 4, checkpoint::DecodeFixed32(p));
+                    p += 4 + f.size();
+                }
+                manifest_.emplace(std::move(field[0]), std::move(field[1]));
+            }
+            return p == limit;
+        }
+
+        // 取第i条记录的key、value，记录越界(文件损坏)时返回false
+        bool RecordAt(size_t i, std::string_view *key, std::string_view *value) const
+        {
+            uint64_t offset = checkpoint::DecodeFixed64(index_ + i * sizeof(uint64_t));
+            if (offset + checkpoint::kRecordHeaderSize > footer_.index_offset)
+            {
+                return false;
+            }
+            const char *p = file_.data() + offset;
+            uint64_t key_len = checkpoint::DecodeFixed32(p);
+            uint64_t value_len = checkpoint::DecodeFixed32(p + 4);
+            if (offset + checkpoint::kRecordHeaderSize + key_len + value_len > footer_.index_offset)
+            {
+                return false;
+            }
+            *key = std::string_view(p + checkpoint::kRecordHeaderSize, key_len);
+            *value = std::string_view(p + checkpoint::kRecordHeaderSize + key_len, value_len);
+            return true;
+        }
+
+        // 比较第i条记录的key与目标key；string key且比较器透明时直接比较映射内存，不构造Key
+        template <typename K>
+        int Compare(size_t i, const K &key) const
+        {
+            std::string_view k, v;
+            if (!RecordAt(i, &k, &v))
+            {
+                return 1; // 损坏的记录视为不匹配
+            }
+            if constexpr (std::is_same_v<Key, std::string> && kIsTransparent<Comparator>)
+            {
+                return cmp_(k, key);
+            }
+            else
+            {
+                Key decoded{};
+                if (!checkpoint::DecodeField(k.data(), k.size(), &decoded))
+                {
+                    return 1;
+                }
+                return cmp_(decoded, key);
+            }
+        }
+
+        // 第一个key >= 目标key的记录下标
+        template <typename K>
+        size_t LowerBound(const K &key) const
+        {
+            size_t lo = 0, hi = footer_.num_entries;
+            while (lo < hi)
+            {
+                size_t mid = lo + (hi - lo) / 2;
+                if (Compare(mid, key) < 0)
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        template <typename K>
+        std::optional<Value> GetImpl(const K &key) const
+        {
+            if (!IsOpen())
+            {
+                return std::nullopt;
+            }
+            size_t i = LowerBound(key);
+            if (i >= footer_.num_entries || Compare(i, key) != 0)
+            {
+                return std::nullopt;
+            }
+            std::string_view k, v;
+            Value value{};
+            if (!RecordAt(i, &k, &v) || !checkpoint::DecodeField(v.data(), v.size(), &value))
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        Comparator cmp_;
+        MmapReadOnlyFile file_;
+        checkpoint::Footer footer_;
+        const char *index_ = nullptr; // 指向映射内存中的index段
+        CheckpointManifest manifest_;
+    };
+
+    /*
+     * 从checkpoint快速启动的memtable：
+     * Open后读请求立即在映射文件上服务，后台重建完成后切换到memtable。
+     * 重建期间表只读，写入前需调用WaitForRebuild/GetMemTable等待重建完成。
+     */
+    template <typename Key, typename Value, class Comparator, class Hash = std::hash<Key>>
+    class RestoredMemTable
+    {
+    public:
+        using Table = MemTable<Key, Value, Comparator, Hash>;
+
+        /**
+         * @description:                    构造
+         * @param {unique_ptr<Table>} table 空的memtable，调用方可事先配置布隆过滤器、统计等
+         * @param {Comparator} cmp          key比较函数，与table一致
+         * @return {*}
+         */
+        explicit RestoredMemTable(std::unique_ptr<Table> table, Comparator cmp = Comparator())
+            : table_(std::move(table)), reader_(cmp)
+        {
+            assert(table_->GetSize() == 0);
+        }
+
+        // 等待后台重建任务结束，映射文件随后解除
+        ~RestoredMemTable()
+        {
+            WaitForRebuild();
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this]
+                     { return !job_pending_; });
+        }
+
+        RestoredMemTable(const RestoredMemTable &) = delete;
+        RestoredMemTable &operator=(const RestoredMemTable &) = delete;
+
+        /**
+         * @description:            打开checkpoint并开始重建
+         * @param {string} &path    checkpoint文件路径
+         * @param {ThreadPool} *pool 后台线程池，重建以高优先级(与flush相同)执行；
+         *                          为空时不在后台重建，推迟到第一次WaitForRebuild/GetMemTable时执行
+         * @return {*}              checkpoint无法打开时返回false，调用方应退回日志重放
+         */
+        bool Open(const std::string &path, ThreadPool *pool)
+        {
+            if (!reader_.Open(path))
+            {
+                return false;
+            }
+            if (pool != nullptr)
+            {
+                job_pending_ = true;
+                pool->Schedule([this]
+                               {
+                                   WaitForRebuild();
+                                   std::lock_guard<std::mutex> lock(mu_);
+                                   job_pending_ = false;
+                                   cv_.notify_all(); },
+                               Priority::kHigh);
+            }
+            return true;
+        }
+
+        // 重建失败后返回空
+        std::optional<Value> Get(const Key &key)
+        {
+            switch (state_.load(std::memory_order_acquire))
+            {
+            case State::kRebuilt:
+                return table_->Get(key);
+            case State::kFailed:
+                return std::nullopt;
+            default:
+                return reader_.Get(key);
+            }
+        }
+
+        bool Contains(const Key &key)
+        {
+            switch (state_.load(std::memory_order_acquire))
+            {
+            case State::kRebuilt:
+                return table_->Contains(key);
+            case State::kFailed:
+                return false;
+            default:
+                return reader_.Contains(key);
+            }
+        }
+
+        inline bool IsRebuilt() const { return state_.load(std::memory_order_acquire) == State::kRebuilt; }
+
+        // 重建失败，checkpoint不可用
+        inline bool IsFailed() const { return state_.load(std::memory_order_acquire) == State::kFailed; }
+
+        /**
+         * @description:    阻塞直到memtable重建完成，尚未开始时在当前线程执行
+         * @return {*}      data段校验或记录解码失败时返回false，此时memtable为空，调用方应退回日志重放
+         */
+        bool WaitForRebuild()
+        {
+            std::call_once(rebuild_once_, [this]
+                           { Rebuild(); });
+            return rebuild_ok_;
+        }
+
+        // 重建完成后的memtable，可以开始写入
+        Table *GetMemTable()
+        {
+            WaitForRebuild();
+            return table_.get();
+        }
+
+        inline const CheckpointManifest &GetManifest() const { return reader_.GetManifest(); }
+
+        inline size_t GetSize() const { return reader_.GetSize(); }
+
+    private:
+        enum class State
+        {
+            kMapped,  // 由映射文件服务读请求
+            kRebuilt, // 由memtable服务读请求
+            kFailed,  // 重建失败，读请求返回空
+        };
+
+        void Rebuild()
+        {
+            size_t inserted = 0;
+            if (reader_.IsOpen() && reader_.VerifyData())
+            {
+                rebuild_ok_ = true;
+                for (; rebuild_ok_ && inserted < reader_.GetSize(); ++inserted)
+                {
+                    Key key{};
+                    Value value{};
+                    rebuild_ok_ = reader_.ReadEntry(inserted, &key, &value);
+                    if (!rebuild_ok_)
+                    {
+                        break;
+                    }
+                    table_->Insert(std::move(key), std::move(value));
+                }
+            }
+            if (!rebuild_ok_)
+            {
+                // 读请求先切走再清空，前inserted条记录已成功解码过一次，可以再读出key逐个删除
+                state_.store(State::kFailed, std::memory_order_release);
+                for (size_t i = 0; i < inserted; ++i)
+                {
+                    Key key{};
+                    Value value{};
+                    if (reader_.ReadEntry(i, &key, &value))
+                    {
+                        table_->Delete(key);
+                    }
+                }
+                return;
+            }
+            // 之后的读请求都由memtable服务，映射文件仍然保留：之前返回的Slice指向映射内存
+            state_.store(State::kRebuilt, std::memory_order_release);
+        }
+
+        std::unique_ptr<Table> table_;
+        CheckpointReader<Key, Value, Comparator> reader_;
+        std::once_flag rebuild_once_;
+        bool rebuild_ok_ = false;
+        std::atomic<State> state_{State::kMapped};
+
+        std::mutex mu_;
+        std::condition_variable cv_;
+        bool job_pending_ = false; // 线程池中的重建任务尚未结束，析构需等待
+    };
+}
+
+#endif
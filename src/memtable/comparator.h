@@ -0,0 +1,65 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 14:26:51
+ * @LastEditTime: 2026-10-23 09:20:11
+ * @FilePath: /miniKV/src/memtable/comparator.h
+ * @Description: 透明比较器与哈希，支持不构造临时Key的异构查找
+ *
+ * ********************************
+ *  与std::less<>、C++20无序容器的做法一致：Comparator(以及HashSkipList的Hash)
+ *  定义了is_transparent类型时，内存表的Get/Contains等查找接口接受任何能与Key比较的类型。
+ *  例如Key为std::string时可以直接用const char*、std::string_view、Slice查找，
+ *  超过SSO长度的key不必为每次读构造一个临时string。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_COMPARATOR_H
+#define MINIKVDB_COMPARATOR_H
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#include "../utils/simd.h"
+
+namespace minikvdb
+{
+    // C是否带有is_transparent标记
+    template <typename C, typename = void>
+    struct IsTransparent : std::false_type
+    {
+    };
+
+    template <typename C>
+    struct IsTransparent<C, std::void_t<typename C::is_transparent>> : std::true_type
+    {
+    };
+
+    template <typename C>
+    inline constexpr bool kIsTransparent = IsTransparent<C>::value;
+
+    // 按字节序比较的透明比较器，std::string、const char*、string_view、Slice可以互相比较；
+    // 比较使用运行时分派的SIMD实现(simd::CompareBytes)，长key按16/32/64字节一组比较
+    struct BytewiseComparator
+    {
+        using is_transparent = void;
+
+        int operator()(std::string_view a, std::string_view b) const
+        {
+            return simd::CompareBytes(a.data(), a.size(), b.data(), b.size());
+        }
+    };
+
+    // 与std::hash<std::string>结果一致的透明哈希(标准保证string与string_view的哈希值相同)
+    struct BytewiseHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>()(s); }
+    };
+}
+
+#endif
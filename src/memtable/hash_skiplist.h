@@ -0,0 +1,521 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 14:30:18
+ * @LastEditTime: 2026-10-24 10:12:36
+ * @FilePath: /miniKV/src/memtable/hash_skiplist.h
+ * @Description: 哈希索引的内存表结构
+ *
+ * ********************************
+ *  该模块实现借鉴于rocksdb的HashLinkList/HashSkipList：
+ *  key先按哈希值分桶，每个桶内是一条按Comparator有序的短链表，
+ *  点查期望O(1)；有序遍历(flush)时再把所有结点收集起来排序
+ *  线程安全：与SkipList一致，写操作(Insert/Delete)需要外部同步，读操作(Get/Contains/迭代器)
+ *  无需加锁，可与一个写者并发执行；Delete摘除的结点通过EpochManager延迟释放
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_HASH_SKIPLIST_H
+#define MINIKVDB_HASH_SKIPLIST_H
+
+#include <memory>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <string>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <type_traits>
+
+#include "../log/log.h"
+#include "../memory/default_alloc.h"
+#include "../memory/node_alloc.h"
+#include "../memory/epoch.h"
+#include "kv_size.h"
+#include "comparator.h"
+
+namespace minikvdb
+{
+    template <typename Key, typename Value, class Comparator, class Hash = std::hash<Key>>
+    class HashSkipList
+    {
+        class Node;
+
+    public:
+        enum
+        {
+            kDefaultBucketCount = 1 << 16 // 默认桶数量
+        };
+
+        /**
+         * @description:                            显示调用HashSkipList构造函数
+         * @param {Comparator} cmp                  key比较函数，cmp(a, b) == 0的key必须哈希值相同
+         * @param {shared_ptr<DefaultAlloc>} alloc  内存分配器
+         * @param {size_t} bucket_count             桶数量，向上取整为2的幂，建议与预期kv数量同一量级
+         * @param {Hash} hash                       key哈希函数
+         * @return {*}
+         */
+        explicit HashSkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc,
+                              size_t bucket_count = kDefaultBucketCount, Hash hash = Hash());
+
+        ~HashSkipList();
+
+        // 删除拷贝构造函数
+        HashSkipList(const HashSkipList &) = delete;
+        HashSkipList &operator=(const HashSkipList &) = delete;
+
+        /**
+         * @description:                key-vaue插入函数, 语义与SkipList::Insert一致
+         * @param {Key} &key            key
+         * @param {Value} &value        value
+         * @return {*}
+         */
+        void Insert(const Key &key, const Value &value);
+
+        // 右值版本：key/value直接移动进结点，不再拷贝
+        void Insert(Key &&key, Value &&value);
+
+        /**
+         * @description:                删除key对应的value
+         * @param {Key} &key            key
+         * @return {*}
+         */
+        void Delete(const Key &key);
+
+        /**
+         * @description:                检查是否存在key
+         * @param {Key} &key            key
+         * @return {*}                  true/false
+         */
+        bool Contains(const Key &key)
+        {
+            EpochGuard guard;
+            return FindNode(key) != nullptr;
+        }
+
+        /**
+         * @description:                key-value查找函数
+         * @param {Key} &key            key
+         * @return {*}                  存在返回value，不存在返回nullopt
+         */
+        std::optional<Value> Get(const Key &key) { return GetImpl(key); }
+
+        /**
+         * @description:                key-value查找函数，结果写入调用方提供的缓冲区，语义与SkipList一致
+         * @param {Key} &key            key
+         * @param {Value} *value        输出，不存在时保持不变
+         * @return {*}                  是否存在
+         */
+        bool Get(const Key &key, Value *value) { return GetImpl(key, value); }
+
+        /*
+         * 异构查找，语义与SkipList一致；哈希分桶还要求Hash也带is_transparent标记，
+         * 且对同一个key的不同表示给出相同的哈希值(见comparator.h中的BytewiseHash)
+         */
+        template <typename K, typename C = Comparator, typename H = Hash,
+                  typename = std::enable_if_t<kIsTransparent<C> && kIsTransparent<H>>>
+        bool Contains(const K &key)
+        {
+            EpochGuard guard;
+            return FindNode(key) != nullptr;
+        }
+
+        template <typename K, typename C = Comparator, typename H = Hash,
+                  typename = std::enable_if_t<kIsTransparent<C> && kIsTransparent<H>>>
+        std::optional<Value> Get(const K &key) { return GetImpl(key); }
+
+        template <typename K, typename C = Comparator, typename H = Hash,
+                  typename = std::enable_if_t<kIsTransparent<C> && kIsTransparent<H>>>
+        bool Get(const K &key, Value *value) { return GetImpl(key, value); }
+
+        inline int GetSize() { return size; }
+
+        inline int64_t GetMemUsage() { return mem_usage; }
+
+        inline size_t GetBucketCount() { return bucket_mask_ + 1; }
+
+        /*
+         * 有序迭代器，接口与SkipListIterator一致
+         * MoveToFirst时对所有结点做一次排序，代价O(n log n)，仅适合flush等全量遍历场景
+         * 迭代器持有EpochGuard，期间被Delete摘除的结点不会释放；排序之后的插入/删除对本次遍历不可见
+         */
+        class HashSkipListIterator
+        {
+        public:
+            explicit HashSkipListIterator(const HashSkipList *list);
+
+            // 如果当前iter指向的位置有效，则返回true
+            bool Valid();
+
+            const Key &key();
+
+            const Value &value();
+
+            void Next();
+
+            // 将当前node移到表头
+            // 必须要先调用此函数才可以进行迭代
+            void MoveToFirst();
+
+            // 将当前node移到第一个key >= target的结点，同样需要一次全量排序
+            void Seek(const Key &target);
+
+        private:
+            const HashSkipList *list_;
+            std::vector<Node *> sorted_; // 按key排好序的全部结点
+            size_t pos_;                 // 当前iter指向sorted_中的位置
+            EpochGuard guard_;           // 保护sorted_中的结点不被回收
+        };
+
+    private:
+        /**
+         * @description:                找到key所在的桶
+         * @param {Key} &key            key
+         * @return {*}                  桶头指针
+         */
+        template <typename K>
+        inline std::atomic<Node *> *Bucket(const K &key);
+
+        /**
+         * @description:                在桶内查找key
+         * @param {Key} &key            key
+         * @return {*}                  key所在结点，不存在返回nullptr
+         */
+        template <typename K>
+        Node *FindNode(const K &key);
+
+        template <typename K>
+        std::optional<Value> GetImpl(const K &key);
+
+        template <typename K>
+        bool GetImpl(const K &key, Value *value);
+
+        template <typename K, typename V>
+        void InsertImpl(K &&key, V &&value);
+
+        // 新建结点，Slice类型key/value的内容与结点在同一次分配中
+        template <typename K, typename V>
+        static Node *NewNode(K &&key, V &&value, Node *next);
+
+        static int64_t KVSize(const Key &key, const Value &value)
+        {
+            return KVSizeOf(key) + KVSizeOf(value);
+        }
+
+    private:
+        std::unique_ptr<std::atomic<Node *>[]> buckets_; // 每个桶是一条有序单链表
+        size_t bucket_mask_;
+
+        std::shared_ptr<DefaultAlloc> alloc;
+
+        int64_t size = 0;          // 表中数据量(kv键值对数量)
+        int64_t mem_usage = 0;     // kv键值对所占用的内存大小，单位：Byte
+        Comparator const compare_; // 比较函数
+        Hash const hash_;          // 哈希函数
+    };
+
+    /*================================================================
+    *  HashSkipList 结点 Node 定义
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    class HashSkipList<Key, Value, Comparator, Hash>::Node
+    {
+    public:
+        Node() = delete;
+
+        template <typename K, typename V>
+        Node(K &&key, V &&value, Node *next) : key(std::forward<K>(key)), value(std::forward<V>(value)), next_(next) {}
+
+        ~Node() = default;
+
+        // acquire读，能看到写者发布结点前对其的全部初始化
+        inline Node *Next() { return next_.load(std::memory_order_acquire); }
+
+        // release写，发布结点前对其的初始化对读者可见
+        inline void SetNext(Node *x) { next_.store(x, std::memory_order_release); }
+
+        // 仅在写者独占的位置使用
+        inline Node *NoBarrierNext() { return next_.load(std::memory_order_relaxed); }
+
+        // 供EpochManager延迟释放
+        static void Destroy(void *p)
+        {
+            Node *node = static_cast<Node *>(p);
+            const size_t n = sizeof(Node) + InlineBytesOf<Key>(node->key) + InlineBytesOf<Value>(node->value);
+            node->~Node();
+            DeallocateNode(node, n);
+        }
+
+        const Key key;
+        Value value;
+
+    private:
+        std::atomic<Node *> next_;
+    };
+
+    /*================================================================
+    *  HashSkipList 迭代器功能实现
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::HashSkipListIterator(const HashSkipList *list)
+        : list_(list), pos_(0)
+    {
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::MoveToFirst()
+    {
+        // 不读取size，写者可能正在并发修改
+        sorted_.clear();
+        for (size_t i = 0; i <= list_->bucket_mask_; ++i)
+        {
+            for (Node *p = list_->buckets_[i].load(std::memory_order_acquire); p != nullptr; p = p->Next())
+            {
+                sorted_.push_back(p);
+            }
+        }
+        const Comparator &cmp = list_->compare_;
+        std::sort(sorted_.begin(), sorted_.end(), [&cmp](const Node *a, const Node *b)
+                  { return cmp(a->key, b->key) < 0; });
+        pos_ = 0;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::Seek(const Key &target)
+    {
+        MoveToFirst();
+        const Comparator &cmp = list_->compare_;
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), target, [&cmp](const Node *a, const Key &k)
+                                   { return cmp(a->key, k) < 0; });
+        pos_ = static_cast<size_t>(it - sorted_.begin());
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    bool HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::Valid()
+    {
+        return pos_ < sorted_.size();
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    const Key &HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::key()
+    {
+        assert(Valid());
+        return sorted_[pos_]->key;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    const Value &HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::value()
+    {
+        assert(Valid());
+        return sorted_[pos_]->value;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::HashSkipListIterator::Next()
+    {
+        assert(Valid());
+        ++pos_;
+    }
+
+    /*================================================================
+    *  HashSkipList 主要功能实现
+    ================================================================*/
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    HashSkipList<Key, Value, Comparator, Hash>::HashSkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc,
+                                                             size_t bucket_count, Hash hash)
+        : alloc(std::move(alloc)),
+          compare_(cmp),
+          hash_(hash)
+    {
+        size_t n = 1;
+        while (n < bucket_count)
+        {
+            n <<= 1;
+        }
+        buckets_.reset(new std::atomic<Node *>[n]);
+        for (size_t i = 0; i < n; ++i)
+        {
+            buckets_[i].store(nullptr, std::memory_order_relaxed);
+        }
+        bucket_mask_ = n - 1;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    HashSkipList<Key, Value, Comparator, Hash>::~HashSkipList()
+    {
+        // 已删除的结点由EpochManager负责释放，这里只释放仍在表中的结点
+        for (size_t i = 0; i <= bucket_mask_; ++i)
+        {
+            Node *head = buckets_[i].load(std::memory_order_relaxed);
+            while (head != nullptr)
+            {
+                Node *next = head->NoBarrierNext();
+                Node::Destroy(head);
+                head = next;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K>
+    std::atomic<typename HashSkipList<Key, Value, Comparator, Hash>::Node *> *HashSkipList<Key, Value, Comparator, Hash>::Bucket(const K &key)
+    {
+        // std::hash对整数是恒等映射，低位分布差，先做一次混合
+        uint64_t h = static_cast<uint64_t>(hash_(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return &buckets_[h & bucket_mask_];
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K>
+    typename HashSkipList<Key, Value, Comparator, Hash>::Node *HashSkipList<Key, Value, Comparator, Hash>::FindNode(const K &key)
+    {
+        for (Node *p = Bucket(key)->load(std::memory_order_acquire); p != nullptr; p = p->Next())
+        {
+            int c = compare_(p->key, key);
+            if (c == 0)
+            {
+                return p;
+            }
+            if (c > 0)
+            {
+                return nullptr; // 桶内有序，遇到更大的key即可停止
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K>
+    std::optional<Value> HashSkipList<Key, Value, Comparator, Hash>::GetImpl(const K &key)
+    {
+        EpochGuard guard;
+        Node *node = FindNode(key);
+        if (node == nullptr)
+        {
+            return std::nullopt;
+        }
+        return node->value;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K>
+    bool HashSkipList<Key, Value, Comparator, Hash>::GetImpl(const K &key, Value *value)
+    {
+        EpochGuard guard;
+        Node *node = FindNode(key);
+        if (node == nullptr)
+        {
+            return false;
+        }
+        *value = node->value;
+        return true;
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::Insert(const Key &key, const Value &value)
+    {
+        InsertImpl(key, value);
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::Insert(Key &&key, Value &&value)
+    {
+        InsertImpl(std::move(key), std::move(value));
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K, typename V>
+    typename HashSkipList<Key, Value, Comparator, Hash>::Node *HashSkipList<Key, Value, Comparator, Hash>::NewNode(K &&key, V &&value, Node *next)
+    {
+        char *mem = static_cast<char *>(AllocateNode(sizeof(Node) + InlineBytesOf<Key>(key) + InlineBytesOf<Value>(value)));
+        char *inline_data = mem + sizeof(Node);
+        return new (mem) Node(InlineCopy<Key>(std::forward<K>(key), inline_data),
+                              InlineCopy<Value>(std::forward<V>(value), inline_data), next);
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    template <typename K, typename V>
+    void HashSkipList<Key, Value, Comparator, Hash>::InsertImpl(K &&key, V &&value)
+    {
+        // prev为nullptr时新结点挂在桶头
+        std::atomic<Node *> *head = Bucket(key);
+        Node *prev = nullptr;
+        Node *next = head->load(std::memory_order_relaxed);
+        while (next != nullptr)
+        {
+            int c = compare_(next->key, key);
+            if (c == 0)
+            {
+                LOG_WARN("%s", "A duplicate key was inserted.");
+                return;
+            }
+            if (c > 0)
+            {
+                break;
+            }
+            prev = next;
+            next = next->NoBarrierNext();
+        }
+        ++size;
+        mem_usage += KVSize(key, value);
+        // 结点初始化完成后再以release发布，并发读者看到的一定是完整结点
+        Node *x = NewNode(std::forward<K>(key), std::forward<V>(value), next);
+        if (prev == nullptr)
+        {
+            head->store(x, std::memory_order_release);
+        }
+        else
+        {
+            prev->SetNext(x);
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash>
+    void HashSkipList<Key, Value, Comparator, Hash>::Delete(const Key &key)
+    {
+        std::atomic<Node *> *head = Bucket(key);
+        Node *prev = nullptr;
+        Node *target = head->load(std::memory_order_relaxed);
+        while (target != nullptr)
+        {
+            int c = compare_(target->key, key);
+            if (c == 0)
+            {
+                // target自身的next保持不变，正停留在target上的读者仍能沿着它继续向后遍历
+                Node *next = target->NoBarrierNext();
+                if (prev == nullptr)
+                {
+                    head->store(next, std::memory_order_release);
+                }
+                else
+                {
+                    prev->SetNext(next);
+                }
+                --size;
+                mem_usage -= KVSize(target->key, target->value);
+                // 可能仍有读者持有target，交给EpochManager在安全后释放
+                EpochManager::get_instance()->Retire(target, &Node::Destroy);
+                return;
+            }
+            if (c > 0)
+            {
+                break;
+            }
+            prev = target;
+            target = target->NoBarrierNext();
+        }
+        LOG_WARN("%s", "The value you want to delete does not exist.");
+    }
+}
+
+#endif
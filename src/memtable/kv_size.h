@@ -0,0 +1,77 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 19:31:08
+ * @LastEditTime: 2026-10-18 19:31:08
+ * @FilePath: /miniKV/src/memtable/kv_size.h
+ * @Description: 内存表中key/value内存占用统计与结点内联存储
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_KV_SIZE_H
+#define MINIKVDB_KV_SIZE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../utils/slice.h"
+
+namespace minikvdb
+{
+    // string、Slice按内容长度计算，其余类型按sizeof计算
+    template <typename T>
+    inline int64_t KVSizeOf(const T &t)
+    {
+        if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, Slice>)
+        {
+            return static_cast<int64_t>(t.size());
+        }
+        else
+        {
+            return static_cast<int64_t>(sizeof(t));
+        }
+    }
+
+    /*
+     * Slice只是视图，内存表以Slice为key/value时需要把内容拷贝进结点：
+     * 结点与其key/value内容在同一次分配中，InlineBytesOf给出需要额外分配的字节数，
+     * InlineCopy把内容拷贝到dst并返回指向结点内存的Slice；其余类型原样转发(可移动)
+     */
+    template <typename T>
+    inline size_t InlineBytesOf(const T &t)
+    {
+        if constexpr (std::is_same_v<T, Slice>)
+        {
+            return t.size();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    template <typename T, typename U>
+    inline decltype(auto) InlineCopy(U &&u, char *&dst)
+    {
+        if constexpr (std::is_same_v<T, Slice>)
+        {
+            const Slice &src = u;
+            if (src.size() > 0)
+            {
+                memcpy(dst, src.data(), src.size());
+            }
+            Slice copied(dst, src.size());
+            dst += src.size();
+            return copied;
+        }
+        else
+        {
+            return std::forward<U>(u);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,522 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 15:05:52
+ * @LastEditTime: 2026-10-24 10:12:36
+ * @FilePath: /miniKV/src/memtable/memtable.h
+ * @Description: 内存表MemTable，底层结构在构造时选择
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_MEMTABLE_H
+#define MINIKVDB_MEMTABLE_H
+
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cassert>
+
+#include "../memory/default_alloc.h"
+#include "../utils/statistics.h"
+#include "../utils/dynamic_bloom.h"
+#include "../utils/perf_context.h"
+#include "skiplist.h"
+#include "hash_skiplist.h"
+#include "bplus_tree.h"
+#include "comparator.h"
+
+namespace minikvdb
+{
+    // MemTable底层数据结构
+    enum class MemTableRepType
+    {
+        kSkipList,     // 跳表：点查O(log n)，天然有序
+        kHashSkipList, // 哈希分桶：点查期望O(1)，有序遍历需额外排序，适合点查为主的负载；读者同样无锁
+        kBPlusTree,    // B+树：与跳表语义一致，相邻kv在叶子中连续存放，适合范围扫描较多的负载
+    };
+
+    // 64位哈希的最终混合(murmur3 fmix64)，使std::hash等弱哈希的各位分布均匀
+    inline uint64_t MixHash64(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // 前缀布隆过滤器的哈希函数：只对string key的前len个字节哈希
+    inline std::function<uint64_t(const std::string &)> FixedPrefixBloomHash(size_t len)
+    {
+        return [len](const std::string &key)
+        {
+            return MixHash64(std::hash<std::string_view>()(std::string_view(key.data(), std::min(len, key.size()))));
+        };
+    }
+
+    template <typename Key, typename Value, class Comparator, class Hash = std::hash<Key>>
+    class MemTable
+    {
+    public:
+        using SkipListRep = SkipList<Key, Value, Comparator>;
+        using HashSkipListRep = HashSkipList<Key, Value, Comparator, Hash>;
+        using BPlusTreeRep = BPlusTree<Key, Value, Comparator>;
+
+        /**
+         * @description:                            显示调用MemTable构造函数
+         * @param {Comparator} cmp                  key比较函数
+         * @param {shared_ptr<DefaultAlloc>} alloc  内存分配器
+         * @param {MemTableRepType} type            底层数据结构
+         * @param {size_t} bucket_count             kHashSkipList的桶数量
+         * @return {*}
+         */
+        explicit MemTable(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc,
+                          MemTableRepType type = MemTableRepType::kSkipList,
+                          size_t bucket_count = HashSkipListRep::kDefaultBucketCount)
+            : type_(type)
+        {
+            if (type_ == MemTableRepType::kHashSkipList)
+            {
+                hash_list_ = std::make_unique<HashSkipListRep>(cmp, std::move(alloc), bucket_count);
+            }
+            else if (type_ == MemTableRepType::kBPlusTree)
+            {
+                btree_ = std::make_unique<BPlusTreeRep>(cmp, std::move(alloc));
+            }
+            else
+            {
+                skiplist_ = std::make_unique<SkipListRep>(cmp, std::move(alloc));
+            }
+        }
+
+        // 删除拷贝构造函数
+        MemTable(const MemTable &) = delete;
+        MemTable &operator=(const MemTable &) = delete;
+
+        inline MemTableRepType GetRepType() { return type_; }
+
+        // 设置统计对象，需在并发访问开始前调用；有序表示底层还会统计key比较次数(skiplist还有结点高度)
+        void SetStatistics(std::shared_ptr<Statistics> stats)
+        {
+            if (!IsHash())
+            {
+                WithOrderedRep([&](auto &rep)
+                               { rep.SetStatistics(stats); });
+            }
+            stats_ = std::move(stats);
+        }
+
+        using BloomHash = std::function<uint64_t(const Key &)>;
+
+        /**
+         * @description:                    启用布隆过滤器，Get/Contains先查过滤器，判定不存在时直接返回
+         *                                  只能在插入数据前调用
+         * @param {size_t} memory_bytes     过滤器内存预算，每个key约10bit时误判率约1%
+         * @param {BloomHash} bloom_hash    key到哈希值的映射，为空时对完整key哈希；
+         *                                  传入FixedPrefixBloomHash等只看前缀的函数即为前缀布隆过滤器
+         * @param {int} num_probes          每个key设置的位数
+         * @return {*}
+         */
+        void EnableBloomFilter(size_t memory_bytes, BloomHash bloom_hash = nullptr, int num_probes = 6)
+        {
+            assert(GetSize() == 0);
+            bloom_ = std::make_unique<DynamicBloom>(memory_bytes, num_probes);
+            bloom_default_hash_ = bloom_hash == nullptr;
+            if (bloom_hash == nullptr)
+            {
+                bloom_hash = [](const Key &key)
+                { return MixHash64(static_cast<uint64_t>(Hash()(key))); };
+            }
+            bloom_hash_ = std::move(bloom_hash);
+        }
+
+        // 布隆过滤器占用的内存，未启用时为0
+        size_t GetBloomMemUsage() const { return bloom_ == nullptr ? 0 : bloom_->GetMemUsage(); }
+
+        void Insert(const Key &key, const Value &value) { InsertImpl(key, value); }
+
+        // 右值版本：key/value直接移动进底层结构的结点，不再拷贝
+        void Insert(Key &&key, Value &&value) { InsertImpl(std::move(key), std::move(value)); }
+
+        void Delete(const Key &key)
+        {
+            if (IsHash())
+            {
+                hash_list_->Delete(key);
+                return;
+            }
+            WithOrderedRep([&](auto &rep)
+                           { rep.Delete(key); });
+        }
+
+        bool Contains(const Key &key) { return ContainsImpl(key); }
+
+        std::optional<Value> Get(const Key &key) { return GetImpl(key); }
+
+        /**
+         * @description:                查找并把结果写入调用方提供的缓冲区，
+         *                              对string value是赋值，循环查找时复用同一个缓冲区即可避免每次分配
+         * @param {Key} &key            key
+         * @param {Value} *value        输出，不存在时保持不变
+         * @return {*}                  是否存在
+         */
+        bool Get(const Key &key, Value *value) { return GetImpl(key, value); }
+
+        /*
+         * 异构查找：Comparator带is_transparent标记时(见comparator.h)可以直接用与Key可比较的类型查找。
+         * 有序表示(skiplist/B+树)下全程不构造Key；哈希表示下还需Hash也是透明的，否则退化为构造一个临时Key。
+         * 布隆过滤器使用默认哈希且Hash透明时同样不构造Key，自定义的过滤器哈希(如前缀)只接受Key
+         */
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Contains(const K &key) { return ContainsImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        std::optional<Value> Get(const K &key) { return GetImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Get(const K &key, Value *value) { return GetImpl(key, value); }
+
+        /**
+         * @description:                    批量查找，先用布隆过滤器剔除不存在的key，
+         *                                  剩余的key交给有序表示的MultiGet(skiplist上排序后一次遍历完成)
+         * @param {vector<Key>} &keys       待查找的key
+         * @return {*}                      与keys一一对应的结果
+         */
+        std::vector<std::optional<Value>> MultiGet(const std::vector<Key> &keys)
+        {
+            PERF_TIMER_GUARD(get_cycles);
+            PERF_COUNTER_ADD(get_count, keys.size());
+            std::vector<std::optional<Value>> values(keys.size());
+            std::vector<size_t> candidates;
+            candidates.reserve(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                if (BloomMayContain(keys[i]))
+                {
+                    candidates.push_back(i);
+                }
+            }
+
+            if (IsHash())
+            {
+                // 哈希表示下key分散在各个桶中，没有可复用的查找路径
+                for (size_t i : candidates)
+                {
+                    values[i] = hash_list_->Get(keys[i]);
+                }
+            }
+            else
+            {
+                std::vector<const Key *> probe(candidates.size());
+                std::vector<std::optional<Value>> found(candidates.size());
+                for (size_t j = 0; j < candidates.size(); ++j)
+                {
+                    probe[j] = &keys[candidates[j]];
+                }
+                WithOrderedRep([&](auto &rep)
+                               { rep.MultiGet(probe.size(), probe.data(), found.data()); });
+                for (size_t j = 0; j < candidates.size(); ++j)
+                {
+                    values[candidates[j]] = std::move(found[j]);
+                }
+            }
+
+            for (size_t i : candidates)
+            {
+                RecordBloomResult(values[i].has_value());
+            }
+            for (const auto &value : values)
+            {
+                RecordGetResult(value.has_value() ? &*value : nullptr);
+            }
+            return values;
+        }
+
+        int GetSize()
+        {
+            if (IsHash())
+            {
+                return hash_list_->GetSize();
+            }
+            return WithOrderedRep([](auto &rep)
+                                  { return rep.GetSize(); });
+        }
+
+        int64_t GetMemUsage()
+        {
+            if (IsHash())
+            {
+                return hash_list_->GetMemUsage();
+            }
+            return WithOrderedRep([](auto &rep)
+                                  { return rep.GetMemUsage(); });
+        }
+
+        /*
+         * MemTable有序迭代器，对底层结构的迭代器做一层转发，主供flush调用
+         */
+        class MemTableIterator
+        {
+        public:
+            explicit MemTableIterator(const MemTable *table)
+            {
+                if (table->type_ == MemTableRepType::kHashSkipList)
+                {
+                    hash_iter_.emplace(table->hash_list_.get());
+                }
+                else if (table->type_ == MemTableRepType::kBPlusTree)
+                {
+                    btree_iter_.emplace(table->btree_.get());
+                }
+                else
+                {
+                    skiplist_iter_.emplace(table->skiplist_.get());
+                }
+            }
+
+            bool Valid()
+            {
+                return Visit([](auto &iter)
+                             { return iter.Valid(); });
+            }
+
+            const Key &key()
+            {
+                return Visit([](auto &iter) -> const Key &
+                             { return iter.key(); });
+            }
+
+            const Value &value()
+            {
+                return Visit([](auto &iter) -> const Value &
+                             { return iter.value(); });
+            }
+
+            void Next()
+            {
+                Visit([](auto &iter)
+                      { iter.Next(); });
+            }
+
+            void MoveToFirst()
+            {
+                Visit([](auto &iter)
+                      { iter.MoveToFirst(); });
+            }
+
+            void Seek(const Key &target)
+            {
+                Visit([&](auto &iter)
+                      { iter.Seek(target); });
+            }
+
+        private:
+            template <typename F>
+            decltype(auto) Visit(F &&f)
+            {
+                if (hash_iter_)
+                {
+                    return f(*hash_iter_);
+                }
+                if (btree_iter_)
+                {
+                    return f(*btree_iter_);
+                }
+                return f(*skiplist_iter_);
+            }
+
+            std::optional<typename SkipListRep::SkipListIterator> skiplist_iter_;
+            std::optional<typename HashSkipListRep::HashSkipListIterator> hash_iter_;
+            std::optional<typename BPlusTreeRep::BPlusTreeIterator> btree_iter_;
+        };
+
+    private:
+        inline bool IsHash() const { return type_ == MemTableRepType::kHashSkipList; }
+
+        // 对有序表示(skiplist或B+树)执行f，两者的接口一致
+        template <typename F>
+        decltype(auto) WithOrderedRep(F &&f)
+        {
+            if (btree_ != nullptr)
+            {
+                return f(*btree_);
+            }
+            return f(*skiplist_);
+        }
+
+        template <typename K>
+        bool ContainsImpl(const K &key)
+        {
+            if (!BloomMayContain(key))
+            {
+                return false;
+            }
+            bool found = IsHash() ? hash_list_->Contains(HashRepKey(key))
+                                  : WithOrderedRep([&](auto &rep)
+                                                   { return rep.Contains(key); });
+            RecordBloomResult(found);
+            return found;
+        }
+
+        template <typename K>
+        std::optional<Value> GetImpl(const K &key)
+        {
+            PERF_TIMER_GUARD(get_cycles);
+            PERF_COUNTER_ADD(get_count, 1);
+            std::optional<Value> value;
+            if (BloomMayContain(key))
+            {
+                value = IsHash() ? hash_list_->Get(HashRepKey(key))
+                                 : WithOrderedRep([&](auto &rep)
+                                                  { return rep.Get(key); });
+                RecordBloomResult(value.has_value());
+            }
+            RecordGetResult(value.has_value() ? &*value : nullptr);
+            return value;
+        }
+
+        template <typename K>
+        bool GetImpl(const K &key, Value *value)
+        {
+            PERF_TIMER_GUARD(get_cycles);
+            PERF_COUNTER_ADD(get_count, 1);
+            bool found = false;
+            if (BloomMayContain(key))
+            {
+                found = IsHash() ? hash_list_->Get(HashRepKey(key), value)
+                                 : WithOrderedRep([&](auto &rep)
+                                                  { return rep.Get(key, value); });
+                RecordBloomResult(found);
+            }
+            RecordGetResult(found ? value : nullptr);
+            return found;
+        }
+
+        // 哈希表示的异构查找要求Hash透明，否则只能构造临时Key
+        template <typename K>
+        decltype(auto) HashRepKey(const K &key)
+        {
+            if constexpr (std::is_same_v<K, Key> || kIsTransparent<Hash>)
+            {
+                return (key);
+            }
+            else
+            {
+                return Key(key);
+            }
+        }
+
+        // 未启用过滤器时恒为true
+        template <typename K>
+        bool BloomMayContain(const K &key)
+        {
+            if (bloom_ == nullptr)
+            {
+                return true;
+            }
+            uint64_t h;
+            if constexpr (std::is_same_v<K, Key>)
+            {
+                h = bloom_hash_(key);
+            }
+            else if constexpr (kIsTransparent<Hash>)
+            {
+                h = bloom_default_hash_ ? MixHash64(static_cast<uint64_t>(Hash()(key))) : bloom_hash_(Key(key));
+            }
+            else
+            {
+                h = bloom_hash_(Key(key));
+            }
+            if (bloom_->MayContainHash(h))
+            {
+                PERF_COUNTER_ADD(bloom_memtable_hit_count, 1);
+                return true;
+            }
+            PERF_COUNTER_ADD(bloom_memtable_miss_count, 1);
+            if (stats_ != nullptr)
+            {
+                stats_->RecordTick(Ticker::kBloomFilterUseful);
+            }
+            return false;
+        }
+
+        template <typename K, typename V>
+        void InsertImpl(K &&key, V &&value)
+        {
+            PERF_TIMER_GUARD(put_cycles);
+            PERF_COUNTER_ADD(put_count, 1);
+            if (bloom_ != nullptr)
+            {
+                // 先加入过滤器再插入，读者不会看到已插入但过滤器中没有的key
+                bloom_->AddHash(bloom_hash_(key));
+            }
+            if (stats_ != nullptr)
+            {
+                // key/value可能被移动走，先统计
+                stats_->RecordTick(Ticker::kKeysWritten);
+                stats_->RecordTick(Ticker::kBytesWritten, KVSizeOf(key) + KVSizeOf(value));
+            }
+            if (IsHash())
+            {
+                hash_list_->Insert(std::forward<K>(key), std::forward<V>(value));
+            }
+            else if (btree_ != nullptr)
+            {
+                btree_->Insert(std::forward<K>(key), std::forward<V>(value));
+            }
+            else
+            {
+                skiplist_->Insert(std::forward<K>(key), std::forward<V>(value));
+            }
+        }
+
+        // 记录一次点查的结果，value为空表示未命中
+        void RecordGetResult(const Value *value)
+        {
+            if (stats_ == nullptr)
+            {
+                return;
+            }
+            if (value != nullptr)
+            {
+                stats_->RecordTick(Ticker::kMemtableHit);
+                stats_->RecordTick(Ticker::kKeysRead);
+                stats_->RecordTick(Ticker::kBytesRead, KVSizeOf(*value));
+            }
+            else
+            {
+                stats_->RecordTick(Ticker::kMemtableMiss);
+            }
+        }
+
+        // 过滤器判定可能存在之后，记录实际查找结果，用于统计误判率
+        void RecordBloomResult(bool found)
+        {
+            if (bloom_ != nullptr && stats_ != nullptr)
+            {
+                stats_->RecordTick(Ticker::kBloomFilterPositive);
+                if (found)
+                {
+                    stats_->RecordTick(Ticker::kBloomFilterTruePositive);
+                }
+            }
+        }
+
+        MemTableRepType const type_;
+        std::unique_ptr<SkipListRep> skiplist_;
+        std::unique_ptr<HashSkipListRep> hash_list_;
+        std::unique_ptr<BPlusTreeRep> btree_;
+        std::shared_ptr<Statistics> stats_; // 统计信息，可为空
+        std::unique_ptr<DynamicBloom> bloom_; // 布隆过滤器，可为空
+        BloomHash bloom_hash_;                // key到过滤器哈希值的映射
+        bool bloom_default_hash_ = false;     // bloom_hash_是否为默认的MixHash64(Hash()(key))
+    };
+}
+
+#endif
@@ -1,12 +1,13 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-28 17:46:34
- * @LastEditTime: 2023-05-28 17:53:09
+ * @LastEditTime: 2026-10-19 17:05:33
  * @FilePath: /miniKV/src/memtable/random.h
  * @Description: 随机数生成器
  *
  * ********************************
  *  该模块实现借鉴于leveldb: https://github.com/google/leveldb/blob/main/util/random.h
+ *  FastRandom为xorshift64*生成器，每次只需一次乘法，用于跳表层高等热点路径
  * ********************************
  *
  * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
@@ -15,6 +16,7 @@
 #ifndef MINIKVDB_RANDOM_H
 #define MINIKVDB_RANDOM_H
 
+#include <atomic>
 #include <cstdint>
 
 namespace minikvdb
@@ -72,6 +74,46 @@ namespace minikvdb
         // range [0,2^max_log-1] with exponential bias towards smaller numbers.
         uint32_t Skewed(int max_log) { return Uniform(1 << Uniform(max_log + 1)); }
     };
+
+    // xorshift64*：周期2^64-1，通过BigCrush以外的大多数统计测试，速度远快于上面的Lehmer生成器。
+    // 非线程安全，多线程请使用各自的实例或GetTLSInstance()
+    class FastRandom
+    {
+    public:
+        explicit FastRandom(uint64_t seed)
+        {
+            // splitmix64打散种子，避免相近的种子产生相关的序列；state不能为0
+            uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            state_ = (z ^ (z >> 31)) | 1;
+        }
+
+        uint64_t Next64()
+        {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return state_ * 0x2545f4914f6cdd1dULL;
+        }
+
+        // Returns a uniformly distributed value in the range [0..n-1]
+        // 用乘法代替取模(Lemire)，REQUIRES: n > 0
+        uint32_t Uniform(uint32_t n) { return static_cast<uint32_t>(((Next64() >> 32) * n) >> 32); }
+
+        bool OneIn(uint32_t n) { return Uniform(n) == 0; }
+
+        // 当前线程的实例，每个线程的种子不同
+        static FastRandom *GetTLSInstance()
+        {
+            static std::atomic<uint64_t> next_seed{301};
+            thread_local FastRandom instance(next_seed.fetch_add(1, std::memory_order_relaxed));
+            return &instance;
+        }
+
+    private:
+        uint64_t state_;
+    };
 }
 
 #endif
\ No newline at end of file
@@ -1,47 +1,80 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-28 17:46:34
- * @LastEditTime: 2023-05-30 18:01:21
+ * @LastEditTime: 2026-10-22 21:18:40
  * @FilePath: /miniKV/src/memtable/skiplist.h
  * @Description: 跳表实现
  *
  * ********************************
  *  该模块实现借鉴于leveldb
+ *  线程安全：写操作(Insert/Delete)需要外部同步，读操作(Get/Contains/迭代器)
+ *  无需加锁，可与一个写者并发执行；Delete摘除的结点通过EpochManager延迟释放
  * ********************************
  *
  * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
  */
 
+#include <array>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <cstdlib>
 #include <utility>
 #include <iostream>
 #include <optional>
+#include <atomic>
+#include <new>
 #include <cassert>
 
 #include "../log/log.h"
 #include "../memory/default_alloc.h"
+#include "../memory/node_alloc.h"
+#include "../memory/epoch.h"
+#include "../utils/statistics.h"
+#include "../utils/perf_context.h"
 #include "random.h"
+#include "kv_size.h"
+#include "comparator.h"
 
 #ifndef MINIKVDB_SKIPLIST_H
 #define MINIKVDB_SKIPLIST_H
 
+// 跳表的分支因子(每层结点数约为下一层的1/BRANCHING)与最大高度，可在编译时覆盖。
+// 默认值下最大高度12可高效容纳约4^12 = 16M个结点；更大的表应同时调大MAX_HEIGHT
+#ifndef MINIKVDB_SKIPLIST_BRANCHING
+#define MINIKVDB_SKIPLIST_BRANCHING 4
+#endif
+
+#ifndef MINIKVDB_SKIPLIST_MAX_HEIGHT
+#define MINIKVDB_SKIPLIST_MAX_HEIGHT 12
+#endif
+
 namespace minikvdb
 {
-    template <typename Key, typename Value, class Comparator>
+    /*
+     * MaxHeight为编译期的高度上限，决定头结点与Insert/Delete中栈上前缀数组的大小；
+     * 构造时可再指定不超过MaxHeight的运行期上限，例如按预计数据量用HeightForEntries计算
+     */
+    template <typename Key, typename Value, class Comparator, int MaxHeight = MINIKVDB_SKIPLIST_MAX_HEIGHT>
     class SkipList
     {
         class Node;
 
+        // 每层的前缀结点，放在栈上，避免每次Insert/Delete的堆分配
+        using Splice = std::array<Node *, MaxHeight>;
+
     public:
         /**
          * @description:                            显示调用SkipList构造函数
          * @param {Comparator} cmp                  key比较函数
          * @param {shared_ptr<DefaultAlloc>} alloc  内存分配器
+         * @param {int} max_height                  运行期最大高度，取值[1, MaxHeight]
          * @return {*}
          */
-        explicit SkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc);
+        explicit SkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc, int max_height = MaxHeight);
+
+        // 析构时不能再有并发读者
+        ~SkipList();
 
         // 删除拷贝构造函数
         SkipList(const SkipList &) = delete;
@@ -55,6 +88,9 @@ namespace minikvdb
          */
         void Insert(const Key &key, const Value &value);
 
+        // 右值版本：key/value直接移动进结点，不再拷贝
+        void Insert(Key &&key, Value &&value);
+
         /**
          * @description:                删除key对应的value
          * @param {Key} &key            key
@@ -67,24 +103,102 @@ namespace minikvdb
          * @param {Key} &key            key
          * @return {*}                  true/false
          */
-        bool Contains(const Key &key);
+        bool Contains(const Key &key) { return ContainsImpl(key); }
 
         /**
          * @description:                key-value查找函数
          * @param {Key} &key            key
          * @return {*}                  存在返回value，不存在返回nullopt
          */
-        std::optional<Value> Get(const Key &key);
+        std::optional<Value> Get(const Key &key) { return GetImpl(key); }
+
+        /**
+         * @description:                key-value查找函数，结果写入调用方提供的缓冲区，
+         *                              对string value是赋值，复用*value已有的容量，不必每次分配
+         * @param {Key} &key            key
+         * @param {Value} *value        输出，不存在时保持不变
+         * @return {*}                  是否存在
+         */
+        bool Get(const Key &key, Value *value) { return GetImpl(key, value); }
+
+        /*
+         * 固定在结点上的value视图：存活期间处于epoch读临界区，结点即使被并发删除也不会被释放，
+         * 因此可以不拷贝直接读value。只能在调用GetPinned的线程上使用和析构
+         */
+        class PinnedValue
+        {
+        public:
+            PinnedValue() = default;
+
+            PinnedValue(const PinnedValue &) = delete;
+            PinnedValue &operator=(const PinnedValue &) = delete;
+
+            inline bool Valid() const { return value_ != nullptr; }
+
+            inline const Value &value() const
+            {
+                assert(Valid());
+                return *value_;
+            }
+
+            // 解除固定，之后不能再访问value()
+            inline void Reset()
+            {
+                value_ = nullptr;
+                guard_.reset();
+            }
+
+        private:
+            friend class SkipList;
+
+            const Value *value_ = nullptr;
+            std::optional<EpochGuard> guard_;
+        };
+
+        /**
+         * @description:                    零拷贝查找
+         * @param {Key} &key                key
+         * @param {PinnedValue} *pinned     输出，存在时固定在结点的value上，不存在时被Reset
+         * @return {*}                      是否存在
+         */
+        bool GetPinned(const Key &key, PinnedValue *pinned) { return GetPinnedImpl(key, pinned); }
+
+        /*
+         * 异构查找：Comparator带is_transparent标记时(见comparator.h)，以下重载接受任何能与Key比较的类型，
+         * 例如Key为std::string时直接传string_view、const char*，不构造临时Key；
+         * 比较器需支持cmp(const Key &, const K &)。传入Key本身时仍然匹配上面的非模板版本
+         */
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Contains(const K &key) { return ContainsImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        std::optional<Value> Get(const K &key) { return GetImpl(key); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool Get(const K &key, Value *value) { return GetImpl(key, value); }
+
+        template <typename K, typename C = Comparator, typename = typename C::is_transparent>
+        bool GetPinned(const K &key, PinnedValue *pinned) { return GetPinnedImpl(key, pinned); }
+
+        /**
+         * @description:                    批量查找：按key排序后一次遍历完成，
+         *                                  后一个key从前一个key的查找路径(splice)继续，而不是每次从head_开始
+         * @param {size_t} n                key数量
+         * @param {Key} *const *keys        待查找的key，可以乱序、重复
+         * @param {optional<Value>} *values 输出，与keys一一对应
+         * @return {*}
+         */
+        void MultiGet(size_t n, const Key *const *keys, std::optional<Value> *values);
 
         // 仅用于DEBUG：打印表
         void OnlyUsedForDebugging_Print_()
         {
-            auto p = head_->next[0];
+            auto p = head_->Next(0);
             std::cout << "============= DEBUG =============" << std::endl;
             for (int i = 0; i < size; ++i)
             {
                 std::cout << "key_" << i << " = " << p->key << std::endl;
-                p = p->next[0];
+                p = p->Next(0);
             }
             std::cout << "============= DEBUG =============" << std::endl;
         }
@@ -93,8 +207,21 @@ namespace minikvdb
 
         inline int64_t GetMemUsage() { return mem_usage; }
 
+        inline int GetMaxHeight() const { return max_height_; }
+
+        /**
+         * @description:                    容纳entries条数据所需的高度：ceil(log_B(entries))，且不超过MaxHeight
+         * @param {uint64_t} entries        预计数据量
+         * @return {*}
+         */
+        static int HeightForEntries(uint64_t entries);
+
+        // 设置统计对象，需在并发访问开始前调用；为空时不统计
+        inline void SetStatistics(std::shared_ptr<Statistics> stats) { stats_ = std::move(stats); }
+
         /*
          * skiplist迭代器，主供MemTable中的MemeIterator调用
+         * 迭代器存活期间处于epoch读临界区，其指向的结点即使被并发删除也不会被释放
          */
         class SkipListIterator
         {
@@ -117,17 +244,24 @@ namespace minikvdb
             // 必须要先调用此函数才可以进行迭代
             void MoveToFirst();
 
+            // 将当前node移到第一个key >= target的结点，可代替MoveToFirst作为迭代起点
+            void Seek(const Key &target);
+
         private:
             const SkipList *list_;
-            Node *node; // 当前iter指向的节点
+            Node *node;        // 当前iter指向的节点
+            EpochGuard guard_; // 保护node不被回收
         };
 
+        // 与BPlusTree::Iterator同名，便于对两种有序结构编写同一份代码
+        using Iterator = SkipListIterator;
+
     private:
         /**
-         * @description:    随机生成level
-         * @return {*}      随机level
+         * @description:    随机生成level，使用线程局部的随机数，可多线程并发调用
+         * @return {*}      随机level，不超过max_height_
          */
-        int RandomLevel();
+        int RandomLevel() const;
 
         /**
          * @description:    获取当前最大level
@@ -138,100 +272,198 @@ namespace minikvdb
         /**
          * @description:                    找到key结点的前缀结点，也就是找到key的待插入位置
          * @param {Key} &key                key
-         * @param {vector<Node *>} &prev    key前缀结点
-         * @return {*}
+         * @param {Splice} &prev            key前缀结点
+         * @return {*}                      查找过程中的key比较次数
+         */
+        uint64_t FindPrevNode(const Key &key, Splice &prev);
+
+        /**
+         * @description:                    查找key所在的结点，调用方需处于epoch读临界区
+         * @param {K} &key                  Key或与Key可比较的类型
+         * @param {uint64_t} *cmp_count     输出，key比较次数
+         * @return {*}                      不存在返回nullptr
          */
-        void FindPrevNode(const Key &key, std::vector<Node *> &prev);
+        template <typename K>
+        Node *SearchNode(const K &key, uint64_t *cmp_count);
+
+        // 在SearchNode基础上记录点查的perf context与统计信息
+        template <typename K>
+        Node *FindNode(const K &key);
+
+        template <typename K>
+        bool ContainsImpl(const K &key);
+
+        template <typename K>
+        std::optional<Value> GetImpl(const K &key);
+
+        template <typename K>
+        bool GetImpl(const K &key, Value *value);
+
+        template <typename K>
+        bool GetPinnedImpl(const K &key, PinnedValue *pinned);
+
+        template <typename K, typename V>
+        void InsertImpl(K &&key, V &&value);
 
         /**
-         * @description:                    新建一个结点
-         * @param {Key} &key                新结点的key
+         * @description:                    新建一个结点，结点、next数组与Slice类型key/value的内容在同一次分配中
+         * @param {K} &&key                 新结点的key
          * @param {int} level               新结点level
-         * @param {Value} &value            新结点value
+         * @param {V} &&value               新结点value
          * @return {*}
          */
-        inline Node *NewNode(const Key &key, int level, const Value &value);
+        template <typename K, typename V>
+        inline Node *NewNode(K &&key, int level, V &&value);
 
     private:
         enum
         {
-            kMaxHeight = 12 // skiplist最大高度
+            kMaxHeight = MaxHeight,                    // skiplist最大高度
+            kBranching = MINIKVDB_SKIPLIST_BRANCHING,  // 分支因子
+            kBranchingBits = __builtin_ctz(kBranching) // 每升高一层需要的随机位数
         };
+        static_assert(kBranching >= 2 && (kBranching & (kBranching - 1)) == 0,
+                      "MINIKVDB_SKIPLIST_BRANCHING must be a power of two");
+        static_assert(kMaxHeight >= 1 && (kMaxHeight - 1) * kBranchingBits <= 63,
+                      "MaxHeight too large for one 64-bit random draw");
 
-        Node *head_; // 头结点，高度为kMaxHeight，不存数据
+        Node *head_;           // 头结点，高度为max_height_，不存数据
+        int const max_height_; // 运行期最大高度
 
         std::shared_ptr<DefaultAlloc> alloc;
 
-        int max_level;             // 当前表的最大高度节点
+        std::atomic<int> max_level; // 当前表的最大高度节点，读者并发读取
         int64_t size = 0;          // 表中数据量(kv键值对数量)
         int64_t mem_usage = 0;     // kv键值对所占用的内存大小，单位：Byte
         Comparator const compare_; // 比较函数
-        Random rand_;              // 随机数
+
+        std::shared_ptr<Statistics> stats_; // 统计信息，可为空
     };
 
     /*================================================================
     *  skiplist 结点 Node 定义
     ================================================================*/
 
-    template <typename Key, typename Value, class Comparator>
-    class SkipList<Key, Value, Comparator>::Node
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    class SkipList<Key, Value, Comparator, MaxHeight>::Node
     {
     public:
         Node() = delete;
 
-        Node(const Key &key, int level, const Value &value) : key(key), value(value)
+        template <typename K, typename V>
+        Node(K &&key, int level, V &&value)
+            : key(std::forward<K>(key)), value(std::forward<V>(value)), level_(level)
         {
-            next.resize(level, nullptr);
+            for (int i = 0; i < level; ++i)
+            {
+                next_[i].store(nullptr, std::memory_order_relaxed);
+            }
         }
 
         ~Node() = default;
 
-        inline int GetLevel() { return next.size(); }
+        inline int GetLevel() { return level_; }
+
+        // acquire读，保证能看到被发布结点的完整内容
+        inline Node *Next(int n) { return next_[n].load(std::memory_order_acquire); }
+
+        // release写，发布结点前对其的初始化对读者可见
+        inline void SetNext(int n, Node *x) { next_[n].store(x, std::memory_order_release); }
+
+        // 仅在写者独占的位置使用
+        inline Node *NoBarrierNext(int n) { return next_[n].load(std::memory_order_relaxed); }
+
+        inline void NoBarrierSetNext(int n, Node *x) { next_[n].store(x, std::memory_order_relaxed); }
+
+        // level层结点本身占用的字节数，Slice类型key/value的内容紧跟其后
+        static size_t AllocSize(int level) { return sizeof(Node) + sizeof(std::atomic<Node *>) * (level - 1); }
+
+        // 结点连同内联的Slice内容一共分配的字节数
+        inline size_t TotalSize() const
+        {
+            return AllocSize(level_) + InlineBytesOf<Key>(key) + InlineBytesOf<Value>(value);
+        }
+
+        // 供EpochManager延迟释放
+        static void Destroy(void *p)
+        {
+            Node *node = static_cast<Node *>(p);
+            const size_t n = node->TotalSize();
+            node->~Node();
+            DeallocateNode(node, n);
+        }
 
         const Key key;
         Value value;
-        std::vector<Node *> next;
+
+    private:
+        const int level_;
+        std::atomic<Node *> next_[1]; // 实际长度为level_，与结点一起分配
     };
 
     /*================================================================
     *  skiplist 迭代器功能实现
     ================================================================*/
 
-    template <typename Key, typename Value, class Comparator>
-    void SkipList<Key, Value, Comparator>::SkipListIterator::MoveToFirst()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::MoveToFirst()
     {
-        node = list_->head_->next[0];
+        node = list_->head_->Next(0);
     }
 
-    template <typename Key, typename Value, class Comparator>
-    void SkipList<Key, Value, Comparator>::SkipListIterator::Next()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::Seek(const Key &target)
+    {
+        int level = list_->max_level.load(std::memory_order_relaxed) - 1;
+        Node *cur = list_->head_;
+        while (true)
+        {
+            Node *next = cur->Next(level);
+            if (next != nullptr && list_->compare_(next->key, target) < 0)
+            {
+                cur = next; // 在当前层继续向后
+            }
+            else if (level == 0)
+            {
+                node = next;
+                return;
+            }
+            else
+            {
+                --level;
+            }
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::Next()
     {
         assert(Valid());
-        node = node->next[0]; // 遍历肯定是在跳表最底层进行遍历，所以是0
+        node = node->Next(0); // 遍历肯定是在跳表最底层进行遍历，所以是0
     }
 
-    template <typename Key, typename Value, class Comparator>
-    const Key &SkipList<Key, Value, Comparator>::SkipListIterator::key()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    const Key &SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::key()
     {
         assert(Valid());
         return node->key;
     }
 
-    template <typename Key, typename Value, class Comparator>
-    const Value &SkipList<Key, Value, Comparator>::SkipListIterator::value()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    const Value &SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::value()
     {
         assert(Valid());
         return node->value;
     }
 
-    template <typename Key, typename Value, class Comparator>
-    bool SkipList<Key, Value, Comparator>::SkipListIterator::Valid()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    bool SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::Valid()
     {
         return node != nullptr;
     }
 
-    template <typename Key, typename Value, class Comparator>
-    SkipList<Key, Value, Comparator>::SkipListIterator::SkipListIterator(const SkipList *list) : list_(list)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    SkipList<Key, Value, Comparator, MaxHeight>::SkipListIterator::SkipListIterator(const SkipList *list) : list_(list)
     {
         node = nullptr;
     }
@@ -240,78 +472,200 @@ namespace minikvdb
     *  skiplist 主要功能实现
     ================================================================*/
 
-    template <typename Key, typename Value, class Comparator>
-    std::optional<Value> SkipList<Key, Value, Comparator>::Get(const Key &key)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    typename SkipList<Key, Value, Comparator, MaxHeight>::Node *SkipList<Key, Value, Comparator, MaxHeight>::SearchNode(
+        const K &key, uint64_t *cmp_count)
     {
         int level = GetCurrentHeight() - 1;
         auto cur = head_;
         while (true)
         {
-            auto next = cur->next[level];
-            if (next == nullptr)
+            auto next = cur->Next(level);
+            int cmp = 1; // 空指针视为比所有key都大
+            if (next != nullptr)
             {
-                if (level == 0)
-                {
-                    // 遍历到这里说明key不存在
-                    return std::nullopt;
-                }
-                else
+                cmp = compare_(next->key, key); // 每个结点只比较一次
+                ++*cmp_count;
+            }
+
+            if (cmp == 0)
+            {
+                return next; // 找到了
+            }
+            else if (cmp < 0)
+            {
+                cur = next;
+            }
+            else if (level == 0)
+            {
+                return nullptr; // 只有在最后一层，遇到大于key的时候才可以认为没找到
+            }
+            else
+            {
+                --level; // 在非最底层遇到了大于key的数，应该下降
+            }
+        }
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    typename SkipList<Key, Value, Comparator, MaxHeight>::Node *SkipList<Key, Value, Comparator, MaxHeight>::FindNode(const K &key)
+    {
+        PERF_TIMER_GUARD(get_search_cycles);
+        uint64_t cmp_count = 0;
+        Node *found = SearchNode(key, &cmp_count);
+        PERF_TIMER_STOP(get_search_cycles);
+
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+            stats_->RecordInHistogram(HistogramType::kComparisonsPerGet, cmp_count);
+        }
+        return found;
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    std::optional<Value> SkipList<Key, Value, Comparator, MaxHeight>::GetImpl(const K &key)
+    {
+        EpochGuard guard;
+        Node *found = FindNode(key);
+        if (found == nullptr)
+        {
+            return std::nullopt;
+        }
+        return found->value;
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    bool SkipList<Key, Value, Comparator, MaxHeight>::GetImpl(const K &key, Value *value)
+    {
+        EpochGuard guard;
+        Node *found = FindNode(key);
+        if (found == nullptr)
+        {
+            return false;
+        }
+        *value = found->value;
+        return true;
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    bool SkipList<Key, Value, Comparator, MaxHeight>::GetPinnedImpl(const K &key, PinnedValue *pinned)
+    {
+        pinned->Reset();
+        pinned->guard_.emplace(); // 先进入临界区再查找，保证找到的结点在pinned存活期间不被释放
+        Node *found = FindNode(key);
+        if (found == nullptr)
+        {
+            pinned->Reset();
+            return false;
+        }
+        pinned->value_ = &found->value;
+        return true;
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::MultiGet(
+        size_t n, const Key *const *keys, std::optional<Value> *values)
+    {
+        EpochGuard guard;
+        PERF_TIMER_GUARD(get_search_cycles);
+        std::vector<size_t> order(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return compare_(*keys[a], *keys[b]) < 0; });
+
+        // prev[i]始终是第i层上key小于当前key的结点(或head_)，key升序时对后续key依然成立
+        const int height = GetCurrentHeight();
+        Splice prev;
+        prev.fill(head_);
+        uint64_t cmp_count = 0;
+        for (size_t idx : order)
+        {
+            const Key &key = *keys[idx];
+            values[idx].reset();
+
+            // 从最底层向上找到仍然"夹住"key的一层，再从该层的prev向下查找
+            int level = 0;
+            while (level < height - 1)
+            {
+                Node *next = prev[level]->Next(level);
+                if (next == nullptr || (++cmp_count, compare_(next->key, key) >= 0))
                 {
-                    --level;
+                    break;
                 }
+                ++level;
             }
-            else
+
+            Node *cur = prev[level];
+            while (true)
             {
-                if (compare_(next->key, key) == 0)
+                Node *next = cur->Next(level);
+                int cmp = 1; // 空指针视为比所有key都大
+                if (next != nullptr)
                 {
-                    return next->value; // 找到了
+                    cmp = compare_(next->key, key);
+                    ++cmp_count;
                 }
-                else if (compare_(next->key, key) < 0)
+
+                if (cmp < 0)
                 {
                     cur = next;
+                    continue;
                 }
-                else if (compare_(next->key, key) > 0)
+                prev[level] = cur;
+                if (cmp == 0)
                 {
-                    if (level == 0)
-                    {
-                        // 遍历到这里说明key不存在
-                        return std::nullopt;
-                    }
-                    else
-                    {
-                        --level; // 在非最底层遇到了大于key的数，应该下降
-                    }
+                    values[idx] = next->value; // 找到了；更低层的prev仍小于key，不必更新
+                    break;
+                }
+                if (level == 0)
+                {
+                    break;
                 }
+                --level;
             }
         }
+        PERF_TIMER_STOP(get_search_cycles);
+
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+        }
     }
 
-    template <typename Key, typename Value, class Comparator>
-    void SkipList<Key, Value, Comparator>::Delete(const Key &key)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::Delete(const Key &key)
     {
         if (Contains(key) == false)
         {
-            LOG_WARN("%s", ("The value you want to delete does not exist. Key={}", key));
-            printf("The value you want to delete does not exist. Key={}", key);
+            LOG_WARN("%s", "The value you want to delete does not exist.");
             return;
         }
         --size;
 
-        // std::vector<Node *> prev(GetCurrentHeight(), nullptr);
-        std::vector<Node *> prev(kMaxHeight, nullptr);
+        Splice prev{};
 
         int level = GetCurrentHeight() - 1;
         auto cur = head_;
         int level_of_target_node = -1; // 目标节点的层数
         while (true)
         {
-            auto next = cur->next[level];
+            auto next = cur->NoBarrierNext(level);
             if (next == nullptr)
             {
                 if (level == 0)
                 {
                     LOG_ERROR("%s", "A error point.");
-                    printf("A error point.");
                     break; // 遍历完成. 实际上这个分支不可能到达
                 }
                 else
@@ -350,70 +704,53 @@ namespace minikvdb
         // 更新内存占用
         // mem_usage -= sizeof(key);
         // mem_usage -= sizeof(prev[0]->next[0]->value); // prev[0]->next[0]指向待删除的节点
-        mem_usage -= (typeid(key) == typeid(std::string) ? key.size() : sizeof(key));
-        mem_usage -= (typeid(prev[0]->next[0]->value) == typeid(std::string) ? prev[0]->next[0]->value.size() : sizeof(prev[0]->next[0]->value));
+        Node *target = prev[0]->NoBarrierNext(0); // prev[0]->next[0]指向待删除的节点
+        mem_usage -= KVSizeOf(key);
+        mem_usage -= KVSizeOf(target->value);
 
+        // target自身的next指针保持不变，正停留在target上的读者仍能沿着它继续向后遍历
         for (int i = 0; i < level_of_target_node; ++i)
         {
             if (prev[i] != nullptr)
             {
-                assert(prev[i]->next[i] != nullptr);
-                prev[i]->next[i] = prev[i]->next[i]->next[i];
+                assert(prev[i]->NoBarrierNext(i) == target);
+                prev[i]->SetNext(i, target->NoBarrierNext(i));
             }
         }
+
+        // 可能仍有读者持有target，交给EpochManager在安全后释放
+        EpochManager::get_instance()->Retire(target, &Node::Destroy);
     }
 
-    template <typename Key, typename Value, class Comparator>
-    bool SkipList<Key, Value, Comparator>::Contains(const Key &key)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K>
+    bool SkipList<Key, Value, Comparator, MaxHeight>::ContainsImpl(const K &key)
     { // 存在key则返回true
-        int level = GetCurrentHeight() - 1;
-        auto cur = head_;
-        while (true)
-        {
-            auto next = cur->next[level];
-            if (next == nullptr)
-            {
-                if (level == 0)
-                {
-                    return false; // 已经遍历完成
-                }
-                else
-                {
-                    --level;
-                }
-            }
-            else
-            {
-                if (compare_(next->key, key) == 0)
-                {
-                    return true;
-                }
-                else if (compare_(next->key, key) < 0)
-                {
-                    cur = next;
-                }
-                else if (compare_(next->key, key) > 0)
-                {
-                    if (level == 0)
-                    {
-                        return false; // 只有在最后一层，遇到大于key的时候才可以认为没找到
-                    }
-                    else
-                    {
-                        --level; // 在非最底层遇到了大于key的数，应该下降
-                    }
-                }
-            }
-        }
+        EpochGuard guard;
+        uint64_t cmp_count = 0;
+        return SearchNode(key, &cmp_count) != nullptr;
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::Insert(const Key &key, const Value &value)
+    {
+        InsertImpl(key, value);
     }
 
-    template <typename Key, typename Value, class Comparator>
-    void SkipList<Key, Value, Comparator>::Insert(const Key &key, const Value &value)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    void SkipList<Key, Value, Comparator, MaxHeight>::Insert(Key &&key, Value &&value)
     {
+        InsertImpl(std::move(key), std::move(value));
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K, typename V>
+    void SkipList<Key, Value, Comparator, MaxHeight>::InsertImpl(K &&key, V &&value)
+    {
+        PERF_TIMER_GUARD(put_search_cycles);
         if (Contains(key))
         {
-            LOG_WARN("%s", ("A duplicate key was inserted. Key={}", key));
-            printf("A duplicate key was inserted. Key={}\n", key);
+            LOG_WARN("%s", "A duplicate key was inserted.");
             return;
         }
         // 更新size
@@ -422,57 +759,71 @@ namespace minikvdb
         // 更新mem_usage
         // mem_usage += sizeof(key);
         // mem_usage += sizeof(value);
-        mem_usage += (typeid(key) == typeid(std::string) ? key.size() : sizeof(key));
-        mem_usage += (typeid(value) == typeid(std::string) ? value.size() : sizeof(value));
+        mem_usage += KVSizeOf(key);
+        mem_usage += KVSizeOf(value);
 
-        // std::vector<Node *> prev(GetCurrentHeight(), nullptr);
-        std::vector<Node *> prev(kMaxHeight, nullptr);
+        Splice prev{};
 
         // 找到key的前缀节点，并且存到prev中
-        FindPrevNode(key, prev);
+        uint64_t cmp_count = FindPrevNode(key, prev);
+        PERF_TIMER_STOP(put_search_cycles);
+        PERF_COUNTER_ADD(user_key_comparison_count, cmp_count);
+
         int level_of_new_node = RandomLevel();
-        max_level = std::max(level_of_new_node, max_level); // 更新最大高度
-        auto newNode = NewNode(key, level_of_new_node, value);
+        if (stats_ != nullptr)
+        {
+            stats_->RecordTick(Ticker::kKeyComparisons, cmp_count);
+            stats_->RecordInHistogram(HistogramType::kComparisonsPerPut, cmp_count);
+            stats_->RecordInHistogram(HistogramType::kSkipListNodeHeight, level_of_new_node);
+        }
+        if (level_of_new_node > GetCurrentHeight())
+        {
+            // 读者读到新高度时head_在新增层上的next要么为空，要么是新结点，都是安全的
+            max_level.store(level_of_new_node, std::memory_order_relaxed); // 更新最大高度
+        }
+        PERF_TIMER_GUARD(put_alloc_cycles);
+        auto newNode = NewNode(std::forward<K>(key), level_of_new_node, std::forward<V>(value));
+        PERF_TIMER_STOP(put_alloc_cycles);
 
+        PERF_TIMER_GUARD(put_link_cycles);
         for (int i = 0; i < newNode->GetLevel(); ++i)
         {
-            if (prev[i] == nullptr)
-            {
-                newNode->next[i] = nullptr;
-                head_->next[i] = newNode;
-            }
-            else
-            {
-                newNode->next[i] = prev[i]->next[i];
-                prev[i]->next[i] = newNode;
-            }
+            Node *pre = prev[i] == nullptr ? head_ : prev[i];
+            // 新结点尚未发布，可以直接写；随后release发布，读者能看到完整的新结点
+            newNode->NoBarrierSetNext(i, pre->NoBarrierNext(i));
+            pre->SetNext(i, newNode);
         }
     }
 
-    template <typename Key, typename Value, class Comparator>
-    int SkipList<Key, Value, Comparator>::GetCurrentHeight()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    int SkipList<Key, Value, Comparator, MaxHeight>::GetCurrentHeight()
     {
-        return max_level;
+        return max_level.load(std::memory_order_relaxed);
     }
 
-    template <typename Key, typename Value, class Comparator>
-    typename SkipList<Key, Value, Comparator>::Node *SkipList<Key, Value, Comparator>::NewNode(const Key &key, int level, const Value &value)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    template <typename K, typename V>
+    typename SkipList<Key, Value, Comparator, MaxHeight>::Node *SkipList<Key, Value, Comparator, MaxHeight>::NewNode(K &&key, int level, V &&value)
     {
-        // todo: 不确定FreeListAllocate实现有没有问题，
-        //  所以此处先使用系统allocator，稳定了再换。
-        return new Node(key, level, value);
+        // 结点大小随层高与Slice内容变化，经AllocateNode按size class分配(见node_alloc.h)
+        const size_t node_size = Node::AllocSize(level);
+        char *mem = static_cast<char *>(AllocateNode(node_size + InlineBytesOf<Key>(key) + InlineBytesOf<Value>(value)));
+        char *inline_data = mem + node_size;
+        return new (mem) Node(InlineCopy<Key>(std::forward<K>(key), inline_data), level,
+                              InlineCopy<Value>(std::forward<V>(value), inline_data));
     }
 
-    template <typename Key, typename Value, class Comparator>
-    void SkipList<Key, Value, Comparator>::FindPrevNode(
-        const Key &key, std::vector<Node *> &prev)
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    uint64_t SkipList<Key, Value, Comparator, MaxHeight>::FindPrevNode(
+        const Key &key, Splice &prev)
     {
         int level = GetCurrentHeight() - 1;
         auto cur = head_;
+        uint64_t cmp_count = 0;
         while (true)
         {
-            auto next_node = cur->next[level];
-            if (next_node == nullptr || compare_(next_node->key, key) >= 0)
+            auto next_node = cur->NoBarrierNext(level);
+            if (next_node == nullptr || (++cmp_count, compare_(next_node->key, key) >= 0))
             {
                 prev[level] = cur;
                 if (level > 0)
@@ -481,7 +832,7 @@ namespace minikvdb
                 }
                 else
                 {
-                    return;
+                    return cmp_count;
                 }
             }
             else
@@ -491,32 +842,54 @@ namespace minikvdb
         }
     }
 
-    template <typename Key, typename Value, class Comparator>
-    int SkipList<Key, Value, Comparator>::RandomLevel()
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    int SkipList<Key, Value, Comparator, MaxHeight>::RandomLevel() const
     {
+        // 每kBranchingBits个连续的0位代表升高一层的概率1/kBranching，
+        // 因此level - 1 = 尾部0位数 / kBranchingBits；置最高位避免全0时ctz未定义
+        uint64_t r = FastRandom::GetTLSInstance()->Next64() | (1ULL << 63);
+        int level = 1 + __builtin_ctzll(r) / kBranchingBits;
+        level = level < max_height_ ? level : max_height_;
+        assert(level > 0);
+        assert(level <= max_height_);
+        return level;
+    }
 
-        static const unsigned int kBranching = 4;
-        int level = 1;
-        while (level < kMaxHeight && rand_.OneIn(kBranching))
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    int SkipList<Key, Value, Comparator, MaxHeight>::HeightForEntries(uint64_t entries)
+    {
+        int height = 1;
+        for (uint64_t capacity = kBranching; capacity < entries && height < kMaxHeight; capacity *= kBranching)
         {
-            ++level;
+            ++height;
         }
-        assert(level > 0);
-        assert(level <= kMaxHeight);
-        return level;
+        return height;
     }
 
-    template <typename Key, typename Value, class Comparator>
-    SkipList<Key, Value, Comparator>::SkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc)
-        : compare_(cmp),
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    SkipList<Key, Value, Comparator, MaxHeight>::SkipList(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc,
+                                                          int max_height)
+        : max_height_(max_height < 1 ? 1 : (max_height > kMaxHeight ? kMaxHeight : max_height)),
           alloc(std::move(alloc)),
-          rand_(0xdeadbeef)
+          compare_(cmp)
     {
-        head_ = NewNode(Key(), kMaxHeight, Value());
+        head_ = NewNode(Key(), max_height_, Value());
         max_level = 1;
         size = 0;
         mem_usage = 0;
-        Log::get_instance()->init("./MinikvLog", 0, 2000, 800000);
+    }
+
+    template <typename Key, typename Value, class Comparator, int MaxHeight>
+    SkipList<Key, Value, Comparator, MaxHeight>::~SkipList()
+    {
+        // 已删除的结点由EpochManager负责释放，这里只释放仍在表中的结点
+        Node *cur = head_;
+        while (cur != nullptr)
+        {
+            Node *next = cur->NoBarrierNext(0);
+            Node::Destroy(cur);
+            cur = next;
+        }
     }
 }
 #endif
\ No newline at end of file
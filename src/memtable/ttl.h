@@ -0,0 +1,131 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 16:05:27
+ * @LastEditTime: 2026-10-21 16:05:27
+ * @FilePath: /miniKV/src/memtable/ttl.h
+ * @Description: 带过期时间(TTL)的value与惰性过期的内存表
+ *
+ * ********************************
+ *  过期时间与value存放在一起(TtlValue)，读取时惰性判断：过期的key不会被Get返回，
+ *  也不需要为过期数据逐个写删除标记。真正的清理在flush/compaction时由
+ *  TtlCompactionFilter(src/compaction/compaction_filter.h)完成。
+ *  过期时间使用墙上时间(微秒)，随数据落盘，重启后仍然有效。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_TTL_H
+#define MINIKVDB_TTL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "../memory/default_alloc.h"
+#include "kv_size.h"
+#include "memtable.h"
+
+namespace minikvdb
+{
+    // 返回当前墙上时间(微秒)的时钟，测试中可替换
+    using TtlClock = uint64_t (*)();
+
+    inline uint64_t WallClockMicros()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::system_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    template <typename Value>
+    struct TtlValue
+    {
+        Value value{};
+        uint64_t expire_micros = 0; // 过期时刻，0表示永不过期
+
+        inline bool Expired(uint64_t now_micros) const
+        {
+            return expire_micros != 0 && expire_micros <= now_micros;
+        }
+    };
+
+    // 内存占用按value本身加上过期时间计算
+    template <typename Value>
+    inline int64_t KVSizeOf(const TtlValue<Value> &t)
+    {
+        return KVSizeOf(t.value) + static_cast<int64_t>(sizeof(t.expire_micros));
+    }
+
+    /*
+     * 带TTL的内存表：底层为MemTable<Key, TtlValue<Value>>，Get/Contains惰性过滤已过期的key。
+     * 与MemTable相同，写操作需要外部同步。
+     */
+    template <typename Key, typename Value, class Comparator, class Hash = std::hash<Key>>
+    class TtlMemTable
+    {
+    public:
+        using Table = MemTable<Key, TtlValue<Value>, Comparator, Hash>;
+
+        /**
+         * @description:                            构造
+         * @param {Comparator} cmp                  key比较函数
+         * @param {shared_ptr<DefaultAlloc>} alloc  内存分配器
+         * @param {MemTableRepType} type            底层数据结构
+         * @param {TtlClock} clock                  时钟
+         * @return {*}
+         */
+        explicit TtlMemTable(Comparator cmp, std::shared_ptr<DefaultAlloc> alloc,
+                             MemTableRepType type = MemTableRepType::kSkipList, TtlClock clock = &WallClockMicros)
+            : table_(cmp, std::move(alloc), type), clock_(clock)
+        {
+        }
+
+        /**
+         * @description:                        插入key，已存在且未过期时与MemTable一样忽略本次插入
+         * @param {Key} &key                    key
+         * @param {Value} &value                value
+         * @param {uint64_t} ttl_micros         存活时间，0表示永不过期
+         * @return {*}
+         */
+        void Insert(const Key &key, const Value &value, uint64_t ttl_micros = 0)
+        {
+            const uint64_t now = clock_();
+            auto old = table_.Get(key);
+            if (old.has_value() && old->Expired(now))
+            {
+                // 过期的旧值不能挡住新写入
+                table_.Delete(key);
+            }
+            table_.Insert(key, TtlValue<Value>{value, ttl_micros == 0 ? 0 : now + ttl_micros});
+        }
+
+        void Delete(const Key &key) { table_.Delete(key); }
+
+        std::optional<Value> Get(const Key &key)
+        {
+            auto ttl_value = table_.Get(key);
+            if (!ttl_value.has_value() || ttl_value->Expired(clock_()))
+            {
+                return std::nullopt;
+            }
+            return std::move(ttl_value->value);
+        }
+
+        bool Contains(const Key &key) { return Get(key).has_value(); }
+
+        // 底层内存表，包含尚未清理的过期数据，供flush使用
+        inline Table &GetMemTable() { return table_; }
+
+        inline TtlClock GetClock() const { return clock_; }
+
+    private:
+        Table table_;
+        TtlClock clock_;
+    };
+}
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 16:30:09
+ * @LastEditTime: 2026-10-24 09:20:41
+ * @FilePath: /miniKV/src/utils/async_io.cc
+ * @Description: 批量异步读实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "async_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+#include "thread_pool.h"
+
+namespace minikvdb
+{
+    namespace
+    {
+        // 读满len字节或遇到EOF/错误
+        ssize_t FullPread(int fd, char *buf, size_t len, uint64_t offset)
+        {
+            size_t done = 0;
+            while (done < len)
+            {
+                ssize_t r = ::pread(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+                if (r < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return -errno;
+                }
+                if (r == 0)
+                {
+                    break; // EOF
+                }
+                done += static_cast<size_t>(r);
+            }
+            return static_cast<ssize_t>(done);
+        }
+
+        class ThreadPoolReader : public AsyncReader
+        {
+        public:
+            explicit ThreadPoolReader(int threads) : pool_(threads, 0) {}
+
+            void MultiRead(ReadRequest *reqs, size_t n) override
+            {
+                std::mutex mu;
+                std::condition_variable cv;
+                size_t pending = n;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    ReadRequest *req = &reqs[i];
+                    pool_.Schedule([req, &mu, &cv, &pending]()
+                                   {
+                        req->result = FullPread(req->fd, req->scratch, req->len, req->offset);
+                        std::lock_guard<std::mutex> guard(mu);
+                        if (--pending == 0)
+                        {
+                            cv.notify_one();
+                        } },
+                                   Priority::kHigh);
+                }
+                std::unique_lock<std::mutex> lock(mu);
+                cv.wait(lock, [&pending]()
+                        { return pending == 0; });
+            }
+
+            const char *Name() const override { return "thread_pool"; }
+
+        private:
+            ThreadPool pool_;
+        };
+
+#ifdef __linux__
+        class IoUringReader : public AsyncReader
+        {
+        public:
+            ~IoUringReader() override
+            {
+                if (sqes_ != nullptr)
+                {
+                    ::munmap(sqes_, sqes_size_);
+                }
+                if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+                {
+                    ::munmap(cq_ring_, cq_ring_size_);
+                }
+                if (sq_ring_ != nullptr)
+                {
+                    ::munmap(sq_ring_, sq_ring_size_);
+                }
+                if (ring_fd_ >= 0)
+                {
+                    ::close(ring_fd_);
+                }
+            }
+
+            // 初始化失败时返回false，由调用方退回线程池后端
+            bool Init(unsigned entries)
+            {
+                struct io_uring_params p;
+                memset(&p, 0, sizeof(p));
+                ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+                if (ring_fd_ < 0)
+                {
+                    return false;
+                }
+
+                sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+                cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+                bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (single_mmap)
+                {
+                    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                }
+                sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                  ring_fd_, IORING_OFF_SQ_RING);
+                if (sq_ring_ == MAP_FAILED)
+                {
+                    sq_ring_ = nullptr;
+                    return false;
+                }
+                if (single_mmap)
+                {
+                    cq_ring_ = sq_ring_;
+                }
+                else
+                {
+                    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      ring_fd_, IORING_OFF_CQ_RING);
+                    if (cq_ring_ == MAP_FAILED)
+                    {
+                        cq_ring_ = nullptr;
+                        return false;
+                    }
+                }
+                sqes_size_ = p.sq_entries * sizeof(struct io_uring_sqe);
+                void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                    ring_fd_, IORING_OFF_SQES);
+                if (sqes == MAP_FAILED)
+                {
+                    return false;
+                }
+                sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+                char *sq = static_cast<char *>(sq_ring_);
+                char *cq = static_cast<char *>(cq_ring_);
+                sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+                sq_mask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+                sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+                cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + p.cq_off.cqes);
+                sq_entries_ = p.sq_entries;
+                return true;
+            }
+
+            void MultiRead(ReadRequest *reqs, size_t n) override
+            {
+                // 超过队列深度时分批提交
+                for (size_t start = 0; start < n; start += sq_entries_)
+                {
+                    size_t batch = std::min<size_t>(sq_entries_, n - start);
+                    SubmitAndWait(reqs + start, batch);
+                }
+                // 短读(未到EOF)时同步补齐剩余部分
+                for (size_t i = 0; i < n; ++i)
+                {
+                    ReadRequest &req = reqs[i];
+                    if (req.result >= 0 && static_cast<size_t>(req.result) < req.len)
+                    {
+                        ssize_t rest = FullPread(req.fd, req.scratch + req.result, req.len - req.result,
+                                                 req.offset + req.result);
+                        req.result = rest < 0 ? rest : req.result + rest;
+                    }
+                }
+            }
+
+            const char *Name() const override { return "io_uring"; }
+
+        private:
+            void SubmitAndWait(ReadRequest *reqs, size_t n)
+            {
+                unsigned tail = *sq_tail_; // 只有本线程写sq_tail
+                for (size_t i = 0; i < n; ++i)
+                {
+                    unsigned idx = tail & sq_mask_;
+                    struct io_uring_sqe *sqe = &sqes_[idx];
+                    memset(sqe, 0, sizeof(*sqe));
+                    sqe->opcode = IORING_OP_READ;
+                    sqe->fd = reqs[i].fd;
+                    sqe->off = reqs[i].offset;
+                    sqe->addr = reinterpret_cast<uint64_t>(reqs[i].scratch);
+                    sqe->len = static_cast<uint32_t>(reqs[i].len);
+                    sqe->user_data = i;
+                    sq_array_[idx] = idx;
+                    ++tail;
+                }
+                // release：内核看到新tail时sqe内容已写好
+                __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+                size_t submitted = 0;
+                size_t completed = 0;
+                while (completed < n)
+                {
+                    unsigned to_submit = static_cast<unsigned>(n - submitted);
+                    int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1,
+                                                         IORING_ENTER_GETEVENTS, nullptr, 0));
+                    if (ret < 0)
+                    {
+                        if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                        {
+                            continue;
+                        }
+                        // 未被内核取走的sqe退回tail，否则下一批提交时内核会执行这些指向本批scratch的旧请求。
+                        // 没有SQPOLL时内核只在io_uring_enter中读取sq tail，退回是安全的
+                        __atomic_store_n(sq_tail_, *sq_tail_ - static_cast<unsigned>(n - submitted),
+                                         __ATOMIC_RELEASE);
+                        // 提交失败的请求同步读
+                        for (size_t i = submitted; i < n; ++i)
+                        {
+                            reqs[i].result = FullPread(reqs[i].fd, reqs[i].scratch, reqs[i].len, reqs[i].offset);
+                        }
+                        n = submitted;
+                        if (completed >= n)
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+                    submitted += static_cast<size_t>(ret);
+
+                    unsigned head = *cq_head_;
+                    unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+                    while (head != cq_tail)
+                    {
+                        struct io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+                        reqs[cqe->user_data].result = cqe->res;
+                        ++completed;
+                        ++head;
+                    }
+                    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+                }
+            }
+
+            int ring_fd_ = -1;
+            void *sq_ring_ = nullptr;
+            void *cq_ring_ = nullptr;
+            size_t sq_ring_size_ = 0;
+            size_t cq_ring_size_ = 0;
+            size_t sqes_size_ = 0;
+            struct io_uring_sqe *sqes_ = nullptr;
+            struct io_uring_cqe *cqes_ = nullptr;
+            unsigned *sq_tail_ = nullptr;
+            unsigned *sq_array_ = nullptr;
+            unsigned *cq_head_ = nullptr;
+            unsigned *cq_tail_ = nullptr;
+            unsigned sq_mask_ = 0;
+            unsigned cq_mask_ = 0;
+            unsigned sq_entries_ = 0;
+        };
+#endif
+    }
+
+    std::unique_ptr<AsyncReader> NewAsyncReader(bool prefer_io_uring, int queue_depth)
+    {
+        queue_depth = queue_depth < 1 ? 1 : queue_depth;
+#ifdef __linux__
+        if (prefer_io_uring)
+        {
+            std::unique_ptr<IoUringReader> reader(new IoUringReader());
+            if (reader->Init(static_cast<unsigned>(queue_depth)))
+            {
+                return reader;
+            }
+        }
+#endif
+        return std::unique_ptr<AsyncReader>(new ThreadPoolReader(queue_depth));
+    }
+
+    void SyncMultiRead(ReadRequest *reqs, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            reqs[i].result = FullPread(reqs[i].fd, reqs[i].scratch, reqs[i].len, reqs[i].offset);
+        }
+    }
+}
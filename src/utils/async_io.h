@@ -0,0 +1,68 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 16:30:09
+ * @LastEditTime: 2026-10-24 09:20:41
+ * @FilePath: /miniKV/src/utils/async_io.h
+ * @Description: 批量异步读：io_uring后端与线程池pread后端
+ *
+ * ********************************
+ *  MultiRead一次提交一批随机读并等待全部完成，一批读的耗时约为一次I/O延迟，
+ *  而不是逐个pread的延迟之和。
+ *  io_uring后端直接使用linux/io_uring.h中的系统调用接口，不依赖liburing；
+ *  内核不支持或被禁用(例如seccomp)时NewAsyncReader自动退回线程池后端。
+ *  io_uring_enter提交失败时，未提交的请求改为同步pread，其sqe从ring中退回。
+ *  一个AsyncReader同一时刻只能被一个线程使用。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_ASYNC_IO_H
+#define MINIKVDB_ASYNC_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+
+namespace minikvdb
+{
+    struct ReadRequest
+    {
+        int fd = -1;
+        uint64_t offset = 0;
+        size_t len = 0;
+        char *scratch = nullptr; // 调用方提供，至少len字节
+        ssize_t result = 0;      // 读到的字节数，出错时为-errno
+    };
+
+    class AsyncReader
+    {
+    public:
+        virtual ~AsyncReader() = default;
+
+        /**
+         * @description:                    并行执行一批读请求，全部完成后返回
+         * @param {ReadRequest} *reqs       请求数组，结果写回各请求的result
+         * @param {size_t} n                请求数量
+         * @return {*}
+         */
+        virtual void MultiRead(ReadRequest *reqs, size_t n) = 0;
+
+        // "io_uring"或"thread_pool"
+        virtual const char *Name() const = 0;
+    };
+
+    /**
+     * @description:                    创建异步读后端
+     * @param {bool} prefer_io_uring    是否优先使用io_uring
+     * @param {int} queue_depth         io_uring的队列深度，或线程池的线程数
+     * @return {*}
+     */
+    std::unique_ptr<AsyncReader> NewAsyncReader(bool prefer_io_uring = true, int queue_depth = 64);
+
+    // 同步逐个pread，用作对照
+    void SyncMultiRead(ReadRequest *reqs, size_t n);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 10:02:11
+ * @LastEditTime: 2026-10-18 10:02:11
+ * @FilePath: /miniKV/src/utils/cpu_info.cc
+ * @Description: CPU指令集特性检测实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "cpu_info.h"
+
+namespace minikvdb
+{
+    static CpuFeatures DetectCpuFeatures()
+    {
+        CpuFeatures f;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        f.sse42 = __builtin_cpu_supports("sse4.2");
+        f.pclmul = __builtin_cpu_supports("pclmul");
+        f.avx2 = __builtin_cpu_supports("avx2");
+        f.avx512f = __builtin_cpu_supports("avx512f");
+        f.avx512bw = __builtin_cpu_supports("avx512bw");
+#endif
+        return f;
+    }
+
+    const CpuFeatures &GetCpuFeatures()
+    {
+        static const CpuFeatures features = DetectCpuFeatures();
+        return features;
+    }
+}
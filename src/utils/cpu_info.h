@@ -0,0 +1,33 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 10:02:11
+ * @LastEditTime: 2026-10-18 10:02:11
+ * @FilePath: /miniKV/src/utils/cpu_info.h
+ * @Description: CPU指令集特性检测
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_CPU_INFO_H
+#define MINIKVDB_CPU_INFO_H
+
+namespace minikvdb
+{
+    // 运行时检测到的CPU指令集特性
+    struct CpuFeatures
+    {
+        bool sse42 = false;    // crc32指令
+        bool pclmul = false;   // 无进位乘法
+        bool avx2 = false;     // 256位整数向量
+        bool avx512f = false;  // 512位基础指令
+        bool avx512bw = false; // 512位字节/字操作
+    };
+
+    /**
+     * @description:    获取当前CPU的指令集特性，首次调用时检测，结果全局缓存
+     * @return {*}      CpuFeatures
+     */
+    const CpuFeatures &GetCpuFeatures();
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 10:40:05
+ * @LastEditTime: 2026-10-18 13:20:41
+ * @FilePath: /miniKV/src/utils/crc32c.h
+ * @Description: CRC32C(Castagnoli)校验，用于WAL记录与数据块校验
+ *
+ * ********************************
+ *  接口借鉴于leveldb: https://github.com/google/leveldb/blob/main/util/crc32c.h
+ *  硬件三路交织实现参考Mark Adler的crc32c.c
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_CRC32C_H
+#define MINIKVDB_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minikvdb
+{
+    namespace crc32c
+    {
+        /**
+         * @description:                在init_crc基础上继续计算data[0, n)的crc32c
+         * @param {uint32_t} init_crc   之前数据的crc32c
+         * @param {char} *data          数据
+         * @param {size_t} n            数据长度
+         * @return {*}                  crc32c(A || data)，其中init_crc = crc32c(A)
+         */
+        uint32_t Extend(uint32_t init_crc, const char *data, size_t n);
+
+        // 计算data[0, n)的crc32c
+        inline uint32_t Value(const char *data, size_t n) { return Extend(0, data, n); }
+
+        // 纯软件(slicing-by-8)实现，仅供测试、基准对比使用
+        uint32_t ExtendPortable(uint32_t init_crc, const char *data, size_t n);
+
+        // 当前是否使用了SSE4.2硬件加速
+        bool IsHardwareAccelerated();
+
+        static const uint32_t kMaskDelta = 0xa282ead8ul;
+
+        /**
+         * @description:            对crc做掩码变换后再存储
+         *                          对内嵌crc的字符串再计算crc容易出问题，因此落盘的crc都需要先Mask
+         * @param {uint32_t} crc    原始crc
+         * @return {*}              掩码后的crc
+         */
+        inline uint32_t Mask(uint32_t crc)
+        {
+            // 循环右移15位后加上常量
+            return ((crc >> 15) | (crc << 17)) + kMaskDelta;
+        }
+
+        // Mask的逆变换
+        inline uint32_t Unmask(uint32_t masked_crc)
+        {
+            uint32_t rot = masked_crc - kMaskDelta;
+            return ((rot >> 17) | (rot << 15));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 19:12:45
+ * @LastEditTime: 2026-10-19 19:12:45
+ * @FilePath: /miniKV/src/utils/dynamic_bloom.cc
+ * @Description: 缓存行局部的布隆过滤器实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "dynamic_bloom.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace minikvdb
+{
+    DynamicBloom::DynamicBloom(size_t memory_bytes, int num_probes)
+        : num_lines_(memory_bytes == 0 ? 1 : (memory_bytes + kCacheLineBytes - 1) / kCacheLineBytes),
+          num_probes_(num_probes < 1 ? 1 : (num_probes > 16 ? 16 : num_probes)),
+          words_(new std::atomic<uint64_t>[num_lines_ * kWordsPerLine])
+    {
+        for (size_t i = 0; i < num_lines_ * kWordsPerLine; ++i)
+        {
+            words_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void DynamicBloom::AddHash(uint64_t hash)
+    {
+        std::atomic<uint64_t> *line = const_cast<std::atomic<uint64_t> *>(Line(hash));
+        uint32_t h = static_cast<uint32_t>(hash);
+        const uint32_t delta = (h >> 17) | (h << 15); // 双重哈希：第i次探测位置为h + i * delta
+        for (int i = 0; i < num_probes_; ++i, h += delta)
+        {
+            uint32_t bit = h & 511;
+            uint64_t mask = 1ULL << (bit & 63);
+            std::atomic<uint64_t> &word = line[bit >> 6];
+            // 已置位时跳过写，避免热点行上无谓的缓存行失效
+            if ((word.load(std::memory_order_relaxed) & mask) == 0)
+            {
+                word.fetch_or(mask, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool DynamicBloom::MayContainHash(uint64_t hash) const
+    {
+        const std::atomic<uint64_t> *line = Line(hash);
+        uint32_t h = static_cast<uint32_t>(hash);
+        bool found = true;
+        const uint32_t delta = (h >> 17) | (h << 15);
+        // 不提前退出：探测位都在同一缓存行内，无分支的版本更快
+        for (int i = 0; i < num_probes_; ++i, h += delta)
+        {
+            uint32_t bit = h & 511;
+            found &= (line[bit >> 6].load(std::memory_order_relaxed) >> (bit & 63)) & 1;
+        }
+        return found;
+    }
+
+    double DynamicBloom::EstimatedFpRate(uint64_t entries) const
+    {
+        double bits = static_cast<double>(num_lines_) * kCacheLineBytes * 8;
+        return std::pow(1.0 - std::exp(-num_probes_ * static_cast<double>(entries) / bits), num_probes_);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 19:12:45
+ * @LastEditTime: 2026-10-19 19:12:45
+ * @FilePath: /miniKV/src/utils/dynamic_bloom.h
+ * @Description: 缓存行局部的布隆过滤器，供MemTable在查找前快速排除不存在的key
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的DynamicBloom：每个key的全部探测位落在同一个64字节缓存行内，
+ *  一次查询最多访问一个缓存行。位数组按64位字原子更新，
+ *  Add可与多个MayContain并发，也可多个Add并发。
+ *  容量(内存预算)在构造时固定，数据量超出预算时误判率上升，但不会漏判。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_DYNAMIC_BLOOM_H
+#define MINIKVDB_DYNAMIC_BLOOM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace minikvdb
+{
+    class DynamicBloom
+    {
+    public:
+        /**
+         * @description:                    构造布隆过滤器
+         * @param {size_t} memory_bytes     内存预算，向上取整到64字节
+         * @param {int} num_probes          每个key设置的位数，取值[1, 16]
+         * @return {*}
+         */
+        explicit DynamicBloom(size_t memory_bytes, int num_probes = 6);
+
+        DynamicBloom(const DynamicBloom &) = delete;
+        DynamicBloom &operator=(const DynamicBloom &) = delete;
+
+        // 加入一个64位哈希值，调用方负责保证哈希分布均匀
+        void AddHash(uint64_t hash);
+
+        // false表示一定不存在，true表示可能存在
+        bool MayContainHash(uint64_t hash) const;
+
+        inline size_t GetMemUsage() const { return num_lines_ * kCacheLineBytes; }
+
+        inline int GetNumProbes() const { return num_probes_; }
+
+        /**
+         * @description:                按标准公式估计插入entries个key后的误判率
+         * @param {uint64_t} entries    已插入的key数量
+         * @return {*}
+         */
+        double EstimatedFpRate(uint64_t entries) const;
+
+    private:
+        static const size_t kCacheLineBytes = 64;
+        static const uint32_t kWordsPerLine = kCacheLineBytes / sizeof(uint64_t);
+
+        // 高32位选缓存行，低32位生成行内的探测位置
+        inline const std::atomic<uint64_t> *Line(uint64_t hash) const
+        {
+            return &words_[((hash >> 32) * num_lines_ >> 32) * kWordsPerLine];
+        }
+
+        size_t const num_lines_;
+        int const num_probes_;
+        std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    };
+}
+
+#endif
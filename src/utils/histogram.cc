@@ -0,0 +1,129 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 11:02:16
+ * @LastEditTime: 2026-10-19 11:02:16
+ * @FilePath: /miniKV/src/utils/histogram.cc
+ * @Description: HDR风格的延迟直方图实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "histogram.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace minikvdb
+{
+    void Histogram::Clear()
+    {
+        count_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+        memset(buckets_, 0, sizeof(buckets_));
+    }
+
+    int Histogram::BucketIndex(uint64_t value)
+    {
+        if (value < kLinearLimit)
+        {
+            return static_cast<int>(value);
+        }
+        // value位于[2^msb, 2^(msb+1))，保留最高的kSubBucketBits + 1位
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBucketBits;
+        uint64_t sub = (value >> shift) - kSubBuckets; // [0, 64)
+        return kLinearLimit + (shift - 1) * kSubBuckets + static_cast<int>(sub);
+    }
+
+    uint64_t Histogram::BucketUpperBound(int index)
+    {
+        if (index < kLinearLimit)
+        {
+            return static_cast<uint64_t>(index);
+        }
+        int shift = (index - kLinearLimit) / kSubBuckets + 1;
+        uint64_t sub = (index - kLinearLimit) % kSubBuckets + kSubBuckets;
+        // 桶覆盖[sub << shift, (sub + 1) << shift)
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void Histogram::Add(uint64_t value)
+    {
+        ++buckets_[BucketIndex(value)];
+        ++count_;
+        sum_ += value;
+        if (value < min_)
+        {
+            min_ = value;
+        }
+        if (value > max_)
+        {
+            max_ = value;
+        }
+    }
+
+    void Histogram::Merge(const Histogram &other)
+    {
+        for (int i = 0; i < kNumBuckets; ++i)
+        {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        if (other.min_ < min_)
+        {
+            min_ = other.min_;
+        }
+        if (other.max_ > max_)
+        {
+            max_ = other.max_;
+        }
+    }
+
+    uint64_t Histogram::Percentile(double p) const
+    {
+        if (count_ == 0)
+        {
+            return 0;
+        }
+        // 第rank个样本(从1开始)所在的桶
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+        if (rank < 1)
+        {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < kNumBuckets; ++i)
+        {
+            seen += buckets_[i];
+            if (seen >= rank)
+            {
+                uint64_t bound = BucketUpperBound(i);
+                if (bound > max_)
+                {
+                    bound = max_;
+                }
+                return bound < min_ ? min_ : bound;
+            }
+        }
+        return max_;
+    }
+
+    double Histogram::Average() const
+    {
+        return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+    }
+
+    std::string Histogram::ToString(double unit_div) const
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "count=%llu avg=%.2f p50=%.2f p99=%.2f p99.9=%.2f max=%.2f",
+                 static_cast<unsigned long long>(count_), Average() / unit_div,
+                 Percentile(50) / unit_div, Percentile(99) / unit_div,
+                 Percentile(99.9) / unit_div, Max() / unit_div);
+        return buf;
+    }
+}
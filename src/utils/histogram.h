@@ -0,0 +1,83 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 11:02:16
+ * @LastEditTime: 2026-10-19 11:02:16
+ * @FilePath: /miniKV/src/utils/histogram.h
+ * @Description: HDR风格的延迟直方图
+ *
+ * ********************************
+ *  对数-线性分桶：小于128的值每个值一个桶；更大的值按2的幂分段，
+ *  每段再线性切成64个子桶，相对误差不超过1/64，覆盖整个uint64范围，
+ *  内存占用固定(约30KB)。非线程安全，多线程时每个线程一个实例再Merge。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_HISTOGRAM_H
+#define MINIKVDB_HISTOGRAM_H
+
+#include <cstdint>
+#include <string>
+
+namespace minikvdb
+{
+    class Histogram
+    {
+    public:
+        Histogram() { Clear(); }
+
+        ~Histogram() = default;
+
+        void Clear();
+
+        /**
+         * @description:            记录一个样本
+         * @param {uint64_t} value  样本值(例如纳秒)
+         * @return {*}
+         */
+        void Add(uint64_t value);
+
+        // 合并另一个直方图的全部样本
+        void Merge(const Histogram &other);
+
+        /**
+         * @description:        百分位数
+         * @param {double} p    百分比，取值[0, 100]
+         * @return {*}          落在该百分位的样本值(桶上界，不超过最大值)
+         */
+        uint64_t Percentile(double p) const;
+
+        inline uint64_t Count() const { return count_; }
+
+        inline uint64_t Min() const { return count_ == 0 ? 0 : min_; }
+
+        inline uint64_t Max() const { return max_; }
+
+        double Average() const;
+
+        // 以unit为单位输出count/avg/p50/p99/p99.9/max，例如unit_div=1000把纳秒转成微秒
+        std::string ToString(double unit_div = 1.0) const;
+
+    private:
+        enum
+        {
+            kSubBucketBits = 6,                           // 每段64个子桶
+            kSubBuckets = 1 << kSubBucketBits,
+            kLinearLimit = 2 * kSubBuckets,               // 小于该值时精确计数
+            kNumBuckets = kLinearLimit + (64 - kSubBucketBits - 1) * kSubBuckets
+        };
+
+        static int BucketIndex(uint64_t value);
+
+        static uint64_t BucketUpperBound(int index);
+
+        uint64_t count_;
+        uint64_t sum_;
+        uint64_t min_;
+        uint64_t max_;
+        uint64_t buckets_[kNumBuckets];
+    };
+}
+
+#endif
@@ -1,7 +1,7 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-27 20:55:19
- * @LastEditTime: 2023-05-27 21:00:45
+ * @LastEditTime: 2026-10-18 16:10:27
  * @FilePath: /miniKV/src/utils/lock.h
  * @Description: 锁功能模块
  *
@@ -13,10 +13,56 @@
 
 #include <mutex>
 #include <atomic>
+#include <thread>
+#include <shared_mutex>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace minikvdb
 {
-    // 类似于lock_guard, T接受NullLock、MutexLock、SpinLock
+    static const int kCacheLineSize = 64;
+
+    // 自旋等待时的CPU提示：x86下为pause，降低功耗并避免退出循环时的流水线清空
+    inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+    // 指数退避：每次等待的pause次数翻倍，超过上限后让出CPU
+    class Backoff
+    {
+    public:
+        void Pause()
+        {
+            if (spins_ <= kMaxSpins)
+            {
+                for (uint32_t i = 0; i < spins_; ++i)
+                {
+                    CpuRelax();
+                }
+                spins_ <<= 1;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        void Reset() { spins_ = 1; }
+
+    private:
+        static const uint32_t kMaxSpins = 1024;
+        uint32_t spins_ = 1;
+    };
+
+    // 类似于lock_guard, T接受NullLock、MutexLock、SpinLock、TicketLock、RWLock、SharedMutexLock
     template <typename T>
     class ScopedLock
     {
@@ -55,6 +101,45 @@ namespace minikvdb
         bool is_locked = false;
     };
 
+    // 类似于shared_lock, 以共享(读)模式加锁，T接受NullLock、RWLock、SharedMutexLock
+    template <typename T>
+    class ScopedSharedLock
+    {
+    public:
+        explicit ScopedSharedLock(T &t) : local_lock(t)
+        {
+            local_lock.lock_shared();
+            is_locked = true;
+        }
+
+        ~ScopedSharedLock()
+        {
+            unlock();
+        }
+
+        void lock()
+        {
+            if (!is_locked)
+            {
+                local_lock.lock_shared();
+                is_locked = true;
+            }
+        }
+
+        void unlock()
+        {
+            if (is_locked)
+            {
+                local_lock.unlock_shared();
+                is_locked = false;
+            }
+        }
+
+    private:
+        T &local_lock;
+        bool is_locked = false;
+    };
+
     // 无锁
     class NullLock final
     {
@@ -66,6 +151,10 @@ namespace minikvdb
         void lock() {}
 
         void unlock() {}
+
+        void lock_shared() {}
+
+        void unlock_shared() {}
     };
 
     // 互斥锁
@@ -90,7 +179,28 @@ namespace minikvdb
         std::mutex _mutex;
     };
 
-    // 自旋锁
+    // 读写互斥锁，std::shared_mutex的简单封装
+    class SharedMutexLock final
+    {
+    public:
+        SharedMutexLock() = default;
+
+        ~SharedMutexLock() = default;
+
+        void lock() { _mutex.lock(); }
+
+        void unlock() { _mutex.unlock(); }
+
+        void lock_shared() { _mutex.lock_shared(); }
+
+        void unlock_shared() { _mutex.unlock_shared(); }
+
+    private:
+        std::shared_mutex _mutex;
+    };
+
+    // 自旋锁：test-and-test-and-set + pause + 指数退避
+    // 等待时只读本地缓存行，锁释放后才去争抢，避免test_and_set反复使缓存行失效
     class SpinLock final
     {
     public:
@@ -102,17 +212,163 @@ namespace minikvdb
 
         void lock()
         {
-            while (flag.test_and_set())
-                ;
+            Backoff backoff;
+            while (true)
+            {
+                if (!locked.exchange(true, std::memory_order_acquire))
+                {
+                    return;
+                }
+                while (locked.load(std::memory_order_relaxed))
+                {
+                    backoff.Pause();
+                }
+            }
+        }
+
+        bool try_lock()
+        {
+            return !locked.load(std::memory_order_relaxed) &&
+                   !locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<bool> locked{false};
+    };
+
+    // 票据锁：按申请顺序FIFO获得锁，避免自旋锁在高竞争下的饥饿
+    // 两个计数器分别独占一条缓存行，申请者的fetch_add不会干扰持有者对now_serving的更新
+    class TicketLock final
+    {
+    public:
+        TicketLock() = default;
+
+        TicketLock(const TicketLock &) = delete;
+
+        TicketLock &operator=(const TicketLock &) = delete;
+
+        void lock()
+        {
+            uint32_t ticket = next_ticket.fetch_add(1, std::memory_order_relaxed);
+            uint32_t rounds = 0;
+            while (true)
+            {
+                uint32_t serving = now_serving.load(std::memory_order_acquire);
+                if (serving == ticket)
+                {
+                    return;
+                }
+                // 排得太靠后或持有者迟迟不释放(可能已被调度出去)时让出CPU，
+                // 否则按排队位置成比例退避，排在越后面等得越久
+                uint32_t distance = ticket - serving;
+                if (distance > kYieldDistance || ++rounds > kMaxSpinRounds)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (uint32_t i = 0; i < distance * kPausePerWaiter; ++i)
+                {
+                    CpuRelax();
+                }
+            }
+        }
+
+        void unlock()
+        {
+            now_serving.store(now_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        static const uint32_t kPausePerWaiter = 16;
+        static const uint32_t kYieldDistance = 8;
+        static const uint32_t kMaxSpinRounds = 16;
+
+        alignas(kCacheLineSize) std::atomic<uint32_t> next_ticket{0};
+        alignas(kCacheLineSize) std::atomic<uint32_t> now_serving{0};
+    };
+
+    // 读多写少场景的读写锁
+    // 读者计数分散在kReaderSlots个独占缓存行的槽位上，每个线程固定使用一个槽位(近似per-core)，
+    // 读者之间不争抢同一缓存行；写者置位writer后等待所有槽位归零，写者优先
+    class RWLock final
+    {
+    public:
+        RWLock() = default;
+
+        RWLock(const RWLock &) = delete;
+
+        RWLock &operator=(const RWLock &) = delete;
+
+        void lock_shared()
+        {
+            std::atomic<int32_t> &readers = slots[ThreadSlot()].readers;
+            Backoff backoff;
+            while (true)
+            {
+                // 先登记再检查writer，与写者"先置writer再检查读者"构成Dekker式互斥，需要seq_cst
+                readers.fetch_add(1, std::memory_order_seq_cst);
+                if (!writer.load(std::memory_order_seq_cst))
+                {
+                    return;
+                }
+                readers.fetch_sub(1, std::memory_order_release);
+                while (writer.load(std::memory_order_relaxed))
+                {
+                    backoff.Pause();
+                }
+            }
+        }
+
+        void unlock_shared()
+        {
+            slots[ThreadSlot()].readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        void lock()
+        {
+            Backoff backoff;
+            while (writer.load(std::memory_order_relaxed) || writer.exchange(true, std::memory_order_seq_cst))
+            {
+                backoff.Pause();
+            }
+            backoff.Reset();
+            for (auto &slot : slots)
+            {
+                while (slot.readers.load(std::memory_order_seq_cst) != 0)
+                {
+                    backoff.Pause();
+                }
+            }
         }
 
         void unlock()
         {
-            flag.clear();
+            writer.store(false, std::memory_order_release);
         }
 
     private:
-        std::atomic_flag flag{0};
+        static const int kReaderSlots = 32;
+
+        struct alignas(kCacheLineSize) Slot
+        {
+            std::atomic<int32_t> readers{0};
+        };
+
+        // 线程首次使用时按轮转分配槽位，之后固定不变
+        static int ThreadSlot()
+        {
+            static std::atomic<uint32_t> next_slot{0};
+            thread_local int slot = static_cast<int>(next_slot.fetch_add(1, std::memory_order_relaxed) % kReaderSlots);
+            return slot;
+        }
+
+        alignas(kCacheLineSize) std::atomic<bool> writer{false};
+        Slot slots[kReaderSlots];
     };
 }
 
@@ -0,0 +1,95 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:12:40
+ * @LastEditTime: 2026-10-21 10:12:40
+ * @FilePath: /miniKV/src/utils/mmap_file.cc
+ * @Description: 只读内存映射文件实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "mmap_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace minikvdb
+{
+    MmapReadOnlyFile::~MmapReadOnlyFile()
+    {
+        Close();
+    }
+
+    bool MmapReadOnlyFile::Open(const std::string &path)
+    {
+        Close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size > 0)
+        {
+            // 映射建立后即可关闭fd，映射本身持有文件的引用
+            void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                ::close(fd);
+                return false;
+            }
+            data_ = static_cast<const char *>(addr);
+        }
+        ::close(fd);
+        size_ = size;
+        opened_ = true;
+        return true;
+    }
+
+    void MmapReadOnlyFile::Close()
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(const_cast<char *>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        opened_ = false;
+    }
+
+    bool MmapReadOnlyFile::Advise(AccessPattern pattern)
+    {
+        if (data_ == nullptr)
+        {
+            return false;
+        }
+        int advice = MADV_NORMAL;
+        switch (pattern)
+        {
+        case AccessPattern::kNormal:
+            advice = MADV_NORMAL;
+            break;
+        case AccessPattern::kRandom:
+            advice = MADV_RANDOM;
+            break;
+        case AccessPattern::kSequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case AccessPattern::kWillNeed:
+            advice = MADV_WILLNEED;
+            break;
+        case AccessPattern::kDontNeed:
+            advice = MADV_DONTNEED;
+            break;
+        }
+        return ::madvise(const_cast<char *>(data_), size_, advice) == 0;
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:12:40
+ * @LastEditTime: 2026-10-21 10:12:40
+ * @FilePath: /miniKV/src/utils/mmap_file.h
+ * @Description: 只读内存映射文件
+ *
+ * ********************************
+ *  整个文件一次性只读映射，读取时直接访问映射内存，按需缺页，无需read系统调用，
+ *  也不必先把文件完整读入用户态。供checkpoint等启动后立即服务读请求的场景使用。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_MMAP_FILE_H
+#define MINIKVDB_MMAP_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace minikvdb
+{
+    // 对映射区域的访问模式提示(madvise)
+    enum class AccessPattern
+    {
+        kNormal,
+        kRandom,     // 点查：关闭预读
+        kSequential, // 顺序扫描：加大预读
+        kWillNeed,   // 立即异步预读整个文件
+        kDontNeed,   // 不再使用：允许内核回收这些页
+    };
+
+    class MmapReadOnlyFile
+    {
+    public:
+        MmapReadOnlyFile() = default;
+
+        ~MmapReadOnlyFile();
+
+        MmapReadOnlyFile(const MmapReadOnlyFile &) = delete;
+        MmapReadOnlyFile &operator=(const MmapReadOnlyFile &) = delete;
+
+        /**
+         * @description:            映射整个文件
+         * @param {string} &path    文件路径
+         * @return {*}              是否成功，空文件也返回true(data()为空)
+         */
+        bool Open(const std::string &path);
+
+        void Close();
+
+        // 给内核的访问模式提示，失败不影响正确性
+        bool Advise(AccessPattern pattern);
+
+        inline const char *data() const { return data_; }
+
+        inline size_t size() const { return size_; }
+
+        inline bool IsOpen() const { return opened_; }
+
+    private:
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool opened_ = false;
+    };
+}
+
+#endif
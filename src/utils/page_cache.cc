@@ -0,0 +1,82 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/src/utils/page_cache.cc
+ * @Description: 页缓存驻留统计实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "page_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace minikvdb
+{
+    uint64_t PageSize()
+    {
+        static const uint64_t page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        return page_size;
+    }
+
+    bool GetPageCacheResidency(const std::string &path, PageCacheResidency *out)
+    {
+        *out = PageCacheResidency();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        if (size == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+
+        // 只映射不访问，不会把页读入页缓存
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return false;
+        }
+        uint64_t pages = (size + PageSize() - 1) / PageSize();
+        std::vector<unsigned char> vec(pages);
+        bool ok = ::mincore(addr, size, vec.data()) == 0;
+        ::munmap(addr, size);
+        if (!ok)
+        {
+            return false;
+        }
+        out->total_pages = pages;
+        for (unsigned char v : vec)
+        {
+            out->resident_pages += v & 1;
+        }
+        return true;
+    }
+
+    bool DropPageCache(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        ::close(fd);
+        return ok;
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/src/utils/page_cache.h
+ * @Description: 页缓存驻留统计
+ *
+ * ********************************
+ *  通过mmap + mincore查询文件有多少页驻留在页缓存中。对前台读的数据文件而言，
+ *  驻留比例就是随机读命中页缓存的概率，可用来对比开启/关闭direct I/O时
+ *  flush与compaction对页缓存的污染程度。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_PAGE_CACHE_H
+#define MINIKVDB_PAGE_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+namespace minikvdb
+{
+    struct PageCacheResidency
+    {
+        uint64_t total_pages = 0;
+        uint64_t resident_pages = 0;
+
+        inline double HitRate() const
+        {
+            return total_pages == 0 ? 0.0 : static_cast<double>(resident_pages) / total_pages;
+        }
+    };
+
+    /**
+     * @description:                        统计文件驻留在页缓存中的页数
+     * @param {string} &path                文件路径
+     * @param {PageCacheResidency} *out     输出
+     * @return {*}                          是否成功，空文件也返回true
+     */
+    bool GetPageCacheResidency(const std::string &path, PageCacheResidency *out);
+
+    // 提示内核丢弃整个文件的页缓存(只对干净页生效)
+    bool DropPageCache(const std::string &path);
+
+    // 系统页大小
+    uint64_t PageSize();
+}
+
+#endif
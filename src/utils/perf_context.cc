@@ -0,0 +1,72 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 15:40:17
+ * @LastEditTime: 2026-10-19 15:40:17
+ * @FilePath: /miniKV/src/utils/perf_context.cc
+ * @Description: 线程局部的单次操作性能剖析实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "perf_context.h"
+
+#include <cstdio>
+
+namespace minikvdb
+{
+    thread_local PerfLevel perf_level = PerfLevel::kDisable;
+    thread_local PerfContext perf_context = {};
+
+// 遍历全部字段，新增字段时只需在这里追加
+#define PERF_CONTEXT_FIELDS(X)     \
+    X(user_key_comparison_count)   \
+    X(get_count)                   \
+    X(get_cycles)                  \
+    X(get_search_cycles)           \
+    X(put_count)                   \
+    X(put_cycles)                  \
+    X(put_search_cycles)           \
+    X(put_alloc_cycles)            \
+    X(put_link_cycles)             \
+    X(bloom_memtable_hit_count)    \
+    X(bloom_memtable_miss_count)
+
+    void PerfContext::Reset()
+    {
+#define PERF_CONTEXT_RESET(name) name = 0;
+        PERF_CONTEXT_FIELDS(PERF_CONTEXT_RESET)
+#undef PERF_CONTEXT_RESET
+    }
+
+    std::string PerfContext::ToString(bool exclude_zero) const
+    {
+        std::string out;
+        char buf[128];
+#define PERF_CONTEXT_OUTPUT(name)                                                        \
+    if (!exclude_zero || name > 0)                                                       \
+    {                                                                                    \
+        snprintf(buf, sizeof(buf), "%s%s = %llu", out.empty() ? "" : ", ", #name,        \
+                 static_cast<unsigned long long>(name));                                 \
+        out.append(buf);                                                                 \
+    }
+        PERF_CONTEXT_FIELDS(PERF_CONTEXT_OUTPUT)
+#undef PERF_CONTEXT_OUTPUT
+        return out;
+    }
+
+    std::string PerfContext::ToJson() const
+    {
+        std::string out = "{";
+        char buf[128];
+#define PERF_CONTEXT_JSON(name)                                                          \
+    snprintf(buf, sizeof(buf), "%s\"%s\":%llu", out.size() == 1 ? "" : ",", #name,       \
+             static_cast<unsigned long long>(name));                                     \
+    out.append(buf);
+        PERF_CONTEXT_FIELDS(PERF_CONTEXT_JSON)
+#undef PERF_CONTEXT_JSON
+        out.append("}");
+        return out;
+    }
+
+#undef PERF_CONTEXT_FIELDS
+}
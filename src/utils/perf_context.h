@@ -0,0 +1,139 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 15:40:17
+ * @LastEditTime: 2026-10-19 15:40:17
+ * @FilePath: /miniKV/src/utils/perf_context.h
+ * @Description: 线程局部的单次操作性能剖析(perf context)
+ *
+ * ********************************
+ *  记录当前线程上Get/Put各阶段的耗时(CPU周期，x86下为rdtsc)与计数。
+ *  默认关闭(kDisable)，关闭时每个埋点只有一次线程局部变量读取和比较；
+ *  kEnableCount只统计次数，kEnableTime额外统计各阶段耗时。
+ *  用法：
+ *      SetPerfLevel(PerfLevel::kEnableTime);
+ *      GetPerfContext()->Reset();
+ *      table.Get(key);
+ *      printf("%s", GetPerfContext()->ToString(true).c_str());
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_PERF_CONTEXT_H
+#define MINIKVDB_PERF_CONTEXT_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace minikvdb
+{
+    enum class PerfLevel : int
+    {
+        kDisable = 0,     // 不统计
+        kEnableCount = 1, // 只统计次数
+        kEnableTime = 2,  // 统计次数与各阶段耗时
+    };
+
+    struct PerfContext
+    {
+        uint64_t user_key_comparison_count; // key比较次数
+
+        uint64_t get_count;         // Get次数
+        uint64_t get_cycles;        // Get总耗时
+        uint64_t get_search_cycles; // Get在跳表中查找的耗时
+
+        uint64_t put_count;         // Put次数
+        uint64_t put_cycles;        // Put总耗时
+        uint64_t put_search_cycles; // Put查重与定位插入位置的耗时
+        uint64_t put_alloc_cycles;  // Put分配新结点的耗时
+        uint64_t put_link_cycles;   // Put链接新结点的耗时
+
+        uint64_t bloom_memtable_hit_count;  // memtable布隆过滤器判定可能存在
+        uint64_t bloom_memtable_miss_count; // memtable布隆过滤器判定不存在
+
+        void Reset();
+
+        // 每项"name = value"，以", "分隔
+        std::string ToString(bool exclude_zero = false) const;
+
+        std::string ToJson() const;
+    };
+
+    extern thread_local PerfLevel perf_level;
+    extern thread_local PerfContext perf_context;
+
+    inline void SetPerfLevel(PerfLevel level) { perf_level = level; }
+
+    inline PerfLevel GetPerfLevel() { return perf_level; }
+
+    inline PerfContext *GetPerfContext() { return &perf_context; }
+
+    // 读取CPU周期计数器，非x86平台退化为纳秒时钟
+    inline uint64_t ReadCycleCounter()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    // 计时器：PerfLevel为kEnableTime时把Start到Stop(或析构)之间的周期数累加到metric
+    class PerfStepTimer
+    {
+    public:
+        explicit PerfStepTimer(uint64_t *metric)
+            : metric_(GetPerfLevel() >= PerfLevel::kEnableTime ? metric : nullptr), start_(0)
+        {
+        }
+
+        ~PerfStepTimer() { Stop(); }
+
+        void Start()
+        {
+            if (metric_ != nullptr)
+            {
+                start_ = ReadCycleCounter();
+            }
+        }
+
+        void Stop()
+        {
+            if (start_ != 0)
+            {
+                *metric_ += ReadCycleCounter() - start_;
+                start_ = 0;
+            }
+        }
+
+    private:
+        uint64_t *const metric_;
+        uint64_t start_;
+    };
+}
+
+// 从当前位置计时到作用域结束
+#define PERF_TIMER_GUARD(metric)                                                      \
+    ::minikvdb::PerfStepTimer perf_step_timer_##metric(&::minikvdb::perf_context.metric); \
+    perf_step_timer_##metric.Start()
+
+// 提前结束PERF_TIMER_GUARD的计时
+#define PERF_TIMER_STOP(metric) perf_step_timer_##metric.Stop()
+
+#define PERF_COUNTER_ADD(metric, value)                                      \
+    do                                                                       \
+    {                                                                        \
+        if (::minikvdb::perf_level >= ::minikvdb::PerfLevel::kEnableCount)  \
+        {                                                                    \
+            ::minikvdb::perf_context.metric += (value);                      \
+        }                                                                    \
+    } while (0)
+
+#endif
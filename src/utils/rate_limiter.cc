@@ -0,0 +1,151 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 14:05:12
+ * @LastEditTime: 2026-10-23 16:40:18
+ * @FilePath: /miniKV/src/utils/rate_limiter.cc
+ * @Description: 后台写入的令牌桶限速器实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace minikvdb
+{
+    RateLimiter::RateLimiter(int64_t bytes_per_second, int64_t refill_period_us, int32_t fairness, bool auto_tuned)
+        : refill_period_us_(refill_period_us < 1 ? 1 : refill_period_us),
+          fairness_(fairness < 1 ? 1 : fairness),
+          auto_tuned_(auto_tuned),
+          max_bytes_per_second_(bytes_per_second)
+    {
+        // auto_tuned从最低速率起步，随欠账上调
+        SetRateLocked(auto_tuned_ ? bytes_per_second / 20 : bytes_per_second);
+        available_bytes_ = refill_bytes_per_period_;
+        next_refill_us_ = NowMicros() + refill_period_us_;
+    }
+
+    int64_t RateLimiter::NowMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void RateLimiter::SetRateLocked(int64_t bytes_per_second)
+    {
+        bytes_per_second_ = std::max<int64_t>(1, bytes_per_second);
+        refill_bytes_per_period_ = std::max<int64_t>(1, bytes_per_second_ * refill_period_us_ / 1000000);
+    }
+
+    void RateLimiter::SetBytesPerSecond(int64_t bytes_per_second)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        SetRateLocked(bytes_per_second);
+    }
+
+    int64_t RateLimiter::GetBytesPerSecond()
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return bytes_per_second_;
+    }
+
+    int64_t RateLimiter::GetSingleBurstBytes()
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return refill_bytes_per_period_;
+    }
+
+    void RateLimiter::SetPendingDebt(uint64_t debt_bytes, uint64_t debt_limit)
+    {
+        if (!auto_tuned_)
+        {
+            return;
+        }
+        double ratio = debt_limit == 0 ? 1.0 : std::min(1.0, static_cast<double>(debt_bytes) / debt_limit);
+        int64_t min_rate = max_bytes_per_second_ / 20;
+        std::lock_guard<std::mutex> guard(mu_);
+        SetRateLocked(min_rate + static_cast<int64_t>((max_bytes_per_second_ - min_rate) * ratio));
+    }
+
+    int64_t RateLimiter::GetTotalBytesThrough(Priority pri)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return total_bytes_[static_cast<int>(pri)];
+    }
+
+    int64_t RateLimiter::GetTotalRequests(Priority pri)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return total_requests_[static_cast<int>(pri)];
+    }
+
+    void RateLimiter::Request(int64_t bytes, Priority pri)
+    {
+        while (bytes > 0)
+        {
+            int64_t chunk = std::min(bytes, GetSingleBurstBytes());
+            RequestChunk(chunk, pri);
+            bytes -= chunk;
+        }
+    }
+
+    void RateLimiter::RequestChunk(int64_t bytes, Priority pri)
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        int p = static_cast<int>(pri);
+        ++total_requests_[p];
+        total_bytes_[p] += bytes;
+
+        // 没有排队者且令牌足够时直接通过
+        if (queue_[0].empty() && queue_[1].empty() && available_bytes_ >= bytes)
+        {
+            available_bytes_ -= bytes;
+            return;
+        }
+
+        Req req{bytes};
+        queue_[p].push_back(&req);
+        while (!req.granted)
+        {
+            int64_t now = NowMicros();
+            if (now >= next_refill_us_)
+            {
+                // 任何到期的等待者都可以负责补充，补充后唤醒其他等待者检查自己是否已获得令牌
+                RefillAndGrant(now);
+                cv_.notify_all();
+                continue;
+            }
+            cv_.wait_for(lock, std::chrono::microseconds(next_refill_us_ - now));
+        }
+    }
+
+    void RateLimiter::RefillAndGrant(int64_t now_us)
+    {
+        next_refill_us_ = now_us + refill_period_us_;
+        // 空闲期间不累积令牌，避免空闲后出现大突发；余额可能为负(见下)
+        available_bytes_ = std::min(available_bytes_ + refill_bytes_per_period_, refill_bytes_per_period_);
+
+        int first = (++refill_count_ % fairness_ == 0) ? static_cast<int>(Priority::kLow)
+                                                        : static_cast<int>(Priority::kHigh);
+        for (int p : {first, 1 - first})
+        {
+            std::deque<Req *> &queue = queue_[p];
+            while (!queue.empty())
+            {
+                Req *req = queue.front();
+                // 入队后速率被调低时请求可能超过一个周期的令牌，桶满时也要放行，否则会永远阻塞所有等待者
+                if (req->bytes > available_bytes_ && available_bytes_ < refill_bytes_per_period_)
+                {
+                    // 队头无法满足时停止发放，保证先来先得，也不让低优先级插队
+                    return;
+                }
+                available_bytes_ -= req->bytes;
+                req->granted = true;
+                queue.pop_front();
+            }
+        }
+    }
+}
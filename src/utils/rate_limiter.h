@@ -0,0 +1,105 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 14:05:12
+ * @LastEditTime: 2026-10-23 16:40:18
+ * @FilePath: /miniKV/src/utils/rate_limiter.h
+ * @Description: 后台写入的令牌桶限速器
+ *
+ * ********************************
+ *  思路借鉴于rocksdb的GenericRateLimiter：每个refill周期补充rate * period的令牌，
+ *  请求按优先级排队，高优先级(flush、WAL)先于低优先级(compaction)获得令牌；
+ *  每fairness次补充中有一次让低优先级先取，避免低优先级饿死。
+ *  请求按入队时的单次上限拆分，之后调低速率会使排队中的请求大于新的上限：
+ *  桶满时仍放行这样的队头请求，令牌余额变为负数，由之后的补充偿还。
+ *  auto_tuned模式下，速率在[max / 20, max]之间随待合并数据量(compaction debt)线性调整：
+ *  欠账越多越接近最大速率，欠账少时把带宽让给前台读。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_RATE_LIMITER_H
+#define MINIKVDB_RATE_LIMITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include "thread_pool.h"
+
+namespace minikvdb
+{
+    class RateLimiter
+    {
+    public:
+        /**
+         * @description:                        构造限速器
+         * @param {int64_t} bytes_per_second    速率；auto_tuned时为速率上限
+         * @param {int64_t} refill_period_us    令牌补充周期，单次请求最多取一个周期的令牌
+         * @param {int32_t} fairness            每fairness次补充让低优先级先取一次
+         * @param {bool} auto_tuned             是否按compaction欠账自动调整速率
+         * @return {*}
+         */
+        explicit RateLimiter(int64_t bytes_per_second, int64_t refill_period_us = 100 * 1000,
+                             int32_t fairness = 10, bool auto_tuned = false);
+
+        RateLimiter(const RateLimiter &) = delete;
+        RateLimiter &operator=(const RateLimiter &) = delete;
+
+        // 阻塞直到获得bytes个令牌，超过单次上限的请求拆分为多次
+        void Request(int64_t bytes, Priority pri);
+
+        void SetBytesPerSecond(int64_t bytes_per_second);
+
+        int64_t GetBytesPerSecond();
+
+        // 单次请求可获得的最大令牌数
+        int64_t GetSingleBurstBytes();
+
+        /**
+         * @description:                    auto_tuned模式下根据欠账调整速率，非auto_tuned时忽略
+         * @param {uint64_t} debt_bytes     待合并的数据量
+         * @param {uint64_t} debt_limit     欠账达到该值时使用最大速率
+         * @return {*}
+         */
+        void SetPendingDebt(uint64_t debt_bytes, uint64_t debt_limit);
+
+        int64_t GetTotalBytesThrough(Priority pri);
+
+        int64_t GetTotalRequests(Priority pri);
+
+    private:
+        struct Req
+        {
+            int64_t bytes;
+            bool granted = false;
+        };
+
+        void RequestChunk(int64_t bytes, Priority pri);
+
+        // 补充令牌并按优先级发放，调用时需持有mu_
+        void RefillAndGrant(int64_t now_us);
+
+        void SetRateLocked(int64_t bytes_per_second);
+
+        static int64_t NowMicros();
+
+        std::mutex mu_;
+        std::condition_variable cv_;
+        int64_t const refill_period_us_;
+        int32_t const fairness_;
+        bool const auto_tuned_;
+        int64_t const max_bytes_per_second_;
+        int64_t bytes_per_second_;
+        int64_t refill_bytes_per_period_;
+        int64_t available_bytes_ = 0;
+        int64_t next_refill_us_;
+        uint64_t refill_count_ = 0;
+        std::deque<Req *> queue_[2];
+        int64_t total_bytes_[2] = {0, 0};
+        int64_t total_requests_[2] = {0, 0};
+    };
+}
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/src/utils/sequential_file.cc
+ * @Description: 顺序读文件实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "sequential_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace minikvdb
+{
+    namespace
+    {
+        // 每积累这么多已读字节才调用一次fadvise，避免每次Read都陷入内核
+        constexpr uint64_t kDropCacheBytes = 1 << 20;
+    }
+
+    SequentialFile::SequentialFile(bool use_direct_io, bool drop_cache_behind, size_t readahead_size)
+        : use_direct_io_(use_direct_io), drop_cache_behind_(drop_cache_behind),
+          readahead_size_(AlignUp(std::max<size_t>(readahead_size, 1), kDefaultIOAlignment))
+    {
+    }
+
+    SequentialFile::~SequentialFile()
+    {
+        Close();
+        if (abuf_ != nullptr)
+        {
+            if (pool_ != nullptr)
+            {
+                pool_->Release(abuf_);
+            }
+            else
+            {
+                alloc_.Deallocate(abuf_, static_cast<int32_t>(readahead_size_));
+            }
+        }
+    }
+
+    bool SequentialFile::Open(const std::string &path)
+    {
+        Close();
+        offset_ = 0;
+        dropped_ = 0;
+        abuf_len_ = 0;
+        abuf_offset_ = 0;
+        direct_ = false;
+        if (use_direct_io_)
+        {
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+            direct_ = fd_ >= 0;
+            if (fd_ < 0 && errno != EINVAL)
+            {
+                return false;
+            }
+        }
+        if (fd_ < 0)
+        {
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd_ < 0)
+            {
+                return false;
+            }
+            drop_cache_behind_ = drop_cache_behind_ || use_direct_io_;
+            ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        if (direct_ && abuf_ == nullptr)
+        {
+            AlignedBufferPool *shared = AlignedBufferPool::get_instance();
+            if (shared->GetBufferSize() == readahead_size_)
+            {
+                pool_ = shared;
+                abuf_ = pool_->Acquire();
+            }
+            else
+            {
+                abuf_ = static_cast<char *>(alloc_.Allocate(static_cast<int32_t>(readahead_size_)));
+            }
+        }
+        return true;
+    }
+
+    ssize_t SequentialFile::Read(char *scratch, size_t n)
+    {
+        if (fd_ < 0)
+        {
+            return -EBADF;
+        }
+        if (direct_)
+        {
+            return ReadDirect(scratch, n);
+        }
+        size_t done = 0;
+        while (done < n)
+        {
+            ssize_t r = ::read(fd_, scratch + done, n - done);
+            if (r < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return -errno;
+            }
+            if (r == 0)
+            {
+                break;
+            }
+            done += static_cast<size_t>(r);
+        }
+        offset_ += done;
+        DropCacheBehind();
+        return static_cast<ssize_t>(done);
+    }
+
+    ssize_t SequentialFile::ReadDirect(char *scratch, size_t n)
+    {
+        size_t done = 0;
+        while (done < n)
+        {
+            if (offset_ >= abuf_offset_ + abuf_len_)
+            {
+                // 缓冲区已读完，从offset_所在的页开始读入下一块
+                abuf_offset_ = AlignDown(offset_, kDefaultIOAlignment);
+                abuf_len_ = 0;
+                ssize_t r;
+                do
+                {
+                    r = ::pread(fd_, abuf_, readahead_size_, static_cast<off_t>(abuf_offset_));
+                } while (r < 0 && errno == EINTR);
+                if (r < 0)
+                {
+                    return done > 0 ? static_cast<ssize_t>(done) : -errno;
+                }
+                abuf_len_ = static_cast<size_t>(r);
+                if (offset_ >= abuf_offset_ + abuf_len_)
+                {
+                    break; // EOF
+                }
+            }
+            size_t pos = static_cast<size_t>(offset_ - abuf_offset_);
+            size_t copy = std::min(n - done, abuf_len_ - pos);
+            memcpy(scratch + done, abuf_ + pos, copy);
+            done += copy;
+            offset_ += copy;
+        }
+        return static_cast<ssize_t>(done);
+    }
+
+    bool SequentialFile::Skip(uint64_t n)
+    {
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        offset_ += n;
+        if (!direct_)
+        {
+            if (::lseek(fd_, static_cast<off_t>(offset_), SEEK_SET) < 0)
+            {
+                return false;
+            }
+            DropCacheBehind();
+        }
+        return true;
+    }
+
+    void SequentialFile::Close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    void SequentialFile::DropCacheBehind()
+    {
+        if (!drop_cache_behind_ || offset_ - dropped_ < kDropCacheBytes)
+        {
+            return;
+        }
+        uint64_t end = AlignDown(offset_, kDefaultIOAlignment);
+        ::posix_fadvise(fd_, static_cast<off_t>(dropped_), static_cast<off_t>(end - dropped_), POSIX_FADV_DONTNEED);
+        dropped_ = end;
+    }
+}
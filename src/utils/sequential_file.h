@@ -0,0 +1,94 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 19:05:12
+ * @LastEditTime: 2026-10-20 19:05:12
+ * @FilePath: /miniKV/src/utils/sequential_file.h
+ * @Description: 顺序读文件，供compaction读取输入文件、WAL回放使用
+ *
+ * ********************************
+ *  普通模式下打开时用posix_fadvise(SEQUENTIAL)提示内核加大预读，
+ *  可选drop_cache_behind：已读过的部分用posix_fadvise(DONTNEED)丢弃，
+ *  compaction输入读完即被删除，没有必要留在页缓存中挤占前台读的热数据。
+ *  use_direct_io时以O_DIRECT打开，按页对齐的块读入对齐缓冲区再拷贝给调用方；
+ *  文件系统不支持O_DIRECT时退回普通模式并自动开启drop_cache_behind。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_SEQUENTIAL_FILE_H
+#define MINIKVDB_SEQUENTIAL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+#include "../memory/aligned_alloc.h"
+
+namespace minikvdb
+{
+    class SequentialFile
+    {
+    public:
+        /**
+         * @description:                        构造顺序读文件对象
+         * @param {bool} use_direct_io          是否绕过页缓存(O_DIRECT)
+         * @param {bool} drop_cache_behind      普通模式下是否丢弃已读部分的页缓存
+         * @param {size_t} readahead_size       direct I/O时每次读入的块大小，向上取整到页大小
+         * @return {*}
+         */
+        explicit SequentialFile(bool use_direct_io = false, bool drop_cache_behind = false,
+                                size_t readahead_size = 64 * 1024);
+
+        ~SequentialFile();
+
+        SequentialFile(const SequentialFile &) = delete;
+        SequentialFile &operator=(const SequentialFile &) = delete;
+
+        bool Open(const std::string &path);
+
+        /**
+         * @description:                读取至多n字节
+         * @param {char} *scratch       输出缓冲区，至少n字节
+         * @param {size_t} n            期望读取的字节数
+         * @return {*}                  实际读取的字节数，0表示EOF，出错返回-errno
+         */
+        ssize_t Read(char *scratch, size_t n);
+
+        // 跳过n字节
+        bool Skip(uint64_t n);
+
+        void Close();
+
+        inline bool IsOpen() const { return fd_ >= 0; }
+
+        // 当前打开的文件是否真正以O_DIRECT读取
+        inline bool IsDirectIO() const { return fd_ >= 0 && direct_; }
+
+        // 下一次Read开始的文件偏移
+        inline uint64_t GetOffset() const { return offset_; }
+
+    private:
+        ssize_t ReadDirect(char *scratch, size_t n);
+
+        void DropCacheBehind();
+
+        bool const use_direct_io_;
+        bool drop_cache_behind_;
+        size_t const readahead_size_;
+        int fd_ = -1;
+        bool direct_ = false;
+        uint64_t offset_ = 0;
+        uint64_t dropped_ = 0; // 已丢弃页缓存的位置
+
+        // direct I/O状态：abuf_中保存文件[abuf_offset_, abuf_offset_ + abuf_len_)
+        char *abuf_ = nullptr;
+        size_t abuf_len_ = 0;
+        uint64_t abuf_offset_ = 0;
+        AlignedBufferPool *pool_ = nullptr;
+        AlignedAlloc alloc_;
+    };
+}
+
+#endif
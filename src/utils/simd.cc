@@ -0,0 +1,313 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 10:15:40
+ * @LastEditTime: 2026-10-18 10:15:40
+ * @FilePath: /miniKV/src/utils/simd.cc
+ * @Description: 运行时分派的SIMD热点函数实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "simd.h"
+#include "cpu_info.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINIKVDB_X86 1
+#endif
+
+namespace minikvdb
+{
+    namespace simd
+    {
+        /*================================================================
+        *  各指令集的通用实现模板
+        *  模板本身不带target属性，内联进带target属性的包装函数后，
+        *  由编译器针对对应指令集进行向量化
+        ================================================================*/
+
+        template <typename T>
+        static inline size_t FilterRangeLoop(const T *col, size_t n, T lo, T hi, uint8_t *sel)
+        {
+            size_t hits = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint8_t m = static_cast<uint8_t>((col[i] >= lo) & (col[i] <= hi));
+                sel[i] = m;
+                hits += m;
+            }
+            return hits;
+        }
+
+        static inline size_t MismatchTail(const uint8_t *a, const uint8_t *b, size_t i, size_t n)
+        {
+            for (; i < n; ++i)
+            {
+                if (a[i] != b[i])
+                {
+                    return i;
+                }
+            }
+            return n;
+        }
+
+        /*================================================================
+        *  scalar
+        ================================================================*/
+
+        static size_t MismatchScalar(const void *a, const void *b, size_t n)
+        {
+            auto pa = static_cast<const uint8_t *>(a);
+            auto pb = static_cast<const uint8_t *>(b);
+            size_t i = 0;
+            // 按8字节比较，找到不同的字后再定位具体字节
+            for (; i + 8 <= n; i += 8)
+            {
+                uint64_t x, y;
+                memcpy(&x, pa + i, 8);
+                memcpy(&y, pb + i, 8);
+                if (x != y)
+                {
+                    return MismatchTail(pa, pb, i, i + 8);
+                }
+            }
+            return MismatchTail(pa, pb, i, n);
+        }
+
+        static size_t FilterRangeI64Scalar(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        static size_t FilterRangeF64Scalar(const double *col, size_t n, double lo, double hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+#ifdef MINIKVDB_X86
+        /*================================================================
+        *  SSE4.2
+        ================================================================*/
+
+        __attribute__((target("sse4.2"))) static size_t MismatchSSE42(const void *a, const void *b, size_t n)
+        {
+            auto pa = static_cast<const uint8_t *>(a);
+            auto pb = static_cast<const uint8_t *>(b);
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pa + i));
+                __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pb + i));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+                if (mask != 0xFFFFu)
+                {
+                    return i + __builtin_ctz(~mask);
+                }
+            }
+            return MismatchTail(pa, pb, i, n);
+        }
+
+        __attribute__((target("sse4.2"))) static size_t FilterRangeI64SSE42(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        __attribute__((target("sse4.2"))) static size_t FilterRangeF64SSE42(const double *col, size_t n, double lo, double hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        /*================================================================
+        *  AVX2
+        ================================================================*/
+
+        __attribute__((target("avx2"))) static size_t MismatchAVX2(const void *a, const void *b, size_t n)
+        {
+            auto pa = static_cast<const uint8_t *>(a);
+            auto pb = static_cast<const uint8_t *>(b);
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb + i));
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+                if (mask != 0xFFFFFFFFu)
+                {
+                    return i + __builtin_ctz(~mask);
+                }
+            }
+            return MismatchTail(pa, pb, i, n);
+        }
+
+        __attribute__((target("avx2"))) static size_t FilterRangeI64AVX2(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        __attribute__((target("avx2"))) static size_t FilterRangeF64AVX2(const double *col, size_t n, double lo, double hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        /*================================================================
+        *  AVX-512 (F + BW)
+        ================================================================*/
+
+        __attribute__((target("avx512f,avx512bw"))) static size_t MismatchAVX512(const void *a, const void *b, size_t n)
+        {
+            auto pa = static_cast<const uint8_t *>(a);
+            auto pb = static_cast<const uint8_t *>(b);
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64)
+            {
+                __m512i x = _mm512_loadu_si512(pa + i);
+                __m512i y = _mm512_loadu_si512(pb + i);
+                __mmask64 ne = _mm512_cmpneq_epi8_mask(x, y);
+                if (ne != 0)
+                {
+                    return i + __builtin_ctzll(ne);
+                }
+            }
+            if (i < n)
+            {
+                // 尾部用掩码加载，避免越界读
+                __mmask64 live = (1ULL << (n - i)) - 1; // 此处n - i < 64
+                __m512i x = _mm512_maskz_loadu_epi8(live, pa + i);
+                __m512i y = _mm512_maskz_loadu_epi8(live, pb + i);
+                __mmask64 ne = _mm512_mask_cmpneq_epi8_mask(live, x, y);
+                if (ne != 0)
+                {
+                    return i + __builtin_ctzll(ne);
+                }
+            }
+            return n;
+        }
+
+        __attribute__((target("avx512f,avx512bw"))) static size_t FilterRangeI64AVX512(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+
+        __attribute__((target("avx512f,avx512bw"))) static size_t FilterRangeF64AVX512(const double *col, size_t n, double lo, double hi, uint8_t *sel)
+        {
+            return FilterRangeLoop(col, n, lo, hi, sel);
+        }
+#endif
+
+        /*================================================================
+        *  分派表
+        ================================================================*/
+
+        struct Kernels
+        {
+            IsaLevel level;
+            size_t (*mismatch)(const void *, const void *, size_t);
+            size_t (*filter_i64)(const int64_t *, size_t, int64_t, int64_t, uint8_t *);
+            size_t (*filter_f64)(const double *, size_t, double, double, uint8_t *);
+        };
+
+        static Kernels SelectKernels(IsaLevel level)
+        {
+            switch (level)
+            {
+#ifdef MINIKVDB_X86
+            case IsaLevel::kAVX512:
+                return {level, MismatchAVX512, FilterRangeI64AVX512, FilterRangeF64AVX512};
+            case IsaLevel::kAVX2:
+                return {level, MismatchAVX2, FilterRangeI64AVX2, FilterRangeF64AVX2};
+            case IsaLevel::kSSE42:
+                return {level, MismatchSSE42, FilterRangeI64SSE42, FilterRangeF64SSE42};
+#endif
+            default:
+                return {IsaLevel::kScalar, MismatchScalar, FilterRangeI64Scalar, FilterRangeF64Scalar};
+            }
+        }
+
+        static Kernels &Table()
+        {
+            static Kernels kernels = SelectKernels(BestIsa());
+            return kernels;
+        }
+
+        IsaLevel BestIsa()
+        {
+            const CpuFeatures &f = GetCpuFeatures();
+            if (f.avx512f && f.avx512bw)
+            {
+                return IsaLevel::kAVX512;
+            }
+            if (f.avx2)
+            {
+                return IsaLevel::kAVX2;
+            }
+            if (f.sse42)
+            {
+                return IsaLevel::kSSE42;
+            }
+            return IsaLevel::kScalar;
+        }
+
+        IsaLevel ActiveIsa()
+        {
+            return Table().level;
+        }
+
+        const char *IsaName(IsaLevel level)
+        {
+            switch (level)
+            {
+            case IsaLevel::kSSE42:
+                return "sse4.2";
+            case IsaLevel::kAVX2:
+                return "avx2";
+            case IsaLevel::kAVX512:
+                return "avx512";
+            default:
+                return "scalar";
+            }
+        }
+
+        IsaLevel ForceIsa(IsaLevel level)
+        {
+            if (level > BestIsa())
+            {
+                level = BestIsa();
+            }
+            Table() = SelectKernels(level);
+            return Table().level;
+        }
+
+        size_t MismatchIndex(const void *a, const void *b, size_t n)
+        {
+            return Table().mismatch(a, b, n);
+        }
+
+        int CompareBytes(const void *a, size_t an, const void *b, size_t bn)
+        {
+            size_t min_len = an < bn ? an : bn;
+            size_t i = Table().mismatch(a, b, min_len);
+            if (i < min_len)
+            {
+                return static_cast<int>(static_cast<const uint8_t *>(a)[i]) -
+                       static_cast<int>(static_cast<const uint8_t *>(b)[i]);
+            }
+            if (an < bn)
+            {
+                return -1;
+            }
+            return an > bn ? +1 : 0;
+        }
+
+        size_t FilterRange(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel)
+        {
+            return Table().filter_i64(col, n, lo, hi, sel);
+        }
+
+        size_t FilterRange(const double *col, size_t n, double lo, double hi, uint8_t *sel)
+        {
+            return Table().filter_f64(col, n, lo, hi, sel);
+        }
+    }
+}
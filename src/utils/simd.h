@@ -0,0 +1,92 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 10:15:40
+ * @LastEditTime: 2026-10-18 10:15:40
+ * @FilePath: /miniKV/src/utils/simd.h
+ * @Description: 运行时分派的SIMD热点函数(key比较、列过滤)
+ *
+ * ********************************
+ *  程序以通用指令集基线编译，SSE4.2/AVX2/AVX-512版本通过target属性单独编译，
+ *  启动时根据GetCpuFeatures()选择当前CPU支持的最优实现
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_SIMD_H
+#define MINIKVDB_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minikvdb
+{
+    namespace simd
+    {
+        // 可选的指令集等级，按能力从低到高排列
+        enum class IsaLevel
+        {
+            kScalar = 0,
+            kSSE42,
+            kAVX2,
+            kAVX512
+        };
+
+        /**
+         * @description:    当前分派所使用的指令集等级
+         * @return {*}      IsaLevel
+         */
+        IsaLevel ActiveIsa();
+
+        /**
+         * @description:    CPU支持的最高指令集等级
+         * @return {*}      IsaLevel
+         */
+        IsaLevel BestIsa();
+
+        const char *IsaName(IsaLevel level);
+
+        /**
+         * @description:                强制使用指定指令集(会被限制在BestIsa()以内)，仅供测试/基准对比使用
+         *                              非线程安全，调用时不能有其他线程在使用本模块
+         * @param {IsaLevel} level      指令集等级
+         * @return {*}                  实际生效的指令集等级
+         */
+        IsaLevel ForceIsa(IsaLevel level);
+
+        /**
+         * @description:            找到两段内存第一个不相同字节的下标
+         * @param {void} *a         内存a
+         * @param {void} *b         内存b
+         * @param {size_t} n        比较长度
+         * @return {*}              第一个不同字节的下标，完全相同则返回n
+         */
+        size_t MismatchIndex(const void *a, const void *b, size_t n);
+
+        /**
+         * @description:            按字节序比较两个key，语义与memcmp+长度比较一致
+         * @param {void} *a         key a
+         * @param {size_t} an       key a长度
+         * @param {void} *b         key b
+         * @param {size_t} bn       key b长度
+         * @return {*}              a<b返回负数，a==b返回0，a>b返回正数
+         */
+        int CompareBytes(const void *a, size_t an, const void *b, size_t bn);
+
+        /**
+         * @description:            列过滤：选出lo <= col[i] <= hi的行
+         * @param {int64_t} *col    列数据
+         * @param {size_t} n        行数
+         * @param {int64_t} lo      下界(含)
+         * @param {int64_t} hi      上界(含)
+         * @param {uint8_t} *sel    输出选择向量，命中为1否则为0，长度至少为n
+         * @return {*}              命中行数
+         */
+        size_t FilterRange(const int64_t *col, size_t n, int64_t lo, int64_t hi, uint8_t *sel);
+
+        // 同上，double列版本；NaN不会命中任何区间(严格IEEE语义，不依赖-ffast-math)
+        size_t FilterRange(const double *col, size_t n, double lo, double hi, uint8_t *sel);
+    }
+}
+
+#endif
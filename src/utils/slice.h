@@ -0,0 +1,125 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:12:40
+ * @LastEditTime: 2026-10-23 09:20:11
+ * @FilePath: /miniKV/src/utils/slice.h
+ * @Description: 只读字节视图Slice(指针 + 长度)
+ *
+ * ********************************
+ *  该模块实现借鉴于leveldb的Slice：不持有内存，拷贝代价只有两个字。
+ *  调用方需保证Slice指向的内存在使用期间有效；内存表以Slice为key/value时
+ *  会把内容拷贝到结点自己的内存中，插入后外部缓冲区即可释放。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_SLICE_H
+#define MINIKVDB_SLICE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "simd.h"
+
+namespace minikvdb
+{
+    class Slice
+    {
+    public:
+        Slice() : data_(""), size_(0) {}
+
+        Slice(const char *d, size_t n) : data_(d), size_(n) {}
+
+        Slice(const std::string &s) : data_(s.data()), size_(s.size()) {}
+
+        Slice(std::string_view s) : data_(s.data()), size_(s.size()) {}
+
+        Slice(const char *s) : data_(s), size_(strlen(s)) {}
+
+        inline const char *data() const { return data_; }
+
+        inline size_t size() const { return size_; }
+
+        inline bool empty() const { return size_ == 0; }
+
+        inline char operator[](size_t n) const
+        {
+            assert(n < size_);
+            return data_[n];
+        }
+
+        inline void clear()
+        {
+            data_ = "";
+            size_ = 0;
+        }
+
+        // 去掉前n个字节
+        inline void remove_prefix(size_t n)
+        {
+            assert(n <= size_);
+            data_ += n;
+            size_ -= n;
+        }
+
+        inline std::string ToString() const { return std::string(data_, size_); }
+
+        inline std::string_view ToStringView() const { return std::string_view(data_, size_); }
+
+        // 可隐式转换为string_view，便于与透明比较器、std::string互操作
+        inline operator std::string_view() const { return ToStringView(); }
+
+        /**
+         * @description:            按字节序比较，使用运行时分派的SIMD实现(simd::CompareBytes)
+         * @param {Slice} &b        另一个Slice
+         * @return {*}              <0、0、>0分别表示小于、等于、大于b
+         */
+        inline int compare(const Slice &b) const
+        {
+            return simd::CompareBytes(data_, size_, b.data_, b.size_);
+        }
+
+        inline bool starts_with(const Slice &x) const
+        {
+            return size_ >= x.size_ && memcmp(data_, x.data_, x.size_) == 0;
+        }
+
+    private:
+        const char *data_;
+        size_t size_;
+    };
+
+    inline bool operator==(const Slice &a, const Slice &b)
+    {
+        return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
+    }
+
+    inline bool operator!=(const Slice &a, const Slice &b) { return !(a == b); }
+
+    inline bool operator<(const Slice &a, const Slice &b) { return a.compare(b) < 0; }
+
+    // 内存表等模板使用的三路比较器
+    struct SliceComparator
+    {
+        int operator()(const Slice &a, const Slice &b) const { return a.compare(b); }
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<minikvdb::Slice>
+    {
+        size_t operator()(const minikvdb::Slice &s) const noexcept
+        {
+            return hash<string_view>()(s.ToStringView());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 15:08:41
+ * @LastEditTime: 2026-10-19 15:08:41
+ * @FilePath: /miniKV/src/utils/statistics.cc
+ * @Description: 引擎统计信息实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "statistics.h"
+
+#include <cstdio>
+
+namespace minikvdb
+{
+    namespace
+    {
+        const char *const kTickerNames[] = {
+            "memtable.hit",
+            "memtable.miss",
+            "keys.written",
+            "bytes.written",
+            "keys.read",
+            "bytes.read",
+            "key.comparisons",
+            "wal.syncs",
+            "wal.bytes",
+            "cache.hit",
+            "cache.miss",
+            "bloom.filter.useful",
+            "bloom.filter.positive",
+            "bloom.filter.true.positive",
+            "flush.bytes.written",
+            "compaction.bytes.read",
+            "compaction.bytes.written",
+            "compaction.count",
+            "blob.bytes.written",
+            "blob.bytes.read",
+            "blob.gc.bytes.relocated",
+        };
+        static_assert(sizeof(kTickerNames) / sizeof(kTickerNames[0]) == static_cast<size_t>(Ticker::kTickerMax),
+                      "ticker name missing");
+
+        const char *const kHistogramNames[] = {
+            "skiplist.node.height",
+            "comparisons.per.get",
+            "comparisons.per.put",
+        };
+        static_assert(sizeof(kHistogramNames) / sizeof(kHistogramNames[0]) ==
+                          static_cast<size_t>(HistogramType::kHistogramMax),
+                      "histogram name missing");
+    }
+
+    const char *Statistics::TickerName(Ticker ticker)
+    {
+        return kTickerNames[static_cast<uint32_t>(ticker)];
+    }
+
+    const char *Statistics::HistogramName(HistogramType type)
+    {
+        return kHistogramNames[static_cast<uint32_t>(type)];
+    }
+
+    void Statistics::RecordInHistogram(HistogramType type, uint64_t value)
+    {
+        Shard &shard = ThisShard();
+        ScopedLock<SpinLock> guard(shard.lock);
+        std::unique_ptr<Histogram> &hist = shard.hists[static_cast<uint32_t>(type)];
+        if (hist == nullptr)
+        {
+            hist.reset(new Histogram());
+        }
+        hist->Add(value);
+    }
+
+    uint64_t Statistics::GetTickerCount(Ticker ticker) const
+    {
+        uint64_t sum = 0;
+        for (const Shard &shard : shards_)
+        {
+            sum += shard.tickers[static_cast<uint32_t>(ticker)].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    Histogram Statistics::GetHistogram(HistogramType type) const
+    {
+        Histogram merged;
+        for (Shard &shard : shards_)
+        {
+            ScopedLock<SpinLock> guard(shard.lock);
+            const std::unique_ptr<Histogram> &hist = shard.hists[static_cast<uint32_t>(type)];
+            if (hist != nullptr)
+            {
+                merged.Merge(*hist);
+            }
+        }
+        return merged;
+    }
+
+    void Statistics::Reset()
+    {
+        for (Shard &shard : shards_)
+        {
+            for (auto &t : shard.tickers)
+            {
+                t.store(0, std::memory_order_relaxed);
+            }
+            ScopedLock<SpinLock> guard(shard.lock);
+            for (auto &hist : shard.hists)
+            {
+                hist.reset();
+            }
+        }
+    }
+
+    std::string Statistics::ToString() const
+    {
+        std::string out;
+        char buf[256];
+        for (uint32_t i = 0; i < kNumTickers; ++i)
+        {
+            snprintf(buf, sizeof(buf), "%s COUNT : %llu\n", kTickerNames[i],
+                     static_cast<unsigned long long>(GetTickerCount(static_cast<Ticker>(i))));
+            out.append(buf);
+        }
+        for (uint32_t i = 0; i < kNumHistograms; ++i)
+        {
+            Histogram hist = GetHistogram(static_cast<HistogramType>(i));
+            snprintf(buf, sizeof(buf), "%s %s\n", kHistogramNames[i], hist.ToString().c_str());
+            out.append(buf);
+        }
+        return out;
+    }
+
+    std::string Statistics::ToJson() const
+    {
+        std::string out = "{\"tickers\":{";
+        char buf[256];
+        for (uint32_t i = 0; i < kNumTickers; ++i)
+        {
+            snprintf(buf, sizeof(buf), "%s\"%s\":%llu", i == 0 ? "" : ",", kTickerNames[i],
+                     static_cast<unsigned long long>(GetTickerCount(static_cast<Ticker>(i))));
+            out.append(buf);
+        }
+        out.append("},\"histograms\":{");
+        for (uint32_t i = 0; i < kNumHistograms; ++i)
+        {
+            Histogram hist = GetHistogram(static_cast<HistogramType>(i));
+            snprintf(buf, sizeof(buf),
+                     "%s\"%s\":{\"count\":%llu,\"avg\":%.2f,\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}",
+                     i == 0 ? "" : ",", kHistogramNames[i], static_cast<unsigned long long>(hist.Count()),
+                     hist.Average(), static_cast<unsigned long long>(hist.Percentile(50)),
+                     static_cast<unsigned long long>(hist.Percentile(99)),
+                     static_cast<unsigned long long>(hist.Percentile(99.9)),
+                     static_cast<unsigned long long>(hist.Max()));
+            out.append(buf);
+        }
+        out.append("}}");
+        return out;
+    }
+}
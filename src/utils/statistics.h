@@ -0,0 +1,127 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 15:08:41
+ * @LastEditTime: 2026-10-19 15:08:41
+ * @FilePath: /miniKV/src/utils/statistics.h
+ * @Description: 引擎统计信息：计数器(ticker)与分布(histogram)
+ *
+ * ********************************
+ *  计数按线程分散到kNumShards个独占缓存行的分片上，写入为无锁的relaxed fetch_add，
+ *  读取时再汇总所有分片；分布数据每个分片一把自旋锁，分片内基本无竞争。
+ *  一个Statistics对象可以被多个MemTable共享。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_STATISTICS_H
+#define MINIKVDB_STATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "histogram.h"
+#include "lock.h"
+
+namespace minikvdb
+{
+    // 计数器
+    enum class Ticker : uint32_t
+    {
+        kMemtableHit = 0, // Get在memtable中命中
+        kMemtableMiss,    // Get在memtable中未命中
+        kKeysWritten,     // 写入的key数量
+        kBytesWritten,    // 写入的key+value字节数
+        kKeysRead,        // 读到的key数量
+        kBytesRead,       // 读到的value字节数
+        kKeyComparisons,  // 查找过程中的key比较次数
+        kWalSyncs,        // WAL同步次数
+        kWalBytes,        // 写入WAL的字节数
+        kCacheHit,        // 缓存命中
+        kCacheMiss,       // 缓存未命中
+
+        kBloomFilterUseful,       // 布隆过滤器判定不存在，省去一次查找
+        kBloomFilterPositive,     // 布隆过滤器判定可能存在
+        kBloomFilterTruePositive, // 判定可能存在且确实存在，误判数 = positive - true positive
+
+        kFlushBytesWritten,      // flush写出的字节数，写放大 = (flush + compaction写出) / flush
+        kCompactionBytesRead,    // compaction读入的字节数
+        kCompactionBytesWritten, // compaction写出的字节数
+        kCompactions,            // 执行的compaction次数
+
+        kBlobBytesWritten,     // 写入blob文件的value字节数
+        kBlobBytesRead,        // 从blob文件读出的value字节数
+        kBlobGCBytesRelocated, // blob GC搬迁的存活value字节数
+        kTickerMax
+    };
+
+    // 分布
+    enum class HistogramType : uint32_t
+    {
+        kSkipListNodeHeight = 0, // 新插入跳表结点的高度
+        kComparisonsPerGet,      // 每次Get的key比较次数
+        kComparisonsPerPut,      // 每次Put定位插入位置的key比较次数
+        kHistogramMax
+    };
+
+    class Statistics
+    {
+    public:
+        Statistics() = default;
+
+        Statistics(const Statistics &) = delete;
+        Statistics &operator=(const Statistics &) = delete;
+
+        inline void RecordTick(Ticker ticker, uint64_t count = 1)
+        {
+            ThisShard().tickers[static_cast<uint32_t>(ticker)].fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void RecordInHistogram(HistogramType type, uint64_t value);
+
+        // 汇总所有分片，读取期间的并发写入可能计入也可能不计入
+        uint64_t GetTickerCount(Ticker ticker) const;
+
+        Histogram GetHistogram(HistogramType type) const;
+
+        void Reset();
+
+        // 每行一项："memtable.hit COUNT : 10"
+        std::string ToString() const;
+
+        // {"tickers":{"memtable.hit":10,...},"histograms":{"skiplist.node.height":{"count":..},...}}
+        std::string ToJson() const;
+
+        static const char *TickerName(Ticker ticker);
+
+        static const char *HistogramName(HistogramType type);
+
+    private:
+        static const int kNumShards = 16;
+        static const uint32_t kNumTickers = static_cast<uint32_t>(Ticker::kTickerMax);
+        static const uint32_t kNumHistograms = static_cast<uint32_t>(HistogramType::kHistogramMax);
+
+        struct alignas(kCacheLineSize) Shard
+        {
+            std::atomic<uint64_t> tickers[kNumTickers] = {};
+            SpinLock lock;                                    // 保护hists
+            std::unique_ptr<Histogram> hists[kNumHistograms]; // 首次记录时创建
+        };
+
+        // 线程首次使用时按轮转分配分片，之后固定不变
+        static int ThreadShard()
+        {
+            static std::atomic<uint32_t> next_shard{0};
+            thread_local int shard = static_cast<int>(next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards);
+            return shard;
+        }
+
+        inline Shard &ThisShard() { return shards_[ThreadShard()]; }
+
+        mutable Shard shards_[kNumShards];
+    };
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 09:15:37
+ * @LastEditTime: 2026-10-23 14:05:12
+ * @FilePath: /miniKV/src/utils/thread_pool.cc
+ * @Description: 后台任务线程池实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "thread_pool.h"
+
+namespace minikvdb
+{
+    ThreadPool::ThreadPool(int high_threads, int low_threads)
+    {
+        SetBackgroundThreads(high_threads, Priority::kHigh);
+        SetBackgroundThreads(low_threads, Priority::kLow);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mu_);
+            exit_ = true;
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            work_cv_[i].notify_all();
+        }
+        for (Pool &pool : pools_)
+        {
+            for (std::thread &t : pool.threads)
+            {
+                t.join();
+            }
+        }
+    }
+
+    void ThreadPool::Schedule(std::function<void()> job, Priority pri)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mu_);
+            PoolOf(pri).queue.push_back(std::move(job));
+        }
+        work_cv_[static_cast<int>(pri)].notify_one();
+    }
+
+    void ThreadPool::SetBackgroundThreads(int num, Priority pri)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        Pool &pool = PoolOf(pri);
+        while (static_cast<int>(pool.threads.size()) < num)
+        {
+            pool.threads.emplace_back(&ThreadPool::WorkerLoop, this, pri);
+        }
+    }
+
+    int ThreadPool::GetBackgroundThreads(Priority pri)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return static_cast<int>(PoolOf(pri).threads.size());
+    }
+
+    size_t ThreadPool::GetQueueLen(Priority pri)
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        return PoolOf(pri).queue.size();
+    }
+
+    void ThreadPool::WaitForIdle()
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        idle_cv_.wait(lock, [this]()
+                      {
+            for (const Pool &pool : pools_)
+            {
+                if (!pool.queue.empty() || pool.running > 0)
+                {
+                    return false;
+                }
+            }
+            return true; });
+    }
+
+    void ThreadPool::WorkerLoop(Priority pri)
+    {
+        Pool &pool = PoolOf(pri);
+        std::condition_variable &cv = work_cv_[static_cast<int>(pri)];
+        std::unique_lock<std::mutex> lock(mu_);
+        while (true)
+        {
+            cv.wait(lock, [this, &pool]()
+                    { return exit_ || !pool.queue.empty(); });
+            if (pool.queue.empty())
+            {
+                return; // exit_且队列已清空
+            }
+            std::function<void()> job = std::move(pool.queue.front());
+            pool.queue.pop_front();
+            ++pool.running;
+            lock.unlock();
+
+            job();
+
+            lock.lock();
+            --pool.running;
+            if (pool.running == 0 && pool.queue.empty())
+            {
+                idle_cv_.notify_all();
+            }
+        }
+    }
+
+    void CountDownLatch::CountDown()
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        if (count_ > 0 && --count_ == 0)
+        {
+            cv_.notify_all();
+        }
+    }
+
+    void CountDownLatch::Wait()
+    {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this]()
+                 { return count_ == 0; });
+    }
+}
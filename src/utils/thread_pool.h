@@ -0,0 +1,104 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 09:15:37
+ * @LastEditTime: 2026-10-23 14:05:12
+ * @FilePath: /miniKV/src/utils/thread_pool.h
+ * @Description: 后台任务线程池，按优先级分为flush(高)与compaction(低)两组线程
+ *
+ * ********************************
+ *  每个优先级各有一个任务队列和一组线程，互不借用：
+ *  大量compaction排队时flush仍有专属线程可用，不会因此阻塞前台写入。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_THREAD_POOL_H
+#define MINIKVDB_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace minikvdb
+{
+    enum class Priority
+    {
+        kHigh = 0, // flush
+        kLow = 1,  // compaction
+    };
+
+    class ThreadPool
+    {
+    public:
+        /**
+         * @description:                构造线程池并启动线程
+         * @param {int} high_threads    高优先级(flush)线程数
+         * @param {int} low_threads     低优先级(compaction)线程数
+         * @return {*}
+         */
+        explicit ThreadPool(int high_threads = 1, int low_threads = 1);
+
+        // 执行完已排队的任务后退出
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void Schedule(std::function<void()> job, Priority pri);
+
+        // 调整某个优先级的线程数，只增不减
+        void SetBackgroundThreads(int num, Priority pri);
+
+        int GetBackgroundThreads(Priority pri);
+
+        // 排队中(未开始执行)的任务数
+        size_t GetQueueLen(Priority pri);
+
+        // 阻塞直到两个队列都为空且没有正在执行的任务
+        void WaitForIdle();
+
+    private:
+        struct Pool
+        {
+            std::deque<std::function<void()>> queue;
+            std::vector<std::thread> threads;
+            int running = 0; // 正在执行的任务数
+        };
+
+        void WorkerLoop(Priority pri);
+
+        inline Pool &PoolOf(Priority pri) { return pools_[static_cast<int>(pri)]; }
+
+        std::mutex mu_;
+        std::condition_variable work_cv_[2]; // 每个优先级一个，避免唤醒无关线程
+        std::condition_variable idle_cv_;
+        Pool pools_[2];
+        bool exit_ = false;
+    };
+
+    // 计数归零前Wait阻塞，用于等待一组提交到ThreadPool的任务全部完成
+    class CountDownLatch
+    {
+    public:
+        explicit CountDownLatch(int count) : count_(count) {}
+
+        CountDownLatch(const CountDownLatch &) = delete;
+        CountDownLatch &operator=(const CountDownLatch &) = delete;
+
+        void CountDown();
+
+        void Wait();
+
+    private:
+        std::mutex mu_;
+        std::condition_variable cv_;
+        int count_;
+    };
+}
+
+#endif
@@ -0,0 +1,307 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 14:48:30
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/src/utils/writable_file.cc
+ * @Description: 带缓冲、可限速的顺序写文件实现
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include "writable_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace minikvdb
+{
+    WritableFile::WritableFile(RateLimiter *limiter, Priority pri, size_t buffer_size, bool use_direct_io)
+        : limiter_(limiter), pri_(pri),
+          buffer_size_(use_direct_io ? AlignUp(buffer_size, kDefaultIOAlignment) : buffer_size),
+          use_direct_io_(use_direct_io)
+    {
+        if (!use_direct_io_)
+        {
+            buf_.reserve(buffer_size_);
+        }
+    }
+
+    WritableFile::~WritableFile()
+    {
+        Close();
+        ReleaseAlignedBuffer();
+    }
+
+    bool WritableFile::Open(const std::string &path, bool append)
+    {
+        Close();
+        path_ = path;
+        file_size_ = 0;
+        synced_size_ = 0;
+        direct_ = false;
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+        if (use_direct_io_)
+        {
+            // 追加写时末尾不满一页的部分需要读回缓冲区，因此用读写方式打开且不能用O_APPEND
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT | (append ? 0 : O_TRUNC), 0644);
+            direct_ = fd_ >= 0;
+            if (fd_ < 0 && errno != EINVAL)
+            {
+                return false;
+            }
+        }
+        if (fd_ < 0)
+        {
+            fd_ = ::open(path.c_str(), flags | (append ? O_APPEND : O_TRUNC), 0644);
+            if (fd_ < 0)
+            {
+                return false;
+            }
+        }
+        if (append)
+        {
+            struct stat st;
+            if (::fstat(fd_, &st) == 0)
+            {
+                file_size_ = static_cast<uint64_t>(st.st_size);
+            }
+        }
+        synced_size_ = file_size_;
+
+        if (direct_)
+        {
+            if (abuf_ == nullptr)
+            {
+                AlignedBufferPool *shared = AlignedBufferPool::get_instance();
+                if (shared->GetBufferSize() == buffer_size_)
+                {
+                    pool_ = shared;
+                    abuf_ = pool_->Acquire();
+                }
+                else
+                {
+                    abuf_ = static_cast<char *>(alloc_.Allocate(static_cast<int32_t>(buffer_size_)));
+                }
+            }
+            abuf_offset_ = AlignDown(file_size_, kDefaultIOAlignment);
+            abuf_len_ = static_cast<size_t>(file_size_ - abuf_offset_);
+            if (abuf_len_ > 0)
+            {
+                // 读回末尾不满一页的部分，之后整页写出
+                ssize_t r = ::pread(fd_, abuf_, kDefaultIOAlignment, static_cast<off_t>(abuf_offset_));
+                if (r < static_cast<ssize_t>(abuf_len_))
+                {
+                    Close();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool WritableFile::Append(const char *data, size_t n)
+    {
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        file_size_ += n;
+        if (direct_)
+        {
+            return AppendDirect(data, n);
+        }
+        if (buf_.size() + n <= buffer_size_)
+        {
+            buf_.append(data, n);
+            return true;
+        }
+        if (!Flush())
+        {
+            return false;
+        }
+        // 大块数据直接写出，不经过缓冲区
+        if (n >= buffer_size_)
+        {
+            return WriteUnbuffered(data, n);
+        }
+        buf_.append(data, n);
+        return true;
+    }
+
+    bool WritableFile::Flush()
+    {
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        if (direct_)
+        {
+            return FlushDirect(true);
+        }
+        if (buf_.empty())
+        {
+            return true;
+        }
+        bool ok = WriteUnbuffered(buf_.data(), buf_.size());
+        buf_.clear();
+        return ok;
+    }
+
+    bool WritableFile::SetPriority(Priority pri)
+    {
+        if (pri == pri_)
+        {
+            return true;
+        }
+        bool ok = fd_ < 0 || Flush();
+        pri_ = pri;
+        return ok;
+    }
+
+    bool WritableFile::Sync()
+    {
+        if (!Flush() || ::fdatasync(fd_) != 0)
+        {
+            return false;
+        }
+        if (use_direct_io_ && !direct_ && file_size_ > synced_size_)
+        {
+            // 不支持O_DIRECT时退而求其次：已落盘的页不再需要，提示内核丢弃
+            ::posix_fadvise(fd_, static_cast<off_t>(synced_size_), static_cast<off_t>(file_size_ - synced_size_),
+                            POSIX_FADV_DONTNEED);
+            synced_size_ = file_size_;
+        }
+        return true;
+    }
+
+    bool WritableFile::Close()
+    {
+        if (fd_ < 0)
+        {
+            return true;
+        }
+        bool ok = use_direct_io_ && !direct_ ? Sync() : Flush();
+        ok = (::close(fd_) == 0) && ok;
+        fd_ = -1;
+        direct_ = false;
+        abuf_len_ = 0;
+        return ok;
+    }
+
+    bool WritableFile::AppendDirect(const char *data, size_t n)
+    {
+        while (n > 0)
+        {
+            size_t copy = std::min(n, buffer_size_ - abuf_len_);
+            memcpy(abuf_ + abuf_len_, data, copy);
+            abuf_len_ += copy;
+            data += copy;
+            n -= copy;
+            if (abuf_len_ == buffer_size_ && !FlushDirect(false))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool WritableFile::FlushDirect(bool keep_tail)
+    {
+        if (abuf_len_ == 0)
+        {
+            return true;
+        }
+        size_t aligned_len = AlignUp(abuf_len_, kDefaultIOAlignment);
+        size_t tail = abuf_len_ % kDefaultIOAlignment;
+        if (tail != 0)
+        {
+            memset(abuf_ + abuf_len_, 0, aligned_len - abuf_len_);
+        }
+        if (!WriteAt(abuf_, aligned_len, static_cast<int64_t>(abuf_offset_)))
+        {
+            return false;
+        }
+        if (tail != 0)
+        {
+            // 去掉补零的部分，保证文件长度与已Append的字节数一致
+            if (::ftruncate(fd_, static_cast<off_t>(file_size_)) != 0)
+            {
+                return false;
+            }
+            if (keep_tail)
+            {
+                size_t full = abuf_len_ - tail;
+                memmove(abuf_, abuf_ + full, tail);
+                abuf_offset_ += full;
+                abuf_len_ = tail;
+                return true;
+            }
+        }
+        abuf_offset_ += aligned_len;
+        abuf_len_ = 0;
+        return true;
+    }
+
+    void WritableFile::ReleaseAlignedBuffer()
+    {
+        if (abuf_ == nullptr)
+        {
+            return;
+        }
+        if (pool_ != nullptr)
+        {
+            pool_->Release(abuf_);
+        }
+        else
+        {
+            alloc_.Deallocate(abuf_, static_cast<int32_t>(buffer_size_));
+        }
+        abuf_ = nullptr;
+        pool_ = nullptr;
+    }
+
+    bool WritableFile::WriteUnbuffered(const char *data, size_t n)
+    {
+        return WriteAt(data, n, -1);
+    }
+
+    bool WritableFile::WriteAt(const char *data, size_t n, int64_t offset)
+    {
+        while (n > 0)
+        {
+            size_t chunk = n;
+            if (limiter_ != nullptr)
+            {
+                chunk = std::min<size_t>(n, static_cast<size_t>(limiter_->GetSingleBurstBytes()));
+                if (offset >= 0)
+                {
+                    // direct I/O每次写出的长度必须页对齐
+                    chunk = std::min(n, std::max(AlignDown(chunk, kDefaultIOAlignment), kDefaultIOAlignment));
+                }
+                limiter_->Request(static_cast<int64_t>(chunk), pri_);
+            }
+            ssize_t done = offset < 0 ? ::write(fd_, data, chunk)
+                                      : ::pwrite(fd_, data, chunk, static_cast<off_t>(offset));
+            if (done < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            // 部分写入时多申请的令牌不退还，误差至多一次write
+            data += done;
+            n -= static_cast<size_t>(done);
+            if (offset >= 0)
+            {
+                offset += done;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 14:48:30
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/src/utils/writable_file.h
+ * @Description: 带缓冲、可限速的顺序写文件，供SSTable、WAL等写入者使用
+ *
+ * ********************************
+ *  Append先写入用户态缓冲区，缓冲区满或Flush/Sync时才write到内核；
+ *  设置了RateLimiter时每次write前按写入字节数申请令牌。
+ *  use_direct_io时以O_DIRECT打开，写入不经过页缓存，避免flush/compaction的
+ *  输出挤掉前台读的热数据：缓冲区按页对齐，Flush时末尾不满一页的部分补零写出，
+ *  随后ftruncate回真实长度，这部分仍保留在缓冲区中，下次写出时覆盖同一页。
+ *  文件系统不支持O_DIRECT时退回普通写，并在Sync后用posix_fadvise丢弃已落盘的页。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#ifndef MINIKVDB_WRITABLE_FILE_H
+#define MINIKVDB_WRITABLE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rate_limiter.h"
+#include "../memory/aligned_alloc.h"
+
+namespace minikvdb
+{
+    class WritableFile
+    {
+    public:
+        /**
+         * @description:                    构造写文件对象
+         * @param {RateLimiter} *limiter    限速器，为空时不限速
+         * @param {Priority} pri            申请令牌时使用的优先级：flush、WAL用kHigh，compaction用kLow
+         * @param {size_t} buffer_size      用户态缓冲区大小，direct I/O时向上取整到页大小
+         * @param {bool} use_direct_io      是否绕过页缓存(O_DIRECT)
+         * @return {*}
+         */
+        explicit WritableFile(RateLimiter *limiter = nullptr, Priority pri = Priority::kLow,
+                              size_t buffer_size = 64 * 1024, bool use_direct_io = false);
+
+        ~WritableFile();
+
+        WritableFile(const WritableFile &) = delete;
+        WritableFile &operator=(const WritableFile &) = delete;
+
+        /**
+         * @description:                打开文件
+         * @param {string} &path        文件路径
+         * @param {bool} append         true时追加写，false时清空原有内容
+         * @return {*}                  是否成功
+         */
+        bool Open(const std::string &path, bool append = false);
+
+        bool Append(const char *data, size_t n);
+
+        inline bool Append(const std::string &data) { return Append(data.data(), data.size()); }
+
+        // 把缓冲区写入内核
+        bool Flush();
+
+        // Flush并fdatasync落盘
+        bool Sync();
+
+        // 修改之后写出时申请令牌的优先级，缓冲区中已有的数据先按原优先级写出
+        bool SetPriority(Priority pri);
+
+        bool Close();
+
+        inline bool IsOpen() const { return fd_ >= 0; }
+
+        // 已Append的总字节数(含缓冲区中未写出的部分)
+        inline uint64_t GetFileSize() const { return file_size_; }
+
+        // 当前打开的文件是否真正以O_DIRECT写入
+        inline bool IsDirectIO() const { return fd_ >= 0 && direct_; }
+
+    private:
+        bool WriteUnbuffered(const char *data, size_t n);
+
+        bool AppendDirect(const char *data, size_t n);
+
+        // 写出对齐缓冲区；keep_tail为true时末尾不满一页的部分补零写出后留在缓冲区
+        bool FlushDirect(bool keep_tail);
+
+        // 写出时按RateLimiter申请令牌，offset为负时使用write，否则使用pwrite
+        bool WriteAt(const char *data, size_t n, int64_t offset);
+
+        void ReleaseAlignedBuffer();
+
+        RateLimiter *const limiter_;
+        Priority pri_;
+        size_t const buffer_size_;
+        bool const use_direct_io_;
+        std::string buf_;
+        int fd_ = -1;
+        uint64_t file_size_ = 0;
+        std::string path_;
+
+        // direct I/O状态
+        bool direct_ = false;
+        char *abuf_ = nullptr;        // 对齐缓冲区
+        size_t abuf_len_ = 0;         // 缓冲区中的有效字节数
+        uint64_t abuf_offset_ = 0;    // abuf_[0]对应的文件偏移，总是页对齐
+        AlignedBufferPool *pool_ = nullptr;
+        AlignedAlloc alloc_;
+
+        uint64_t synced_size_ = 0; // 非direct模式下已丢弃页缓存的位置
+    };
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 16:30:09
+ * @LastEditTime: 2026-10-24 09:20:41
+ * @FilePath: /miniKV/test/test_async_io.cc
+ * @Description:  批量异步读测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <cstddef>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "../src/utils/async_io.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    class AsyncIOTest : public ::testing::TestWithParam<bool>
+    {
+    protected:
+        static constexpr size_t kFileSize = 1 << 20;
+
+        void SetUp() override
+        {
+            char path[] = "/tmp/minikvdb_async_io_XXXXXX";
+            fd_ = ::mkstemp(path);
+            ASSERT_GE(fd_, 0);
+            path_ = path;
+            content_.resize(kFileSize);
+            for (size_t i = 0; i < kFileSize; ++i)
+            {
+                content_[i] = static_cast<char>((i * 131 + 7) & 0xff);
+            }
+            ASSERT_EQ(::write(fd_, content_.data(), kFileSize), static_cast<ssize_t>(kFileSize));
+        }
+
+        void TearDown() override
+        {
+            ::close(fd_);
+            ::unlink(path_.c_str());
+        }
+
+        int fd_ = -1;
+        string path_;
+        string content_;
+    };
+
+    // 请求数超过队列深度，需要分批提交
+    TEST_P(AsyncIOTest, MultiRead)
+    {
+        auto reader = NewAsyncReader(GetParam(), 8);
+        if (!GetParam())
+        {
+            EXPECT_STREQ(reader->Name(), "thread_pool");
+        }
+
+        const size_t n = 100;
+        const size_t len = 4096;
+        vector<vector<char>> bufs(n, vector<char>(len));
+        vector<ReadRequest> reqs(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            reqs[i].fd = fd_;
+            reqs[i].offset = (i * 7919 * 4096 + i) % (kFileSize - len);
+            reqs[i].len = len;
+            reqs[i].scratch = bufs[i].data();
+        }
+        reader->MultiRead(reqs.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(reqs[i].result, static_cast<ssize_t>(len));
+            EXPECT_EQ(memcmp(bufs[i].data(), content_.data() + reqs[i].offset, len), 0);
+        }
+    }
+
+    // 越过文件末尾只返回实际读到的字节，错误的fd返回-errno
+    TEST_P(AsyncIOTest, ShortReadAndError)
+    {
+        auto reader = NewAsyncReader(GetParam(), 4);
+        vector<char> buf1(4096), buf2(16);
+        ReadRequest reqs[2];
+        reqs[0].fd = fd_;
+        reqs[0].offset = kFileSize - 100;
+        reqs[0].len = buf1.size();
+        reqs[0].scratch = buf1.data();
+        reqs[1].fd = -1;
+        reqs[1].len = buf2.size();
+        reqs[1].scratch = buf2.data();
+        reader->MultiRead(reqs, 2);
+        EXPECT_EQ(reqs[0].result, 100);
+        EXPECT_EQ(memcmp(buf1.data(), content_.data() + kFileSize - 100, 100), 0);
+        EXPECT_EQ(reqs[1].result, -EBADF);
+
+        reader->MultiRead(reqs, 0);
+    }
+
+#ifdef __linux__
+    // 让to_submit为fail_batch的io_uring_enter返回EPERM(模拟seccomp等导致的提交失败)，不可撤销
+    static bool FailIoUringEnter(unsigned fail_batch)
+    {
+        struct sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_enter, 0, 3),
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, args[1])),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, fail_batch, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        };
+        struct sock_fprog prog = {static_cast<unsigned short>(sizeof(filter) / sizeof(filter[0])), filter};
+        return ::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+               ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0;
+    }
+
+    // 提交失败的一批退回同步读后，这批的sqe不能留在ring中被下一批提交
+    TEST_F(AsyncIOTest, IoUringSubmitErrorThenNextBatch)
+    {
+        auto reader = NewAsyncReader(true, 8);
+        if (string(reader->Name()) != "io_uring")
+        {
+            GTEST_SKIP() << "io_uring unavailable";
+        }
+        // seccomp过滤器无法撤销，在子进程中执行，退出码为第一个失败的检查
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0)
+        {
+            if (!FailIoUringEnter(3))
+            {
+                _exit(1);
+            }
+            const size_t len = 4096;
+            auto run = [&](size_t n, uint64_t base) -> bool
+            {
+                vector<vector<char>> bufs(n, vector<char>(len));
+                vector<ReadRequest> reqs(n);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    reqs[i].fd = fd_;
+                    reqs[i].offset = base + i * len;
+                    reqs[i].len = len;
+                    reqs[i].scratch = bufs[i].data();
+                }
+                reader->MultiRead(reqs.data(), n);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (reqs[i].result != static_cast<ssize_t>(len) ||
+                        memcmp(bufs[i].data(), content_.data() + reqs[i].offset, len) != 0)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            // 第一批提交失败，退回pread；第二批(2个请求)仍走io_uring
+            _exit(!run(3, 0) ? 2 : !run(2, 100 * len) ? 3 : 0);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+#endif
+
+    INSTANTIATE_TEST_SUITE_P(async_io, AsyncIOTest, ::testing::Values(true, false),
+                             [](const ::testing::TestParamInfo<bool> &info)
+                             { return info.param ? "IoUring" : "ThreadPool"; });
+}
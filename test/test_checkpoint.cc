@@ -0,0 +1,258 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 10:40:05
+ * @LastEditTime: 2026-10-23 21:05:44
+ * @FilePath: /miniKV/test/test_checkpoint.cc
+ * @Description:  memtable checkpoint写出、mmap读取与后台重建测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/checkpoint.h"
+#include "../src/memtable/comparator.h"
+#include "../src/memtable/memtable.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/utils/rate_limiter.h"
+#include "../src/utils/slice.h"
+#include "../src/utils/thread_pool.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct IntComparator
+    {
+        int operator()(const int64_t &a, const int64_t &b) const
+        {
+            return a < b ? -1 : (a > b ? 1 : 0);
+        }
+    };
+
+    using StringTable = MemTable<string, string, BytewiseComparator, BytewiseHash>;
+    using IntTable = MemTable<int64_t, int64_t, IntComparator>;
+
+    static string CheckpointPath(const char *name)
+    {
+        return string("/tmp/minikvdb_ckpt_") + name + "_" + to_string(getpid());
+    }
+
+    static string KeyOf(int i)
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "key_%06d", i);
+        return buf;
+    }
+
+    class CheckpointTest : public ::testing::TestWithParam<MemTableRepType>
+    {
+    protected:
+        std::unique_ptr<StringTable> NewTable()
+        {
+            return std::make_unique<StringTable>(BytewiseComparator(), std::make_shared<DefaultAlloc>(), GetParam(), 16);
+        }
+    };
+
+    TEST_P(CheckpointTest, WriteAndRead)
+    {
+        const string path = CheckpointPath("rw");
+        auto table = NewTable();
+        for (int i = 0; i < 1000; i += 2)
+        {
+            table->Insert(KeyOf(i), "value_" + to_string(i));
+        }
+        CheckpointManifest manifest{{"next_file_number", "42"}, {"runs", "3,7,9"}};
+        ASSERT_TRUE(WriteCheckpoint(*table, path, manifest));
+        EXPECT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+
+        CheckpointReader<string, string, BytewiseComparator> reader;
+        ASSERT_TRUE(reader.Open(path));
+        EXPECT_EQ(reader.GetSize(), 500u);
+        EXPECT_EQ(reader.GetManifest(), manifest);
+        EXPECT_TRUE(reader.VerifyData());
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto value = reader.Get(KeyOf(i));
+            if (i % 2 == 0)
+            {
+                EXPECT_EQ(value, "value_" + to_string(i));
+                EXPECT_TRUE(reader.Contains(KeyOf(i)));
+            }
+            else
+            {
+                EXPECT_EQ(value, std::nullopt);
+                EXPECT_FALSE(reader.Contains(KeyOf(i)));
+            }
+        }
+        // 透明比较器：string_view直接与映射内存比较
+        EXPECT_EQ(reader.Get(std::string_view("key_000010")), "value_10");
+        EXPECT_EQ(reader.Get(std::string_view("key_999999")), std::nullopt);
+
+        string key, value;
+        ASSERT_TRUE(reader.ReadEntry(0, &key, &value));
+        EXPECT_EQ(key, KeyOf(0));
+        ASSERT_TRUE(reader.ReadEntry(499, &key, &value));
+        EXPECT_EQ(key, KeyOf(998));
+        unlink(path.c_str());
+    }
+
+    TEST_P(CheckpointTest, RestoreInBackground)
+    {
+        const string path = CheckpointPath("restore");
+        {
+            auto table = NewTable();
+            for (int i = 0; i < 5000; ++i)
+            {
+                table->Insert(KeyOf(i), to_string(i));
+            }
+            ASSERT_TRUE(WriteCheckpoint(*table, path, {{"seq", "5000"}}));
+        }
+
+        ThreadPool pool(1, 0);
+        RestoredMemTable<string, string, BytewiseComparator, BytewiseHash> restored(NewTable());
+        ASSERT_TRUE(restored.Open(path, &pool));
+        // 重建是否完成都能读到
+        EXPECT_EQ(restored.Get(KeyOf(1234)), "1234");
+        EXPECT_EQ(restored.GetManifest().at("seq"), "5000");
+
+        ASSERT_TRUE(restored.WaitForRebuild());
+        EXPECT_TRUE(restored.IsRebuilt());
+        StringTable *table = restored.GetMemTable();
+        EXPECT_EQ(table->GetSize(), 5000);
+        EXPECT_EQ(restored.Get(KeyOf(4999)), "4999");
+        table->Insert(KeyOf(5000), "5000");
+        EXPECT_EQ(restored.Get(KeyOf(5000)), "5000");
+
+        // 重建后的memtable按key有序
+        StringTable::MemTableIterator iter(table);
+        int i = 0;
+        for (iter.MoveToFirst(); iter.Valid(); iter.Next(), ++i)
+        {
+            EXPECT_EQ(iter.key(), KeyOf(i));
+        }
+        EXPECT_EQ(i, 5001);
+        unlink(path.c_str());
+    }
+
+    INSTANTIATE_TEST_SUITE_P(RepTypes, CheckpointTest,
+                             ::testing::Values(MemTableRepType::kSkipList, MemTableRepType::kHashSkipList,
+                                               MemTableRepType::kBPlusTree));
+
+    TEST(CheckpointFileTest, LazyRebuildAndTrivialTypes)
+    {
+        const string path = CheckpointPath("int");
+        IntTable table(IntComparator(), std::make_shared<DefaultAlloc>());
+        for (int64_t i = 0; i < 100; ++i)
+        {
+            table.Insert(i * 10, -i);
+        }
+        RateLimiter limiter(1 << 30);
+        ASSERT_TRUE(WriteCheckpoint(table, path, {}, true, &limiter));
+        EXPECT_GE(limiter.GetTotalBytesThrough(Priority::kHigh),
+                  static_cast<int64_t>(std::filesystem::file_size(path)));
+
+        // 没有线程池时推迟到第一次需要memtable时重建
+        RestoredMemTable<int64_t, int64_t, IntComparator> restored(
+            std::make_unique<IntTable>(IntComparator(), std::make_shared<DefaultAlloc>()));
+        ASSERT_TRUE(restored.Open(path, nullptr));
+        EXPECT_FALSE(restored.IsRebuilt());
+        EXPECT_EQ(restored.Get(990), -99);
+        EXPECT_EQ(restored.Get(995), std::nullopt);
+        EXPECT_EQ(restored.GetMemTable()->GetSize(), 100);
+        EXPECT_TRUE(restored.IsRebuilt());
+        EXPECT_EQ(restored.Get(0), 0);
+        unlink(path.c_str());
+    }
+
+    TEST(CheckpointFileTest, SliceValueIsZeroCopy)
+    {
+        const string path = CheckpointPath("slice");
+        MemTable<Slice, Slice, SliceComparator> table(SliceComparator(), std::make_shared<DefaultAlloc>());
+        string k = "k", v = "v";
+        table.Insert(Slice(k), Slice(v));
+        ASSERT_TRUE(WriteCheckpoint(table, path));
+
+        CheckpointReader<Slice, Slice, SliceComparator> reader;
+        ASSERT_TRUE(reader.Open(path));
+        auto value = reader.Get(Slice(k));
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(value->ToString(), "v");
+        EXPECT_NE(value->data(), v.data());
+        unlink(path.c_str());
+    }
+
+    TEST(CheckpointFileTest, DetectCorruption)
+    {
+        const string path = CheckpointPath("corrupt");
+        IntTable table(IntComparator(), std::make_shared<DefaultAlloc>());
+        for (int64_t i = 0; i < 100; ++i)
+        {
+            table.Insert(i, i);
+        }
+        ASSERT_TRUE(WriteCheckpoint(table, path));
+
+        // 损坏data段：打开成功(不读data)，重建时校验失败
+        {
+            fstream f(path, ios::in | ios::out | ios::binary);
+            f.seekp(20);
+            f.put('\x7f');
+        }
+        RestoredMemTable<int64_t, int64_t, IntComparator> restored(
+            std::make_unique<IntTable>(IntComparator(), std::make_shared<DefaultAlloc>()));
+        ASSERT_TRUE(restored.Open(path, nullptr));
+        EXPECT_EQ(restored.Get(1), 1); // 重建前由映射文件服务
+        EXPECT_FALSE(restored.WaitForRebuild());
+        EXPECT_FALSE(restored.IsRebuilt());
+        EXPECT_TRUE(restored.IsFailed());
+        // 失败后不再读损坏的映射内存
+        EXPECT_EQ(restored.Get(1), std::nullopt);
+        EXPECT_FALSE(restored.Contains(1));
+        EXPECT_EQ(restored.GetMemTable()->GetSize(), 0);
+
+        // 损坏footer：无法打开
+        {
+            fstream f(path, ios::in | ios::out | ios::binary);
+            f.seekp(-10, ios::end);
+            f.put('\x7f');
+        }
+        CheckpointReader<int64_t, int64_t, IntComparator> reader;
+        EXPECT_FALSE(reader.Open(path));
+        EXPECT_FALSE(reader.Open(path + ".missing"));
+        unlink(path.c_str());
+    }
+
+    // data校验通过但中途某条记录解码失败：已插入的部分被清空，读请求返回空
+    TEST(CheckpointFileTest, PartialRebuildIsDiscarded)
+    {
+        const string path = CheckpointPath("partial");
+        MemTable<int64_t, string, IntComparator> table(IntComparator(), std::make_shared<DefaultAlloc>());
+        for (int64_t i = 0; i < 100; ++i)
+        {
+            // 前50条value正好8字节，可以按int64_t解码
+            table.Insert(i, i < 50 ? string(8, 'v') : string("short"));
+        }
+        ASSERT_TRUE(WriteCheckpoint(table, path));
+
+        ThreadPool pool(1, 1);
+        RestoredMemTable<int64_t, int64_t, IntComparator> restored(
+            std::make_unique<IntTable>(IntComparator(), std::make_shared<DefaultAlloc>()));
+        ASSERT_TRUE(restored.Open(path, &pool));
+        EXPECT_FALSE(restored.WaitForRebuild());
+        EXPECT_TRUE(restored.IsFailed());
+        EXPECT_EQ(restored.GetMemTable()->GetSize(), 0);
+        for (int64_t i : {0, 10, 49, 50, 99})
+        {
+            EXPECT_EQ(restored.Get(i), std::nullopt);
+            EXPECT_FALSE(restored.Contains(i));
+        }
+        unlink(path.c_str());
+    }
+}
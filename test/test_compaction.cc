@@ -0,0 +1,319 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 11:42:51
+ * @LastEditTime: 2026-10-24 11:02:19
+ * @FilePath: /miniKV/test/test_compaction.cc
+ * @Description:  flush与compaction测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/compaction/compaction_filter.h"
+#include "../src/compaction/compaction_job.h"
+#include "../src/compaction/tiered_compaction.h"
+#include "../src/memtable/memtable.h"
+#include "../src/memtable/random.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/utils/lock.h"
+#include "../src/utils/statistics.h"
+#include "../src/utils/thread_pool.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct RunStringComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using StringRun = SortedRun<string, string>;
+    using StringCompaction = CompactionJob<string, string, RunStringComparator>;
+
+    static string RunKey(int i)
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "k%06d", i);
+        return buf;
+    }
+
+    TEST(compaction, FlushMemTable)
+    {
+        MemTable<string, string, RunStringComparator> table(RunStringComparator(), std::make_shared<DefaultAlloc>());
+        table.Insert("b", "2");
+        table.Insert("a", "1");
+        table.Insert("c", "3");
+        StringRun run = FlushMemTable(table, 7);
+        EXPECT_EQ(run.id, 7u);
+        ASSERT_EQ(run.entries.size(), 3u);
+        EXPECT_EQ(run.Smallest(), "a");
+        EXPECT_EQ(run.Largest(), "c");
+        EXPECT_EQ(run.bytes, 6u);
+    }
+
+    // 多个相互重叠的输入，相同key以最新输入为准；结果与subcompaction数量及是否使用线程池无关
+    TEST(compaction, MergeNewestWins)
+    {
+        ThreadPool pool(1, 3);
+        Random rnd(301);
+        std::vector<StringRun> runs(6);
+        std::map<string, string> expect;
+        // runs[0]最新，倒序写入expect使新值覆盖旧值
+        for (int r = 5; r >= 0; --r)
+        {
+            std::map<string, string> kv;
+            for (int i = 0; i < 2000; ++i)
+            {
+                kv[RunKey(rnd.Uniform(10000))] = "r" + std::to_string(r);
+            }
+            for (auto &[k, v] : kv)
+            {
+                runs[r].Append(k, v);
+                expect[k] = v;
+            }
+        }
+        std::vector<const StringRun *> inputs;
+        for (auto &run : runs)
+        {
+            inputs.push_back(&run);
+        }
+
+        for (ThreadPool *job_pool : {static_cast<ThreadPool *>(nullptr), &pool})
+        {
+            for (int subs : {1, 2, 4, 7})
+            {
+                StringCompaction job(inputs, RunStringComparator(), subs, nullptr, false, job_pool);
+                std::vector<StringRun> outputs = job.Execute();
+                EXPECT_EQ(job.GetStats().num_subcompactions, subs);
+                EXPECT_EQ(outputs.size(), static_cast<size_t>(subs));
+
+                std::vector<std::pair<string, string>> merged;
+                for (size_t i = 0; i < outputs.size(); ++i)
+                {
+                    if (i > 0)
+                    {
+                        // 输出之间按key范围递增且不重叠
+                        EXPECT_LT(outputs[i - 1].Largest(), outputs[i].Smallest());
+                    }
+                    merged.insert(merged.end(), outputs[i].entries.begin(), outputs[i].entries.end());
+                }
+                ASSERT_EQ(merged.size(), expect.size()) << "subs=" << subs;
+                size_t j = 0;
+                for (auto &[k, v] : expect)
+                {
+                    EXPECT_EQ(merged[j].first, k);
+                    EXPECT_EQ(merged[j].second, v);
+                    ++j;
+                }
+                EXPECT_EQ(job.GetStats().entries_written, expect.size());
+                uint64_t entries_read = 0;
+                for (auto &run : runs)
+                {
+                    entries_read += run.entries.size();
+                }
+                EXPECT_EQ(job.GetStats().entries_read, entries_read);
+            }
+        }
+    }
+
+    // Execute本身运行在唯一的低优先级线程上时，由它自己接手排队中的subcompaction，不会死锁
+    TEST(compaction, SubcompactionsOnBusyPool)
+    {
+        std::vector<StringRun> runs(2);
+        for (int i = 0; i < 4000; ++i)
+        {
+            runs[i % 2].Append(RunKey(i), std::to_string(i));
+        }
+        std::vector<const StringRun *> inputs = {&runs[0], &runs[1]};
+
+        ThreadPool pool(1, 1);
+        size_t written = 0;
+        int num_subs = 0;
+        CountDownLatch finished(1);
+        pool.Schedule([&]()
+                      {
+            StringCompaction job(inputs, RunStringComparator(), 4, nullptr, false, &pool);
+            for (const StringRun &out : job.Execute())
+            {
+                written += out.entries.size();
+            }
+            num_subs = job.GetStats().num_subcompactions;
+            finished.CountDown(); },
+                      Priority::kLow);
+        finished.Wait();
+        EXPECT_EQ(num_subs, 4);
+        EXPECT_EQ(written, 4000u);
+        pool.WaitForIdle(); // 认领失败的任务只访问共享状态
+    }
+
+    TEST(compaction, EmptyAndTinyInputs)
+    {
+        StringRun empty;
+        StringRun one;
+        one.Append("x", "1");
+        StringCompaction job({&empty, &one}, RunStringComparator(), 8);
+        std::vector<StringRun> outputs = job.Execute();
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0].entries[0].first, "x");
+        EXPECT_EQ(job.GetStats().num_subcompactions, 1);
+
+        StringCompaction none({&empty}, RunStringComparator(), 4);
+        EXPECT_TRUE(none.Execute().empty());
+    }
+
+    TEST(compaction, TieredPick)
+    {
+        TieredCompactionOptions opts;
+        opts.run_count_trigger = 4;
+        opts.size_ratio = 1;
+        opts.max_size_amplification_percent = 200;
+
+        // 段数不足
+        EXPECT_TRUE(PickTieredCompaction({10, 10, 1000}, opts).Empty());
+
+        // 新段总大小超过最旧段的200%：全量合并
+        TieredCompactionPick pick = PickTieredCompaction({100, 100, 100, 100}, opts);
+        EXPECT_EQ(pick.reason, CompactionReason::kSizeAmplification);
+        EXPECT_EQ(pick.start, 0u);
+        EXPECT_EQ(pick.count, 4u);
+
+        // 最新的三个段大小相近
+        pick = PickTieredCompaction({10, 10, 10, 1000}, opts);
+        EXPECT_EQ(pick.reason, CompactionReason::kSizeRatio);
+        EXPECT_EQ(pick.start, 0u);
+        EXPECT_EQ(pick.count, 3u);
+
+        // 大小相近的段不在最前面
+        pick = PickTieredCompaction({1, 60, 50, 1000}, opts);
+        EXPECT_EQ(pick.reason, CompactionReason::kSizeRatio);
+        EXPECT_EQ(pick.start, 1u);
+        EXPECT_EQ(pick.count, 2u);
+
+        // 大小逐段翻倍以上，只能按段数合并最新的段
+        pick = PickTieredCompaction({1, 3, 10, 30, 1000}, opts);
+        EXPECT_EQ(pick.reason, CompactionReason::kRunCount);
+        EXPECT_EQ(pick.start, 0u);
+        EXPECT_EQ(pick.count, 2u);
+
+        opts.max_merge_width = 2;
+        pick = PickTieredCompaction({10, 10, 10, 1000}, opts);
+        EXPECT_EQ(pick.count, 2u);
+    }
+
+    TEST(compaction, TieredNewestWins)
+    {
+        auto stats = std::make_shared<Statistics>();
+        TieredCompactionOptions opts;
+        opts.max_subcompactions = 2;
+        TieredCompaction<string, string, RunStringComparator> tiered(RunStringComparator(), opts, stats);
+
+        Random rnd(301);
+        std::map<string, string> expect;
+        for (int f = 0; f < 50; ++f)
+        {
+            std::map<string, string> kv;
+            for (int i = 0; i < 200; ++i)
+            {
+                kv[RunKey(rnd.Uniform(3000))] = "f" + std::to_string(f);
+            }
+            StringRun run;
+            run.id = f;
+            for (auto &[k, v] : kv)
+            {
+                run.Append(k, v);
+                expect[k] = v;
+            }
+            tiered.AddRun(std::move(run));
+            tiered.CompactUntilStable();
+            EXPECT_LT(tiered.GetRuns().size(), static_cast<size_t>(opts.run_count_trigger));
+        }
+
+        for (auto &[k, v] : expect)
+        {
+            ASSERT_EQ(tiered.Get(k), v);
+        }
+        EXPECT_EQ(tiered.Get("missing"), std::nullopt);
+        // 从新到旧排列
+        auto &runs = tiered.GetRuns();
+        for (size_t i = 1; i < runs.size(); ++i)
+        {
+            EXPECT_GT(runs[i - 1].id, runs[i].id);
+        }
+
+        TieredCompactionStats s = tiered.GetStats();
+        EXPECT_GT(s.num_compactions, 0u);
+        EXPECT_GT(s.WriteAmplification(), 1.0);
+        EXPECT_GE(s.SpaceAmplification(), 1.0);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kFlushBytesWritten), s.bytes_flushed);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kCompactionBytesWritten), s.bytes_compaction_written);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kCompactionBytesRead), s.bytes_compaction_read);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kCompactions), s.num_compactions);
+    }
+
+    using StringTiered = TieredCompaction<string, string, RunStringComparator>;
+
+    // 合并进行中时加入一个更新的有序段，模拟后台flush
+    class AddRunFilter : public CompactionFilter<string, string>
+    {
+    public:
+        explicit AddRunFilter(StringTiered *tiered) : tiered_(tiered) {}
+
+        Decision Filter(const Context & /*ctx*/, const string & /*key*/, const string & /*value*/,
+                        string * /*new_value*/) const override
+        {
+            if (tiered_ != nullptr)
+            {
+                StringRun run;
+                run.id = 100;
+                run.Append("new", "flushed");
+                StringTiered *tiered = tiered_;
+                tiered_ = nullptr;
+                tiered->AddRun(std::move(run));
+            }
+            return Decision::kKeep;
+        }
+
+        const char *Name() const override { return "AddRunFilter"; }
+
+    private:
+        mutable StringTiered *tiered_;
+    };
+
+    // 合并期间最前面加入了新段，结果按输入段的编号安装，新段保留在最前面
+    TEST(compaction, TieredAddRunDuringCompaction)
+    {
+        SharedMutexLock mu;
+        StringTiered tiered{RunStringComparator()};
+        tiered.SetRunsMutex(&mu);
+        for (int f = 1; f <= 4; ++f)
+        {
+            StringRun run;
+            run.id = f;
+            run.Append(RunKey(f), "v" + std::to_string(f));
+            tiered.AddRun(std::move(run));
+        }
+        tiered.SetCompactionFilter(std::make_shared<AddRunFilter>(&tiered));
+        ASSERT_NE(tiered.MaybeCompact(), CompactionReason::kNone);
+
+        auto &runs = tiered.GetRuns();
+        ASSERT_GE(runs.size(), 2u);
+        EXPECT_EQ(runs[0].id, 100u);
+        for (size_t i = 1; i < runs.size(); ++i)
+        {
+            EXPECT_GT(runs[i - 1].id, runs[i].id);
+        }
+        EXPECT_EQ(tiered.Get("new"), "flushed");
+        for (int f = 1; f <= 4; ++f)
+        {
+            EXPECT_EQ(tiered.Get(RunKey(f)), "v" + std::to_string(f));
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 13:41:09
+ * @LastEditTime: 2026-10-18 13:41:09
+ * @FilePath: /miniKV/test/test_crc32c.cc
+ * @Description:  CRC32C模块测试
+ *
+ * ********************************
+ *  标准测试向量来自 RFC 3720 B.4 以及leveldb crc32c_test
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstring>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/random.h"
+#include "../src/utils/crc32c.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    TEST(crc32c, StandardResults)
+    {
+        char buf[32];
+
+        memset(buf, 0, sizeof(buf));
+        EXPECT_EQ(0x8a9136aau, crc32c::Value(buf, sizeof(buf)));
+
+        memset(buf, 0xff, sizeof(buf));
+        EXPECT_EQ(0x62a8ab43u, crc32c::Value(buf, sizeof(buf)));
+
+        for (int i = 0; i < 32; ++i)
+        {
+            buf[i] = static_cast<char>(i);
+        }
+        EXPECT_EQ(0x46dd794eu, crc32c::Value(buf, sizeof(buf)));
+
+        for (int i = 0; i < 32; ++i)
+        {
+            buf[i] = static_cast<char>(31 - i);
+        }
+        EXPECT_EQ(0x113fdb5cu, crc32c::Value(buf, sizeof(buf)));
+
+        uint8_t data[48] = {
+            0x01, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+            0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18, 0x28, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        };
+        EXPECT_EQ(0xd9963a56u, crc32c::Value(reinterpret_cast<char *>(data), sizeof(data)));
+
+        EXPECT_EQ(0xe3069283u, crc32c::Value("123456789", 9));
+        EXPECT_EQ(0xe3069283u, crc32c::ExtendPortable(0, "123456789", 9));
+    }
+
+    TEST(crc32c, Values)
+    {
+        EXPECT_NE(crc32c::Value("a", 1), crc32c::Value("foo", 3));
+    }
+
+    TEST(crc32c, Extend)
+    {
+        EXPECT_EQ(crc32c::Value("hello world", 11),
+                  crc32c::Extend(crc32c::Value("hello ", 6), "world", 5));
+    }
+
+    TEST(crc32c, Mask)
+    {
+        uint32_t crc = crc32c::Value("foo", 3);
+        EXPECT_NE(crc, crc32c::Mask(crc));
+        EXPECT_NE(crc, crc32c::Mask(crc32c::Mask(crc)));
+        EXPECT_EQ(crc, crc32c::Unmask(crc32c::Mask(crc)));
+        EXPECT_EQ(crc, crc32c::Unmask(crc32c::Unmask(crc32c::Mask(crc32c::Mask(crc)))));
+    }
+
+    // 覆盖三路交织的长/短分段边界、非对齐起始地址，并与软件实现对比
+    TEST(crc32c, LargeBuffersMatchPortable)
+    {
+        Random rnd(2023);
+        std::string buf(3 * 8192 * 2 + 3 * 256 + 100, '\0');
+        for (auto &c : buf)
+        {
+            c = static_cast<char>(rnd.Uniform(256));
+        }
+        const size_t lens[] = {0, 1, 7, 8, 255, 768, 769, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 3 * 256 + 9, buf.size() - 8};
+        for (size_t offset = 0; offset < 8; ++offset)
+        {
+            for (size_t len : lens)
+            {
+                const char *p = buf.data() + offset;
+                uint32_t expect = crc32c::ExtendPortable(0, p, len);
+                EXPECT_EQ(expect, crc32c::Value(p, len)) << "offset=" << offset << " len=" << len;
+
+                // 增量计算结果与一次计算一致
+                size_t half = len / 3;
+                EXPECT_EQ(expect, crc32c::Extend(crc32c::Value(p, half), p + half, len - half));
+            }
+        }
+    }
+}
@@ -0,0 +1,658 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-22 09:30:18
+ * @LastEditTime: 2026-10-24 14:37:52
+ * @FilePath: /miniKV/test/test_db.cc
+ * @Description:  列族、WriteBatch、WAL恢复、后台flush、kv分离与DB日志测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "../src/compaction/compaction_filter.h"
+#include "../src/db/db.h"
+#include "../src/db/wal.h"
+#include "../src/db/write_batch.h"
+#include "../src/utils/rate_limiter.h"
+#include "../src/utils/statistics.h"
+#include "../src/utils/thread_pool.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    // 逆序比较，用来验证列族各自使用自己的Comparator
+    struct ReverseComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return b.compare(a);
+        }
+    };
+
+    static string WalPath(const char *name)
+    {
+        return string("/tmp/minikvdb_wal_") + name + "_" + to_string(getpid());
+    }
+
+    // 每次打开DB都需要按相同顺序创建列族
+    static std::unique_ptr<DB> OpenDB(const string &wal, std::shared_ptr<Statistics> stats = nullptr)
+    {
+        DBOptions options;
+        options.wal_path = wal;
+        options.stats = stats;
+        auto db = std::make_unique<DB>(options);
+        ColumnFamilyOptions small;
+        small.write_buffer_size = 4096;
+        db->CreateColumnFamily("users", small);
+        db->CreateColumnFamily<ReverseComparator>("events", ColumnFamilyOptions());
+        return db->Open() ? std::move(db) : nullptr;
+    }
+
+    class RecordHandler : public WriteBatch::Handler
+    {
+    public:
+        void Put(uint32_t cf_id, const Slice &key, const Slice &value) override
+        {
+            out += "P" + to_string(cf_id) + ":" + key.ToString() + "=" + value.ToString() + ";";
+        }
+
+        void Delete(uint32_t cf_id, const Slice &key) override
+        {
+            out += "D" + to_string(cf_id) + ":" + key.ToString() + ";";
+        }
+
+        string out;
+    };
+
+    TEST(db, WriteBatchEncoding)
+    {
+        WriteBatch batch;
+        batch.Put(0, "a", "1");
+        batch.Delete(2, "b");
+        batch.Put(1, "", "");
+        batch.SetSequence(42);
+        EXPECT_EQ(batch.Count(), 3u);
+        EXPECT_EQ(batch.Sequence(), 42u);
+
+        WriteBatch copy;
+        ASSERT_TRUE(copy.SetData(batch.Data()));
+        RecordHandler handler;
+        ASSERT_TRUE(copy.Iterate(&handler));
+        EXPECT_EQ(handler.out, "P0:a=1;D2:b;P1:=;");
+
+        // 截断的批次
+        string data = batch.Data();
+        data.pop_back();
+        ASSERT_TRUE(copy.SetData(data));
+        EXPECT_FALSE(copy.Iterate(&handler));
+        EXPECT_FALSE(copy.SetData("short"));
+    }
+
+    TEST(db, WalTornTail)
+    {
+        const string path = WalPath("torn");
+        unlink(path.c_str());
+        {
+            WalWriter writer;
+            ASSERT_TRUE(writer.Open(path));
+            ASSERT_TRUE(writer.AddRecord("first", false));
+            ASSERT_TRUE(writer.AddRecord(string(10000, 'x'), true));
+            ASSERT_TRUE(writer.AddRecord("third", false));
+        }
+        ASSERT_EQ(truncate(path.c_str(), 8 + 5 + 8 + 10000 + 6), 0);
+
+        WalReader reader;
+        ASSERT_TRUE(reader.Open(path));
+        string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        EXPECT_EQ(record, "first");
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        EXPECT_EQ(record.size(), 10000u);
+        EXPECT_FALSE(reader.ReadRecord(&record));
+        EXPECT_TRUE(reader.IsTruncated());
+        EXPECT_EQ(reader.GetValidSize(), 8u + 5 + 8 + 10000);
+        unlink(path.c_str());
+    }
+
+    // 中间记录校验失败不是崩溃造成的，默认打开失败，显式容忍时才丢弃损坏处之后的内容
+    TEST(db, WalMidFileCorruption)
+    {
+        const string path = WalPath("corrupt");
+        unlink(path.c_str());
+        {
+            auto db = OpenDB(path);
+            ASSERT_NE(db, nullptr);
+            ColumnFamily *users = db->GetColumnFamily("users");
+            ASSERT_TRUE(db->Put(users, "k1", "v1"));
+            ASSERT_TRUE(db->Put(users, "k2", "v2"));
+            ASSERT_TRUE(db->Put(users, "k3", "v3"));
+        }
+        uint32_t first = 0;
+        {
+            fstream file(path, ios::in | ios::out | ios::binary);
+            file.seekg(4);
+            file.read(reinterpret_cast<char *>(&first), sizeof(first));
+            // 翻转第二条记录payload的第一个字节
+            const streamoff offset = WalWriter::kHeaderSize + first + WalWriter::kHeaderSize;
+            char c;
+            file.seekg(offset);
+            file.get(c);
+            file.seekp(offset);
+            file.put(static_cast<char>(c ^ 0x5a));
+        }
+        const uintmax_t size = std::filesystem::file_size(path);
+
+        WalReader reader;
+        ASSERT_TRUE(reader.Open(path));
+        string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        EXPECT_FALSE(reader.ReadRecord(&record));
+        EXPECT_TRUE(reader.IsCorrupted());
+        EXPECT_FALSE(reader.IsTruncated());
+        EXPECT_EQ(reader.GetValidSize(), WalWriter::kHeaderSize + first);
+
+        // 默认打开失败，WAL保持原样
+        EXPECT_EQ(OpenDB(path), nullptr);
+        EXPECT_EQ(std::filesystem::file_size(path), size);
+
+        DBOptions options;
+        options.wal_path = path;
+        options.wal_tolerate_corruption = true;
+        DB db(options);
+        ColumnFamilyOptions small;
+        small.write_buffer_size = 4096;
+        ColumnFamily *users = db.CreateColumnFamily("users", small);
+        db.CreateColumnFamily<ReverseComparator>("events", ColumnFamilyOptions());
+        ASSERT_TRUE(db.Open());
+        EXPECT_EQ(std::filesystem::file_size(path), WalWriter::kHeaderSize + first);
+        string value;
+        ASSERT_TRUE(db.Get(users, "k1", &value));
+        EXPECT_EQ(value, "v1");
+        EXPECT_FALSE(db.Get(users, "k2", &value));
+        EXPECT_FALSE(db.Get(users, "k3", &value));
+        unlink(path.c_str());
+    }
+
+    TEST(db, ColumnFamiliesAreIndependent)
+    {
+        const string path = WalPath("cf");
+        unlink(path.c_str());
+        auto db = OpenDB(path);
+        ASSERT_NE(db, nullptr);
+        ColumnFamily *users = db->GetColumnFamily("users");
+        ColumnFamily *events = db->GetColumnFamily("events");
+        ASSERT_NE(users, nullptr);
+        ASSERT_NE(events, nullptr);
+        EXPECT_EQ(db->CreateColumnFamily("late"), nullptr);
+
+        ASSERT_TRUE(db->Put(users, "k", "user"));
+        ASSERT_TRUE(db->Put(events, "k", "event"));
+        ASSERT_TRUE(db->Put(db->DefaultColumnFamily(), "k", "default"));
+        string value;
+        ASSERT_TRUE(db->Get(users, "k", &value));
+        EXPECT_EQ(value, "user");
+        ASSERT_TRUE(db->Get(events, "k", &value));
+        EXPECT_EQ(value, "event");
+        ASSERT_TRUE(db->Get(db->DefaultColumnFamily(), "k", &value));
+        EXPECT_EQ(value, "default");
+
+        // 覆盖与删除
+        ASSERT_TRUE(db->Put(users, "k", "user2"));
+        ASSERT_TRUE(db->Get(users, "k", &value));
+        EXPECT_EQ(value, "user2");
+        ASSERT_TRUE(db->Delete(events, "k"));
+        EXPECT_FALSE(db->Get(events, "k", &value));
+        EXPECT_EQ(db->GetLatestSequence(), 5u);
+        unlink(path.c_str());
+    }
+
+    TEST(db, DeleteShadowsFlushedData)
+    {
+        auto db = OpenDB("");
+        ASSERT_NE(db, nullptr);
+        ColumnFamily *cf = db->DefaultColumnFamily();
+        ASSERT_TRUE(db->Put(cf, "a", "1"));
+        ASSERT_TRUE(db->Put(cf, "b", "2"));
+        ASSERT_TRUE(db->Flush(cf));
+        EXPECT_EQ(cf->GetNumRuns(), 1u);
+
+        ASSERT_TRUE(db->Delete(cf, "a"));
+        ASSERT_TRUE(db->Put(cf, "b", "3"));
+        string value;
+        EXPECT_FALSE(db->Get(cf, "a", &value));
+        ASSERT_TRUE(db->Get(cf, "b", &value));
+        EXPECT_EQ(value, "3");
+
+        // 删除标记随flush进入有序段，仍然遮住旧版本
+        ASSERT_TRUE(db->Flush(cf));
+        EXPECT_FALSE(db->Get(cf, "a", &value));
+        ASSERT_TRUE(db->Get(cf, "b", &value));
+        EXPECT_EQ(value, "3");
+    }
+
+    TEST(db, AtomicBatchAndRecovery)
+    {
+        const string path = WalPath("recover");
+        unlink(path.c_str());
+        auto stats = std::make_shared<Statistics>();
+        {
+            auto db = OpenDB(path, stats);
+            ASSERT_NE(db, nullptr);
+            ColumnFamily *users = db->GetColumnFamily("users");
+            ColumnFamily *events = db->GetColumnFamily("events");
+            for (int i = 0; i < 500; ++i)
+            {
+                // users的write_buffer_size很小，会触发多次flush与compaction
+                WriteBatch batch;
+                batch.Put(users->GetID(), "user" + to_string(i), string(100, 'u'));
+                batch.Put(events->GetID(), "event" + to_string(i), to_string(i));
+                ASSERT_TRUE(db->Write(&batch));
+                EXPECT_EQ(batch.Sequence(), 2u * i + 1);
+            }
+            ASSERT_TRUE(db->Delete(users, "user7"));
+            db->WaitForBackgroundWork();
+            EXPECT_GT(users->GetNumRuns(), 0u);
+
+            // 引用不存在列族的批次整批拒绝
+            WriteBatch bad;
+            bad.Put(users->GetID(), "never", "x");
+            bad.Put(99, "k", "v");
+            EXPECT_FALSE(db->Write(&bad));
+            string value;
+            EXPECT_FALSE(db->Get(users, "never", &value));
+        }
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kWalSyncs), 0u);
+        EXPECT_GT(stats->GetTickerCount(Ticker::kWalBytes), 500u * 100);
+
+        // 模拟崩溃时写了一半的记录
+        {
+            FILE *f = fopen(path.c_str(), "ab");
+            fwrite("\x01\x02\x03", 1, 3, f);
+            fclose(f);
+        }
+        {
+            auto db = OpenDB(path);
+            ASSERT_NE(db, nullptr);
+            EXPECT_EQ(db->GetLatestSequence(), 1001u);
+            ColumnFamily *users = db->GetColumnFamily("users");
+            ColumnFamily *events = db->GetColumnFamily("events");
+            string value;
+            for (int i = 0; i < 500; ++i)
+            {
+                EXPECT_EQ(db->Get(users, "user" + to_string(i), &value), i != 7);
+                ASSERT_TRUE(db->Get(events, "event" + to_string(i), &value));
+                EXPECT_EQ(value, to_string(i));
+            }
+            ASSERT_TRUE(db->Put(events, "after", "restart"));
+        }
+        {
+            auto db = OpenDB(path);
+            ASSERT_NE(db, nullptr);
+            string value;
+            ASSERT_TRUE(db->Get(db->GetColumnFamily("events"), "after", &value));
+            EXPECT_EQ(value, "restart");
+            EXPECT_EQ(db->GetLatestSequence(), 1002u);
+        }
+        unlink(path.c_str());
+    }
+
+    // flush在后台执行，写入线程不等待；flush完成前immutable memtable仍可读
+    TEST(db, BackgroundFlushKeepsImmutableReadable)
+    {
+        auto pool = std::make_shared<ThreadPool>(1, 1);
+        // 占住唯一的高优先级线程，flush只能排队
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        pool->Schedule([&started, &release]
+                       {
+            started.store(true);
+            while (!release.load())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } },
+                       Priority::kHigh);
+        while (!started.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        DBOptions options;
+        options.thread_pool = pool;
+        DB db(options);
+        ColumnFamilyOptions small;
+        small.write_buffer_size = 4096;
+        ColumnFamily *cf = db.CreateColumnFamily("small", small);
+        ASSERT_TRUE(db.Open());
+
+        int written = 0;
+        while (pool->GetQueueLen(Priority::kHigh) == 0)
+        {
+            ASSERT_TRUE(db.Put(cf, "key" + to_string(written), string(100, 'v')));
+            ++written;
+        }
+        ASSERT_GT(written, 1);
+        ASSERT_TRUE(db.Delete(cf, "key0"));
+        EXPECT_EQ(cf->GetNumRuns(), 0u);
+        string value;
+        EXPECT_FALSE(db.Get(cf, "key0", &value));
+        for (int i = 1; i < written; ++i)
+        {
+            ASSERT_TRUE(db.Get(cf, "key" + to_string(i), &value)) << i;
+            EXPECT_EQ(value, string(100, 'v'));
+        }
+
+        release.store(true);
+        db.WaitForBackgroundWork();
+        EXPECT_EQ(cf->GetNumRuns(), 1u);
+        EXPECT_FALSE(db.Get(cf, "key0", &value));
+        for (int i = 1; i < written; ++i)
+        {
+            ASSERT_TRUE(db.Get(cf, "key" + to_string(i), &value)) << i;
+        }
+    }
+
+    // 第一次在compaction中被调用时阻塞，直到Release
+    class BlockingCompactionFilter : public CompactionFilter<string, string>
+    {
+    public:
+        Decision Filter(const Context &ctx, const string & /*key*/, const string & /*value*/,
+                        string * /*new_value*/) const override
+        {
+            if (!ctx.is_flush && !entered_.exchange(true))
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this]
+                         { return released_; });
+            }
+            return Decision::kKeep;
+        }
+
+        const char *Name() const override { return "BlockingCompactionFilter"; }
+
+        bool Entered() const { return entered_.load(); }
+
+        void Release()
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            released_ = true;
+            cv_.notify_all();
+        }
+
+    private:
+        mutable std::atomic<bool> entered_{false};
+        mutable std::mutex mu_;
+        mutable std::condition_variable cv_;
+        bool released_ = false;
+    };
+
+    // 最多等待5秒
+    static bool WaitUntil(const std::function<bool()> &pred)
+    {
+        for (int i = 0; i < 5000 && !pred(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pred();
+    }
+
+    // compaction很慢时flush不等待它，写停顿也不在持有DB锁时等待，读不被阻塞
+    TEST(db, FlushDoesNotWaitForCompaction)
+    {
+        auto filter = std::make_shared<BlockingCompactionFilter>();
+        DBOptions db_options;
+        DB db(db_options);
+        ColumnFamilyOptions options;
+        options.write_buffer_size = 4096;
+        options.compaction.run_count_trigger = 2;
+        options.compaction_filter = filter;
+        ColumnFamily *cf = db.CreateColumnFamily("slow", options);
+        ASSERT_TRUE(db.Open());
+        ASSERT_TRUE(db.Put(cf, "first", "v"));
+
+        const int kMoreKeys = 2000;
+        std::atomic<int> next{0};
+        std::atomic<bool> written{false};
+        std::thread writer([&]
+                           {
+                               // 写到第二个有序段加入、compaction阻塞在filter中为止，之后再写约50个memtable
+                               int stop = -1;
+                               for (int i = 0; i < 100000 && (stop < 0 || i < stop); ++i)
+                               {
+                                   EXPECT_TRUE(db.Put(cf, "key" + to_string(i), string(100, 'v')));
+                                   next = i + 1;
+                                   if (stop < 0 && filter->Entered())
+                                   {
+                                       stop = i + 1 + kMoreKeys;
+                                   }
+                               }
+                               written = true; });
+        EXPECT_TRUE(WaitUntil([&]
+                              { return filter->Entered(); }));
+        // 这些写入需要多次flush，都在compaction阻塞期间完成
+        EXPECT_TRUE(WaitUntil([&]
+                              { return written.load(); }));
+        std::atomic<bool> read{false};
+        std::thread reader([&]
+                           {
+                               string value;
+                               EXPECT_TRUE(db.Get(cf, "first", &value));
+                               read = true; });
+        EXPECT_TRUE(WaitUntil([&]
+                              { return read.load(); }));
+
+        filter->Release();
+        writer.join();
+        reader.join();
+        db.WaitForBackgroundWork();
+        // 合并期间加入的新段在安装结果后仍然可读
+        string value;
+        for (int i = 0; i < next; ++i)
+        {
+            ASSERT_TRUE(db.Get(cf, "key" + to_string(i), &value)) << i;
+        }
+    }
+
+    static string BlobDir(const char *name)
+    {
+        string dir = string("/tmp/minikvdb_blob_") + name + "_" + to_string(getpid());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    static size_t CountFiles(const string &dir)
+    {
+        return static_cast<size_t>(std::distance(std::filesystem::directory_iterator(dir),
+                                                 std::filesystem::directory_iterator()));
+    }
+
+    // flush与compaction后按最旧段以外的有序段大小调整限速器的速率，WAL写入经过同一个限速器
+    TEST(db, RateLimiterTracksCompactionDebt)
+    {
+        const string path = WalPath("limiter");
+        unlink(path.c_str());
+        DBOptions options;
+        options.wal_path = path;
+        options.rate_limiter = std::make_shared<RateLimiter>(100 << 20, 100 * 1000, 10, true);
+        DB db(options);
+        ASSERT_TRUE(db.Open());
+        ColumnFamily *cf = db.DefaultColumnFamily();
+        const int64_t min_rate = (100 << 20) / 20;
+
+        // 只有一个有序段时没有欠账
+        ASSERT_TRUE(db.Put(cf, "a", string(1000, 'a')));
+        ASSERT_TRUE(db.Flush(cf));
+        EXPECT_EQ(options.rate_limiter->GetBytesPerSecond(), min_rate);
+
+        ASSERT_TRUE(db.Put(cf, "b", string(1000, 'b')));
+        ASSERT_TRUE(db.Flush(cf));
+        ASSERT_EQ(cf->GetNumRuns(), 2u);
+        EXPECT_GT(options.rate_limiter->GetBytesPerSecond(), min_rate);
+
+        // WAL写入以高优先级申请令牌
+        EXPECT_EQ(options.rate_limiter->GetTotalBytesThrough(Priority::kHigh),
+                  static_cast<int64_t>(std::filesystem::file_size(path)));
+        unlink(path.c_str());
+    }
+
+    TEST(db, BlobSeparation)
+    {
+        const string dir = BlobDir("separation");
+        auto stats = std::make_shared<Statistics>();
+        DBOptions options;
+        options.stats = stats;
+        options.rate_limiter = std::make_shared<RateLimiter>(1 << 30);
+        DB db(options);
+        ColumnFamilyOptions cf_options;
+        cf_options.enable_blob_files = true;
+        cf_options.min_blob_size = 1024;
+        cf_options.blob_dir = dir;
+        ColumnFamily *cf = db.CreateColumnFamily("blobs", cf_options);
+        ASSERT_NE(cf, nullptr);
+        ASSERT_TRUE(db.Open());
+
+        ASSERT_TRUE(db.Put(cf, "large", string(4096, 'L')));
+        ASSERT_TRUE(db.Put(cf, "small", "s"));
+        ASSERT_TRUE(db.Flush(cf));
+
+        // 有序段中只剩引用，value在blob文件中
+        EXPECT_LT(cf->GetCompactionStats().total_bytes, 1024u);
+        BlobStorageStats blob_stats = cf->GetBlobStats();
+        EXPECT_EQ(blob_stats.num_files, 1u);
+        EXPECT_EQ(blob_stats.total_bytes, 4096u);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBlobBytesWritten), 4096u);
+        // blob文件写入使用DB的限速器，flush时以高优先级申请令牌
+        EXPECT_EQ(options.rate_limiter->GetTotalBytesThrough(Priority::kHigh), 4096);
+        EXPECT_EQ(options.rate_limiter->GetTotalBytesThrough(Priority::kLow), 0);
+
+        string value;
+        ASSERT_TRUE(db.Get(cf, "large", &value));
+        EXPECT_EQ(value, string(4096, 'L'));
+        ASSERT_TRUE(db.Get(cf, "small", &value));
+        EXPECT_EQ(value, "s");
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBlobBytesRead), 4096u);
+
+        // 未开启kv分离的列族不产生blob文件
+        EXPECT_EQ(db.DefaultColumnFamily()->GetBlobStats().num_files, 0u);
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST(db, BlobGarbageCollection)
+    {
+        const string dir = BlobDir("gc");
+        DB db{DBOptions()};
+        ColumnFamilyOptions cf_options;
+        cf_options.enable_blob_files = true;
+        cf_options.min_blob_size = 1024;
+        cf_options.blob_file_size = 16 << 10; // 每个文件两个value
+        cf_options.blob_dir = dir;
+        cf_options.compaction.run_count_trigger = 2;
+        cf_options.rate_limiter = std::make_shared<RateLimiter>(1 << 30);
+        ColumnFamily *cf = db.CreateColumnFamily("blobs", cf_options);
+        ASSERT_TRUE(db.Open());
+
+        const size_t kValueSize = 8 << 10;
+        for (int i = 0; i < 8; ++i)
+        {
+            ASSERT_TRUE(db.Put(cf, "key" + to_string(i), string(kValueSize, 'a' + i)));
+        }
+        ASSERT_TRUE(db.Flush(cf));
+        EXPECT_EQ(cf->GetBlobStats().num_files, 4u);
+
+        // 覆盖一半的key，合并后旧文件各有一半垃圾，存活的value被搬走
+        for (int i = 0; i < 8; i += 2)
+        {
+            ASSERT_TRUE(db.Put(cf, "key" + to_string(i), string(kValueSize, 'A' + i)));
+        }
+        ASSERT_TRUE(db.Flush(cf));
+        EXPECT_EQ(cf->GetNumRuns(), 1u);
+
+        BlobStorageStats blob_stats = cf->GetBlobStats();
+        EXPECT_EQ(blob_stats.gc_files, 4u);
+        EXPECT_EQ(blob_stats.gc_relocated, 4 * kValueSize);
+        EXPECT_EQ(blob_stats.total_bytes, 8 * kValueSize);
+        EXPECT_EQ(blob_stats.GarbageBytes(), 0u);
+        EXPECT_EQ(CountFiles(dir), blob_stats.num_files);
+        // flush写入的blob以高优先级、GC搬迁以低优先级申请令牌
+        EXPECT_EQ(cf_options.rate_limiter->GetTotalBytesThrough(Priority::kHigh), static_cast<int64_t>(12 * kValueSize));
+        EXPECT_EQ(cf_options.rate_limiter->GetTotalBytesThrough(Priority::kLow), static_cast<int64_t>(4 * kValueSize));
+
+        string value;
+        for (int i = 0; i < 8; ++i)
+        {
+            ASSERT_TRUE(db.Get(cf, "key" + to_string(i), &value));
+            EXPECT_EQ(value, string(kValueSize, (i % 2 == 0 ? 'A' : 'a') + i));
+        }
+
+        // 删除后合并到最旧的段，引用全部消失，除当前文件外都被回收
+        for (int i = 0; i < 8; ++i)
+        {
+            ASSERT_TRUE(db.Delete(cf, "key" + to_string(i)));
+        }
+        ASSERT_TRUE(db.Flush(cf));
+        EXPECT_EQ(cf->GetBlobStats().num_files, 1u);
+        EXPECT_FALSE(db.Get(cf, "key0", &value));
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST(db, InfoLogEvents)
+    {
+        const string path = WalPath("info_log");
+        const string dir = "/tmp/minikvdb_info_log_" + to_string(getpid());
+        unlink(path.c_str());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+
+        auto info_log = std::make_shared<Log>();
+        ASSERT_TRUE(info_log->init((dir + "/LOG").c_str(), 0));
+        {
+            DBOptions options;
+            options.wal_path = path;
+            options.info_log = info_log;
+            DB db(options);
+            ASSERT_TRUE(db.Open());
+            ColumnFamily *cf = db.DefaultColumnFamily();
+            ASSERT_TRUE(db.Put(cf, "a", "1"));
+            ASSERT_TRUE(db.Flush(cf));
+        }
+        // 重新打开时记录重放的WAL记录数
+        {
+            DBOptions options;
+            options.wal_path = path;
+            options.info_log = info_log;
+            DB db(options);
+            ASSERT_TRUE(db.Open());
+        }
+
+        ifstream in(info_log->get_file_name());
+        vector<string> lines;
+        string line;
+        while (getline(in, line))
+        {
+            lines.push_back(line);
+        }
+        ASSERT_EQ(lines.size(), 3u);
+        EXPECT_NE(lines[0].find("event=db.open wal=" + path + " column_families=1 wal_records=0"), string::npos);
+        EXPECT_NE(lines[1].find("event=flush cf=default reason=manual run_id=1"), string::npos);
+        EXPECT_NE(lines[1].find("runs=1"), string::npos);
+        EXPECT_NE(lines[2].find("event=db.open"), string::npos);
+        EXPECT_NE(lines[2].find("wal_records=1 wal_truncated=false last_sequence=1"), string::npos);
+
+        unlink(path.c_str());
+        std::filesystem::remove_all(dir);
+    }
+}
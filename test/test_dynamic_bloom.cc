@@ -0,0 +1,127 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 19:55:20
+ * @LastEditTime: 2026-10-19 19:55:20
+ * @FilePath: /miniKV/test/test_dynamic_bloom.cc
+ * @Description:  布隆过滤器及MemTable布隆过滤器测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/memtable.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/utils/dynamic_bloom.h"
+#include "../src/utils/statistics.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct BloomStringComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using BloomTable = MemTable<string, string, BloomStringComparator>;
+
+    // 约10bit/key时误判率应在1%左右，且不能漏判
+    TEST(dynamic_bloom, FalsePositiveRate)
+    {
+        const int n = 100000;
+        DynamicBloom bloom(n * 10 / 8);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            bloom.AddHash(MixHash64(i));
+        }
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            ASSERT_TRUE(bloom.MayContainHash(MixHash64(i))) << i;
+        }
+        int fp = 0;
+        for (uint64_t i = n; i < 2 * n; ++i)
+        {
+            fp += bloom.MayContainHash(MixHash64(i));
+        }
+        double rate = static_cast<double>(fp) / n;
+        EXPECT_LT(rate, 0.02);
+        EXPECT_NEAR(bloom.EstimatedFpRate(n), 0.0084, 0.001);
+        EXPECT_EQ(bloom.GetMemUsage(), static_cast<size_t>(n * 10 / 8 + 63) / 64 * 64);
+    }
+
+    TEST(dynamic_bloom, ConcurrentAdd)
+    {
+        DynamicBloom bloom(64 * 1024);
+        std::vector<std::thread> threads;
+        for (uint64_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&bloom, t]()
+                                 {
+                for (uint64_t i = t; i < 40000; i += 4)
+                {
+                    bloom.AddHash(MixHash64(i));
+                } });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        for (uint64_t i = 0; i < 40000; ++i)
+        {
+            ASSERT_TRUE(bloom.MayContainHash(MixHash64(i))) << i;
+        }
+    }
+
+    TEST(dynamic_bloom, MemTableFullKey)
+    {
+        auto stats = std::make_shared<Statistics>();
+        BloomTable table(BloomStringComparator(), std::make_shared<DefaultAlloc>());
+        table.SetStatistics(stats);
+        table.EnableBloomFilter(16 * 1024);
+        EXPECT_EQ(table.GetBloomMemUsage(), 16u * 1024);
+        for (int i = 0; i < 1000; ++i)
+        {
+            table.Insert("key" + std::to_string(i), "v");
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            EXPECT_EQ(table.Get("key" + std::to_string(i)), "v");
+            EXPECT_TRUE(table.Contains("key" + std::to_string(i)));
+        }
+        for (int i = 1000; i < 2000; ++i)
+        {
+            EXPECT_EQ(table.Get("key" + std::to_string(i)), std::nullopt);
+        }
+        uint64_t useful = stats->GetTickerCount(Ticker::kBloomFilterUseful);
+        uint64_t positive = stats->GetTickerCount(Ticker::kBloomFilterPositive);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBloomFilterTruePositive), 2000u);
+        EXPECT_EQ(useful + positive, 3000u);
+        EXPECT_GT(useful, 950u);
+    }
+
+    // 前缀过滤器：前缀不存在的key不会走到底层查找
+    TEST(dynamic_bloom, MemTablePrefix)
+    {
+        auto stats = std::make_shared<Statistics>();
+        BloomTable table(BloomStringComparator(), std::make_shared<DefaultAlloc>(), MemTableRepType::kHashSkipList, 16);
+        table.SetStatistics(stats);
+        table.EnableBloomFilter(4 * 1024, FixedPrefixBloomHash(4));
+        for (int i = 0; i < 100; ++i)
+        {
+            table.Insert("usr:" + std::to_string(i), "v");
+        }
+        EXPECT_EQ(table.Get("usr:7"), "v");
+        EXPECT_EQ(table.Get("usr:100"), std::nullopt); // 前缀存在，需要查找
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBloomFilterUseful), 0u);
+        EXPECT_EQ(table.Get("job:7"), std::nullopt);
+        EXPECT_FALSE(table.Contains("job:8"));
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBloomFilterUseful), 2u);
+    }
+}
@@ -0,0 +1,179 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 19:10:26
+ * @LastEditTime: 2026-10-18 19:10:26
+ * @FilePath: /miniKV/test/test_epoch.cc
+ * @Description:  epoch内存回收测试，包含跳表并发删除/读取压力测试
+ *
+ * ********************************
+ *  建议以 -DMINIKVDB_SANITIZER=address 构建后运行，ASan会捕获任何use-after-free
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/memory/default_alloc.h"
+#include "../src/memory/epoch.h"
+#include "../src/memtable/random.h"
+#include "../src/memtable/skiplist.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    static std::atomic<int> g_destroyed{0};
+
+    static void CountingDelete(void *p)
+    {
+        delete static_cast<int *>(p);
+        g_destroyed.fetch_add(1);
+    }
+
+    // 读者处于临界区时，retire的对象不能被释放；读者退出后可以被回收
+    TEST(epoch, RetireWaitsForReaders)
+    {
+        EpochManager *mgr = EpochManager::get_instance();
+        while (mgr->PendingCount() > 0)
+        {
+            mgr->TryReclaim();
+        }
+        g_destroyed.store(0);
+
+        std::atomic<bool> entered{false};
+        std::atomic<bool> release{false};
+        std::thread reader([&]()
+                           {
+            EpochGuard guard;
+            entered.store(true);
+            while (!release.load())
+            {
+                std::this_thread::yield();
+            } });
+        while (!entered.load())
+        {
+            std::this_thread::yield();
+        }
+
+        mgr->Retire(new int(1), CountingDelete);
+        for (int i = 0; i < 10; ++i)
+        {
+            mgr->TryReclaim();
+        }
+        EXPECT_EQ(g_destroyed.load(), 0);
+        EXPECT_EQ(mgr->PendingCount(), 1u);
+
+        release.store(true);
+        reader.join();
+        for (int i = 0; i < 3; ++i)
+        {
+            mgr->TryReclaim();
+        }
+        EXPECT_EQ(g_destroyed.load(), 1);
+        EXPECT_EQ(mgr->PendingCount(), 0u);
+    }
+
+    TEST(epoch, NestedGuards)
+    {
+        EpochManager *mgr = EpochManager::get_instance();
+        g_destroyed.store(0);
+        {
+            EpochGuard outer;
+            {
+                EpochGuard inner;
+            }
+            // 内层退出后仍处于外层临界区
+            mgr->Retire(new int(2), CountingDelete);
+            for (int i = 0; i < 5; ++i)
+            {
+                mgr->TryReclaim();
+            }
+            EXPECT_EQ(g_destroyed.load(), 0);
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            mgr->TryReclaim();
+        }
+        EXPECT_EQ(g_destroyed.load(), 1);
+    }
+
+    struct IntComparator
+    {
+        int operator()(const int &a, const int &b) const
+        {
+            return a < b ? -1 : (a > b ? 1 : 0);
+        }
+    };
+
+    // 一个写者反复插入/删除，多个读者同时无锁读取
+    // 偶数key始终存在，读者必须总能读到；奇数key不断被增删，读到时value必须正确
+    TEST(epoch, SkipListConcurrentDeleteAndRead)
+    {
+        const int kKeys = 2000;
+        const int kReaders = 3;
+        auto alloc = std::make_shared<DefaultAlloc>();
+        SkipList<int, std::string, IntComparator> list(IntComparator(), alloc);
+        for (int k = 0; k < kKeys; k += 2)
+        {
+            list.Insert(k, "value_" + std::to_string(k));
+        }
+
+        std::atomic<bool> stop{false};
+        std::atomic<int64_t> errors{0};
+        std::atomic<int64_t> reads{0};
+        std::vector<std::thread> readers;
+        for (int r = 0; r < kReaders; ++r)
+        {
+            readers.emplace_back([&, r]()
+                                 {
+                Random rnd(1000 + r);
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    int k = rnd.Uniform(kKeys);
+                    auto v = list.Get(k);
+                    if ((k % 2 == 0 && !v) || (v && *v != "value_" + std::to_string(k)))
+                    {
+                        errors.fetch_add(1);
+                    }
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                } });
+        }
+
+        Random rnd(301);
+        for (int round = 0; round < 20000; ++round)
+        {
+            int k = 2 * rnd.Uniform(kKeys / 2) + 1;
+            if (list.Contains(k))
+            {
+                list.Delete(k);
+            }
+            else
+            {
+                list.Insert(k, "value_" + std::to_string(k));
+            }
+        }
+        stop.store(true);
+        for (auto &th : readers)
+        {
+            th.join();
+        }
+
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_GT(reads.load(), 0);
+        for (int k = 0; k < kKeys; k += 2)
+        {
+            EXPECT_EQ(list.Get(k), "value_" + std::to_string(k));
+        }
+        // 所有读者都已退出，被删除的结点最终都会被回收
+        EpochManager *mgr = EpochManager::get_instance();
+        for (int i = 0; i < 3; ++i)
+        {
+            mgr->TryReclaim();
+        }
+        EXPECT_EQ(mgr->PendingCount(), 0u);
+    }
+}
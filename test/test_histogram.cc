@@ -0,0 +1,78 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 11:30:44
+ * @LastEditTime: 2026-10-19 11:30:44
+ * @FilePath: /miniKV/test/test_histogram.cc
+ * @Description:  延迟直方图测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "../src/utils/histogram.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    TEST(histogram, Empty)
+    {
+        Histogram h;
+        EXPECT_EQ(h.Count(), 0u);
+        EXPECT_EQ(h.Percentile(99), 0u);
+        EXPECT_EQ(h.Min(), 0u);
+        EXPECT_EQ(h.Max(), 0u);
+    }
+
+    TEST(histogram, SmallValuesAreExact)
+    {
+        Histogram h;
+        for (uint64_t v = 1; v <= 100; ++v)
+        {
+            h.Add(v);
+        }
+        EXPECT_EQ(h.Count(), 100u);
+        EXPECT_EQ(h.Min(), 1u);
+        EXPECT_EQ(h.Max(), 100u);
+        EXPECT_EQ(h.Percentile(50), 50u);
+        EXPECT_EQ(h.Percentile(99), 99u);
+        EXPECT_EQ(h.Percentile(100), 100u);
+        EXPECT_DOUBLE_EQ(h.Average(), 50.5);
+    }
+
+    // 大数值的百分位相对误差不超过1/64
+    TEST(histogram, RelativeError)
+    {
+        Histogram h;
+        for (uint64_t v = 1; v <= 1000000; ++v)
+        {
+            h.Add(v * 1000);
+        }
+        const double ps[] = {50, 90, 99, 99.9};
+        for (double p : ps)
+        {
+            double expect = p / 100.0 * 1000000 * 1000;
+            double got = static_cast<double>(h.Percentile(p));
+            EXPECT_NEAR(got, expect, expect / 64) << "p" << p;
+        }
+        EXPECT_EQ(h.Max(), 1000000000u);
+        h.Add(UINT64_MAX);
+        EXPECT_EQ(h.Percentile(100), UINT64_MAX);
+    }
+
+    TEST(histogram, Merge)
+    {
+        Histogram a;
+        Histogram b;
+        for (uint64_t v = 0; v < 1000; ++v)
+        {
+            (v % 2 ? a : b).Add(v);
+        }
+        a.Merge(b);
+        EXPECT_EQ(a.Count(), 1000u);
+        EXPECT_EQ(a.Min(), 0u);
+        EXPECT_EQ(a.Max(), 999u);
+        EXPECT_NEAR(static_cast<double>(a.Percentile(50)), 500.0, 500.0 / 64);
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 16:40:51
+ * @LastEditTime: 2026-10-18 16:40:51
+ * @FilePath: /miniKV/test/test_lock.cc
+ * @Description:  锁模块测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/utils/lock.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    // 多线程对非原子计数器做自增，结果正确说明互斥有效
+    template <typename T>
+    static void CheckMutualExclusion()
+    {
+        T lock;
+        int64_t counter = 0;
+        const int kThreads = 8;
+        const int kLoops = 20000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t)
+        {
+            threads.emplace_back([&]()
+                                 {
+                for (int i = 0; i < kLoops; ++i)
+                {
+                    ScopedLock<T> guard(lock);
+                    ++counter;
+                } });
+        }
+        for (auto &th : threads)
+        {
+            th.join();
+        }
+        EXPECT_EQ(counter, int64_t(kThreads) * kLoops);
+    }
+
+    TEST(lock, MutexLock) { CheckMutualExclusion<MutexLock>(); }
+
+    TEST(lock, SpinLock) { CheckMutualExclusion<SpinLock>(); }
+
+    TEST(lock, TicketLock) { CheckMutualExclusion<TicketLock>(); }
+
+    TEST(lock, RWLockExclusive) { CheckMutualExclusion<RWLock>(); }
+
+    TEST(lock, SpinLockTryLock)
+    {
+        SpinLock lock;
+        EXPECT_TRUE(lock.try_lock());
+        EXPECT_FALSE(lock.try_lock());
+        lock.unlock();
+        EXPECT_TRUE(lock.try_lock());
+        lock.unlock();
+    }
+
+    // 读者之间可以并发，写者与读者互斥：写者每次把两个值改成相同的数，读者不能看到不一致的状态
+    TEST(lock, RWLockReadersSeeConsistentState)
+    {
+        RWLock lock;
+        int64_t a = 0;
+        int64_t b = 0;
+        std::atomic<bool> stop{false};
+        std::atomic<int64_t> reads{0};
+        std::atomic<int64_t> inconsistent{0};
+
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t)
+        {
+            readers.emplace_back([&]()
+                                 {
+                while (!stop.load())
+                {
+                    ScopedSharedLock<RWLock> guard(lock);
+                    if (a != b)
+                    {
+                        inconsistent.fetch_add(1);
+                    }
+                    reads.fetch_add(1);
+                } });
+        }
+        // 等所有读者都跑起来再开始写
+        while (reads.load() < 4)
+        {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 20000; ++i)
+        {
+            ScopedLock<RWLock> guard(lock);
+            ++a;
+            ++b;
+        }
+        stop.store(true);
+        for (auto &th : readers)
+        {
+            th.join();
+        }
+        EXPECT_EQ(inconsistent.load(), 0);
+        EXPECT_EQ(a, 20000);
+    }
+
+    TEST(lock, ScopedSharedLockUnlockRelock)
+    {
+        SharedMutexLock lock;
+        ScopedSharedLock<SharedMutexLock> guard(lock);
+        guard.unlock();
+        {
+            ScopedLock<SharedMutexLock> writer(lock); // 共享锁已释放，写锁可以拿到
+        }
+        guard.lock();
+    }
+}
@@ -1,27 +1,175 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-27 22:38:20
- * @LastEditTime: 2023-05-29 16:59:17
+ * @LastEditTime: 2026-10-23 15:31:09
  * @FilePath: /miniKV/test/test_log.cc
  * @Description: 日志模块测试
  *
  * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
  */
 
-#include "../src/log/log.h"
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "../src/log/log.h"
 using namespace std;
 
-// int main(int argc, char **argv)
-// {
-//     cout << "Log Test Module" << endl;
-//     minikvdb::Log::get_instance()->init("./ServerLog", 0, 2000, 800000);
+namespace minikvdb::unittest
+{
+    // 每个用例一个独立目录，日志文件名带日期前缀
+    static string LogDir(const char *name)
+    {
+        string dir = string("/tmp/minikvdb_log_") + name + "_" + to_string(getpid());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    static vector<string> ReadLines(const string &path)
+    {
+        vector<string> lines;
+        ifstream in(path);
+        string line;
+        while (getline(in, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    TEST(log, UninitializedLoggerIsSilent)
+    {
+        Log logger;
+        EXPECT_NE(logger.get_close_log(), 0);
+        EXPECT_TRUE(logger.get_file_name().empty());
+        // 未初始化时写日志是空操作
+        logger.write_log(kLogInfo, "%s", "dropped");
+        logger.write_kv(kLogInfo, "dropped", {{"k", 1}});
+        logger.flush();
+        LOG_EVENT(&logger, kLogInfo, "dropped");
+        LOG_EVENT(static_cast<Log *>(nullptr), kLogInfo, "dropped");
+    }
+
+    TEST(log, InitOnlyOnce)
+    {
+        string dir = LogDir("once");
+        Log logger;
+        ASSERT_TRUE(logger.init((dir + "/first").c_str(), 0));
+        string file = logger.get_file_name();
+        EXPECT_NE(file.find("first"), string::npos);
+
+        // 后续init直接返回第一次的结果，不会切换到新文件
+        EXPECT_TRUE(logger.init((dir + "/second").c_str(), 0));
+        EXPECT_EQ(logger.get_file_name(), file);
+        logger.write_log(kLogWarn, "value=%d", 7);
+        logger.flush();
+
+        size_t files = 0;
+        for (auto &entry : std::filesystem::directory_iterator(dir))
+        {
+            (void)entry;
+            ++files;
+        }
+        EXPECT_EQ(files, 1u);
+        auto lines = ReadLines(file);
+        ASSERT_EQ(lines.size(), 1u);
+        EXPECT_NE(lines[0].find("[warn]: value=7"), string::npos);
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST(log, ConcurrentInit)
+    {
+        string dir = LogDir("concurrent");
+        string name = dir + "/db";
+        Log logger;
+        vector<thread> threads;
+        for (int i = 0; i < 8; ++i)
+        {
+            threads.emplace_back([&]
+                                 {
+                                     EXPECT_TRUE(logger.init(name.c_str(), 0));
+                                     for (int j = 0; j < 100; ++j)
+                                     {
+                                         logger.write_log(kLogInfo, "line %d", j);
+                                     } });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        logger.flush();
+        EXPECT_EQ(ReadLines(logger.get_file_name()).size(), 800u);
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST(log, StructuredEvent)
+    {
+        string dir = LogDir("kv");
+        Log logger;
+        ASSERT_TRUE(logger.init((dir + "/events").c_str(), 0));
+        LOG_EVENT(&logger, kLogInfo, "flush", {"cf", "default"}, {"bytes", uint64_t(1024)}, {"ratio", 0.5},
+                  {"ok", true}, {"path", string("/tmp/a b")}, {"note", "say \"hi\""}, {"empty", ""});
+
+        auto lines = ReadLines(logger.get_file_name());
+        ASSERT_EQ(lines.size(), 1u);
+        const string &line = lines[0];
+        size_t body = line.find("[info]: ");
+        ASSERT_NE(body, string::npos);
+        EXPECT_EQ(line.substr(body + 8),
+                  "event=flush cf=default bytes=1024 ratio=0.500000 ok=true path=\"/tmp/a b\" "
+                  "note=\"say \\\"hi\\\"\" empty=\"\"");
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST(log, IndependentInstances)
+    {
+        string dir = LogDir("instances");
+        Log a;
+        Log b;
+        ASSERT_TRUE(a.init((dir + "/a").c_str(), 0));
+        ASSERT_TRUE(b.init((dir + "/b").c_str(), 0));
+        LOG_EVENT(&a, kLogInfo, "only_a");
+        LOG_EVENT(&b, kLogError, "only_b");
+        auto la = ReadLines(a.get_file_name());
+        auto lb = ReadLines(b.get_file_name());
+        ASSERT_EQ(la.size(), 1u);
+        ASSERT_EQ(lb.size(), 1u);
+        EXPECT_NE(la[0].find("[info]: event=only_a"), string::npos);
+        EXPECT_NE(lb[0].find("[error]: event=only_b"), string::npos);
+        std::filesystem::remove_all(dir);
+    }
 
-//     cout << "Loger Create OK ! ! !" << endl;
-//     LOG_INFO("%s", "INFO");
-//     LOG_DEBUG("%s", "DEBUG");
-//     LOG_WARN("%s", "WARN");
-//     LOG_ERROR("%s", "ERROR");
+    TEST(log, LongMessageIsTruncated)
+    {
+        string dir = LogDir("long");
+        Log logger;
+        ASSERT_TRUE(logger.init((dir + "/long").c_str(), 0, 256));
+        string big(4096, 'x');
+        logger.write_log(kLogDebug, "%s", big.c_str());
+        logger.flush();
+        auto lines = ReadLines(logger.get_file_name());
+        ASSERT_EQ(lines.size(), 1u);
+        EXPECT_LT(lines[0].size(), 256u);
+        EXPECT_NE(lines[0].find("[debug]: xxx"), string::npos);
+        std::filesystem::remove_all(dir);
+    }
 
-//     return 0;
-// }
+    // 文件名放不下时初始化失败，不会截断后写到别的文件
+    TEST(log, TooLongNameFails)
+    {
+        string dir = LogDir("toolong");
+        Log logger;
+        EXPECT_FALSE(logger.init((dir + "/" + string(200, 'n')).c_str(), 0));
+        EXPECT_NE(logger.get_close_log(), 0);
+        EXPECT_TRUE(logger.get_file_name().empty());
+        EXPECT_TRUE(std::filesystem::is_empty(dir));
+        std::filesystem::remove_all(dir);
+    }
+}
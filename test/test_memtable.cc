@@ -0,0 +1,291 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 15:32:14
+ * @LastEditTime: 2026-10-24 10:12:36
+ * @FilePath: /miniKV/test/test_memtable.cc
+ * @Description:  内存表测试模块，对每种底层结构运行相同的测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/memtable.h"
+#include "../src/memtable/random.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/utils/slice.h"
+#include "../src/memtable/comparator.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct StringComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using Table = MemTable<string, string, StringComparator>;
+
+    class MemTableTest : public ::testing::TestWithParam<MemTableRepType>
+    {
+    protected:
+        std::unique_ptr<Table> NewTable()
+        {
+            // 桶数量取得很小，保证桶内链表会有多个结点
+            return std::make_unique<Table>(StringComparator(), std::make_shared<DefaultAlloc>(), GetParam(), 16);
+        }
+    };
+
+    TEST_P(MemTableTest, InsertGetContains)
+    {
+        auto table = NewTable();
+        table->Insert("1", "value_1");
+        table->Insert("3", "value_3");
+        table->Insert("5", "value_5");
+
+        EXPECT_EQ(table->Get("0"), std::nullopt);
+        EXPECT_EQ(table->Get("1"), "value_1");
+        EXPECT_EQ(table->Get("3"), "value_3");
+        EXPECT_EQ(table->Get("5"), "value_5");
+        EXPECT_EQ(table->Contains("2"), false);
+        EXPECT_EQ(table->Contains("5"), true);
+        EXPECT_EQ(table->GetSize(), 3);
+        EXPECT_EQ(table->GetMemUsage(), 24);
+    }
+
+    TEST_P(MemTableTest, Delete)
+    {
+        auto table = NewTable();
+        const int N = 1234;
+        for (int i = 0; i < N; ++i)
+        {
+            table->Insert(std::to_string(i), "value_" + std::to_string(i));
+            if (i & 1)
+            {
+                table->Delete(std::to_string(i));
+            }
+        }
+        EXPECT_EQ(table->GetSize(), N / 2);
+        for (int i = 0; i < N; ++i)
+        {
+            if (i & 1)
+            {
+                EXPECT_EQ(table->Get(std::to_string(i)), std::nullopt);
+            }
+            else
+            {
+                EXPECT_EQ(table->Get(std::to_string(i)), "value_" + std::to_string(i));
+            }
+        }
+    }
+
+    // 两种结构都必须按key有序输出，供flush使用
+    TEST_P(MemTableTest, OrderedIteration)
+    {
+        auto table = NewTable();
+        Random rnd(301);
+        std::vector<string> keys;
+        for (int i = 0; i < 500; ++i)
+        {
+            string key = "key_" + std::to_string(rnd.Uniform(100000));
+            if (!table->Contains(key))
+            {
+                table->Insert(key, "v" + key);
+                keys.push_back(key);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+
+        Table::MemTableIterator iter(table.get());
+        iter.MoveToFirst();
+        size_t i = 0;
+        for (; iter.Valid(); iter.Next(), ++i)
+        {
+            ASSERT_LT(i, keys.size());
+            EXPECT_EQ(iter.key(), keys[i]);
+            EXPECT_EQ(iter.value(), "v" + keys[i]);
+        }
+        EXPECT_EQ(i, keys.size());
+    }
+
+    TEST_P(MemTableTest, Seek)
+    {
+        auto table = NewTable();
+        for (int i = 10; i < 100; i += 10)
+        {
+            table->Insert(std::to_string(i), "v" + std::to_string(i));
+        }
+
+        Table::MemTableIterator iter(table.get());
+        iter.Seek("30");
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "30");
+        iter.Next();
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "40");
+
+        iter.Seek("35");
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "40");
+
+        iter.Seek("0");
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "10");
+
+        iter.Seek("91");
+        EXPECT_FALSE(iter.Valid());
+    }
+
+    // 乱序、重复、不存在的key混合，结果应与逐个Get一致
+    TEST_P(MemTableTest, MultiGet)
+    {
+        auto table = NewTable();
+        Random rnd(301);
+        for (int k = 0; k < 6000; k += 3)
+        {
+            table->Insert(std::to_string(k), "v" + std::to_string(k));
+        }
+
+        vector<string> keys;
+        for (int i = 0; i < 500; ++i)
+        {
+            keys.push_back(std::to_string(rnd.Uniform(6500)));
+        }
+        keys.push_back(keys[0]);
+        keys.push_back("");
+
+        auto values = table->MultiGet(keys);
+        ASSERT_EQ(values.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            EXPECT_EQ(values[i], table->Get(keys[i])) << keys[i];
+        }
+        EXPECT_TRUE(table->MultiGet({}).empty());
+    }
+
+    // Slice为key/value、右值插入与写入调用方缓冲区的查找
+    TEST_P(MemTableTest, SliceAndBufferGet)
+    {
+        MemTable<Slice, Slice, SliceComparator> slices(SliceComparator(), std::make_shared<DefaultAlloc>(), GetParam(), 16);
+        string key = "key", value = "value";
+        slices.Insert(Slice(key), Slice(value));
+        key[0] = 'x';
+        value[0] = 'x';
+        EXPECT_EQ(slices.Get("key"), Slice("value"));
+        EXPECT_FALSE(slices.Contains("xey"));
+
+        auto table = NewTable();
+        table->Insert(string(100, 'k'), string(100, 'v'));
+        string buf;
+        EXPECT_TRUE(table->Get(string(100, 'k'), &buf));
+        EXPECT_EQ(buf, string(100, 'v'));
+        EXPECT_FALSE(table->Get("missing", &buf));
+        EXPECT_EQ(table->GetMemUsage(), 200);
+    }
+
+    // 透明比较器下的异构查找，Hash透明与不透明两种情况下结果一致，布隆过滤器同样生效
+    template <class Hash>
+    static void CheckHeterogeneousLookup(MemTableRepType type)
+    {
+        MemTable<string, string, BytewiseComparator, Hash> table(BytewiseComparator(), std::make_shared<DefaultAlloc>(), type, 16);
+        table.EnableBloomFilter(1024);
+        for (int i = 0; i < 100; ++i)
+        {
+            table.Insert(string(64, 'a' + i % 26) + std::to_string(i), std::to_string(i));
+        }
+        string key = string(64, 'a' + 42 % 26) + "42";
+        EXPECT_EQ(table.Get(std::string_view(key)), "42");
+        EXPECT_EQ(table.Get(Slice(key)), "42");
+        EXPECT_TRUE(table.Contains(key.c_str()));
+        EXPECT_FALSE(table.Contains(std::string_view(key.data(), 65)));
+        string buf;
+        EXPECT_TRUE(table.Get(std::string_view(key), &buf));
+        EXPECT_EQ(buf, "42");
+        EXPECT_FALSE(table.Get("missing", &buf));
+    }
+
+    TEST_P(MemTableTest, HeterogeneousLookup)
+    {
+        CheckHeterogeneousLookup<BytewiseHash>(GetParam());
+        CheckHeterogeneousLookup<std::hash<string>>(GetParam());
+    }
+
+    // 一个写者在同一批桶里反复插入/删除的同时，无锁读者总能读到从未删除的key，迭代结果有序
+    TEST_P(MemTableTest, ConcurrentReadDuringWrite)
+    {
+        auto table = NewTable();
+        const int N = 4000;
+        for (int i = 0; i < N; i += 2)
+        {
+            table->Insert("stable" + std::to_string(i), "v" + std::to_string(i));
+        }
+
+        std::atomic<bool> done{false};
+        std::atomic<int> errors{0};
+        std::thread reader([&]()
+                           {
+            Random rnd(7);
+            while (!done.load(std::memory_order_acquire))
+            {
+                int i = static_cast<int>(rnd.Uniform(N / 2)) * 2;
+                string key = "stable" + std::to_string(i);
+                if (table->Get(key) != "v" + std::to_string(i) || !table->Contains(key))
+                {
+                    errors.fetch_add(1);
+                }
+                Table::MemTableIterator iter(table.get());
+                iter.Seek(key);
+                string prev;
+                for (int k = 0; k < 64 && iter.Valid(); ++k, iter.Next())
+                {
+                    if (!prev.empty() && !(prev < iter.key()))
+                    {
+                        errors.fetch_add(1);
+                    }
+                    prev = iter.key();
+                }
+            } });
+
+        for (int round = 0; round < 5; ++round)
+        {
+            for (int i = 1; i < N; i += 2)
+            {
+                table->Insert("stable" + std::to_string(i), "odd");
+            }
+            for (int i = 1; i < N; i += 2)
+            {
+                table->Delete("stable" + std::to_string(i));
+            }
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_EQ(table->GetSize(), N / 2);
+    }
+
+    INSTANTIATE_TEST_SUITE_P(memtable, MemTableTest,
+                             ::testing::Values(MemTableRepType::kSkipList, MemTableRepType::kHashSkipList,
+                                               MemTableRepType::kBPlusTree),
+                             [](const ::testing::TestParamInfo<MemTableRepType> &info)
+                             {
+                                 switch (info.param)
+                                 {
+                                 case MemTableRepType::kHashSkipList:
+                                     return "HashSkipList";
+                                 case MemTableRepType::kBPlusTree:
+                                     return "BPlusTree";
+                                 default:
+                                     return "SkipList";
+                                 }
+                             });
+}
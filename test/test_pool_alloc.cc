@@ -0,0 +1,142 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 20:48:13
+ * @LastEditTime: 2026-10-18 20:48:13
+ * @FilePath: /miniKV/test/test_pool_alloc.cc
+ * @Description:  内存池测试模块
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <gtest/gtest.h>
+
+#include "../src/memory/pool_alloc.h"
+#include "../src/memtable/random.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    TEST(pool_alloc, RoundUpSize)
+    {
+        EXPECT_EQ(PoolAlloc::RoundUpSize(1), 16);
+        EXPECT_EQ(PoolAlloc::RoundUpSize(16), 16);
+        EXPECT_EQ(PoolAlloc::RoundUpSize(17), 32);
+        EXPECT_EQ(PoolAlloc::RoundUpSize(129), 160);
+        EXPECT_EQ(PoolAlloc::RoundUpSize(4096), 4096);
+        EXPECT_EQ(PoolAlloc::RoundUpSize(5000), 5000);
+        for (int32_t n = 1; n <= PoolAlloc::kMaxSmallSize; ++n)
+        {
+            ASSERT_GE(PoolAlloc::RoundUpSize(n), n);
+        }
+    }
+
+    // 分配的内存互不重叠、内容不会被破坏，并且大小块都能正确释放
+    TEST(pool_alloc, AllocateWriteFree)
+    {
+        PoolAlloc alloc;
+        Random rnd(301);
+        std::vector<std::pair<char *, int32_t>> blocks;
+        for (int i = 0; i < 5000; ++i)
+        {
+            int32_t n = 1 + rnd.Uniform(i % 50 == 0 ? 20000 : 2048);
+            char *p = static_cast<char *>(alloc.Allocate(n));
+            ASSERT_NE(p, nullptr);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0u);
+            memset(p, i & 0xff, n);
+            blocks.emplace_back(p, n);
+        }
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            auto [p, n] = blocks[i];
+            for (int32_t j = 0; j < n; ++j)
+            {
+                ASSERT_EQ(static_cast<uint8_t>(p[j]), i & 0xff);
+            }
+            alloc.Deallocate(p, n);
+        }
+    }
+
+    TEST(pool_alloc, Reallocate)
+    {
+        PoolAlloc alloc;
+        char *p = static_cast<char *>(alloc.Allocate(20));
+        memcpy(p, "0123456789abcdefghi", 20);
+        EXPECT_EQ(alloc.Reallocate(p, 20, 30), p); // 同一个size class
+        char *q = static_cast<char *>(alloc.Reallocate(p, 30, 10000));
+        EXPECT_EQ(memcmp(q, "0123456789abcdefghi", 20), 0);
+        char *r = static_cast<char *>(alloc.Reallocate(q, 10000, 100));
+        EXPECT_EQ(memcmp(r, "0123456789abcdefghi", 20), 0);
+        alloc.Deallocate(r, 100);
+    }
+
+    TEST(pool_alloc, Stats)
+    {
+        PoolAlloc alloc;
+        PoolAllocStats before = PoolAlloc::GetStats();
+        void *small = alloc.Allocate(100);
+        void *large = alloc.Allocate(100000);
+        PoolAllocStats mid = PoolAlloc::GetStats();
+        EXPECT_EQ(mid.alloc_count - before.alloc_count, 2u);
+        EXPECT_EQ(mid.large_alloc_count - before.large_alloc_count, 1u);
+        EXPECT_EQ(mid.bytes_in_use - before.bytes_in_use, 112u);
+        EXPECT_GT(mid.bytes_reserved, 0u);
+
+        alloc.Deallocate(small, 100);
+        alloc.Deallocate(large, 100000);
+        PoolAllocStats after = PoolAlloc::GetStats();
+        EXPECT_EQ(after.free_count - before.free_count, 2u);
+        EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+        EXPECT_FALSE(after.ToString().empty());
+    }
+
+    // 多线程交叉分配释放：生产者分配、消费者释放
+    TEST(pool_alloc, CrossThreadFree)
+    {
+        PoolAlloc alloc;
+        PoolAllocStats before = PoolAlloc::GetStats();
+        const int kThreads = 4;
+        const int kBlocks = 20000;
+        std::vector<std::vector<void *>> produced(kThreads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                for (int i = 0; i < kBlocks; ++i)
+                {
+                    void *p = alloc.Allocate(64);
+                    memset(p, t, 64);
+                    produced[t].push_back(p);
+                } });
+        }
+        for (auto &th : threads)
+        {
+            th.join();
+        }
+        threads.clear();
+        for (int t = 0; t < kThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                // 释放另一个线程分配的内存
+                for (void *p : produced[(t + 1) % kThreads])
+                {
+                    alloc.Deallocate(p, 64);
+                } });
+        }
+        for (auto &th : threads)
+        {
+            th.join();
+        }
+        PoolAllocStats after = PoolAlloc::GetStats();
+        EXPECT_EQ(after.alloc_count - before.alloc_count, uint64_t(kThreads) * kBlocks);
+        EXPECT_EQ(after.free_count - before.free_count, uint64_t(kThreads) * kBlocks);
+        EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+        EXPECT_GT(after.depot_releases, before.depot_releases);
+    }
+}
@@ -0,0 +1,161 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 15:20:47
+ * @LastEditTime: 2026-10-23 16:40:18
+ * @FilePath: /miniKV/test/test_rate_limiter.cc
+ * @Description:  限速器与可限速写文件测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "../src/utils/rate_limiter.h"
+#include "../src/utils/writable_file.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    static double ElapsedSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    TEST(rate_limiter, EnforcesRate)
+    {
+        // 1MB/s，周期10ms，单次最多10KB
+        RateLimiter limiter(1 << 20, 10 * 1000);
+        EXPECT_EQ(limiter.GetSingleBurstBytes(), (1 << 20) / 100);
+        auto start = std::chrono::steady_clock::now();
+        limiter.Request(300 * 1024, Priority::kLow);
+        double sec = ElapsedSeconds(start);
+        // 首个周期的令牌可以立即使用，其余需等待约0.28s
+        EXPECT_GT(sec, 0.2);
+        EXPECT_LT(sec, 1.5);
+        EXPECT_EQ(limiter.GetTotalBytesThrough(Priority::kLow), 300 * 1024);
+        EXPECT_GE(limiter.GetTotalRequests(Priority::kLow), 29);
+    }
+
+    // 两个优先级同时排队时，高优先级先完成
+    TEST(rate_limiter, HighPriorityFirst)
+    {
+        RateLimiter limiter(1 << 20, 10 * 1000, 1 << 30);
+        std::atomic<int> order{0};
+        int high_done = 0;
+        int low_done = 0;
+        limiter.Request(limiter.GetSingleBurstBytes(), Priority::kLow); // 耗尽初始令牌
+        std::thread low([&]()
+                        { limiter.Request(100 * 1024, Priority::kLow);
+                          low_done = ++order; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::thread high([&]()
+                         { limiter.Request(100 * 1024, Priority::kHigh);
+                           high_done = ++order; });
+        low.join();
+        high.join();
+        EXPECT_EQ(high_done, 1);
+        EXPECT_EQ(low_done, 2);
+    }
+
+    TEST(rate_limiter, AutoTune)
+    {
+        RateLimiter limiter(100 << 20, 100 * 1000, 10, true);
+        EXPECT_EQ(limiter.GetBytesPerSecond(), (100 << 20) / 20);
+        limiter.SetPendingDebt(50, 100);
+        int64_t half = limiter.GetBytesPerSecond();
+        EXPECT_GT(half, (100 << 20) / 2 - (100 << 20) / 20);
+        EXPECT_LT(half, (100 << 20) / 2 + (100 << 20) / 20);
+        limiter.SetPendingDebt(1000, 100);
+        EXPECT_EQ(limiter.GetBytesPerSecond(), 100 << 20);
+
+        // 非auto_tuned时忽略欠账
+        RateLimiter fixed(8 << 20);
+        fixed.SetPendingDebt(0, 100);
+        EXPECT_EQ(fixed.GetBytesPerSecond(), 8 << 20);
+    }
+
+    // 请求排队期间调低速率，超过新单次上限的队头请求仍能在桶满时获得令牌
+    TEST(rate_limiter, LowerRateWhileWaiting)
+    {
+        // 1MB/s，周期100ms，单次最多约100KB
+        RateLimiter limiter(1 << 20, 100 * 1000, 10, true);
+        limiter.SetPendingDebt(100, 100);
+        const int64_t burst = limiter.GetSingleBurstBytes();
+        limiter.Request(burst, Priority::kLow); // 耗尽初始令牌
+        std::atomic<bool> done{false};
+        std::thread waiter([&]()
+                           { limiter.Request(burst, Priority::kLow);
+                             done.store(true); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        // 欠账为0，速率降到1/20，单次上限约5KB
+        limiter.SetPendingDebt(0, 100);
+        EXPECT_LT(limiter.GetSingleBurstBytes(), burst);
+        for (int i = 0; i < 3000 && !done.load(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(done.load());
+        if (!done.load())
+        {
+            limiter.SetPendingDebt(100, 100); // 恢复速率，避免测试卡住
+        }
+        waiter.join();
+
+        // 余额为负，之后的请求需要等欠下的令牌补回
+        auto start = std::chrono::steady_clock::now();
+        limiter.Request(limiter.GetSingleBurstBytes(), Priority::kHigh);
+        EXPECT_GT(ElapsedSeconds(start), 0.5);
+        EXPECT_EQ(limiter.GetTotalBytesThrough(Priority::kLow), 2 * burst);
+    }
+
+    TEST(writable_file, AppendWithLimiter)
+    {
+        char path[] = "/tmp/minikvdb_writable_file_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+
+        RateLimiter limiter(64 << 20, 1000);
+        std::string expect;
+        {
+            WritableFile file(&limiter, Priority::kHigh, 4096);
+            ASSERT_TRUE(file.Open(path));
+            for (int i = 0; i < 1000; ++i)
+            {
+                std::string line = "record " + std::to_string(i) + "\n";
+                ASSERT_TRUE(file.Append(line));
+                expect += line;
+            }
+            std::string big(100000, 'x');
+            ASSERT_TRUE(file.Append(big));
+            expect += big;
+            EXPECT_EQ(file.GetFileSize(), expect.size());
+            ASSERT_TRUE(file.Sync());
+            ASSERT_TRUE(file.Close());
+        }
+        EXPECT_EQ(limiter.GetTotalBytesThrough(Priority::kHigh), static_cast<int64_t>(expect.size()));
+
+        // 追加模式
+        {
+            WritableFile file;
+            ASSERT_TRUE(file.Open(path, true));
+            EXPECT_EQ(file.GetFileSize(), expect.size());
+            ASSERT_TRUE(file.Append("tail"));
+            expect += "tail";
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        EXPECT_EQ(ss.str(), expect);
+        unlink(path);
+    }
+}
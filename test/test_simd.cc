@@ -0,0 +1,129 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-18 11:02:37
+ * @LastEditTime: 2026-10-23 09:20:11
+ * @FilePath: /miniKV/test/test_simd.cc
+ * @Description:  SIMD分派模块测试，所有CPU支持的指令集版本都与标量结果对比
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/comparator.h"
+#include "../src/memtable/random.h"
+#include "../src/utils/simd.h"
+#include "../src/utils/slice.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    using simd::IsaLevel;
+
+    static int Sign(int x) { return (x > 0) - (x < 0); }
+
+    // 依次切换到每个CPU支持的指令集执行fn，结束后恢复最优指令集
+    template <typename Fn>
+    static void ForEachIsa(Fn fn)
+    {
+        for (int l = 0; l <= static_cast<int>(simd::BestIsa()); ++l)
+        {
+            auto level = simd::ForceIsa(static_cast<IsaLevel>(l));
+            SCOPED_TRACE(simd::IsaName(level));
+            fn();
+        }
+        simd::ForceIsa(simd::BestIsa());
+    }
+
+    TEST(simd, CompareBytes)
+    {
+        Random rnd(301);
+        ForEachIsa([&]()
+                   {
+            for (int len = 0; len < 200; ++len)
+            {
+                std::string a(len, 'x');
+                for (auto &c : a)
+                {
+                    c = static_cast<char>(rnd.Uniform(256));
+                }
+                EXPECT_EQ(simd::MismatchIndex(a.data(), a.data(), len), static_cast<size_t>(len));
+                EXPECT_EQ(simd::CompareBytes(a.data(), len, a.data(), len), 0);
+                if (len == 0)
+                {
+                    continue;
+                }
+                std::string b = a;
+                size_t pos = rnd.Uniform(len);
+                b[pos] = static_cast<char>(b[pos] ^ (1 + rnd.Uniform(255)));
+                EXPECT_EQ(simd::MismatchIndex(a.data(), b.data(), len), pos);
+                EXPECT_EQ(Sign(simd::CompareBytes(a.data(), len, b.data(), len)),
+                          Sign(memcmp(a.data(), b.data(), len)));
+                // 前缀比较
+                EXPECT_LT(simd::CompareBytes(a.data(), len - 1, a.data(), len), 0);
+                EXPECT_GT(simd::CompareBytes(a.data(), len, a.data(), len - 1), 0);
+            } });
+    }
+
+    // 引擎中的字节序比较(BytewiseComparator、Slice)走分派的实现，结果须与std::string一致
+    TEST(simd, BytewiseComparatorUsesDispatch)
+    {
+        Random rnd(29);
+        BytewiseComparator cmp;
+        ForEachIsa([&]()
+                   {
+            for (int i = 0; i < 500; ++i)
+            {
+                std::string a(rnd.Uniform(100), 'k');
+                std::string b = a.substr(0, rnd.Uniform(static_cast<int>(a.size()) + 1));
+                if (!b.empty() && rnd.OneIn(2))
+                {
+                    b[rnd.Uniform(static_cast<int>(b.size()))] = static_cast<char>(rnd.Uniform(256));
+                }
+                EXPECT_EQ(Sign(cmp(a, b)), Sign(a.compare(b)));
+                EXPECT_EQ(Sign(Slice(a).compare(Slice(b))), Sign(a.compare(b)));
+                EXPECT_EQ(Sign(SliceComparator()(b, a)), Sign(b.compare(a)));
+            } });
+    }
+
+    TEST(simd, FilterRangeInt64)
+    {
+        Random rnd(17);
+        std::vector<int64_t> col(1000);
+        for (auto &v : col)
+        {
+            v = static_cast<int64_t>(rnd.Uniform(2000)) - 1000;
+        }
+        col[3] = std::numeric_limits<int64_t>::min();
+        col[4] = std::numeric_limits<int64_t>::max();
+
+        ForEachIsa([&]()
+                   {
+            std::vector<uint8_t> sel(col.size());
+            size_t expect = 0;
+            for (auto v : col)
+            {
+                expect += (v >= -100 && v <= 250);
+            }
+            EXPECT_EQ(simd::FilterRange(col.data(), col.size(), int64_t(-100), int64_t(250), sel.data()), expect);
+            for (size_t i = 0; i < col.size(); ++i)
+            {
+                EXPECT_EQ(sel[i], (col[i] >= -100 && col[i] <= 250) ? 1 : 0);
+            } });
+    }
+
+    TEST(simd, FilterRangeDoubleNaN)
+    {
+        std::vector<double> col = {0.5, std::nan(""), -1.0, 2.0, std::numeric_limits<double>::infinity(), 1.0, -0.0};
+        ForEachIsa([&]()
+                   {
+            std::vector<uint8_t> sel(col.size());
+            EXPECT_EQ(simd::FilterRange(col.data(), col.size(), 0.0, 1.0, sel.data()), 3u);
+            EXPECT_EQ(sel, (std::vector<uint8_t>{1, 0, 0, 0, 0, 1, 1})); });
+    }
+}
@@ -1,22 +1,33 @@
 /*
  * @Author: ZeroOneTaT
  * @Date: 2023-05-29 16:44:56
- * @LastEditTime: 2023-05-30 16:33:06
+ * @LastEditTime: 2026-10-22 19:08:36
  * @FilePath: /miniKV/test/test_skiplist.cc
- * @Description:  跳表测试模块
+ * @Description:  有序内存表结构测试模块：同一组用例分别运行于跳表与B+树
  *
  * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
  */
 
 #include <iostream>
 #include <ctime>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
 #include <gtest/gtest.h>
 
 #include "../src/log/log.h"
 #include "../src/memtable/skiplist.h"
+#include "../src/memtable/bplus_tree.h"
 #include "../src/memory/default_alloc.h"
+#include "../src/utils/statistics.h"
+#include "../src/utils/slice.h"
+#include "../src/memtable/comparator.h"
 using namespace std;
 
 namespace minikvdb::unittest
@@ -45,20 +56,70 @@ namespace minikvdb::unittest
     // 比较器，供测试代码调用
     Comparator cmp;
 
+    // 接口一致的有序结构，Type<K, V, C>为对应的类型
+    struct SkipListRep
+    {
+        template <typename K, typename V, class C>
+        using Type = SkipList<K, V, C>;
+    };
+
+    struct BPlusTreeRep
+    {
+        template <typename K, typename V, class C>
+        using Type = BPlusTree<K, V, C>;
+    };
+
+    // 每个结点只有4个key，少量数据即可产生多层结点与频繁分裂
+    struct NarrowBPlusTreeRep
+    {
+        template <typename K, typename V, class C>
+        using Type = BPlusTree<K, V, C, 4>;
+    };
+
+    template <class Rep>
+    using StringList = typename Rep::template Type<Key, Value, Comparator>;
+
+    template <class Rep>
+    class OrderedRepTest : public ::testing::Test
+    {
+    };
+
+    class OrderedRepNames
+    {
+    public:
+        template <typename T>
+        static std::string GetName(int)
+        {
+            if constexpr (std::is_same_v<T, SkipListRep>)
+            {
+                return "SkipList";
+            }
+            else if constexpr (std::is_same_v<T, BPlusTreeRep>)
+            {
+                return "BPlusTree";
+            }
+            else
+            {
+                return "NarrowBPlusTree";
+            }
+        }
+    };
+
+    using OrderedReps = ::testing::Types<SkipListRep, BPlusTreeRep, NarrowBPlusTreeRep>;
+    TYPED_TEST_SUITE(OrderedRepTest, OrderedReps, OrderedRepNames);
+
     // 插入功能模块测试
-    TEST(skiplist, Insert)
+    TYPED_TEST(OrderedRepTest, Insert)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
         skiplist->Insert("1", "value_1");
         skiplist->Insert("2", "value_2");
     }
-    TEST(skiplist, Insert2)
+    TYPED_TEST(OrderedRepTest, Insert2)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
         for (int i = 0; i < 100; ++i)
         {
             cout << "preocessing  " << i << endl;
@@ -67,11 +128,10 @@ namespace minikvdb::unittest
     }
 
     // 检查功能模块测试
-    TEST(skiplist, Contains)
+    TYPED_TEST(OrderedRepTest, Contains)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
 
         skiplist->Insert("1", "value_1");
         skiplist->Insert("3", "value_3");
@@ -85,11 +145,10 @@ namespace minikvdb::unittest
         EXPECT_EQ(skiplist->Contains("6"), false);
     }
 
-    TEST(skiplist, Contains2)
+    TYPED_TEST(OrderedRepTest, Contains2)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
 
         const int N = 2000;
         srand(time(0));
@@ -122,11 +181,10 @@ namespace minikvdb::unittest
     }
 
     // 删除功能模块测试
-    TEST(skiplist, Delete)
+    TYPED_TEST(OrderedRepTest, Delete)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
 
         skiplist->Insert("1", "value_1");
         skiplist->Insert("3", "value_3");
@@ -143,11 +201,10 @@ namespace minikvdb::unittest
         EXPECT_EQ(skiplist->Contains("5"), false);
     }
 
-    TEST(skiplist, Delete2)
+    TYPED_TEST(OrderedRepTest, Delete2)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
         const int N = 2000;
         for (int i = 0; i < N; ++i)
         {
@@ -166,11 +223,10 @@ namespace minikvdb::unittest
     }
 
     // 读取功能模块测试
-    TEST(skiplist, Get)
+    TYPED_TEST(OrderedRepTest, Get)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
 
         skiplist->Insert("1", "value_1");
         skiplist->Insert("3", "value_3");
@@ -184,11 +240,10 @@ namespace minikvdb::unittest
         EXPECT_EQ(skiplist->Get("5"), "value_5");
     }
 
-    TEST(skiplist, Get2)
+    TYPED_TEST(OrderedRepTest, Get2)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
         const int N = 1234;
         for (int i = 0; i < N; ++i)
         {
@@ -211,12 +266,108 @@ namespace minikvdb::unittest
         }
     }
 
+    // 写入调用方缓冲区、固定在结点上的零拷贝读取，以及右值插入
+    TYPED_TEST(OrderedRepTest, GetIntoBufferAndPinned)
+    {
+        using List = StringList<TypeParam>;
+        auto skiplist = std::make_shared<List>(cmp, std::make_shared<DefaultAlloc>());
+        std::string key(64, 'k');
+        std::string value(1000, 'v');
+        skiplist->Insert(std::move(key), std::move(value));
+        skiplist->Insert("a", "value_a");
+
+        std::string buf;
+        EXPECT_TRUE(skiplist->Get(std::string(64, 'k'), &buf));
+        EXPECT_EQ(buf, std::string(1000, 'v'));
+        const char *storage = buf.data();
+        EXPECT_TRUE(skiplist->Get("a", &buf));
+        EXPECT_EQ(buf, "value_a");
+        EXPECT_EQ(buf.data(), storage); // 复用了已有容量
+        EXPECT_FALSE(skiplist->Get("b", &buf));
+        EXPECT_EQ(buf, "value_a");
+
+        typename List::PinnedValue pinned;
+        EXPECT_TRUE(skiplist->GetPinned("a", &pinned));
+        ASSERT_TRUE(pinned.Valid());
+        EXPECT_EQ(pinned.value(), "value_a");
+        // 固定期间删除，结点要等pinned释放后才会被回收
+        skiplist->Delete("a");
+        EXPECT_EQ(pinned.value(), "value_a");
+        pinned.Reset();
+        EXPECT_FALSE(skiplist->GetPinned("a", &pinned));
+        EXPECT_FALSE(pinned.Valid());
+        EXPECT_EQ(skiplist->GetSize(), 1);
+    }
+
+    // Slice为key/value时内容被拷贝进结点，插入后外部缓冲区可以改写
+    TYPED_TEST(OrderedRepTest, SliceKeyValue)
+    {
+        using List = typename TypeParam::template Type<Slice, Slice, SliceComparator>;
+        auto skiplist = std::make_shared<List>(SliceComparator(), std::make_shared<DefaultAlloc>());
+        char key_buf[16];
+        char value_buf[32];
+        for (int i = 0; i < 1000; ++i)
+        {
+            int klen = snprintf(key_buf, sizeof(key_buf), "key%04d", i);
+            int vlen = snprintf(value_buf, sizeof(value_buf), "value%d", i * 7);
+            skiplist->Insert(Slice(key_buf, klen), Slice(value_buf, vlen));
+            memset(key_buf, 'x', sizeof(key_buf));
+            memset(value_buf, 'y', sizeof(value_buf));
+        }
+        EXPECT_EQ(skiplist->GetSize(), 1000);
+        EXPECT_EQ(skiplist->Get("key0010"), Slice("value70"));
+        EXPECT_EQ(skiplist->Get("key1000"), std::nullopt);
+
+        Slice value;
+        EXPECT_TRUE(skiplist->Get(std::string("key0999"), &value));
+        EXPECT_EQ(value.ToString(), "value6993");
+
+        skiplist->Delete("key0010");
+        EXPECT_FALSE(skiplist->Contains("key0010"));
+
+        typename List::Iterator iter(skiplist.get());
+        iter.MoveToFirst();
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), Slice("key0000"));
+        int count = 0;
+        for (; iter.Valid(); iter.Next())
+        {
+            ++count;
+        }
+        EXPECT_EQ(count, 999);
+    }
+
+    // 透明比较器下直接用string_view、const char*、Slice查找string key
+    TYPED_TEST(OrderedRepTest, HeterogeneousLookup)
+    {
+        using List = typename TypeParam::template Type<std::string, std::string, BytewiseComparator>;
+        auto skiplist = std::make_shared<List>(BytewiseComparator(), std::make_shared<DefaultAlloc>());
+        std::string long_key(64, 'k');
+        skiplist->Insert(long_key, "long");
+        skiplist->Insert("short", "value");
+
+        const char raw[] = "shortXXX";
+        std::string_view view(raw, 5);
+        EXPECT_TRUE(skiplist->Contains(view));
+        EXPECT_FALSE(skiplist->Contains(std::string_view(raw, 6)));
+        EXPECT_EQ(skiplist->Get(view), "value");
+        EXPECT_EQ(skiplist->Get("short"), "value");
+        EXPECT_EQ(skiplist->Get(Slice(long_key)), "long");
+        EXPECT_EQ(skiplist->Get(std::string_view(long_key.data(), 63)), std::nullopt);
+
+        std::string buf;
+        EXPECT_TRUE(skiplist->Get(std::string_view(long_key), &buf));
+        EXPECT_EQ(buf, "long");
+        typename List::PinnedValue pinned;
+        EXPECT_TRUE(skiplist->GetPinned(Slice("short"), &pinned));
+        EXPECT_EQ(pinned.value(), "value");
+    }
+
     // 元素数量、内存读取功能模块测试
-    TEST(skiplist, GetMemUsage_and_GetSize)
+    TYPED_TEST(OrderedRepTest, GetMemUsage_and_GetSize)
     {
         auto alloc = std::make_shared<DefaultAlloc>();
-        std::shared_ptr<SkipList<std::string, std::string, Comparator>> skiplist =
-            std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, alloc);
+        auto skiplist = std::make_shared<StringList<TypeParam>>(cmp, alloc);
 
         EXPECT_EQ(skiplist->GetSize(), 0);
         EXPECT_EQ(skiplist->GetMemUsage(), 0);
@@ -245,4 +396,163 @@ namespace minikvdb::unittest
         EXPECT_EQ(skiplist->GetSize(), 0);
         EXPECT_EQ(skiplist->GetMemUsage(), 0);
     }
+
+    // 乱序插入、删除后有序遍历与Seek
+    TYPED_TEST(OrderedRepTest, IteratorSeek)
+    {
+        using List = StringList<TypeParam>;
+        auto list = std::make_shared<List>(cmp, std::make_shared<DefaultAlloc>());
+        const int N = 3000;
+        std::vector<int> order(N);
+        for (int i = 0; i < N; ++i)
+        {
+            order[i] = i;
+        }
+        std::mt19937 rng(301);
+        std::shuffle(order.begin(), order.end(), rng);
+        char buf[16];
+        for (int i : order)
+        {
+            snprintf(buf, sizeof(buf), "key%05d", i);
+            list->Insert(buf, std::to_string(i));
+        }
+        // 删除所有3的倍数，其中[900, 1200)整段删空
+        for (int i = 0; i < N; ++i)
+        {
+            if (i % 3 == 0 || (i >= 900 && i < 1200))
+            {
+                snprintf(buf, sizeof(buf), "key%05d", i);
+                list->Delete(buf);
+            }
+        }
+
+        typename List::Iterator iter(list.get());
+        int expected = 0;
+        int count = 0;
+        for (iter.MoveToFirst(); iter.Valid(); iter.Next(), ++expected, ++count)
+        {
+            while (expected % 3 == 0 || (expected >= 900 && expected < 1200))
+            {
+                ++expected;
+            }
+            snprintf(buf, sizeof(buf), "key%05d", expected);
+            ASSERT_EQ(iter.key(), buf);
+            ASSERT_EQ(iter.value(), std::to_string(expected));
+        }
+        EXPECT_EQ(count, list->GetSize());
+
+        iter.Seek("key00950");
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "key01201");
+        iter.Seek("key00004");
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "key00004");
+        iter.Next();
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.key(), "key00005");
+        iter.Seek("key99999");
+        EXPECT_FALSE(iter.Valid());
+    }
+
+    // 一个写者持续插入/删除的同时，读者总能读到从未删除的key
+    TYPED_TEST(OrderedRepTest, ConcurrentReadDuringWrite)
+    {
+        using List = StringList<TypeParam>;
+        auto list = std::make_shared<List>(cmp, std::make_shared<DefaultAlloc>());
+        const int N = 20000;
+        for (int i = 0; i < N; i += 2)
+        {
+            list->Insert("stable" + std::to_string(i), "v" + std::to_string(i));
+        }
+
+        std::atomic<bool> done{false};
+        std::atomic<int> errors{0};
+        std::thread reader([&]()
+                           {
+            std::mt19937 rng(7);
+            while (!done.load(std::memory_order_acquire))
+            {
+                int i = static_cast<int>(rng() % (N / 2)) * 2;
+                auto v = list->Get("stable" + std::to_string(i));
+                if (!v.has_value() || *v != "v" + std::to_string(i))
+                {
+                    errors.fetch_add(1);
+                }
+                // 遍历中stable key保持有序且不重复
+                typename List::Iterator iter(list.get());
+                iter.Seek("stable" + std::to_string(i));
+                std::string prev;
+                for (int k = 0; k < 64 && iter.Valid(); ++k, iter.Next())
+                {
+                    if (!prev.empty() && !(prev < iter.key()))
+                    {
+                        errors.fetch_add(1);
+                    }
+                    prev = iter.key();
+                }
+            } });
+
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int i = 1; i < N; i += 2)
+            {
+                list->Insert("stable" + std::to_string(i), "odd");
+            }
+            for (int i = 1; i < N; i += 2)
+            {
+                list->Delete("stable" + std::to_string(i));
+            }
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_EQ(list->GetSize(), N / 2);
+    }
+
+    // 结点高度按1/B逐层递减，且不超过最大高度
+    TEST(skiplist, LevelDistribution)
+    {
+        auto stats = std::make_shared<Statistics>();
+        auto skiplist = std::make_shared<SkipList<std::string, std::string, Comparator>>(cmp, std::make_shared<DefaultAlloc>());
+        skiplist->SetStatistics(stats);
+        const int n = 100000;
+        for (int i = 0; i < n; ++i)
+        {
+            skiplist->Insert(std::to_string(i), "");
+        }
+        Histogram height = stats->GetHistogram(HistogramType::kSkipListNodeHeight);
+        EXPECT_EQ(height.Count(), static_cast<uint64_t>(n));
+        EXPECT_LE(height.Max(), static_cast<uint64_t>(MINIKVDB_SKIPLIST_MAX_HEIGHT));
+        // 高度服从几何分布，期望为B / (B - 1)
+        const double b = MINIKVDB_SKIPLIST_BRANCHING;
+        EXPECT_NEAR(height.Average(), b / (b - 1), 0.02);
+#if MINIKVDB_SKIPLIST_BRANCHING == 4
+        EXPECT_EQ(height.Percentile(50), 1u);
+        EXPECT_EQ(height.Percentile(80), 2u);
+        EXPECT_EQ(height.Percentile(95), 3u);
+#endif
+    }
+
+    // 线程局部的随机数实例互不相同
+    TEST(skiplist, FastRandomPerThread)
+    {
+        FastRandom *main_rnd = FastRandom::GetTLSInstance();
+        EXPECT_EQ(main_rnd, FastRandom::GetTLSInstance());
+        FastRandom *other_rnd = nullptr;
+        std::thread([&other_rnd]()
+                    { other_rnd = FastRandom::GetTLSInstance(); })
+            .join();
+        EXPECT_NE(main_rnd, other_rnd);
+
+        FastRandom rnd(301);
+        int hits[10] = {0};
+        for (int i = 0; i < 100000; ++i)
+        {
+            ++hits[rnd.Uniform(10)];
+        }
+        for (int h : hits)
+        {
+            EXPECT_NEAR(h, 10000, 500);
+        }
+    }
 }
@@ -0,0 +1,122 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 16:15:02
+ * @LastEditTime: 2026-10-19 16:15:02
+ * @FilePath: /miniKV/test/test_statistics.cc
+ * @Description:  统计信息与perf context测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/memtable/memtable.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/utils/statistics.h"
+#include "../src/utils/perf_context.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct StatsStringComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    TEST(statistics, TickersFromManyThreads)
+    {
+        Statistics stats;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&stats]()
+                                 {
+                for (int i = 0; i < 10000; ++i)
+                {
+                    stats.RecordTick(Ticker::kBytesWritten, 3);
+                    stats.RecordInHistogram(HistogramType::kComparisonsPerGet, i % 10);
+                } });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        EXPECT_EQ(stats.GetTickerCount(Ticker::kBytesWritten), 8u * 10000 * 3);
+        Histogram hist = stats.GetHistogram(HistogramType::kComparisonsPerGet);
+        EXPECT_EQ(hist.Count(), 80000u);
+        EXPECT_EQ(hist.Max(), 9u);
+
+        stats.Reset();
+        EXPECT_EQ(stats.GetTickerCount(Ticker::kBytesWritten), 0u);
+        EXPECT_EQ(stats.GetHistogram(HistogramType::kComparisonsPerGet).Count(), 0u);
+    }
+
+    TEST(statistics, MemTableHitMiss)
+    {
+        auto stats = std::make_shared<Statistics>();
+        MemTable<string, string, StatsStringComparator> table(StatsStringComparator(), std::make_shared<DefaultAlloc>());
+        table.SetStatistics(stats);
+        for (int i = 0; i < 100; ++i)
+        {
+            table.Insert("key" + std::to_string(i), "value");
+        }
+        for (int i = 0; i < 150; ++i)
+        {
+            table.Get("key" + std::to_string(i));
+        }
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kKeysWritten), 100u);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kMemtableHit), 100u);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kMemtableMiss), 50u);
+        EXPECT_EQ(stats->GetTickerCount(Ticker::kBytesRead), 500u);
+        EXPECT_GT(stats->GetTickerCount(Ticker::kKeyComparisons), 0u);
+        EXPECT_EQ(stats->GetHistogram(HistogramType::kSkipListNodeHeight).Count(), 100u);
+        EXPECT_EQ(stats->GetHistogram(HistogramType::kComparisonsPerGet).Count(), 150u);
+
+        std::string json = stats->ToJson();
+        EXPECT_NE(json.find("\"memtable.hit\":100"), std::string::npos);
+        EXPECT_NE(json.find("\"skiplist.node.height\":{\"count\":100"), std::string::npos);
+        EXPECT_NE(stats->ToString().find("memtable.miss COUNT : 50"), std::string::npos);
+    }
+
+    TEST(perf_context, GetAndPut)
+    {
+        MemTable<string, string, StatsStringComparator> table(StatsStringComparator(), std::make_shared<DefaultAlloc>());
+        table.Insert("a", "1");
+
+        // 默认关闭
+        GetPerfContext()->Reset();
+        table.Get("a");
+        EXPECT_EQ(GetPerfContext()->get_count, 0u);
+
+        SetPerfLevel(PerfLevel::kEnableCount);
+        table.Get("a");
+        EXPECT_EQ(GetPerfContext()->get_count, 1u);
+        EXPECT_GT(GetPerfContext()->user_key_comparison_count, 0u);
+        EXPECT_EQ(GetPerfContext()->get_cycles, 0u);
+
+        SetPerfLevel(PerfLevel::kEnableTime);
+        GetPerfContext()->Reset();
+        table.Insert("b", "2");
+        table.Get("b");
+        EXPECT_EQ(GetPerfContext()->put_count, 1u);
+        EXPECT_GT(GetPerfContext()->put_cycles, 0u);
+        EXPECT_GT(GetPerfContext()->get_cycles, 0u);
+        EXPECT_GE(GetPerfContext()->get_cycles, GetPerfContext()->get_search_cycles);
+        EXPECT_NE(GetPerfContext()->ToString(true).find("put_count = 1"), std::string::npos);
+        EXPECT_NE(GetPerfContext()->ToJson().find("\"get_count\":1"), std::string::npos);
+
+        // 其他线程的perf context相互独立
+        std::thread([]()
+                    { EXPECT_EQ(GetPerfContext()->get_count, 0u);
+                      EXPECT_EQ(GetPerfLevel(), PerfLevel::kDisable); })
+            .join();
+        SetPerfLevel(PerfLevel::kDisable);
+    }
+}
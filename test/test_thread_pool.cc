@@ -0,0 +1,89 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-20 11:20:06
+ * @LastEditTime: 2026-10-20 11:20:06
+ * @FilePath: /miniKV/test/test_thread_pool.cc
+ * @Description:  后台任务线程池测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "../src/utils/thread_pool.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    TEST(thread_pool, RunsAllJobs)
+    {
+        ThreadPool pool(2, 3);
+        EXPECT_EQ(pool.GetBackgroundThreads(Priority::kHigh), 2);
+        EXPECT_EQ(pool.GetBackgroundThreads(Priority::kLow), 3);
+        std::atomic<int> high{0};
+        std::atomic<int> low{0};
+        for (int i = 0; i < 1000; ++i)
+        {
+            pool.Schedule([&high]()
+                          { high.fetch_add(1); },
+                          Priority::kHigh);
+            pool.Schedule([&low]()
+                          { low.fetch_add(1); },
+                          Priority::kLow);
+        }
+        pool.WaitForIdle();
+        EXPECT_EQ(high.load(), 1000);
+        EXPECT_EQ(low.load(), 1000);
+        EXPECT_EQ(pool.GetQueueLen(Priority::kHigh), 0u);
+        EXPECT_EQ(pool.GetQueueLen(Priority::kLow), 0u);
+    }
+
+    // 低优先级线程全部被占用时，高优先级任务仍能执行
+    TEST(thread_pool, FlushNotBlockedByCompaction)
+    {
+        ThreadPool pool(1, 1);
+        std::atomic<bool> release{false};
+        std::atomic<bool> flushed{false};
+        pool.Schedule([&release]()
+                      {
+            while (!release.load())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } },
+                      Priority::kLow);
+        pool.Schedule([]() {}, Priority::kLow);
+        pool.Schedule([&flushed]()
+                      { flushed.store(true); },
+                      Priority::kHigh);
+        for (int i = 0; i < 5000 && !flushed.load(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(flushed.load());
+        EXPECT_EQ(pool.GetQueueLen(Priority::kLow), 1u);
+        release.store(true);
+        pool.WaitForIdle();
+        EXPECT_EQ(pool.GetQueueLen(Priority::kLow), 0u);
+    }
+
+    // 析构前会执行完已排队的任务
+    TEST(thread_pool, DrainOnDestroy)
+    {
+        std::atomic<int> done{0};
+        {
+            ThreadPool pool(1, 1);
+            pool.SetBackgroundThreads(4, Priority::kLow);
+            EXPECT_EQ(pool.GetBackgroundThreads(Priority::kLow), 4);
+            for (int i = 0; i < 100; ++i)
+            {
+                pool.Schedule([&done]()
+                              { done.fetch_add(1); },
+                              Priority::kLow);
+            }
+        }
+        EXPECT_EQ(done.load(), 100);
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-21 16:05:27
+ * @LastEditTime: 2026-10-23 15:14:03
+ * @FilePath: /miniKV/test/test_ttl.cc
+ * @Description:  TTL惰性过期与compaction filter测试
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../src/compaction/compaction_filter.h"
+#include "../src/compaction/compaction_job.h"
+#include "../src/compaction/tiered_compaction.h"
+#include "../src/memtable/ttl.h"
+#include "../src/memory/default_alloc.h"
+using namespace std;
+
+namespace minikvdb::unittest
+{
+    struct TtlStringComparator
+    {
+        int operator()(const string &a, const string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    static uint64_t fake_now = 1000;
+
+    static uint64_t FakeClock()
+    {
+        return fake_now;
+    }
+
+    using TtlTable = TtlMemTable<string, string, TtlStringComparator>;
+    using TtlRun = SortedRun<string, TtlValue<string>>;
+
+    // 丢弃以"tmp_"开头的key，把"secret"改写为"***"
+    class RedactFilter : public CompactionFilter<string, string>
+    {
+    public:
+        Decision Filter(const Context & /*ctx*/, const string &key, const string &value, string *new_value) const override
+        {
+            if (key.compare(0, 4, "tmp_") == 0)
+            {
+                return Decision::kRemove;
+            }
+            if (value == "secret")
+            {
+                *new_value = "***";
+                return Decision::kChangeValue;
+            }
+            return Decision::kKeep;
+        }
+
+        const char *Name() const override { return "RedactFilter"; }
+    };
+
+    TEST(ttl, LazyExpiryOnGet)
+    {
+        fake_now = 1000;
+        TtlTable table(TtlStringComparator(), std::make_shared<DefaultAlloc>(), MemTableRepType::kSkipList, &FakeClock);
+        table.Insert("forever", "v0");
+        table.Insert("short", "v1", 100);
+        table.Insert("long", "v2", 10000);
+        EXPECT_EQ(table.Get("short"), "v1");
+
+        fake_now = 1100;
+        EXPECT_EQ(table.Get("short"), std::nullopt);
+        EXPECT_FALSE(table.Contains("short"));
+        EXPECT_EQ(table.Get("long"), "v2");
+        EXPECT_EQ(table.Get("forever"), "v0");
+        // 过期数据还在底层表中，等待flush时清理
+        EXPECT_EQ(table.GetMemTable().GetSize(), 3);
+
+        // 过期的旧值不会挡住新写入；未过期时与MemTable一样忽略重复插入
+        table.Insert("short", "v3", 100);
+        EXPECT_EQ(table.Get("short"), "v3");
+        table.Insert("long", "other");
+        EXPECT_EQ(table.Get("long"), "v2");
+    }
+
+    TEST(ttl, FlushAndCompactionFilter)
+    {
+        MemTable<string, string, TtlStringComparator> table(TtlStringComparator(), std::make_shared<DefaultAlloc>());
+        table.Insert("a", "1");
+        table.Insert("tmp_b", "2");
+        table.Insert("c", "secret");
+        RedactFilter filter;
+        SortedRun<string, string> run = FlushMemTable(table, 1, &filter);
+        ASSERT_EQ(run.entries.size(), 2u);
+        EXPECT_EQ(run.entries[0].first, "a");
+        EXPECT_EQ(run.entries[1].second, "***");
+
+        // compaction只对最新版本调用filter，同一key的旧版本一起丢弃
+        SortedRun<string, string> newer, older;
+        newer.Append("tmp_x", "new");
+        newer.Append("y", "secret");
+        older.Append("tmp_x", "old");
+        older.Append("y", "plain");
+        older.Append("z", "z");
+        CompactionJob<string, string, TtlStringComparator> job({&newer, &older}, TtlStringComparator(), 1, &filter, true);
+        std::vector<SortedRun<string, string>> outputs = job.Execute();
+        ASSERT_EQ(outputs.size(), 1u);
+        ASSERT_EQ(outputs[0].entries.size(), 2u);
+        EXPECT_EQ(outputs[0].entries[0], make_pair(string("y"), string("***")));
+        EXPECT_EQ(outputs[0].entries[1].first, "z");
+        EXPECT_EQ(job.GetStats().entries_filtered, 1u);
+    }
+
+    TEST(ttl, TtlFilterOnlyDropsAtBottommost)
+    {
+        fake_now = 1000;
+        TtlCompactionFilter<string, string> filter(&FakeClock);
+        using Decision = CompactionFilter<string, TtlValue<string>>::Decision;
+        CompactionFilter<string, TtlValue<string>>::Context ctx;
+        TtlValue<string> expired{"payload", 500}, alive{"payload", 5000}, out;
+        EXPECT_EQ(filter.Filter(ctx, "k", alive, &out), Decision::kKeep);
+        // 非bottommost：改写为空value，保留过期时间作为删除标记
+        EXPECT_EQ(filter.Filter(ctx, "k", expired, &out), Decision::kChangeValue);
+        EXPECT_EQ(out.value, "");
+        EXPECT_EQ(out.expire_micros, 500u);
+        ctx.is_bottommost = true;
+        EXPECT_EQ(filter.Filter(ctx, "k", expired, &out), Decision::kRemove);
+
+        // 旧段中未过期的旧版本不能因为新版本过期被丢弃而重新可见
+        TieredCompactionOptions opts;
+        opts.run_count_trigger = 3;
+        opts.max_size_amplification_percent = 1000000;
+        opts.size_ratio = 1000000;
+        opts.max_merge_width = 2;
+        TieredCompaction<string, TtlValue<string>, TtlStringComparator> tiered(TtlStringComparator(), opts);
+        tiered.SetCompactionFilter(std::make_shared<TtlCompactionFilter<string, string>>(&FakeClock));
+        TtlRun oldest, middle, newest;
+        oldest.id = 1;
+        oldest.Append("k", TtlValue<string>{"old", 0});
+        middle.id = 2;
+        middle.Append("k", TtlValue<string>{"expired", 500});
+        newest.id = 3;
+        newest.Append("other", TtlValue<string>{"x", 0});
+        tiered.AddRun(oldest);
+        tiered.AddRun(middle);
+        tiered.AddRun(newest);
+
+        // 只合并最新的两个段，不是bottommost
+        EXPECT_EQ(tiered.MaybeCompact(), CompactionReason::kSizeRatio);
+        ASSERT_EQ(tiered.GetRuns().size(), 2u);
+        auto v = tiered.Get("k");
+        ASSERT_TRUE(v.has_value());
+        EXPECT_TRUE(v->Expired(fake_now));
+        EXPECT_EQ(v->value, "");
+
+        // 合并到最旧的段时，过期的key连同旧版本一起丢弃
+        TieredCompaction<string, TtlValue<string>, TtlStringComparator> full{TtlStringComparator()};
+        full.SetCompactionFilter(std::make_shared<TtlCompactionFilter<string, string>>(&FakeClock));
+        full.AddRun(oldest);
+        full.AddRun(middle);
+        full.AddRun(newest);
+        full.AddRun(TtlRun());
+        TtlRun one;
+        one.id = 4;
+        one.Append("other", TtlValue<string>{"y", 0});
+        full.AddRun(one);
+        full.CompactUntilStable();
+        EXPECT_EQ(full.Get("k"), std::nullopt);
+        EXPECT_EQ(full.Get("other")->value, "y");
+    }
+}
@@ -0,0 +1,585 @@
+/*
+ * @Author: ZeroOneTaT
+ * @Date: 2026-10-19 13:20:08
+ * @LastEditTime: 2026-10-19 13:20:08
+ * @FilePath: /miniKV/tools/ycsb.cc
+ * @Description: YCSB风格的负载驱动程序
+ *
+ * ********************************
+ *  对MemTable运行YCSB A~F负载，按操作类型记录延迟直方图，
+ *  输出吞吐与p50/p99/p99.9/max。
+ *    A: 50% read  / 50% update               zipfian
+ *    B: 95% read  / 5% update                zipfian
+ *    C: 100% read                            zipfian
+ *    D: 95% read  / 5% insert                latest
+ *    E: 95% scan  / 5% insert                zipfian
+ *    F: 50% read  / 50% read-modify-write    zipfian
+ *  并发模型与跳表一致：写操作(update/insert/rmw的写部分)通过写锁串行化；
+ *  skiplist底层的读操作无锁，hash底层的读操作持有读锁。
+ *  update实现为Delete + Insert，两者之间并发的无锁读可能短暂读不到该key。
+ *  --bg_write=1时运行期间另起一个线程持续顺序写临时文件，模拟饱和的compaction写入，
+ *  配合--bg_rate_limit_mb观察限速对前台延迟的影响。
+ * ********************************
+ *
+ * Copyright (c) 2023 by ZeroOneTaT, All Rights Reserved.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../bench/key_generator.h"
+#include "../src/memory/default_alloc.h"
+#include "../src/memtable/memtable.h"
+#include "../src/utils/histogram.h"
+#include "../src/utils/lock.h"
+#include "../src/utils/rate_limiter.h"
+#include "../src/utils/writable_file.h"
+
+namespace minikvdb::ycsb
+{
+    using bench::FnvHash64;
+    using bench::MakeKey;
+    using bench::ZipfianGenerator;
+
+    struct StringComparator
+    {
+        int operator()(const std::string &a, const std::string &b) const
+        {
+            return a.compare(b);
+        }
+    };
+
+    using Table = MemTable<std::string, std::string, StringComparator>;
+
+    enum class Distribution
+    {
+        kUniform,
+        kZipfian,
+        kLatest, // 偏向最近插入的key
+    };
+
+    enum OpType
+    {
+        kRead = 0,
+        kUpdate,
+        kInsert,
+        kScan,
+        kReadModifyWrite,
+        kNumOpTypes
+    };
+
+    const char *const kOpNames[kNumOpTypes] = {"READ", "UPDATE", "INSERT", "SCAN", "RMW"};
+
+    struct Workload
+    {
+        char name;
+        double proportion[kNumOpTypes]; // 各操作占比，和为1
+        Distribution dist;
+    };
+
+    const Workload kWorkloads[] = {
+        {'a', {0.50, 0.50, 0, 0, 0}, Distribution::kZipfian},
+        {'b', {0.95, 0.05, 0, 0, 0}, Distribution::kZipfian},
+        {'c', {1.00, 0, 0, 0, 0}, Distribution::kZipfian},
+        {'d', {0.95, 0, 0.05, 0, 0}, Distribution::kLatest},
+        {'e', {0, 0, 0.05, 0.95, 0}, Distribution::kZipfian},
+        {'f', {0.50, 0, 0, 0, 0.50}, Distribution::kZipfian},
+    };
+
+    struct Options
+    {
+        const Workload *workload = &kWorkloads[0];
+        bool override_dist = false;
+        Distribution dist = Distribution::kZipfian;
+        MemTableRepType rep = MemTableRepType::kSkipList;
+        uint64_t records = 100000;
+        uint64_t operations = 1000000;
+        std::vector<int> threads = {1};
+        int scan_length = 100; // scan长度在[1, scan_length]中均匀选取
+        int value_size = 100;
+        uint32_t seed = 301;
+        bool bg_write = false;         // 运行期间是否有后台写入负载
+        int64_t bg_rate_limit_mb = 0;  // 后台写入限速(MB/s)，0为不限速
+        std::string bg_dir = "/tmp";   // 后台写入的临时文件目录
+    };
+
+    const char *DistName(Distribution d)
+    {
+        switch (d)
+        {
+        case Distribution::kUniform:
+            return "uniform";
+        case Distribution::kLatest:
+            return "latest";
+        default:
+            return "zipfian";
+        }
+    }
+
+    // 对MemTable的一层封装：写串行化，读按底层结构决定是否加锁
+    class Store
+    {
+    public:
+        explicit Store(MemTableRepType rep)
+            : table_(StringComparator(), std::make_shared<DefaultAlloc>(), rep),
+              lock_free_reads_(rep == MemTableRepType::kSkipList)
+        {
+        }
+
+        bool Read(const std::string &key)
+        {
+            if (lock_free_reads_)
+            {
+                return table_.Get(key).has_value();
+            }
+            ScopedSharedLock<RWLock> guard(lock_);
+            return table_.Get(key).has_value();
+        }
+
+        void Update(const std::string &key, const std::string &value)
+        {
+            ScopedLock<RWLock> guard(lock_);
+            if (table_.Contains(key))
+            {
+                table_.Delete(key);
+            }
+            table_.Insert(key, value);
+        }
+
+        // 插入下一个编号的key，返回插入后的key总数
+        uint64_t InsertNext(const std::string &value)
+        {
+            ScopedLock<RWLock> guard(lock_);
+            uint64_t k = key_count_.load(std::memory_order_relaxed);
+            table_.Insert(MakeKey<std::string>(k), value);
+            // 写操作串行化，因此[0, k]都已在表中
+            key_count_.store(k + 1, std::memory_order_release);
+            return k + 1;
+        }
+
+        int Scan(const std::string &start, int len)
+        {
+            if (lock_free_reads_)
+            {
+                return DoScan(start, len);
+            }
+            ScopedSharedLock<RWLock> guard(lock_);
+            return DoScan(start, len);
+        }
+
+        uint64_t KeyCount() const { return key_count_.load(std::memory_order_acquire); }
+
+        int GetSize() { return table_.GetSize(); }
+
+    private:
+        int DoScan(const std::string &start, int len)
+        {
+            Table::MemTableIterator iter(&table_);
+            int n = 0;
+            for (iter.Seek(start); iter.Valid() && n < len; iter.Next())
+            {
+                ++n;
+            }
+            return n;
+        }
+
+        Table table_;
+        bool const lock_free_reads_;
+        RWLock lock_;
+        std::atomic<uint64_t> key_count_{0};
+    };
+
+    // 每个线程一个，负责选择操作和key
+    class OpChooser
+    {
+    public:
+        OpChooser(const Options &opt, const ZipfianGenerator &zipf, uint32_t seed)
+            : opt_(opt), zipf_(zipf), rnd_(seed),
+              dist_(opt.override_dist ? opt.dist : opt.workload->dist)
+        {
+        }
+
+        OpType NextOp()
+        {
+            double u = bench::NextDouble(rnd_);
+            double acc = 0;
+            for (int i = 0; i < kNumOpTypes; ++i)
+            {
+                acc += opt_.workload->proportion[i];
+                if (u < acc)
+                {
+                    return static_cast<OpType>(i);
+                }
+            }
+            return kRead;
+        }
+
+        // 从已存在的key中按分布选取一个编号
+        uint64_t NextKey(uint64_t key_count)
+        {
+            switch (dist_)
+            {
+            case Distribution::kUniform:
+                return rnd_.Uniform(static_cast<int>(key_count));
+            case Distribution::kLatest:
+            {
+                // Skewed偏向小值：距最新key越近出现概率越高
+                int max_log = 63 - __builtin_clzll(key_count);
+                uint64_t offset = rnd_.Skewed(max_log > 30 ? 30 : max_log);
+                return offset >= key_count ? 0 : key_count - 1 - offset;
+            }
+            default:
+                // 热点只分布在初始加载的key上，新插入的key不参与
+                return FnvHash64(zipf_.Next(rnd_)) % zipf_.GetItemCount();
+            }
+        }
+
+        int NextScanLength() { return 1 + rnd_.Uniform(opt_.scan_length); }
+
+    private:
+        const Options &opt_;
+        const ZipfianGenerator &zipf_;
+        Random rnd_;
+        Distribution const dist_;
+    };
+
+    struct ThreadResult
+    {
+        Histogram hist[kNumOpTypes];
+        uint64_t not_found = 0;
+    };
+
+    void RunThread(Store *store, const Options &opt, const ZipfianGenerator &zipf, uint64_t ops, uint32_t seed,
+                   const std::atomic<bool> *start, ThreadResult *result)
+    {
+        OpChooser chooser(opt, zipf, seed);
+        const std::string value(opt.value_size, 'v');
+        while (!start->load(std::memory_order_acquire))
+        {
+            CpuRelax();
+        }
+
+        for (uint64_t i = 0; i < ops; ++i)
+        {
+            OpType op = chooser.NextOp();
+            std::string key;
+            int scan_len = 0;
+            if (op != kInsert)
+            {
+                key = MakeKey<std::string>(chooser.NextKey(store->KeyCount()));
+            }
+            if (op == kScan)
+            {
+                scan_len = chooser.NextScanLength();
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            switch (op)
+            {
+            case kRead:
+                result->not_found += store->Read(key) ? 0 : 1;
+                break;
+            case kUpdate:
+                store->Update(key, value);
+                break;
+            case kInsert:
+                store->InsertNext(value);
+                break;
+            case kScan:
+                store->Scan(key, scan_len);
+                break;
+            default:
+                result->not_found += store->Read(key) ? 0 : 1;
+                store->Update(key, value);
+                break;
+            }
+            auto end = std::chrono::steady_clock::now();
+            result->hist[op].Add(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        }
+    }
+
+    // 模拟compaction：以1MB为单位顺序写文件，每16MB同步一次，文件写满1GB后从头覆盖
+    class BackgroundWriter
+    {
+    public:
+        explicit BackgroundWriter(const Options &opt)
+            : limiter_(opt.bg_rate_limit_mb > 0 ? new RateLimiter(opt.bg_rate_limit_mb << 20) : nullptr),
+              file_(limiter_.get(), Priority::kLow),
+              path_(opt.bg_dir + "/minikvdb_ycsb_bg." + std::to_string(getpid()))
+        {
+        }
+
+        ~BackgroundWriter()
+        {
+            Stop();
+            unlink(path_.c_str());
+        }
+
+        bool Start()
+        {
+            if (!file_.Open(path_))
+            {
+                return false;
+            }
+            begin_ = std::chrono::steady_clock::now();
+            thread_ = std::thread(&BackgroundWriter::Loop, this);
+            return true;
+        }
+
+        void Stop()
+        {
+            if (thread_.joinable())
+            {
+                stop_.store(true, std::memory_order_relaxed);
+                thread_.join();
+                file_.Close();
+            }
+        }
+
+        double MBPerSecond() const
+        {
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_).count();
+            return sec > 0 ? written_ / 1048576.0 / sec : 0;
+        }
+
+    private:
+        void Loop()
+        {
+            const std::string block(1 << 20, 'c');
+            while (!stop_.load(std::memory_order_relaxed))
+            {
+                if (!file_.Append(block))
+                {
+                    return;
+                }
+                written_ += block.size();
+                if (file_.GetFileSize() % (16 << 20) == 0)
+                {
+                    file_.Sync();
+                }
+                if (file_.GetFileSize() >= (1ULL << 30) && !file_.Open(path_))
+                {
+                    return;
+                }
+            }
+        }
+
+        std::unique_ptr<RateLimiter> limiter_;
+        WritableFile file_;
+        std::string path_;
+        std::thread thread_;
+        std::atomic<bool> stop_{false};
+        uint64_t written_ = 0;
+        std::chrono::steady_clock::time_point begin_;
+    };
+
+    void Run(const Options &opt, const ZipfianGenerator &zipf, int threads)
+    {
+        Store store(opt.rep);
+        const std::string value(opt.value_size, 'v');
+        auto load_begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < opt.records; ++i)
+        {
+            store.InsertNext(value);
+        }
+        double load_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_begin).count();
+
+        std::vector<ThreadResult> results(threads);
+        std::vector<std::thread> workers;
+        std::atomic<bool> start{false};
+        uint64_t per_thread = opt.operations / threads;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(RunThread, &store, std::cref(opt), std::cref(zipf), per_thread,
+                                 opt.seed + 1 + t, &start, &results[t]);
+        }
+        std::unique_ptr<BackgroundWriter> bg;
+        if (opt.bg_write)
+        {
+            bg.reset(new BackgroundWriter(opt));
+            if (!bg->Start())
+            {
+                fprintf(stderr, "cannot open background write file in %s\n", opt.bg_dir.c_str());
+                bg.reset();
+            }
+        }
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true, std::memory_order_release);
+        for (auto &w : workers)
+        {
+            w.join();
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        double bg_mbps = 0;
+        if (bg != nullptr)
+        {
+            bg->Stop();
+            bg_mbps = bg->MBPerSecond();
+        }
+
+        ThreadResult total;
+        for (auto &r : results)
+        {
+            for (int i = 0; i < kNumOpTypes; ++i)
+            {
+                total.hist[i].Merge(r.hist[i]);
+            }
+            total.not_found += r.not_found;
+        }
+
+        uint64_t done = per_thread * threads;
+        printf("threads=%d load=%.2fs run=%.2fs throughput=%.0f ops/s entries=%d not_found=%llu\n",
+               threads, load_sec, sec, done / sec, store.GetSize(),
+               static_cast<unsigned long long>(total.not_found));
+        if (opt.bg_write)
+        {
+            printf("  background write %.1f MB/s (limit %s)\n", bg_mbps,
+                   opt.bg_rate_limit_mb > 0 ? (std::to_string(opt.bg_rate_limit_mb) + " MB/s").c_str() : "none");
+        }
+        for (int i = 0; i < kNumOpTypes; ++i)
+        {
+            if (total.hist[i].Count() > 0)
+            {
+                printf("  %-7s %s (us)\n", kOpNames[i], total.hist[i].ToString(1000.0).c_str());
+            }
+        }
+    }
+
+    void Usage(const char *prog)
+    {
+        fprintf(stderr,
+                "Usage: %s [options]\n"
+                "  --workload=a|b|c|d|e|f       YCSB core workload (default a)\n"
+                "  --distribution=zipfian|uniform|latest  override the workload's key distribution\n"
+                "  --rep=skiplist|hash          memtable representation (default skiplist)\n"
+                "  --records=N                  keys loaded before the run (default 100000)\n"
+                "  --operations=N               operations per run, split across threads (default 1000000)\n"
+                "  --threads=1,2,4              thread counts to run, comma separated (default 1)\n"
+                "  --scan_length=N              max scan length (default 100)\n"
+                "  --value_size=N               value bytes (default 100)\n"
+                "  --seed=N                     random seed (default 301)\n"
+                "  --bg_write=0|1               run a saturating background file writer during the run\n"
+                "  --bg_rate_limit_mb=N         rate limit for the background writer in MB/s (default 0, unlimited)\n"
+                "  --bg_dir=PATH                directory for the background write file (default /tmp)\n",
+                prog);
+    }
+
+    bool ParseOptions(int argc, char **argv, Options *opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const char *eq = strchr(arg, '=');
+            if (strncmp(arg, "--", 2) != 0 || eq == nullptr)
+            {
+                return false;
+            }
+            std::string name(arg + 2, eq - arg - 2);
+            std::string val(eq + 1);
+            if (name == "workload")
+            {
+                opt->workload = nullptr;
+                for (const Workload &w : kWorkloads)
+                {
+                    if (val.size() == 1 && (val[0] | 0x20) == w.name)
+                    {
+                        opt->workload = &w;
+                    }
+                }
+                if (opt->workload == nullptr)
+                {
+                    return false;
+                }
+            }
+            else if (name == "distribution")
+            {
+                opt->override_dist = true;
+                if (val == "zipfian")
+                    opt->dist = Distribution::kZipfian;
+                else if (val == "uniform")
+                    opt->dist = Distribution::kUniform;
+                else if (val == "latest")
+                    opt->dist = Distribution::kLatest;
+                else
+                    return false;
+            }
+            else if (name == "rep")
+            {
+                if (val == "skiplist")
+                    opt->rep = MemTableRepType::kSkipList;
+                else if (val == "hash")
+                    opt->rep = MemTableRepType::kHashSkipList;
+                else
+                    return false;
+            }
+            else if (name == "records")
+                opt->records = strtoull(val.c_str(), nullptr, 10);
+            else if (name == "operations")
+                opt->operations = strtoull(val.c_str(), nullptr, 10);
+            else if (name == "scan_length")
+                opt->scan_length = atoi(val.c_str());
+            else if (name == "value_size")
+                opt->value_size = atoi(val.c_str());
+            else if (name == "bg_write")
+                opt->bg_write = val == "1";
+            else if (name == "bg_rate_limit_mb")
+                opt->bg_rate_limit_mb = strtoll(val.c_str(), nullptr, 10);
+            else if (name == "bg_dir")
+                opt->bg_dir = val;
+            else if (name == "seed")
+                opt->seed = static_cast<uint32_t>(strtoul(val.c_str(), nullptr, 10));
+            else if (name == "threads")
+            {
+                opt->threads.clear();
+                for (const char *p = val.c_str(); *p != '\0';)
+                {
+                    char *end = nullptr;
+                    long n = strtol(p, &end, 10);
+                    if (end == p || n <= 0)
+                    {
+                        return false;
+                    }
+                    opt->threads.push_back(static_cast<int>(n));
+                    p = *end == ',' ? end + 1 : end;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return opt->records > 0 && opt->scan_length > 0 && opt->value_size >= 0 && !opt->threads.empty();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    using namespace minikvdb::ycsb;
+    Options opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    Distribution dist = opt.override_dist ? opt.dist : opt.workload->dist;
+    printf("workload=%c rep=%s distribution=%s records=%llu operations=%llu\n", opt.workload->name,
+           opt.rep == minikvdb::MemTableRepType::kSkipList ? "skiplist" : "hash", DistName(dist),
+           static_cast<unsigned long long>(opt.records), static_cast<unsigned long long>(opt.operations));
+
+    // Zipfian的zeta计算与key数量线性相关，所有线程数共用一个
+    minikvdb::bench::ZipfianGenerator zipf(opt.records);
+    for (int threads : opt.threads)
+    {
+        Run(opt, zipf, threads);
+    }
+    return 0;
+}